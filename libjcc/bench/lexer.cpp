@@ -0,0 +1,583 @@
+#include "compile.hpp"
+#include <iostream>
+#include <fstream>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <new>
+#include <thread>
+
+using namespace jcc;
+
+///=============================================================================
+/// Allocation counting
+///
+/// Every allocation made by the process goes through these replacements, so
+/// the number of allocations a lex performs can be read off the counter.
+///=============================================================================
+
+static std::atomic<uint64_t> g_allocations{0};
+
+void *operator new(size_t size)
+{
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void *ptr = std::malloc(size ? size : 1))
+    {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+void *operator new[](size_t size)
+{
+    return operator new(size);
+}
+
+void operator delete(void *ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete[](void *ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete(void *ptr, size_t) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete[](void *ptr, size_t) noexcept
+{
+    std::free(ptr);
+}
+
+///=============================================================================
+/// Corpus generator
+///=============================================================================
+
+/// @brief Deterministic generator so every run lexes the same corpus
+class Random
+{
+public:
+    Random(uint64_t seed) : m_state(seed) {}
+
+    uint64_t next()
+    {
+        // splitmix64
+        uint64_t z = (m_state += 0x9e3779b97f4a7c15ull);
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+        return z ^ (z >> 31);
+    }
+
+    size_t below(size_t n) { return next() % n; }
+
+    template <typename T, size_t N>
+    const T &pick(const T (&items)[N]) { return items[below(N)]; }
+
+private:
+    uint64_t m_state;
+};
+
+enum class CorpusKind
+{
+    Identifiers,
+    Operators,
+    Literals,
+    Comments,
+    Mixed,
+};
+
+static const char *corpus_name(CorpusKind kind)
+{
+    switch (kind)
+    {
+    case CorpusKind::Identifiers:
+        return "identifiers";
+    case CorpusKind::Operators:
+        return "operators";
+    case CorpusKind::Literals:
+        return "literals";
+    case CorpusKind::Comments:
+        return "comments";
+    case CorpusKind::Mixed:
+        return "mixed";
+    }
+
+    return "unknown";
+}
+
+static const char *const g_operators[] = {"+", "-", "*", "/", "%", "+=", "-=", "*=", "/=", "++", "--", "==", "!=", "<", "<=", ">", ">=", "<<", ">>", "&&", "||", "^^", "&", "|", "^", "!", "~", "=", "?", "??", "<<=", ">>=", ">>>=", "&&=", "||="};
+static const char *const g_punctuators[] = {"(", ")", "{", "}", "[", "]", ";", ":", ",", "."};
+
+static void append_identifier(std::string &out, Random &rng)
+{
+    static const char first[] = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ_";
+    static const char rest[] = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ_0123456789";
+
+    // a working set of names repeats, like real code does
+    if (rng.below(4) != 0)
+    {
+        out += "name";
+        out += std::to_string(rng.below(256));
+        return;
+    }
+
+    size_t length = 1 + rng.below(16);
+    out += first[rng.below(sizeof(first) - 1)];
+    for (size_t i = 1; i < length; i++)
+    {
+        out += rest[rng.below(sizeof(rest) - 1)];
+    }
+}
+
+static void append_literal(std::string &out, Random &rng)
+{
+    static const char *const escapes[] = {"\\n", "\\t", "\\\\", "\\\"", "\\x41"};
+
+    switch (rng.below(5))
+    {
+    case 0:
+        out += std::to_string(rng.next() % 1000000);
+        break;
+    case 1:
+    {
+        static const char hex[] = "0123456789abcdef";
+        out += "0x";
+        for (size_t i = 0, n = 1 + rng.below(8); i < n; i++)
+        {
+            out += hex[rng.below(16)];
+        }
+        break;
+    }
+    case 2:
+        out += std::to_string(rng.below(1000)) + "." + std::to_string(rng.below(1000));
+        break;
+    case 3:
+        out += std::to_string(1 + rng.below(9)) + "." + std::to_string(rng.below(100)) + "e" + std::to_string(rng.below(20));
+        break;
+    default:
+        out += '"';
+        for (size_t i = 0, n = rng.below(24); i < n; i++)
+        {
+            if (rng.below(8) == 0)
+            {
+                out += rng.pick(escapes);
+            }
+            else
+            {
+                out += static_cast<char>('a' + rng.below(26));
+            }
+        }
+        out += '"';
+        break;
+    }
+}
+
+static void append_comment(std::string &out, Random &rng)
+{
+    if (rng.below(2) == 0)
+    {
+        out += "// ";
+        for (size_t i = 0, n = 4 + rng.below(12); i < n; i++)
+        {
+            append_identifier(out, rng);
+            out += ' ';
+        }
+        out += '\n';
+    }
+    else
+    {
+        out += "/*\n";
+        for (size_t line = 0, lines = 1 + rng.below(4); line < lines; line++)
+        {
+            out += " * ";
+            for (size_t i = 0, n = 4 + rng.below(8); i < n; i++)
+            {
+                append_identifier(out, rng);
+                out += ' ';
+            }
+            out += '\n';
+        }
+        out += " */\n";
+    }
+}
+
+/// @brief Generate a corpus of at least `size` bytes
+/// @param kind Which token class dominates the corpus
+/// @param size Target size in bytes
+/// @return The corpus
+static std::string generate_corpus(CorpusKind kind, size_t size)
+{
+    Random rng(0x6a63632d62656e63ull ^ static_cast<uint64_t>(kind));
+    std::string out;
+    out.reserve(size + 256);
+
+    while (out.size() < size)
+    {
+        CorpusKind line_kind = kind;
+        if (kind == CorpusKind::Mixed)
+        {
+            line_kind = static_cast<CorpusKind>(rng.below(4));
+        }
+
+        switch (line_kind)
+        {
+        case CorpusKind::Identifiers:
+            for (size_t i = 0, n = 4 + rng.below(8); i < n; i++)
+            {
+                if (rng.below(8) == 0)
+                {
+                    // every keyword the lexer knows, so each one is a hit in its keyword table
+                    out += lexKeywordMapReverse.m_values[rng.below(lexKeywordCount)];
+                }
+                else
+                {
+                    append_identifier(out, rng);
+                }
+                out += ' ';
+            }
+            break;
+        case CorpusKind::Operators:
+            for (size_t i = 0, n = 8 + rng.below(16); i < n; i++)
+            {
+                out += rng.below(3) == 0 ? rng.pick(g_punctuators) : rng.pick(g_operators);
+                out += ' ';
+            }
+            break;
+        case CorpusKind::Literals:
+            for (size_t i = 0, n = 4 + rng.below(8); i < n; i++)
+            {
+                append_literal(out, rng);
+                out += ' ';
+            }
+            break;
+        case CorpusKind::Comments:
+            append_comment(out, rng);
+            break;
+        default:
+            break;
+        }
+
+        out += '\n';
+    }
+
+    return out;
+}
+
+///=============================================================================
+/// Measurement
+///=============================================================================
+
+struct BenchResult
+{
+    CorpusKind kind;
+    size_t bytes = 0;
+    size_t tokens = 0;
+    size_t iterations = 0;
+    uint64_t p50 = 0;
+    uint64_t p90 = 0;
+    uint64_t p99 = 0;
+    double mean = 0;
+    double allocs_per_token = 0;
+};
+
+struct BenchOptions
+{
+    std::vector<CorpusKind> kinds = {CorpusKind::Identifiers, CorpusKind::Operators, CorpusKind::Literals, CorpusKind::Comments, CorpusKind::Mixed};
+    std::vector<size_t> sizes = {1 << 10, 64 << 10, 1 << 20, 16 << 20, 100 << 20};
+    size_t max_iterations = 200;
+    double budget_seconds = 2.0;
+    LexMode mode = LexMode::Full;
+    std::string json_file = "bench-lexer.json";
+};
+
+static uint64_t percentile(const std::vector<uint64_t> &sorted, double p)
+{
+    size_t index = static_cast<size_t>(p * (sorted.size() - 1) + 0.5);
+    return sorted[std::min(index, sorted.size() - 1)];
+}
+
+static BenchResult run_case(CorpusKind kind, size_t size, const BenchOptions &options)
+{
+    BenchResult result;
+    result.kind = kind;
+
+    auto source = std::make_shared<const std::string>(generate_corpus(kind, size));
+    result.bytes = source->size();
+
+    // warm up (this also interns the corpus' identifiers), then count tokens
+    // and allocations on a single run
+    CompilationUnit::lex(source, options.mode);
+
+    uint64_t allocations = g_allocations.load(std::memory_order_relaxed);
+    {
+        TokenList tokens = CompilationUnit::lex(source, options.mode);
+        result.tokens = tokens.size();
+    }
+    allocations = g_allocations.load(std::memory_order_relaxed) - allocations;
+    result.allocs_per_token = result.tokens ? static_cast<double>(allocations) / result.tokens : 0;
+
+    std::vector<uint64_t> times;
+    auto budget = std::chrono::duration<double>(options.budget_seconds);
+    auto started = std::chrono::steady_clock::now();
+
+    // at least 5 samples, so the percentiles mean something on huge inputs
+    while (times.size() < options.max_iterations && (times.size() < 5 || std::chrono::steady_clock::now() - started < budget))
+    {
+        auto start = std::chrono::steady_clock::now();
+        TokenList tokens = CompilationUnit::lex(source, options.mode);
+        auto end = std::chrono::steady_clock::now();
+
+        times.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count());
+    }
+
+    std::sort(times.begin(), times.end());
+
+    uint64_t sum = 0;
+    for (auto time : times)
+    {
+        sum += time;
+    }
+
+    result.iterations = times.size();
+    result.p50 = percentile(times, 0.50);
+    result.p90 = percentile(times, 0.90);
+    result.p99 = percentile(times, 0.99);
+    result.mean = static_cast<double>(sum) / times.size();
+
+    return result;
+}
+
+///=============================================================================
+/// Reporting
+///=============================================================================
+
+static std::string format_size(size_t bytes)
+{
+    if (bytes >= (1 << 20))
+    {
+        return std::to_string(bytes >> 20) + " MB";
+    }
+    if (bytes >= (1 << 10))
+    {
+        return std::to_string(bytes >> 10) + " KB";
+    }
+    return std::to_string(bytes) + " B";
+}
+
+static void print_result(const BenchResult &r)
+{
+    double seconds = r.p50 / 1e9;
+
+    std::cout << corpus_name(r.kind) << " " << format_size(r.bytes) << ": "
+              << r.tokens << " tokens, " << r.iterations << " runs, "
+              << "p50 " << r.p50 << " ns, p90 " << r.p90 << " ns, p99 " << r.p99 << " ns, "
+              << static_cast<uint64_t>(r.tokens / seconds) << " tokens/s, "
+              << static_cast<uint64_t>(r.bytes / seconds / (1 << 20)) << " MB/s, "
+              << r.allocs_per_token << " allocs/token" << std::endl;
+}
+
+static bool write_json(const std::string &path, const std::vector<BenchResult> &results, const BenchOptions &options)
+{
+    std::ofstream out(path);
+    if (!out.is_open())
+    {
+        return false;
+    }
+
+    out << "{\"benchmark\":\"lexer\",\"mode\":\"" << (options.mode == LexMode::Full ? "full" : "no-trivia")
+        << "\",\"threads\":" << std::thread::hardware_concurrency() << ",\"results\":[";
+
+    for (size_t i = 0; i < results.size(); i++)
+    {
+        const BenchResult &r = results[i];
+        double seconds = r.p50 / 1e9;
+
+        out << (i ? "," : "") << "{\"corpus\":\"" << corpus_name(r.kind) << "\""
+            << ",\"bytes\":" << r.bytes
+            << ",\"tokens\":" << r.tokens
+            << ",\"iterations\":" << r.iterations
+            << ",\"p50_ns\":" << r.p50
+            << ",\"p90_ns\":" << r.p90
+            << ",\"p99_ns\":" << r.p99
+            << ",\"mean_ns\":" << static_cast<uint64_t>(r.mean)
+            << ",\"tokens_per_sec\":" << static_cast<uint64_t>(r.tokens / seconds)
+            << ",\"bytes_per_sec\":" << static_cast<uint64_t>(r.bytes / seconds)
+            << ",\"allocs_per_token\":" << r.allocs_per_token << "}";
+    }
+
+    out << "]}\n";
+    return out.good();
+}
+
+///=============================================================================
+/// Entry point
+///=============================================================================
+
+static bool parse_size(const std::string &text, size_t &size)
+{
+    char *end = nullptr;
+    unsigned long long value = std::strtoull(text.c_str(), &end, 10);
+    if (end == text.c_str())
+    {
+        return false;
+    }
+
+    std::string suffix(end);
+    if (suffix == "K" || suffix == "KB")
+    {
+        value <<= 10;
+    }
+    else if (suffix == "M" || suffix == "MB")
+    {
+        value <<= 20;
+    }
+    else if (!suffix.empty())
+    {
+        return false;
+    }
+
+    size = value;
+    return value > 0;
+}
+
+static void print_usage()
+{
+    std::cerr << "usage: bench-lexer [options]\n"
+              << "  -sizes <list>       comma separated corpus sizes, e.g. 1K,1M,100M (default 1K,64K,1M,16M,100M)\n"
+              << "  -corpus <list>      comma separated corpora: identifiers,operators,literals,comments,mixed\n"
+              << "  -iterations <n>     maximum number of timed runs per case (default 200)\n"
+              << "  -budget <seconds>   time budget per case, after the first 5 runs (default 2)\n"
+              << "  -no-trivia          lex without whitespace and comment tokens\n"
+              << "  -o <file>           JSON report (default bench-lexer.json)\n";
+}
+
+static std::vector<std::string> split_list(const std::string &text)
+{
+    std::vector<std::string> items;
+    size_t start = 0;
+    while (start <= text.size())
+    {
+        size_t comma = text.find(',', start);
+        if (comma == std::string::npos)
+        {
+            comma = text.size();
+        }
+        items.push_back(text.substr(start, comma - start));
+        start = comma + 1;
+    }
+    return items;
+}
+
+static bool parse_arguments(int argc, char **argv, BenchOptions &options)
+{
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc;
+
+        if (arg == "-sizes" && has_value)
+        {
+            options.sizes.clear();
+            for (const auto &item : split_list(argv[++i]))
+            {
+                size_t size;
+                if (!parse_size(item, size))
+                {
+                    std::cerr << "bench-lexer: invalid size '" << item << "'" << std::endl;
+                    return false;
+                }
+                options.sizes.push_back(size);
+            }
+        }
+        else if (arg == "-corpus" && has_value)
+        {
+            options.kinds.clear();
+            for (const auto &item : split_list(argv[++i]))
+            {
+                bool found = false;
+                for (auto kind : {CorpusKind::Identifiers, CorpusKind::Operators, CorpusKind::Literals, CorpusKind::Comments, CorpusKind::Mixed})
+                {
+                    if (item == corpus_name(kind))
+                    {
+                        options.kinds.push_back(kind);
+                        found = true;
+                    }
+                }
+                if (!found)
+                {
+                    std::cerr << "bench-lexer: unknown corpus '" << item << "'" << std::endl;
+                    return false;
+                }
+            }
+        }
+        else if (arg == "-iterations" && has_value)
+        {
+            options.max_iterations = std::max(1ul, std::strtoul(argv[++i], nullptr, 10));
+        }
+        else if (arg == "-budget" && has_value)
+        {
+            options.budget_seconds = std::strtod(argv[++i], nullptr);
+        }
+        else if (arg == "-no-trivia")
+        {
+            options.mode = LexMode::NoTrivia;
+        }
+        else if (arg == "-o" && has_value)
+        {
+            options.json_file = argv[++i];
+        }
+        else
+        {
+            print_usage();
+            return false;
+        }
+    }
+
+    return true;
+}
+
+int main(int argc, char **argv)
+{
+    BenchOptions options;
+    if (!parse_arguments(argc, argv, options))
+    {
+        return 1;
+    }
+
+    std::vector<BenchResult> results;
+
+    try
+    {
+        for (auto kind : options.kinds)
+        {
+            for (auto size : options.sizes)
+            {
+                results.push_back(run_case(kind, size, options));
+                print_result(results.back());
+            }
+        }
+    }
+    catch (const LexerException &e)
+    {
+        std::cerr << "Lexer failed: " << e.what() << std::endl;
+        return 1;
+    }
+
+    if (!write_json(options.json_file, results, options))
+    {
+        std::cerr << "bench-lexer: unable to write '" << options.json_file << "'" << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,203 @@
+#ifndef _JCC_ARENA_HPP_
+#define _JCC_ARENA_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <initializer_list>
+
+namespace jcc
+{
+    /// @brief Bump allocator owning every node of one syntax tree.
+    /// @note Nodes are never freed individually. Destroying the arena runs the
+    /// destructors of the nodes that need one and releases all of its blocks at
+    /// once, so tearing down a tree costs one pass instead of a refcount
+    /// decrement and a free per node.
+    class AstArena
+    {
+    public:
+        AstArena() : m_blocks(nullptr), m_cursor(nullptr), m_left(0), m_finalizers(nullptr), m_used(0), m_reserved(0) {}
+        ~AstArena();
+
+        AstArena(const AstArena &) = delete;
+        AstArena &operator=(const AstArena &) = delete;
+
+        /// @brief Allocate uninitialized memory
+        /// @param size Size in bytes
+        /// @param align Alignment, a power of two no larger than `alignof(std::max_align_t)`
+        /// @return Pointer to memory owned by the arena
+        void *allocate(size_t size, size_t align)
+        {
+            size_t pad = (align - reinterpret_cast<uintptr_t>(m_cursor)) & (align - 1);
+            if (pad + size > m_left)
+            {
+                grow(size);
+                pad = 0;
+            }
+
+            char *ptr = m_cursor + pad;
+            m_cursor = ptr + size;
+            m_left -= pad + size;
+            m_used += size;
+            return ptr;
+        }
+
+        /// @brief Construct a node in the arena
+        /// @tparam T Node type
+        /// @param args Constructor arguments
+        /// @return Pointer to the node, valid for the lifetime of the arena
+        template <typename T, typename... Args>
+        T *make(Args &&...args)
+        {
+            T *object = new (allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+
+            if constexpr (!std::is_trivially_destructible_v<T>)
+            {
+                Finalizer *finalizer = new (allocate(sizeof(Finalizer), alignof(Finalizer))) Finalizer{m_finalizers, object, [](void *ptr)
+                                                                                                          { static_cast<T *>(ptr)->~T(); }};
+                m_finalizers = finalizer;
+            }
+
+            return object;
+        }
+
+        /// @brief Take over the nodes of another arena, which is left empty
+        /// @param other Arena whose nodes must now live as long as this one
+        void adopt(AstArena &other);
+
+        /// @brief Bytes handed out by `allocate`
+        size_t used() const { return m_used; }
+
+        /// @brief Bytes reserved from the system
+        size_t reserved() const { return m_reserved; }
+
+        /// @brief Get the arena that `make_node` and `NodeList` allocate from on this thread
+        /// @return AstArena, or nullptr outside of a `Scope`
+        static AstArena *current();
+
+        /// @brief Get the arena that `make_node` and `NodeList` allocate from on this thread
+        /// @return AstArena
+        /// @throw std::logic_error outside of a `Scope`
+        static AstArena &active();
+
+        /// @brief Makes an arena current on this thread for the lifetime of the scope
+        class Scope
+        {
+        public:
+            Scope(AstArena &arena);
+            ~Scope();
+
+            Scope(const Scope &) = delete;
+            Scope &operator=(const Scope &) = delete;
+
+        private:
+            AstArena *m_previous;
+        };
+
+    private:
+        struct Block
+        {
+            Block *next;
+        };
+
+        struct Finalizer
+        {
+            Finalizer *next;
+            void *object;
+            void (*destroy)(void *);
+        };
+
+        Block *m_blocks;
+        char *m_cursor;
+        size_t m_left;
+        Finalizer *m_finalizers;
+        size_t m_used;
+        size_t m_reserved;
+
+        void grow(size_t size);
+    };
+
+    /// @brief Construct a node in the current arena
+    /// @tparam T Node type
+    /// @param args Constructor arguments
+    /// @return Pointer to the node
+    /// @throw std::logic_error outside of an `AstArena::Scope`
+    template <typename T, typename... Args>
+    T *make_node(Args &&...args)
+    {
+        return AstArena::active().make<T>(std::forward<Args>(args)...);
+    }
+
+    /// @brief Growable list of node pointers stored in the current arena.
+    /// @note 16 bytes, trivially destructible and never freed on its own. A copy
+    /// shares the storage of the original but reallocates before its first
+    /// push, so appending to one never clobbers the other.
+    template <typename T>
+    class NodeList
+    {
+    public:
+        typedef T *value_type;
+        typedef T *const *const_iterator;
+        typedef T **iterator;
+
+        NodeList() : m_data(nullptr), m_size(0), m_capacity(0) {}
+        NodeList(std::initializer_list<T *> nodes) : NodeList()
+        {
+            for (T *node : nodes)
+            {
+                push_back(node);
+            }
+        }
+        NodeList(const NodeList &other) : m_data(other.m_data), m_size(other.m_size), m_capacity(other.m_size) {}
+        NodeList &operator=(const NodeList &other)
+        {
+            m_data = other.m_data;
+            m_size = other.m_size;
+            m_capacity = other.m_size;
+            return *this;
+        }
+
+        void push_back(T *node)
+        {
+            if (m_size == m_capacity)
+            {
+                uint32_t capacity = m_capacity == 0 ? 4 : m_capacity * 2;
+                T **data = static_cast<T **>(AstArena::active().allocate(sizeof(T *) * capacity, alignof(T *)));
+                if (m_size != 0)
+                {
+                    std::memcpy(data, m_data, sizeof(T *) * m_size);
+                }
+                m_data = data;
+                m_capacity = capacity;
+            }
+
+            m_data[m_size++] = node;
+        }
+
+        void clear() { m_size = 0; }
+
+        size_t size() const { return m_size; }
+        bool empty() const { return m_size == 0; }
+
+        T *operator[](size_t index) const { return m_data[index]; }
+        T *&operator[](size_t index) { return m_data[index]; }
+
+        T *front() const { return m_data[0]; }
+        T *back() const { return m_data[m_size - 1]; }
+
+        iterator begin() { return m_data; }
+        iterator end() { return m_data + m_size; }
+        const_iterator begin() const { return m_data; }
+        const_iterator end() const { return m_data + m_size; }
+
+    private:
+        T **m_data;
+        uint32_t m_size;
+        uint32_t m_capacity;
+    };
+}
+
+#endif // _JCC_ARENA_HPP_
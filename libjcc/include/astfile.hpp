@@ -0,0 +1,97 @@
+#ifndef _JCC_ASTFILE_HPP_
+#define _JCC_ASTFILE_HPP_
+
+#include <string>
+#include <string_view>
+#include <cstdint>
+#include <cstddef>
+#include "parser.hpp"
+
+namespace jcc
+{
+    /// @brief Version of the binary AST (`.jast`) format; files of another version are rejected
+    constexpr uint32_t astFileVersion = 1;
+
+    /// @brief Cursor over the fields of one node of a binary AST.
+    /// @note Fields are read in the order the format lists them for the node's
+    /// type (see astfile.cpp). Reading past the end of the record, or a string
+    /// or node index out of range, throws `std::runtime_error`.
+    class AstFileRecord
+    {
+    public:
+        /// @brief Value of `node()` for an absent child
+        static constexpr uint32_t null = UINT32_MAX;
+
+        AstFileRecord(const uint8_t *begin, const uint8_t *end, const uint32_t *string_offsets, const char *string_data, uint32_t strings, uint32_t nodes);
+
+        NodeType type() const { return m_type; }
+
+        /// @brief Read an unsigned number
+        uint64_t number();
+
+        /// @brief Read a boolean
+        bool flag() { return number() != 0; }
+
+        /// @brief Read a string
+        /// @return std::string_view into the file
+        std::string_view string();
+
+        /// @brief Read a reference to a child node
+        /// @return Index of the child, or `null`
+        uint32_t node();
+
+        /// @brief Read the length of a list; the list's elements follow
+        uint32_t count();
+
+        /// @brief Check if every field of the record was read
+        bool done() const { return m_cursor == m_end; }
+
+    private:
+        const uint8_t *m_cursor;
+        const uint8_t *m_end;
+        const uint32_t *m_string_offsets;
+        const char *m_string_data;
+        uint32_t m_strings;
+        uint32_t m_nodes;
+        NodeType m_type;
+    };
+
+    /// @brief Zero-copy view of a binary AST, such as a mapped `.jast` file.
+    /// @note Nodes are numbered breadth first from the root, node 0, so every
+    /// child has a larger index than its parent. Nothing is decoded up front:
+    /// strings are views into the buffer and records are decoded as they are
+    /// read. The buffer must outlive the view.
+    class AstFileView
+    {
+    public:
+        AstFileView() = default;
+
+        /// @brief Check the header and tables of a buffer and view it
+        /// @param data The buffer
+        /// @return True if it holds a binary AST of this version, false otherwise
+        bool open(std::string_view data);
+
+        uint32_t node_count() const { return m_nodes; }
+        uint32_t string_count() const { return m_strings; }
+
+        /// @brief Get an entry of the string table
+        /// @param index Index below `string_count()`
+        /// @return std::string_view into the buffer
+        std::string_view string(uint32_t index) const;
+
+        /// @brief Start reading a node
+        /// @param index Index below `node_count()`
+        /// @return Cursor past the node's type
+        AstFileRecord record(uint32_t index) const;
+
+    private:
+        const uint32_t *m_string_offsets = nullptr;
+        const uint32_t *m_node_offsets = nullptr;
+        const char *m_string_data = nullptr;
+        const uint8_t *m_node_data = nullptr;
+        uint32_t m_strings = 0;
+        uint32_t m_nodes = 0;
+    };
+}
+
+#endif // _JCC_ASTFILE_HPP_
@@ -10,6 +10,7 @@
 #include <memory>
 #include "lexer.hpp"
 #include "parser.hpp"
+#include "sourcefile.hpp"
 
 namespace jcc
 {
@@ -24,6 +25,12 @@ namespace jcc
         OptimizeSize,
         Object,
         TranslateOnly,
+        /// @brief Write each source's tokens to `<file>.lex.json`
+        DumpTokens,
+        /// @brief Write each source's syntax tree to `<file>.ast.json`
+        DumpAst,
+        /// @brief Write each source's syntax tree to `<file>.jast` in the binary AST format
+        EmitAstBinary,
     };
 
     enum class CompilerMessageType
@@ -133,6 +140,15 @@ namespace jcc
         /// @brief Change the output file of the compilation unit
         void set_output_file(const std::string &file);
 
+        /// @brief Cache lexed tokens in a directory
+        /// @param directory Directory of `.jtok` files named by the source's content hash; empty to disable
+        /// @note Sources whose preprocessed text is unchanged are not lexed again.
+        void set_token_cache(const std::string &directory);
+
+        /// @brief Limit how deeply subsystems and expressions may nest in the sources
+        /// @param depth Nesting limit; deeper subsystems are reported as syntax errors
+        void set_max_nesting(size_t depth);
+
         /// @brief Get the files in the compilation unit
         /// @return std::vector<std::string>
         const std::vector<std::string> &files() const;
@@ -166,20 +182,85 @@ namespace jcc
         bool success() const;
 
         /// @brief Reset instance and clear all build-specific ephemeral data (keep user parameters)
+        /// @note The trees of the last build are kept, so the next build only reparses what changed.
         void reset_instance();
 
         /// @brief Lex a string of J++ source code into a list of tokens.
         /// @param source JXX source code raw string
+        /// @param mode Whether to keep whitespace and comment tokens
+        /// @param threads Number of threads to lex on; 0 picks one from the
+        /// number of cores and the size of the source
         /// @return A vector of tokens
         /// @throw LexerException
-        static TokenList lex(const std::string &source);
+        static TokenList lex(const std::string &source, LexMode mode = LexMode::Full, size_t threads = 0);
+
+        /// @brief Lex a pinned buffer of J++ source code without copying it.
+        /// @param source JXX source code buffer; token text views point into it
+        /// @param mode Whether to keep whitespace and comment tokens
+        /// @param threads Number of threads to lex on; 0 picks one from the
+        /// number of cores and the size of the source
+        /// @return A vector of tokens that keeps `source` alive
+        /// @throw LexerException
+        static TokenList lex(std::shared_ptr<const std::string> source, LexMode mode = LexMode::Full, size_t threads = 0);
 
         /// @brief Parse a list of tokens into an abstract syntax tree.
         /// @param tokens Tokens to parse.
         /// @return Abstract syntax tree.
-        /// @throw UnexpectedTokenError
+        /// @throw SyntaxError for the first syntax error
         static std::shared_ptr<AbstractSyntaxTree> parse(const TokenList &tokens);
 
+        /// @brief Parse the tokens after a cursor into an abstract syntax tree.
+        /// @param tokens Token cursor to consume.
+        /// @return Abstract syntax tree.
+        /// @throw SyntaxError for the first syntax error
+        static std::shared_ptr<AbstractSyntaxTree> parse(TokenCursor &tokens);
+
+        /// @brief Parse the tokens after a cursor, recovering from syntax errors.
+        /// @param tokens Token cursor to consume.
+        /// @param diagnostics Receives every syntax error, in source order.
+        /// @param max_nesting How deeply subsystems and expressions may nest; a deeper one is an error and skipped.
+        /// @param threads Number of threads to parse on; 0 picks one from the number of cores and tokens.
+        /// @return Abstract syntax tree of the statements that parsed.
+        /// @note Nothing is thrown for syntax errors. A malformed statement,
+        /// struct field or union field is reported, skipped up to the next `;`,
+        /// `}` or statement keyword, and parsing carries on.
+        static std::shared_ptr<AbstractSyntaxTree> parse(TokenCursor &tokens, std::vector<ParserDiagnostic> &diagnostics, size_t max_nesting = parseMaxNestingDefault, size_t threads = 0);
+
+        /// @brief Parse a new version of a source, reusing what is unchanged from an earlier version.
+        /// @param tokens Token cursor to consume.
+        /// @param previous Tree of the earlier version, or nullptr to parse everything.
+        /// @param diagnostics Receives every syntax error, in source order.
+        /// @param max_nesting How deeply subsystems and expressions may nest.
+        /// @param threads Number of threads to parse on; 0 picks one from the number of cores and tokens.
+        /// @return Abstract syntax tree of the statements that parsed.
+        /// @note Only the top-level declarations whose text changed are parsed.
+        /// The others, matched by content hash, share their nodes with `previous`
+        /// unless they were parsed `parseMaxRetainedVersions` versions ago, in
+        /// which case they are parsed again so their old arena can be released.
+        /// Errors are recovered from as in `parse`.
+        static std::shared_ptr<AbstractSyntaxTree> reparse(TokenCursor &tokens, const std::shared_ptr<AbstractSyntaxTree> &previous, std::vector<ParserDiagnostic> &diagnostics, size_t max_nesting = parseMaxNestingDefault, size_t threads = 0);
+
+        /// @brief Parse only the declarations of a list of tokens, skipping function bodies.
+        /// @param tokens Tokens to parse; the tree keeps them to parse bodies later.
+        /// @param diagnostics Receives every syntax error, in source order.
+        /// @param max_nesting How deeply subsystems and expressions may nest.
+        /// @param threads Number of threads to parse on; 0 picks one from the number of cores and tokens.
+        /// @return Abstract syntax tree whose function definitions and struct
+        /// methods have a null block and the byte range of their body.
+        /// @note Meant for imported files, where only signatures, struct layouts
+        /// and subsystems matter. Bodies are skipped by brace counting, so
+        /// errors inside them are not reported until they are parsed.
+        static std::shared_ptr<AbstractSyntaxTree> skim(const TokenList &tokens, std::vector<ParserDiagnostic> &diagnostics, size_t max_nesting = parseMaxNestingDefault, size_t threads = 0);
+
+        /// @brief Parse a function body skipped by `skim`.
+        /// @param ast Skimmed tree the function belongs to.
+        /// @param function FunctionDefinition or StructMethod of the tree.
+        /// @param diagnostics Receives the syntax errors of the body.
+        /// @return The body, also stored in the function; nullptr if there is nothing to parse.
+        /// @note Allocates in the tree's arena, so bodies of one tree must not
+        /// be parsed from several threads at once.
+        static Block *parse_body(const std::shared_ptr<AbstractSyntaxTree> &ast, GenericNode *function, std::vector<ParserDiagnostic> &diagnostics);
+
         /// @brief Synthesize target language source code from an abstract syntax tree.
         /// @param ast Abstract syntax tree.
         /// @param target Target language.
@@ -199,10 +280,16 @@ namespace jcc
         size_t m_current_file;
         std::set<CompileFlag> m_flags;
         std::string m_output_file;
+        std::string m_token_cache;
+        size_t m_max_nesting;
         /// @brief Map input to c++ temporary output files
         std::map<std::string, std::string> m_cxx_temp_files;
         std::map<std::string, std::string> m_obj_temp_files;
         bool m_success;
+        /// @brief Preprocessed source of the file being compiled. Tokens reference it.
+        std::shared_ptr<const std::string> m_source;
+        /// @brief Tree of the last version of each file, for reparsing only what changed
+        std::map<std::string, std::shared_ptr<AbstractSyntaxTree>> m_trees;
 
         /// @brief Push a message to the compilation unit
         /// @param type The type of the message
@@ -217,11 +304,17 @@ namespace jcc
         /// @return True if successful, false otherwise
         bool compile_file(const std::string &file);
 
-        /// @brief Read the source code from a file
+        /// @brief Map a source file and check that it is valid UTF-8
         /// @param filepath The path to the file
-        /// @param source_code The source code
+        /// @param source_code Receives the file contents
         /// @return True if successful, false otherwise
-        bool read_source_code(const std::string &filepath, std::string &source_code);
+        bool read_source_code(const std::string &filepath, SourceFile &source_code);
+
+        /// @brief Lex `m_source`, going through the token cache if one is set
+        /// @param mode The lexing mode
+        /// @return TokenList
+        /// @throw LexerException
+        TokenList lex_cached(LexMode mode);
 
         /// @brief Invoke the JCC helper c++ compiler
         /// @param input_cxx Input c++ file
@@ -0,0 +1,130 @@
+#ifndef _JCC_JSON_HPP_
+#define _JCC_JSON_HPP_
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <array>
+#include <ostream>
+#include <cstdint>
+
+namespace jcc
+{
+    /// @brief Streams JSON into a string, a stream or a file descriptor.
+    /// @note Output goes straight into one buffer, with no intermediate string
+    /// per value. Commas between the members of objects and arrays are written
+    /// automatically. Writers to a stream or file descriptor flush their buffer
+    /// whenever it fills up and when destroyed.
+    class JsonWriter
+    {
+    public:
+        /// @brief Escape sequence of every byte, empty for bytes written as is
+        typedef std::array<std::string_view, 256> EscapeTable;
+
+        /// @brief Append to a string
+        JsonWriter(std::string &out);
+        /// @brief Write to a stream
+        JsonWriter(std::ostream &out);
+        /// @brief Write to a file descriptor, which the writer does not close
+        JsonWriter(int fd);
+        ~JsonWriter();
+
+        JsonWriter(const JsonWriter &) = delete;
+        JsonWriter &operator=(const JsonWriter &) = delete;
+
+        void begin_object();
+        void end_object();
+        void begin_array();
+        void end_array();
+
+        /// @brief Write the key of the next member of the current object
+        /// @param name Key, written as is: keys are field names, not user text
+        void key(std::string_view name);
+
+        /// @brief Write a string value
+        /// @param str Contents, escaped with `escapes`
+        /// @param escapes Escape table, the JSON one by default
+        void value(std::string_view str, const EscapeTable &escapes = json_escapes());
+        void value(const char *str) { value(std::string_view(str)); }
+        void value(uint64_t number);
+        void null();
+
+        /// @brief Write an object member with a string value
+        void member(std::string_view name, std::string_view str)
+        {
+            key(name);
+            value(str);
+        }
+
+        /// @brief Write an object member with a numeric value
+        void member(std::string_view name, uint64_t number)
+        {
+            key(name);
+            value(number);
+        }
+
+        /// @brief Write bytes as they are, with no separator or escaping
+        /// @param text Text
+        void raw(std::string_view text) { put(text); }
+
+        /// @brief Escape a string into the output, with no quotes or separator
+        /// @param str String
+        /// @param escapes Escape table
+        void escape(std::string_view str, const EscapeTable &escapes = json_escapes());
+
+        /// @brief Hand the buffered output to the stream or file descriptor
+        void flush();
+
+        /// @brief Get the table escaping quotes, backslashes and control characters
+        /// @return EscapeTable
+        static const EscapeTable &json_escapes();
+
+    private:
+        std::string *m_out;
+        std::string m_buffer;
+        std::ostream *m_stream;
+        int m_fd;
+        /// @brief One entry per open object or array: whether a member was written yet
+        std::vector<bool> m_nonempty;
+        bool m_after_key;
+
+        void put(std::string_view text)
+        {
+            m_out->append(text);
+            if (m_out == &m_buffer && m_buffer.size() >= FlushSize)
+            {
+                flush();
+            }
+        }
+
+        void put(char c)
+        {
+            m_out->push_back(c);
+            if (m_out == &m_buffer && m_buffer.size() >= FlushSize)
+            {
+                flush();
+            }
+        }
+
+        /// @brief Write a comma unless the value is the first of its parent or follows a key
+        void separate()
+        {
+            if (m_after_key)
+            {
+                m_after_key = false;
+            }
+            else if (!m_nonempty.empty())
+            {
+                if (m_nonempty.back())
+                {
+                    put(',');
+                }
+                m_nonempty.back() = true;
+            }
+        }
+
+        static constexpr size_t FlushSize = 64 * 1024;
+    };
+}
+
+#endif // _JCC_JSON_HPP_
@@ -4,13 +4,22 @@
 #include <string>
 #include <vector>
 #include <map>
-#include <variant>
+#include <array>
+#include <cstddef>
+#include <memory>
+#include <deque>
+#include <mutex>
+#include <string_view>
+#include <cstdint>
 #include <exception>
 #include <stdexcept>
+#include <algorithm>
+#include "symbol.hpp"
+#include "json.hpp"
 
 namespace jcc
 {
-    enum class TokenType
+    enum class TokenType : int8_t
     {
         Unknown = -1,
         Identifier,
@@ -26,7 +35,7 @@ namespace jcc
         Whitespace,
     };
 
-    enum class Keyword
+    enum class Keyword : uint8_t
     {
         // Namespaces
         Subsystem,
@@ -122,169 +131,107 @@ namespace jcc
         Null,
     };
 
-    const std::map<const char *, jcc::Keyword> lexKeywordMap = {
-        {"subsystem", jcc::Keyword::Subsystem},
-
-        {"import", jcc::Keyword::Import},
-        {"export", jcc::Keyword::Export},
-        {"extern", jcc::Keyword::Extern},
-
-        {"infer", jcc::Keyword::Infer},
-        {"let", jcc::Keyword::Let},
-        {"var", jcc::Keyword::Var},
-
-        {"struct", jcc::Keyword::Struct},
-        {"region", jcc::Keyword::Region},
-        {"union", jcc::Keyword::Union},
-        {"packet", jcc::Keyword::Packet},
-
-        {"func", jcc::Keyword::Func},
-
-        {"typedef", jcc::Keyword::Typedef},
-        {"const", jcc::Keyword::Const},
-        {"ref", jcc::Keyword::Ref},
-        {"static", jcc::Keyword::Static},
-        {"volatile", jcc::Keyword::Volatile},
-
-        {"class", jcc::Keyword::Class},
-        {"public", jcc::Keyword::Public},
-        {"private", jcc::Keyword::Private},
-        {"protected", jcc::Keyword::Protected},
-        {"override", jcc::Keyword::Override},
-        {"claim", jcc::Keyword::Claim},
-        {"virtual", jcc::Keyword::Virtual},
-        {"abstract", jcc::Keyword::Abstract},
-        {"friend", jcc::Keyword::Friend},
-        {"interface", jcc::Keyword::Interface},
-
-        {"meta", jcc::Keyword::Meta},
-
-        {"if", jcc::Keyword::If},
-        {"else", jcc::Keyword::Else},
-        {"for", jcc::Keyword::For},
-        {"while", jcc::Keyword::While},
-        {"do", jcc::Keyword::Do},
-        {"switch", jcc::Keyword::Switch},
-        {"return", jcc::Keyword::Return},
-        {"case", jcc::Keyword::Case},
-        {"break", jcc::Keyword::Break},
-        {"default", jcc::Keyword::Default},
-        {"abort", jcc::Keyword::Abort},
-        {"throw", jcc::Keyword::Throw},
-        {"continue", jcc::Keyword::Continue},
-
-        {"enum", jcc::Keyword::Enum},
-
-        {"bool", jcc::Keyword::Bool},
-        {"char", jcc::Keyword::Char},
-        {"byte", jcc::Keyword::Byte},
-        {"short", jcc::Keyword::Short},
-        {"word", jcc::Keyword::Word},
-        {"int", jcc::Keyword::Int},
-        {"dword", jcc::Keyword::Dword},
-        {"long", jcc::Keyword::Long},
-        {"qword", jcc::Keyword::Qword},
-        {"float", jcc::Keyword::Float},
-        {"double", jcc::Keyword::Double},
-        {"intn", jcc::Keyword::Intn},
-        {"uintn", jcc::Keyword::Uintn},
-        {"address", jcc::Keyword::Address},
-        {"routine", jcc::Keyword::Routine},
-        {"bigfloat", jcc::Keyword::Bigfloat},
-        {"bigint", jcc::Keyword::Bigint},
-        {"biguint", jcc::Keyword::Biguint},
-        {"arbint", jcc::Keyword::Arbint},
-        {"arbuint", jcc::Keyword::Arbuint},
-        {"real", jcc::Keyword::Real},
-        {"complex", jcc::Keyword::Complex},
-        {"string", jcc::Keyword::String},
-        {"map", jcc::Keyword::Map},
-        {"tensor", jcc::Keyword::Tensor},
-        {"void", jcc::Keyword::Void},
-        {"null", jcc::Keyword::Null}};
-
-    const std::map<jcc::Keyword, const char *> lexKeywordMapReverse = {
-        {jcc::Keyword::Subsystem, "subsystem"},
-
-        {jcc::Keyword::Import, "import"},
-        {jcc::Keyword::Export, "export"},
-        {jcc::Keyword::Extern, "extern"},
-
-        {jcc::Keyword::Infer, "infer"},
-        {jcc::Keyword::Let, "let"},
-        {jcc::Keyword::Var, "var"},
-
-        {jcc::Keyword::Struct, "struct"},
-        {jcc::Keyword::Region, "region"},
-        {jcc::Keyword::Union, "union"},
-        {jcc::Keyword::Packet, "packet"},
-
-        {jcc::Keyword::Func, "func"},
-
-        {jcc::Keyword::Typedef, "typedef"},
-        {jcc::Keyword::Const, "const"},
-        {jcc::Keyword::Ref, "ref"},
-        {jcc::Keyword::Static, "static"},
-        {jcc::Keyword::Volatile, "volatile"},
-
-        {jcc::Keyword::Class, "class"},
-        {jcc::Keyword::Public, "public"},
-        {jcc::Keyword::Private, "private"},
-        {jcc::Keyword::Protected, "protected"},
-        {jcc::Keyword::Override, "override"},
-        {jcc::Keyword::Claim, "claim"},
-        {jcc::Keyword::Virtual, "virtual"},
-        {jcc::Keyword::Abstract, "abstract"},
-        {jcc::Keyword::Friend, "friend"},
-        {jcc::Keyword::Interface, "interface"},
-
-        {jcc::Keyword::Meta, "meta"},
-
-        {jcc::Keyword::If, "if"},
-        {jcc::Keyword::Else, "else"},
-        {jcc::Keyword::For, "for"},
-        {jcc::Keyword::While, "while"},
-        {jcc::Keyword::Do, "do"},
-        {jcc::Keyword::Switch, "switch"},
-        {jcc::Keyword::Return, "return"},
-        {jcc::Keyword::Case, "case"},
-        {jcc::Keyword::Break, "break"},
-        {jcc::Keyword::Default, "default"},
-        {jcc::Keyword::Abort, "abort"},
-        {jcc::Keyword::Throw, "throw"},
-        {jcc::Keyword::Continue, "continue"},
-
-        {jcc::Keyword::Enum, "enum"},
-
-        {jcc::Keyword::Bool, "bool"},
-        {jcc::Keyword::Char, "char"},
-        {jcc::Keyword::Byte, "byte"},
-        {jcc::Keyword::Short, "short"},
-        {jcc::Keyword::Word, "word"},
-        {jcc::Keyword::Int, "int"},
-        {jcc::Keyword::Dword, "dword"},
-        {jcc::Keyword::Long, "long"},
-        {jcc::Keyword::Qword, "qword"},
-        {jcc::Keyword::Float, "float"},
-        {jcc::Keyword::Double, "double"},
-        {jcc::Keyword::Intn, "intn"},
-        {jcc::Keyword::Uintn, "uintn"},
-        {jcc::Keyword::Address, "address"},
-        {jcc::Keyword::Routine, "routine"},
-        {jcc::Keyword::Bigfloat, "bigfloat"},
-        {jcc::Keyword::Bigint, "bigint"},
-        {jcc::Keyword::Biguint, "biguint"},
-        {jcc::Keyword::Arbint, "arbint"},
-        {jcc::Keyword::Arbuint, "arbuint"},
-        {jcc::Keyword::Real, "real"},
-        {jcc::Keyword::Complex, "complex"},
-        {jcc::Keyword::String, "string"},
-        {jcc::Keyword::Map, "map"},
-        {jcc::Keyword::Tensor, "tensor"},
-        {jcc::Keyword::Void, "void"},
-        {jcc::Keyword::Null, "null"}};
-
-    enum class Punctuator
+    /// @brief Fixed-size lookup table indexed directly by an enum class value
+    template <typename E, typename T, std::size_t N>
+    struct EnumTable
+    {
+        std::array<T, N> m_values;
+
+        constexpr const T &at(E key) const { return m_values[static_cast<std::size_t>(key)]; }
+        constexpr const T &operator[](E key) const { return m_values[static_cast<std::size_t>(key)]; }
+        constexpr std::size_t size() const { return N; }
+    };
+
+    constexpr std::size_t lexKeywordCount = static_cast<std::size_t>(jcc::Keyword::Null) + 1;
+
+    /// @brief Keyword spellings, indexed by `jcc::Keyword`. Must stay in enum order.
+    constexpr EnumTable<jcc::Keyword, const char *, lexKeywordCount> lexKeywordMapReverse = {{
+        "subsystem", // Subsystem
+
+        "import", // Import
+        "export", // Export
+        "extern", // Extern
+
+        "infer", // Infer
+        "let", // Let
+        "var", // Var
+
+        "struct", // Struct
+        "region", // Region
+        "union", // Union
+        "packet", // Packet
+
+        "func", // Func
+
+        "typedef", // Typedef
+        "const", // Const
+        "ref", // Ref
+        "static", // Static
+        "volatile", // Volatile
+
+        "class", // Class
+        "public", // Public
+        "private", // Private
+        "protected", // Protected
+        "override", // Override
+        "claim", // Claim
+        "virtual", // Virtual
+        "abstract", // Abstract
+        "friend", // Friend
+        "interface", // Interface
+
+        "meta", // Meta
+
+        "if", // If
+        "else", // Else
+        "for", // For
+        "while", // While
+        "do", // Do
+        "switch", // Switch
+        "return", // Return
+        "retif", // Retif
+        "retz", // Retz
+        "retnz", // Retnz
+        "abortif", // Abortif
+        "case", // Case
+        "break", // Break
+        "default", // Default
+        "abort", // Abort
+        "throw", // Throw
+        "continue", // Continue
+
+        "enum", // Enum
+
+        "bool", // Bool
+        "char", // Char
+        "byte", // Byte
+        "short", // Short
+        "word", // Word
+        "int", // Int
+        "dword", // Dword
+        "long", // Long
+        "qword", // Qword
+        "float", // Float
+        "double", // Double
+        "intn", // Intn
+        "uintn", // Uintn
+        "address", // Address
+        "routine", // Routine
+        "bigfloat", // Bigfloat
+        "bigint", // Bigint
+        "biguint", // Biguint
+        "arbint", // Arbint
+        "arbuint", // Arbuint
+        "real", // Real
+        "complex", // Complex
+        "string", // String
+        "map", // Map
+        "tensor", // Tensor
+        "void", // Void
+        "null", // Null
+    }};
+
+    enum class Punctuator : uint8_t
     {
         OpenParen,
         CloseParen,
@@ -298,18 +245,6 @@ namespace jcc
         Period,
     };
 
-    const std::map<const char *, jcc::Punctuator> lexPunctuatorMap = {
-        {"(", jcc::Punctuator::OpenParen},
-        {")", jcc::Punctuator::CloseParen},
-        {"{", jcc::Punctuator::OpenBrace},
-        {"}", jcc::Punctuator::CloseBrace},
-        {"[", jcc::Punctuator::OpenBracket},
-        {"]", jcc::Punctuator::CloseBracket},
-        {";", jcc::Punctuator::Semicolon},
-        {":", jcc::Punctuator::Colon},
-        {",", jcc::Punctuator::Comma},
-        {".", jcc::Punctuator::Period}};
-
     const std::map<jcc::Punctuator, const char *> lexPunctuatorMapReverse = {
         {jcc::Punctuator::OpenParen, "("},
         {jcc::Punctuator::CloseParen, ")"},
@@ -322,7 +257,7 @@ namespace jcc
         {jcc::Punctuator::Comma, ","},
         {jcc::Punctuator::Period, "."},};
 
-    enum class Operator
+    enum class Operator : uint8_t
     {
         PlusEquals,
         MinusEquals,
@@ -374,55 +309,6 @@ namespace jcc
         Ternary,
     };
 
-    const std::map<const char *, jcc::Operator> lexOperatorMap = {
-        {"+=", jcc::Operator::PlusEquals},
-        {"-=", jcc::Operator::MinusEquals},
-        {"*=", jcc::Operator::TimesEquals},
-        {"/=", jcc::Operator::FloatingDivideEquals},
-        {"%=", jcc::Operator::ModulusEquals},
-
-        {"^^=", jcc::Operator::XorEquals},
-        {"||=", jcc::Operator::OrEquals},
-        {"&&=", jcc::Operator::AndEquals},
-        {"<<=", jcc::Operator::LeftShiftEquals},
-        {">>=", jcc::Operator::ArithmeticRightShiftEquals},
-        {">>>=", jcc::Operator::UnsignedRightShiftEquals},
-        {"|=", jcc::Operator::BitwiseOrEquals},
-        {"&=", jcc::Operator::BitwiseAndEquals},
-        {"^=", jcc::Operator::BitwiseXorEquals},
-
-        {"<<", jcc::Operator::LeftShift},
-        {">>", jcc::Operator::RightShift},
-        {"==", jcc::Operator::Equals},
-        {"!=", jcc::Operator::NotEquals},
-        {"&&", jcc::Operator::And},
-        {"||", jcc::Operator::Or},
-        {"^^", jcc::Operator::Xor},
-        {"<=", jcc::Operator::LessThanOrEqual},
-        {">=", jcc::Operator::GreaterThanOrEqual},
-        {"<", jcc::Operator::LessThan},
-        {">", jcc::Operator::GreaterThan},
-
-        {"=", jcc::Operator::Assign},
-        {"??", jcc::Operator::NullCoalesce},
-        {"@", jcc::Operator::At},
-
-        {"//", jcc::Operator::FloorDivide},
-        {"++", jcc::Operator::Increment},
-        {"--", jcc::Operator::Decrement},
-        {"+", jcc::Operator::Plus},
-        {"-", jcc::Operator::Minus},
-        {"*", jcc::Operator::Times},
-        {"/", jcc::Operator::FloatingDivide},
-        {"%", jcc::Operator::Modulus},
-        {"&", jcc::Operator::BitwiseAnd},
-        {"|", jcc::Operator::BitwiseOr},
-        {"^", jcc::Operator::BitwiseXor},
-        {"~", jcc::Operator::BitwiseNot},
-        {"!", jcc::Operator::Not},
-
-        {"?", jcc::Operator::Ternary}};
-
     const std::map<jcc::Operator, const char *> lexOperatorMapReverse = {
         {jcc::Operator::PlusEquals, "+="},
         {jcc::Operator::MinusEquals, "-="},
@@ -472,9 +358,13 @@ namespace jcc
         {jcc::Operator::Not, "!"},
         {jcc::Operator::Ternary, "?"}};
 
-    typedef std::variant<std::string, Operator, Keyword, Punctuator>
-        TokenValueType;
-
+    /// @brief A lexical token.
+    /// @note Text-carrying tokens (literals, comments, raw blocks and whitespace)
+    /// do not own their text. They reference either the source buffer pinned by
+    /// the TokenList that produced them, or a decoded copy stored in that same
+    /// TokenList when the source spelling had to be rewritten (escapes,
+    /// normalized number literals). A token must not outlive its TokenList.
+    /// Identifier text is interned and lives as long as the process.
     class Token
     {
     public:
@@ -482,29 +372,112 @@ namespace jcc
 
         ~Token() = default;
 
-        /// @brief Construct a new Token object
+        /// @brief Construct a text-carrying token
         /// @param type The type of the token
-        /// @param value The value of the token
-        Token(TokenType type, TokenValueType value);
+        /// @param text View of the token text; must outlive the token. Identifiers are interned.
+        Token(TokenType type, std::string_view text);
+
+        /// @brief Construct an identifier token
+        /// @param identifier The interned identifier
+        Token(Symbol identifier);
+
+        /// @brief Construct a keyword token
+        Token(TokenType type, Keyword keyword);
+
+        /// @brief Construct an operator token
+        Token(TokenType type, Operator op);
+
+        /// @brief Construct a punctuator token
+        Token(TokenType type, Punctuator punctuator);
 
         /// @brief Get the type of the token
         /// @return TokenType
-        TokenType type() const;
+        TokenType type() const { return m_type; }
 
-        /// @brief Get the value of the token
-        /// @return std::string
-        const TokenValueType &value() const;
+        /// @brief Get the text of an identifier, literal, comment or raw token
+        /// @return std::string_view
+        std::string_view text() const { return std::string_view(m_data, m_length); }
+
+        /// @brief Get the interned symbol of an Identifier token
+        /// @return Symbol
+        Symbol symbol() const { return Symbol::from_interned(text()); }
+
+        /// @brief Get the keyword of a Keyword token
+        Keyword keyword() const { return static_cast<Keyword>(m_kind); }
+
+        /// @brief Get the operator of an Operator token
+        Operator op() const { return static_cast<Operator>(m_kind); }
+
+        /// @brief Get the punctuator of a Punctuator token
+        Punctuator punctuator() const { return static_cast<Punctuator>(m_kind); }
 
         /// @brief Convert the token to a string
         /// @return std::string
         std::string to_string() const;
 
+        bool operator==(const Token &other) const;
+
+    private:
+        const char *m_data;
+        uint32_t m_length;
         TokenType m_type;
-        TokenValueType m_value;
+        uint8_t m_kind;
+    };
 
-        bool operator==(const Token &other) const;
+    static_assert(sizeof(Token) <= 16, "jcc::Token should stay within 16 bytes");
+
+    /// @brief 1-based line and column of a byte in a source buffer
+    struct SourceLocation
+    {
+        uint32_t line = 0;
+        uint32_t column = 0;
+    };
+
+    /// @brief Byte range [begin, end) of a source buffer
+    struct SourceRange
+    {
+        uint32_t begin = 0;
+        uint32_t end = 0;
+
+        bool empty() const { return begin == end; }
+    };
+
+    /// @brief Maps byte offsets of a source buffer to line/column.
+    /// @note The newline table is only built the first time a location is
+    /// requested, so lexing and parsing pay nothing for it unless a diagnostic
+    /// is produced.
+    class LineIndex
+    {
+    public:
+        LineIndex(std::shared_ptr<const std::string> source);
+
+        /// @brief Locate a byte offset
+        /// @param offset Byte offset into the source; clamped to the end of the buffer
+        /// @return SourceLocation
+        SourceLocation locate(uint32_t offset) const;
+
+    private:
+        std::shared_ptr<const std::string> m_source;
+        mutable std::vector<uint32_t> m_line_starts;
+        mutable std::once_flag m_built;
     };
 
+    /// @brief Which tokens the lexer produces
+    enum class LexMode
+    {
+        /// @brief Every token, including whitespace and comments (tooling, token dumps)
+        Full,
+        /// @brief Whitespace and comments are skipped without producing tokens (compilation)
+        NoTrivia,
+    };
+
+    /// @brief Struct-of-arrays token store with a read cursor.
+    /// @note Each token is stored as a type byte, a 32-bit payload, and the
+    /// 32-bit byte offset and length of its spelling in the pinned source. The
+    /// payload is the Keyword/Operator/Punctuator value, the Symbol ID of an
+    /// identifier, or for other text tokens 0 if the text is the source spelling
+    /// itself, otherwise 1 + the index of its materialized (decoded) copy.
+    /// `peek()` assembles a Token view on demand.
     class TokenList
     {
     public:
@@ -518,15 +491,64 @@ namespace jcc
 
         /// @brief Push a token to the back of the list
         /// @param token The token to push
+        /// @note Text that does not point into the pinned source is copied.
         void push_back(const Token &token);
 
         /// @brief Push a vector of tokens to the back of the list
         /// @param tokens The vector of tokens to push
         void push_back(const std::vector<Token> &tokens);
 
+        /// @brief Push a raw token entry to the back of the list
+        /// @param type The type of the token
+        /// @param payload Kind, symbol ID, or materialized text handle (see class notes)
+        /// @param offset Byte offset of the spelling in the source
+        /// @param length Byte length of the spelling in the source
+        void push_back(TokenType type, uint32_t payload, uint32_t offset, uint32_t length)
+        {
+            m_types.push_back(type);
+            m_payloads.push_back(payload);
+            m_offsets.push_back(offset);
+            m_lengths.push_back(length);
+        }
+
+        /// @brief Append another list's token, which must share this list's storage
+        /// @param other The list to copy from
+        /// @param index Index relative to `other`'s cursor
+        void push_back(const TokenList &other, size_t index);
+
         /// @brief Finish building the list
         void done();
 
+        /// @brief Reserve space for a number of tokens
+        void reserve(size_t count);
+
+        /// @brief Keep the source buffer alive for as long as this list (or a copy of it) exists
+        /// @param source The buffer that token text views point into
+        void pin_source(std::shared_ptr<const std::string> source);
+
+        /// @brief Share the source buffer and materialized strings of another list
+        /// @param other The list whose storage to share
+        void share_storage(const TokenList &other);
+
+        /// @brief Store text that does not appear verbatim in the source
+        /// @param text The decoded text
+        /// @return The payload referring to the stored copy
+        uint32_t materialize(std::string text);
+
+        /// @brief Get the pinned source buffer
+        /// @return std::string_view
+        std::string_view source() const;
+
+        /// @brief Derive the line and column of a byte offset in the source
+        /// @param offset Byte offset into the source
+        /// @return SourceLocation
+        SourceLocation locate(uint32_t offset) const;
+
+        /// @brief Derive the line and column of a token
+        /// @param index Index of the token, relative to the cursor
+        /// @return SourceLocation of the token, or of the end of the source past the last token
+        SourceLocation location(size_t index = 0) const;
+
         /// @brief Check if the list is locked
         /// @return true if the list is locked
         bool is_locked() const;
@@ -539,10 +561,32 @@ namespace jcc
         /// @return std::string
         std::string to_json() const;
 
+        /// @brief Stream the list as JSON
+        /// @param writer Writer receiving the list as one array
+        void to_json(JsonWriter &writer) const;
+
+        /// @brief Write the list to a binary `.jtok` token cache file
+        /// @param path The file to write; replaced atomically
+        /// @param key Content hash of the source the list was lexed from (up to 32 bytes)
+        /// @param mode The mode the list was lexed with
+        /// @return True if successful, false otherwise
+        /// @note The file holds the raw token arrays, so loading it is a copy
+        /// out of a mapped file. Identifier symbol IDs are not stored; they are
+        /// interned again from the source on load.
+        bool save(const std::string &path, const std::string &key, LexMode mode) const;
+
+        /// @brief Replace the list with one loaded from a `.jtok` token cache file
+        /// @param path The file to read
+        /// @param source The source the list was lexed from; it is pinned
+        /// @param key Content hash of `source`
+        /// @param mode The mode the list must have been lexed with
+        /// @return True if the file holds a valid list for `source`, false otherwise
+        bool load(const std::string &path, std::shared_ptr<const std::string> source, const std::string &key, LexMode mode);
+
         /// @brief Get the token at the specified index
-        /// @param index The index of the token
+        /// @param index The absolute index of the token
         /// @return Token
-        const Token &operator[](size_t index) const;
+        Token operator[](size_t index) const;
 
         /// @brief Pop the first token off the list
         void pop(size_t count = 1);
@@ -550,17 +594,144 @@ namespace jcc
         /// @brief Peek at a token
         /// @param index The index of the token to peek at
         /// @return Token
-        const Token &peek(size_t index = 0) const;
+        Token peek(size_t index = 0) const;
 
         /// @brief Check if the list is empty
         /// @return true if the list is empty
         bool eof() const;
 
-        /// @brief Get the size of the list
+        /// @brief Get the number of tokens left after the cursor
         /// @return size_t
         size_t size() const;
 
-        std::vector<Token> m_tokens;
+    private:
+        friend class TokenCursor;
+
+        /// @brief Assemble a view of a token without bounds checking
+        /// @param index The absolute index of the token
+        /// @return Token
+        Token token(size_t index) const;
+
+        std::vector<TokenType> m_types;
+        std::vector<uint32_t> m_payloads;
+        std::vector<uint32_t> m_offsets;
+        std::vector<uint32_t> m_lengths;
+        size_t m_pos;
+
+        std::shared_ptr<const std::string> m_source;
+        std::shared_ptr<std::deque<std::string>> m_strings;
+        std::shared_ptr<LineIndex> m_lines;
+    };
+
+    /// @brief Read cursor over the tokens of a TokenList, consumed by the parser.
+    /// @note The cursor reads the list's arrays in place; `peek()` assembles a
+    /// Token view of the entry it lands on. A list lexed without trivia is
+    /// walked directly. For one with whitespace or comments, the indices of the
+    /// other tokens are collected once, 4 bytes per token. Consuming is an
+    /// increment, and `mark()`/`rewind()` make speculative parsing free.
+    /// Peeking past the last token yields a token of type `TokenType::Unknown`.
+    class TokenCursor
+    {
+    public:
+        /// @brief Read the tokens after a list's cursor, skipping trivia
+        /// @param tokens The list; must outlive the cursor and not change while it is read
+        TokenCursor(const TokenList &tokens);
+        TokenCursor(const TokenList &&tokens) = delete;
+
+        /// @brief Read the tokens after a list's cursor, skipping trivia, sharing ownership of it
+        /// @param tokens The list; must not change while it is read
+        TokenCursor(std::shared_ptr<const TokenList> tokens);
+
+        /// @brief View a range of another cursor's tokens, e.g. to parse it on another thread
+        /// @param parent The cursor whose tokens to view; must outlive this one
+        /// @param begin Mark (see `mark()`) of the first token of the range
+        /// @param end Mark one past the last token of the range
+        TokenCursor(const TokenCursor &parent, size_t begin, size_t end);
+
+        TokenCursor(const TokenCursor &) = delete;
+        TokenCursor &operator=(const TokenCursor &) = delete;
+
+        /// @brief Consume the next token
+        /// @return Token
+        Token next()
+        {
+            Token token = peek();
+            pop();
+            return token;
+        }
+
+        /// @brief Peek at a token without consuming it
+        /// @param index The index of the token to peek at, relative to the cursor
+        /// @return Token
+        Token peek(size_t index = 0) const
+        {
+            size_t i = m_pos + index;
+            return i < m_count ? m_list->token(entry(i)) : Token();
+        }
+
+        /// @brief Consume tokens
+        /// @param count The number of tokens to consume; clamped to the tokens left
+        void pop(size_t count = 1) { m_pos = std::min(m_pos + count, m_count); }
+
+        /// @brief Check if the cursor is past the last token
+        /// @return true if no tokens are left
+        bool eof() const { return m_pos >= m_count; }
+
+        /// @brief Get the number of tokens left after the cursor
+        /// @return size_t
+        size_t size() const { return m_count - m_pos; }
+
+        /// @brief Remember the position of the cursor
+        /// @return A mark to pass to `rewind()`
+        size_t mark() const { return m_pos; }
+
+        /// @brief Move the cursor back (or forward) to a remembered position
+        /// @param mark A value returned by `mark()`
+        void rewind(size_t mark) { m_pos = mark; }
+
+        /// @brief Derive the line and column of a token
+        /// @param index Index of the token to locate, relative to the cursor
+        /// @return SourceLocation of the token, or of the end of the source past the last token
+        SourceLocation location(size_t index = 0) const { return m_list->locate(offset(index)); }
+
+        /// @brief Get the byte offset of a token in the source
+        /// @param index Index of the token, relative to the cursor
+        /// @return Offset of the token, or of the end of the source past the last token
+        uint32_t offset(size_t index = 0) const
+        {
+            size_t i = m_pos + index;
+            return i < m_count ? m_list->m_offsets[entry(i)] : m_end_offset;
+        }
+
+        /// @brief Find the first token at or after a byte offset
+        /// @param offset Byte offset in the source
+        /// @return Mark (see `mark()`) of the token, or one past the last token
+        size_t find(uint32_t offset) const;
+
+        /// @brief Get the source buffer
+        /// @return std::string_view
+        std::string_view source() const { return m_list->source(); }
+
+        /// @brief Get the list the cursor reads, which pins the source buffer and decoded text
+        /// @return TokenList to `share_storage()` with
+        const TokenList &storage() const { return *m_list; }
+
+    private:
+        const TokenList *m_list;
+        // Index in the list of each token, or nullptr if they are consecutive from `m_first`
+        const uint32_t *m_index;
+        size_t m_first;
+        size_t m_count;
+        size_t m_pos;
+        uint32_t m_end_offset;
+
+        // Owned index array; empty for a list without trivia or a view of another cursor's range
+        std::vector<uint32_t> m_index_array;
+        std::shared_ptr<const TokenList> m_owner;
+
+        size_t entry(size_t i) const { return m_index != nullptr ? m_index[i] : m_first + i; }
+
+        void init();
     };
 
     class LexerException : public std::runtime_error
@@ -5,15 +5,196 @@
 #include <vector>
 #include <memory>
 #include <map>
+#include <unordered_map>
 #include <stack>
 #include <queue>
+#include <deque>
+#include <atomic>
 #include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <exception>
+#include <stdexcept>
+#include <cstdint>
 #include <functional>
 #include <algorithm>
 #include <random>
 
 namespace jcc
 {
+    /// @brief Visit every node of a tree on several threads.
+    /// @param root The first node
+    /// @param children Called as `children(node, push)`, calls `push` on each child of a node
+    /// @param func Called once on each node, concurrently
+    /// @param threads Number of threads, including the calling one
+    /// @return Number of nodes visited
+    /// @note Each thread walks depth first through a queue of its own. Once it
+    /// runs dry it steals the oldest node of another thread's queue, the root of
+    /// the largest subtree left there, so uneven trees keep every thread busy.
+    /// A thread that finds nothing to steal sleeps until nodes are queued or
+    /// the walk ends, rather than spinning. If `func` throws, the walk stops
+    /// and the first exception is rethrown.
+    template <typename Handle, typename Children, typename Func>
+    size_t parallel_dfs(Handle root, Children &&children, Func &&func, size_t threads)
+    {
+        if (threads <= 1)
+        {
+            size_t count = 0;
+            std::vector<Handle> node_stack = {root};
+
+            while (!node_stack.empty())
+            {
+                Handle node = node_stack.back();
+                node_stack.pop_back();
+                func(node);
+                count++;
+
+                children(node, [&node_stack](Handle child)
+                         { node_stack.push_back(child); });
+            }
+
+            return count;
+        }
+
+        struct WorkQueue
+        {
+            std::mutex lock;
+            std::deque<Handle> nodes;
+        };
+
+        std::vector<WorkQueue> queues(threads);
+        queues[0].nodes.push_back(root);
+
+        // nodes queued or being visited; children are counted before their parent is done
+        std::atomic<size_t> pending = 1;
+        std::atomic<size_t> visited = 0;
+        std::atomic<bool> failed = false;
+        std::exception_ptr error;
+        std::mutex error_lock;
+
+        // nodes in the queues, and the threads asleep waiting for some
+        std::atomic<size_t> queued = 1;
+        std::atomic<size_t> sleepers = 0;
+        std::mutex idle_lock;
+        std::condition_variable idle;
+
+        // a sleeper counts itself before checking `queued`, `pending` and `failed`,
+        // and these are changed before `sleepers` is read, so no wakeup is lost
+        auto wake = [&]()
+        {
+            if (sleepers != 0)
+            {
+                std::lock_guard<std::mutex> guard(idle_lock);
+                idle.notify_all();
+            }
+        };
+
+        auto work = [&](size_t self)
+        {
+            std::vector<Handle> found;
+            size_t count = 0;
+
+            while (pending != 0 && !failed)
+            {
+                Handle node{};
+                bool have = false;
+
+                {
+                    std::lock_guard<std::mutex> guard(queues[self].lock);
+                    if (!queues[self].nodes.empty())
+                    {
+                        node = queues[self].nodes.back();
+                        queues[self].nodes.pop_back();
+                        queued--;
+                        have = true;
+                    }
+                }
+
+                for (size_t i = 1; !have && i < threads; i++)
+                {
+                    WorkQueue &victim = queues[(self + i) % threads];
+                    std::lock_guard<std::mutex> guard(victim.lock);
+                    if (!victim.nodes.empty())
+                    {
+                        node = victim.nodes.front();
+                        victim.nodes.pop_front();
+                        queued--;
+                        have = true;
+                    }
+                }
+
+                if (!have)
+                {
+                    std::unique_lock<std::mutex> guard(idle_lock);
+                    sleepers++;
+                    idle.wait(guard, [&]()
+                              { return queued != 0 || pending == 0 || failed; });
+                    sleepers--;
+                    continue;
+                }
+
+                try
+                {
+                    func(node);
+                    found.clear();
+                    children(node, [&found](Handle child)
+                             { found.push_back(child); });
+                }
+                catch (...)
+                {
+                    std::lock_guard<std::mutex> guard(error_lock);
+                    if (!error)
+                    {
+                        error = std::current_exception();
+                    }
+                    failed = true;
+                    wake();
+                    break;
+                }
+
+                count++;
+
+                if (!found.empty())
+                {
+                    pending += found.size();
+                    {
+                        std::lock_guard<std::mutex> guard(queues[self].lock);
+                        queues[self].nodes.insert(queues[self].nodes.end(), found.begin(), found.end());
+                        queued += found.size();
+                    }
+                    wake();
+                }
+
+                if (--pending == 0)
+                {
+                    wake();
+                }
+            }
+
+            visited += count;
+        };
+
+        std::vector<std::thread> workers;
+        for (size_t i = 1; i < threads; i++)
+        {
+            workers.emplace_back(work, i);
+        }
+
+        work(0);
+
+        for (auto &worker : workers)
+        {
+            worker.join();
+        }
+
+        if (error)
+        {
+            std::rethrow_exception(error);
+        }
+
+        return visited;
+    }
+
     template <typename T>
     class Node
     {
@@ -107,7 +288,6 @@ namespace jcc
         /// @param newname. Unique name of the child. If empty, name is autogenerated
         void add_child(const Node &child, const std::string &newname = "")
         {
-            auto us = std::make_shared<Node>(*this);
             auto new_child = std::make_shared<Node>(child);
 
             if (newname.empty() && child.m_name.empty())
@@ -143,30 +323,16 @@ namespace jcc
         /// @return true if the child was removed. false if doesn't exist
         bool remove_child(const std::string &name)
         {
-            std::stack<Node *> node_stack;
-            node_stack.push(this); // Start with the current node
-
-            while (!node_stack.empty())
+            auto it = this->m_children_named.find(name);
+            if (it == this->m_children_named.end())
             {
-                Node *current = node_stack.top();
-                node_stack.pop();
-
-                if (current->m_name == name)
-                {
-                    this->m_children_named.erase(name);
-                    this->m_children.erase(std::find_if(this->m_children.begin(), this->m_children.end(), [&](const std::shared_ptr<Node> &node)
-                                                        { return node->m_name == name; }));
-
-                    return true;
-                }
-
-                for (const auto &child : current->m_children)
-                {
-                    node_stack.push(child.get()); // Add children to the stack to visit later
-                }
+                return false;
             }
 
-            return false;
+            this->m_children.erase(std::find(this->m_children.begin(), this->m_children.end(), it->second));
+            this->m_children_named.erase(it);
+
+            return true;
         }
 
         /// @brief Remove a child by index
@@ -370,92 +536,119 @@ namespace jcc
         ///=================================================================
 
         /// @brief Depth first search
-        /// @param func The predicate function to use
-        /// @param node The resulting node
-        /// @return true if found, false if not found
-        bool find_dfs(std::function<bool(const Node &)> func, Node &node) const
+        /// @param func The predicate to use, called as `bool(const Node &)`
+        /// @return The first node found, or nullptr if not found
+        template <typename Pred>
+        const Node *find_dfs(Pred &&func) const
         {
-            std::stack<const Node *> node_stack;
-            node_stack.push(this); // Start with the current node
+            std::vector<const Node *> node_stack = {this}; // Start with the current node
 
             while (!node_stack.empty())
             {
-                const Node *current = node_stack.top();
-                node_stack.pop();
+                const Node *current = node_stack.back();
+                node_stack.pop_back();
 
                 if (func(*current))
                 {
-                    node = *current;
-                    return true;
+                    return current;
                 }
 
                 for (const auto &child : current->m_children)
                 {
-                    node_stack.push(child.get()); // Add children to the stack to visit later
+                    node_stack.push_back(child.get()); // Add children to the stack to visit later
                 }
             }
 
-            return false;
+            return nullptr;
         }
 
-        /// @brief Breadth first search
-        /// @param func The predicate function to use
+        /// @brief Depth first search
+        /// @param func The predicate to use, called as `bool(const Node &)`
         /// @param node The resulting node
         /// @return true if found, false if not found
-        bool find_bfs(std::function<bool(const Node &)> func, Node &node) const
+        template <typename Pred>
+        bool find_dfs(Pred &&func, Node &node) const
         {
-            std::queue<const Node *> node_queue;
-            node_queue.push(this); // Start with the current node
-
-            while (!node_queue.empty())
+            const Node *found = this->find_dfs(std::forward<Pred>(func));
+            if (found == nullptr)
             {
-                const Node *current = node_queue.front();
-                node_queue.pop();
+                return false;
+            }
 
-                if (func(*current))
+            node = *found;
+            return true;
+        }
+
+        /// @brief Breadth first search
+        /// @param func The predicate to use, called as `bool(const Node &)`
+        /// @return The first node found, or nullptr if not found
+        template <typename Pred>
+        const Node *find_bfs(Pred &&func) const
+        {
+            std::vector<const Node *> node_queue = {this}; // Start with the current node
+
+            for (size_t i = 0; i < node_queue.size(); i++)
+            {
+                if (func(*node_queue[i]))
                 {
-                    node = *current;
-                    return true;
+                    return node_queue[i];
                 }
 
-                for (const auto &child : current->m_children)
+                for (const auto &child : node_queue[i]->m_children)
                 {
-                    node_queue.push(child.get()); // Add children to the queue to visit later
+                    node_queue.push_back(child.get()); // Add children to the queue to visit later
                 }
             }
 
-            return false;
+            return nullptr;
+        }
+
+        /// @brief Breadth first search
+        /// @param func The predicate to use, called as `bool(const Node &)`
+        /// @param node The resulting node
+        /// @return true if found, false if not found
+        template <typename Pred>
+        bool find_bfs(Pred &&func, Node &node) const
+        {
+            const Node *found = this->find_bfs(std::forward<Pred>(func));
+            if (found == nullptr)
+            {
+                return false;
+            }
+
+            node = *found;
+            return true;
         }
 
         /// @brief Find shortest path to a node
         /// @param name The name of the node to search for
-        /// @param path The resulting path
+        /// @param path The resulting path, from this node to the one found
         /// @return true if found, false if not found
-        bool find_path(const std::string &name, std::vector<Node> &path) const
+        bool find_path(const std::string &name, std::vector<const Node *> &path) const
         {
-            std::queue<std::pair<const Node *, std::vector<Node>>> node_queue;
-            node_queue.push({this, {}}); // Start with the current node and an empty path
+            // each visited node keeps the index of its parent, so no path is copied until one is found
+            std::vector<std::pair<const Node *, size_t>> visited = {{this, SIZE_MAX}}; // Start with the current node
 
-            while (!node_queue.empty())
+            for (size_t i = 0; i < visited.size(); i++)
             {
-                const Node *current = node_queue.front().first;
-                std::vector<Node> current_path = node_queue.front().second;
-                node_queue.pop();
-
-                // Update the current path with the current node
-                current_path.push_back(*current);
+                const Node *current = visited[i].first;
 
                 if (current->m_name == name)
                 {
-                    path = std::move(current_path); // Assign the found path
+                    path.clear();
+                    for (size_t j = i; j != SIZE_MAX; j = visited[j].second)
+                    {
+                        path.push_back(visited[j].first);
+                    }
+                    std::reverse(path.begin(), path.end());
                     return true;
                 }
 
                 for (const auto &child : current->m_children)
                 {
                     if (child)
-                    {                                                 // Check if child is not null
-                        node_queue.push({child.get(), current_path}); // Add child with updated path
+                    {                                      // Check if child is not null
+                        visited.push_back({child.get(), i}); // Add child with its parent's index
                     }
                 }
             }
@@ -463,6 +656,27 @@ namespace jcc
             return false;
         }
 
+        /// @brief Find shortest path to a node
+        /// @param name The name of the node to search for
+        /// @param path The resulting path
+        /// @return true if found, false if not found
+        bool find_path(const std::string &name, std::vector<Node> &path) const
+        {
+            std::vector<const Node *> found;
+            if (!this->find_path(name, found))
+            {
+                return false;
+            }
+
+            path.clear();
+            for (const Node *node : found)
+            {
+                path.push_back(*node);
+            }
+
+            return true;
+        }
+
         /// @brief Calculate distance between two nodes
         /// @param node other node
         /// @return size_t
@@ -476,7 +690,7 @@ namespace jcc
         /// @return size_t
         ssize_t distance(const std::string &name) const
         {
-            std::vector<Node> path;
+            std::vector<const Node *> path;
             if (!this->find_path(name, path))
             {
                 return -1;
@@ -506,23 +720,23 @@ namespace jcc
         }
 
         /// @brief Depth first traversal
-        /// @param func The function to call on each node
-        size_t traverse_dfs(std::function<void(Node &)> func)
+        /// @param func The function to call on each node, as `void(Node &)`
+        template <typename Func>
+        size_t traverse_dfs(Func &&func)
         {
             size_t count = 0;
-            std::stack<Node *> node_stack;
-            node_stack.push(this); // Start with the current node
+            std::vector<Node *> node_stack = {this}; // Start with the current node
 
             while (!node_stack.empty())
             {
-                Node *current = node_stack.top();
-                node_stack.pop();
+                Node *current = node_stack.back();
+                node_stack.pop_back();
                 func(*current);
                 count++; // Increment count for each node visited
 
                 for (const auto &child : current->m_children)
                 {
-                    node_stack.push(child.get()); // Add children to the stack to visit later
+                    node_stack.push_back(child.get()); // Add children to the stack to visit later
                 }
             }
 
@@ -530,27 +744,45 @@ namespace jcc
         }
 
         /// @brief Breadth first traversal
-        /// @param func The function to call on each node
-        size_t traverse_bfs(std::function<void(Node &)> func)
+        /// @param func The function to call on each node, as `void(Node &)`
+        template <typename Func>
+        size_t traverse_bfs(Func &&func)
         {
-            size_t count = 0;
-            std::queue<Node *> node_queue;
-            node_queue.push(this); // Start with the current node
+            std::vector<Node *> node_queue = {this}; // Start with the current node
 
-            while (!node_queue.empty())
+            for (size_t i = 0; i < node_queue.size(); i++)
             {
-                Node *current = node_queue.front();
-                node_queue.pop();
-                func(*current);
-                count++; // Increment count for each node visited
+                func(*node_queue[i]);
 
-                for (const auto &child : current->m_children)
+                for (const auto &child : node_queue[i]->m_children)
                 {
-                    node_queue.push(child.get()); // Add children to the queue to visit later
+                    node_queue.push_back(child.get()); // Add children to the queue to visit later
                 }
             }
 
-            return count;
+            return node_queue.size();
+        }
+
+        /// @brief Depth first traversal on several threads, which steal work from each other
+        /// @param func The function to call on each node, as `void(Node &)`; called concurrently
+        /// @param threads Number of threads, the number of cores by default
+        /// @return Number of nodes visited
+        /// @note Nodes are visited in no particular order. The tree must not change
+        /// shape during the traversal. If `func` throws, the traversal stops and the
+        /// first exception is rethrown.
+        template <typename Func>
+        size_t parallel_for_each_dfs(Func &&func, size_t threads = std::thread::hardware_concurrency())
+        {
+            return parallel_dfs<Node *>(
+                this, [](Node *node, auto &&push)
+                {
+                    for (const auto &child : node->m_children)
+                    {
+                        push(child.get());
+                    } },
+                [&func](Node *node)
+                { func(*node); },
+                threads);
         }
 
         ///=================================================================
@@ -727,14 +959,14 @@ namespace jcc
 
         std::string findpath_string(const std::string &name) const
         {
-            std::vector<Node> path;
+            std::vector<const Node *> path;
             std::string path_string = "";
 
             if (this->find_path(name, path))
             {
-                for (const auto &node : path)
+                for (const Node *node : path)
                 {
-                    path_string += node.m_name + " -> ";
+                    path_string += node->m_name + " -> ";
                 }
 
                 if (path_string.size() > 4)
@@ -756,11 +988,9 @@ namespace jcc
 
         std::string autogenerate_name()
         {
-            static int i = 0;
-            static std::mutex m;
+            static std::atomic<uint64_t> i = 0;
 
-            std::lock_guard<std::mutex> lock(m);
-            std::string n = std::to_string(i++);
+            std::string n = std::to_string(i.fetch_add(1, std::memory_order_relaxed));
 
             return n == "0" ? "root" : n;
         }
@@ -840,6 +1070,400 @@ namespace jcc
             return output;
         }
     };
+
+    /// @brief A tree of values stored flat, for graphs too large for `Node`.
+    /// @note Nodes are addressed by index, the root being 0, and are stored in
+    /// the order they are added. The links between nodes are indices held apart
+    /// from the values and names, so traversals walk one contiguous array and
+    /// need no recursion. Names are optional and unique across the tree; a node
+    /// added without one is only addressed by index, and adding it allocates
+    /// nothing once `reserve` made room. Nodes are never removed.
+    template <typename T>
+    class FlatTree
+    {
+    public:
+        typedef uint32_t Index;
+
+        /// @brief Index of no node
+        static constexpr Index npos = UINT32_MAX;
+
+        ///=================================================================
+        /// Constructors & Destructors
+        ///=================================================================
+
+        /// @brief Construct a tree holding only its root
+        /// @param value T of the root
+        /// @param name Name of the root
+        FlatTree(T value = T(), const std::string &name = "root") { this->add(npos, std::move(value), name); }
+
+        /// @brief Make room for nodes
+        /// @param count Total number of nodes the tree will hold
+        void reserve(size_t count)
+        {
+            this->m_links.reserve(count);
+            this->m_values.reserve(count);
+            this->m_names.reserve(count);
+        }
+
+        ///=================================================================
+        /// Getters & Setters
+        ///=================================================================
+
+        /// @brief Get the number of nodes in the tree
+        /// @return size_t
+        size_t size() const { return this->m_links.size(); }
+
+        const T &value(Index node) const { return this->m_values[node]; }
+        T &value(Index node) { return this->m_values[node]; }
+
+        /// @brief Get the name of a node
+        /// @return std::string, empty if the node was added without a name
+        const std::string &name(Index node) const { return this->m_names[node]; }
+
+        /// @return Index of the parent, or npos for the root
+        Index parent(Index node) const { return this->m_links[node].parent; }
+
+        /// @return Index of the first child, or npos if the node has no children
+        Index first_child(Index node) const { return this->m_links[node].first_child; }
+
+        /// @return Index of the next child of the node's parent, or npos if it is the last
+        Index next_sibling(Index node) const { return this->m_links[node].next_sibling; }
+
+        ///=================================================================
+        /// Manage children
+        ///=================================================================
+
+        /// @brief Add a child after the existing children of a node
+        /// @param parent Index of the parent
+        /// @param value T of the child
+        /// @param name Unique name of the child, or empty to address it by index only
+        /// @return Index of the child
+        /// @note Throws std::invalid_argument if the name is taken
+        Index add_child(Index parent, T value, const std::string &name = "")
+        {
+            if (parent >= this->m_links.size())
+            {
+                throw std::out_of_range("Parent node does not exist");
+            }
+
+            return this->add(parent, std::move(value), name);
+        }
+
+        /// @brief Find a node by name
+        /// @param name The unique name of the node
+        /// @return Index of the node, or npos if no node has the name
+        Index find(const std::string &name) const
+        {
+            auto it = this->m_named.find(name);
+            return it == this->m_named.end() ? npos : it->second;
+        }
+
+        /// @brief Get a child by name
+        /// @param parent Index of the parent
+        /// @param name The unique name of the child
+        /// @return Index of the child, or npos if the parent has no child of that name
+        Index child(Index parent, const std::string &name) const
+        {
+            Index node = this->find(name);
+            return node != npos && this->m_links[node].parent == parent ? node : npos;
+        }
+
+        /// @brief Check if a node exists by name
+        /// @param name The unique name of the node
+        /// @return true if the node exists, false if doesn't exist
+        bool exists(const std::string &name) const { return this->m_named.contains(name); }
+
+        /// @brief Check if a node has no children
+        /// @return true if empty, false if not empty
+        bool is_empty(Index node) const { return this->m_links[node].first_child == npos; }
+
+        /// @brief Count the nodes of a subtree
+        /// @param from Root of the subtree
+        /// @return size_t
+        size_t count(Index from = 0) const
+        {
+            if (from == 0)
+            {
+                return this->m_links.size();
+            }
+
+            size_t count = 0;
+            for (Index node = from; node != npos; node = this->next_dfs(node, from))
+            {
+                count++;
+            }
+
+            return count;
+        }
+
+        ///=================================================================
+        /// Traversal
+        ///=================================================================
+
+        /// @brief Depth first search
+        /// @param func The predicate to use, called as `bool(Index)`
+        /// @param node The resulting node
+        /// @param from Root of the subtree to search
+        /// @return true if found, false if not found
+        template <typename Pred>
+        bool find_dfs(Pred &&func, Index &node, Index from = 0) const
+        {
+            for (Index current = from; current != npos; current = this->next_dfs(current, from))
+            {
+                if (func(current))
+                {
+                    node = current;
+                    return true;
+                }
+            }
+
+            return false;
+        }
+
+        /// @brief Breadth first search
+        /// @param func The predicate to use, called as `bool(Index)`
+        /// @param node The resulting node
+        /// @param from Root of the subtree to search
+        /// @return true if found, false if not found
+        template <typename Pred>
+        bool find_bfs(Pred &&func, Index &node, Index from = 0) const
+        {
+            std::vector<Index> queue = {from};
+
+            for (size_t i = 0; i < queue.size(); i++)
+            {
+                if (func(queue[i]))
+                {
+                    node = queue[i];
+                    return true;
+                }
+
+                for (Index child = this->m_links[queue[i]].first_child; child != npos; child = this->m_links[child].next_sibling)
+                {
+                    queue.push_back(child);
+                }
+            }
+
+            return false;
+        }
+
+        /// @brief Find the path to a node
+        /// @param name The name of the node to search for
+        /// @param path The resulting path, from `from` to the node
+        /// @param from Node the path starts at
+        /// @return true if the node is in the subtree of `from`, false if not
+        bool find_path(const std::string &name, std::vector<Index> &path, Index from = 0) const
+        {
+            // a tree has one path between two nodes: the target's ancestors
+            path.clear();
+            for (Index node = this->find(name); node != npos; node = this->m_links[node].parent)
+            {
+                path.push_back(node);
+
+                if (node == from)
+                {
+                    std::reverse(path.begin(), path.end());
+                    return true;
+                }
+            }
+
+            path.clear();
+            return false;
+        }
+
+        /// @brief Calculate the distance from a node to one below it
+        /// @param name The name of the other node
+        /// @param from The upper node
+        /// @return Number of edges, or -1 if the node is not in the subtree of `from`
+        ssize_t distance(const std::string &name, Index from = 0) const
+        {
+            Index node = this->find(name);
+            return node == npos ? -1 : this->distance(node, from);
+        }
+
+        /// @brief Calculate the distance from a node to one below it
+        /// @param node Index of the other node
+        /// @param from The upper node
+        /// @return Number of edges, or -1 if the node is not in the subtree of `from`
+        ssize_t distance(Index node, Index from = 0) const
+        {
+            for (ssize_t distance = 0; node != npos; distance++)
+            {
+                if (node == from)
+                {
+                    return distance;
+                }
+                node = this->m_links[node].parent;
+            }
+
+            return -1;
+        }
+
+        /// @brief Get the depth of a subtree
+        /// @param from Root of the subtree
+        /// @return Number of edges on the longest path down from `from`
+        size_t depth(Index from = 0) const
+        {
+            size_t depth = 0, max_depth = 0;
+            Index node = from;
+
+            while (true)
+            {
+                max_depth = std::max(max_depth, depth);
+
+                if (this->m_links[node].first_child != npos)
+                {
+                    node = this->m_links[node].first_child;
+                    depth++;
+                    continue;
+                }
+
+                while (node != from && this->m_links[node].next_sibling == npos)
+                {
+                    node = this->m_links[node].parent;
+                    depth--;
+                }
+
+                if (node == from)
+                {
+                    return max_depth;
+                }
+
+                node = this->m_links[node].next_sibling;
+            }
+        }
+
+        /// @brief Depth first traversal, children in the order they were added
+        /// @param func The function to call on each node, as `void(Index)`
+        /// @param from Root of the subtree to traverse
+        /// @return Number of nodes visited
+        template <typename Func>
+        size_t traverse_dfs(Func &&func, Index from = 0) const
+        {
+            size_t count = 0;
+            for (Index node = from; node != npos; node = this->next_dfs(node, from))
+            {
+                func(node);
+                count++;
+            }
+
+            return count;
+        }
+
+        /// @brief Breadth first traversal
+        /// @param func The function to call on each node, as `void(Index)`
+        /// @param from Root of the subtree to traverse
+        /// @return Number of nodes visited
+        template <typename Func>
+        size_t traverse_bfs(Func &&func, Index from = 0) const
+        {
+            std::vector<Index> queue = {from};
+
+            for (size_t i = 0; i < queue.size(); i++)
+            {
+                func(queue[i]);
+
+                for (Index child = this->m_links[queue[i]].first_child; child != npos; child = this->m_links[child].next_sibling)
+                {
+                    queue.push_back(child);
+                }
+            }
+
+            return queue.size();
+        }
+
+        /// @brief Depth first traversal on several threads, which steal work from each other
+        /// @param func The function to call on each node, as `void(Index)`; called concurrently
+        /// @param from Root of the subtree to traverse
+        /// @param threads Number of threads, the number of cores by default
+        /// @return Number of nodes visited
+        /// @note Nodes are visited in no particular order. No nodes may be added
+        /// during the traversal. If `func` throws, the traversal stops and the
+        /// first exception is rethrown.
+        template <typename Func>
+        size_t parallel_for_each_dfs(Func &&func, Index from = 0, size_t threads = std::thread::hardware_concurrency()) const
+        {
+            return parallel_dfs<Index>(
+                from, [this](Index node, auto &&push)
+                {
+                    for (Index child = this->m_links[node].first_child; child != npos; child = this->m_links[child].next_sibling)
+                    {
+                        push(child);
+                    } },
+                func, threads);
+        }
+
+    protected:
+        struct Links
+        {
+            Index parent;
+            Index first_child;
+            Index last_child;
+            Index next_sibling;
+        };
+
+        std::vector<Links> m_links;
+        std::vector<T> m_values;
+        std::vector<std::string> m_names;
+        std::unordered_map<std::string, Index> m_named;
+
+        Index add(Index parent, T value, const std::string &name)
+        {
+            if (this->m_links.size() >= npos)
+            {
+                throw std::length_error("Tree has too many nodes");
+            }
+
+            Index index = static_cast<Index>(this->m_links.size());
+
+            if (!name.empty() && !this->m_named.emplace(name, index).second)
+            {
+                throw std::invalid_argument("Node name '" + name + "' is not unique");
+            }
+
+            this->m_links.push_back({parent, npos, npos, npos});
+            this->m_values.push_back(std::move(value));
+            this->m_names.push_back(name);
+
+            if (parent != npos)
+            {
+                Links &links = this->m_links[parent];
+                if (links.last_child == npos)
+                {
+                    links.first_child = index;
+                }
+                else
+                {
+                    this->m_links[links.last_child].next_sibling = index;
+                }
+                links.last_child = index;
+            }
+
+            return index;
+        }
+
+        /// @brief Get the node after another in a depth first walk of a subtree
+        /// @param node The current node
+        /// @param from Root of the subtree
+        /// @return Index of the next node, or npos once the subtree is done
+        Index next_dfs(Index node, Index from) const
+        {
+            if (this->m_links[node].first_child != npos)
+            {
+                return this->m_links[node].first_child;
+            }
+
+            for (; node != from; node = this->m_links[node].parent)
+            {
+                if (this->m_links[node].next_sibling != npos)
+                {
+                    return this->m_links[node].next_sibling;
+                }
+            }
+
+            return npos;
+        }
+    };
 } // namespace jcc
 
 namespace std
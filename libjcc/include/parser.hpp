@@ -8,6 +8,8 @@
 #include <variant>
 #include <memory>
 #include "lexer.hpp"
+#include "arena.hpp"
+#include "json.hpp"
 
 namespace jcc
 {
@@ -62,10 +64,12 @@ namespace jcc
         ///===================
         BinaryExpression,
         UnaryExpression,
+        TernaryExpression,
         CastExpression,
         NullExpression,
         LiteralExpression,
         CallExpression,
+        IdentifierExpression,
         StringLiteralExpression,
         CharLiteralExpression,
         IntegerLiteralExpression,
@@ -95,13 +99,21 @@ namespace jcc
 
         NodeType type() const { return m_type; }
 
-        virtual std::string to_string() const { return "GenericNode()"; }
-        virtual std::string to_json() const { return "{\"type\":\"generic_node\"}"; }
+        /// @brief Print the node and its children for debugging
+        /// @return std::string
+        /// @note Printing is a `ConstNodeVisitor` pass (see visitor.hpp), not a virtual call per node
+        std::string to_string() const;
+
+        /// @brief Serialize the node and its children to JSON
+        /// @return std::string
+        std::string to_json() const;
+
+        /// @brief Stream the node and its children as JSON
+        /// @param writer Writer receiving the node as one value
+        void to_json(JsonWriter &writer) const;
 
     protected:
         NodeType m_type;
-
-        std::string json_escape(const std::string &str) const;
     };
 
     class Expression;
@@ -110,11 +122,11 @@ namespace jcc
     {
     public:
         TypeNode(NodeType type = NodeType::TypeNode) : GenericNode(type) {}
-        TypeNode(const std::string &name, bool is_const, bool is_reference, size_t arr_size, size_t bitfield, std::shared_ptr<Expression> default_value) : GenericNode(NodeType::TypeNode), m_name(name), m_is_const(is_const), m_is_reference(is_reference), m_arr_size(arr_size), m_bitfield(bitfield), m_default_value(default_value) {}
+        TypeNode(Symbol name, bool is_const, bool is_reference, size_t arr_size, size_t bitfield, Expression *default_value) : GenericNode(NodeType::TypeNode), m_name(name), m_is_const(is_const), m_is_reference(is_reference), m_arr_size(arr_size), m_bitfield(bitfield), m_default_value(default_value) {}
         virtual ~TypeNode() {}
 
-        const std::string &name() const { return m_name; }
-        std::string &name() { return m_name; }
+        const Symbol &name() const { return m_name; }
+        Symbol &name() { return m_name; }
 
         const bool &is_const() const { return m_is_const; }
         bool &is_const() { return m_is_const; }
@@ -128,19 +140,16 @@ namespace jcc
         const size_t &bitfield() const { return m_bitfield; }
         size_t &bitfield() { return m_bitfield; }
 
-        const std::shared_ptr<Expression> &default_value() const { return m_default_value; }
-        std::shared_ptr<Expression> &default_value() { return m_default_value; }
-
-        std::string to_string() const override { return "TypeNode(" + m_name + ")"; }
-        std::string to_json() const override;
+        Expression *default_value() const { return m_default_value; }
+        Expression *&default_value() { return m_default_value; }
 
     protected:
-        std::string m_name;
+        Symbol m_name;
         bool m_is_const;
         bool m_is_reference;
         size_t m_arr_size;
         size_t m_bitfield;
-        std::shared_ptr<Expression> m_default_value;
+        Expression *m_default_value = nullptr;
     };
 
     class RawNode : public GenericNode
@@ -153,9 +162,6 @@ namespace jcc
         const std::string &value() const { return m_value; }
         std::string &value() { return m_value; }
 
-        std::string to_string() const override { return "RawNode(" + m_value + ")"; }
-        std::string to_json() const override { return "{\"type\":\"raw_node\",\"value\":\"" + json_escape(m_value) + "\"}"; }
-
     protected:
         std::string m_value;
     };
@@ -165,9 +171,6 @@ namespace jcc
     public:
         Expression(NodeType type = NodeType::Expression) : GenericNode(type) {}
         virtual ~Expression() {}
-
-        std::string to_string() const override { return "Expression()"; }
-        std::string to_json() const override { return "{\"type\":\"expression\"}"; }
     };
 
     class Statement : public GenericNode
@@ -175,9 +178,6 @@ namespace jcc
     public:
         Statement(NodeType type = NodeType::Statement) : GenericNode(type) {}
         virtual ~Statement() {}
-
-        std::string to_string() const override { return "Statement()"; }
-        std::string to_json() const override { return "{\"type\":\"statement\"}"; }
     };
 
     class Declaration : public GenericNode
@@ -185,9 +185,6 @@ namespace jcc
     public:
         Declaration(NodeType type = NodeType::Declaration) : GenericNode(type) {}
         virtual ~Declaration() {}
-
-        std::string to_string() const override { return "Declaration()"; }
-        std::string to_json() const override { return "{\"type\":\"declaration\"}"; }
     };
 
     class Definition : public GenericNode
@@ -195,30 +192,24 @@ namespace jcc
     public:
         Definition(NodeType type = NodeType::Definition) : GenericNode(type) {}
         virtual ~Definition() {}
-
-        std::string to_string() const override { return "Definition()"; }
-        std::string to_json() const override { return "{\"type\":\"definition\"}"; }
     };
 
     class Block : public GenericNode
     {
     public:
         Block(NodeType type = NodeType::Block) : GenericNode(type), m_render_braces(true) {}
-        Block(const std::vector<std::shared_ptr<GenericNode>> &children, bool render_braces = true) : GenericNode(NodeType::Block), m_children(children), m_render_braces(render_braces) {}
+        Block(const NodeList<GenericNode> &children, bool render_braces = true) : GenericNode(NodeType::Block), m_children(children), m_render_braces(render_braces) {}
         virtual ~Block() {}
 
-        const std::vector<std::shared_ptr<GenericNode>> &children() const { return m_children; }
-        std::vector<std::shared_ptr<GenericNode>> &children() { return m_children; }
+        const NodeList<GenericNode> &children() const { return m_children; }
+        NodeList<GenericNode> &children() { return m_children; }
         const bool &render_braces() const { return m_render_braces; }
         bool &render_braces() { return m_render_braces; }
 
-        void push(std::shared_ptr<GenericNode> node) { m_children.push_back(node); }
-
-        std::string to_string() const override;
-        std::string to_json() const override;
+        void push(GenericNode *node) { m_children.push_back(node); }
 
     protected:
-        std::vector<std::shared_ptr<GenericNode>> m_children;
+        NodeList<GenericNode> m_children;
         bool m_render_braces;
     };
 
@@ -249,9 +240,6 @@ namespace jcc
         /// @return Name of the type
         std::string &type_name() { return m_typename; }
 
-        std::string to_string() const override { return "TypeDeclaration(" + m_alias + ", " + m_typename + ")"; }
-        std::string to_json() const override { return "{\"type\":\"type_declaration\",\"alias\":\"" + json_escape(m_alias) + "\",\"typename\":\"" + json_escape(m_typename) + "\"}"; }
-
     protected:
         std::string m_alias;
         std::string m_typename;
@@ -267,9 +255,6 @@ namespace jcc
         const std::string &name() const { return m_name; }
         std::string &name() { return m_name; }
 
-        std::string to_string() const override;
-        std::string to_json() const override;
-
     protected:
         std::string m_name;
     };
@@ -284,10 +269,6 @@ namespace jcc
         const std::string &name() const { return m_name; }
         std::string &name() { return m_name; }
 
-        std::string to_string() const override;
-
-        std::string to_json() const override;
-
     protected:
         std::string m_name;
     };
@@ -302,10 +283,6 @@ namespace jcc
         const std::string &name() const { return m_name; }
         std::string &name() { return m_name; }
 
-        std::string to_string() const override;
-
-        std::string to_json() const override;
-
     protected:
         std::string m_name;
     };
@@ -314,24 +291,21 @@ namespace jcc
     {
     public:
         FunctionParameter(NodeType type = NodeType::FunctionParameter) : GenericNode(type), m_arr_size(0), m_is_const(false), m_is_reference(false) {}
-        FunctionParameter(const std::string &name, const std::string &type, const std::shared_ptr<Expression> &default_value, uint64_t arr_size = 0, bool is_const = false, bool is_reference = false) : GenericNode(NodeType::FunctionParameter), m_name(name), m_type(type), m_arr_size(arr_size), m_default_value(default_value), m_is_const(is_const), m_is_reference(is_reference) {}
+        FunctionParameter(Symbol name, Symbol type, Expression *default_value, uint64_t arr_size = 0, bool is_const = false, bool is_reference = false) : GenericNode(NodeType::FunctionParameter), m_name(name), m_type(type), m_arr_size(arr_size), m_default_value(default_value), m_is_const(is_const), m_is_reference(is_reference) {}
         virtual ~FunctionParameter() {}
 
-        const std::string &name() const { return m_name; }
-        std::string &name() { return m_name; }
+        const Symbol &name() const { return m_name; }
+        Symbol &name() { return m_name; }
 
-        const std::string &type() const { return m_type; }
-        std::string &type() { return m_type; }
+        const Symbol &type() const { return m_type; }
+        Symbol &type() { return m_type; }
 
-        const std::shared_ptr<Expression> &default_value() const { return m_default_value; }
-        std::shared_ptr<Expression> &default_value() { return m_default_value; }
+        Expression *default_value() const { return m_default_value; }
+        Expression *&default_value() { return m_default_value; }
 
         const uint64_t &arr_size() const { return m_arr_size; }
         uint64_t &arr_size() { return m_arr_size; }
 
-        std::string to_string() const override;
-        std::string to_json() const override;
-
         const bool &is_const() const { return m_is_const; }
         bool &is_const() { return m_is_const; }
 
@@ -339,10 +313,10 @@ namespace jcc
         bool &is_reference() { return m_is_reference; }
 
     protected:
-        std::string m_name;
-        std::string m_type;
+        Symbol m_name;
+        Symbol m_type;
         uint64_t m_arr_size;
-        std::shared_ptr<Expression> m_default_value;
+        Expression *m_default_value = nullptr;
         bool m_is_const;
         bool m_is_reference;
     };
@@ -351,7 +325,7 @@ namespace jcc
     {
     public:
         FunctionDeclaration(NodeType type = NodeType::FunctionDeclaration) : Declaration(type), m_return_arr_size(0) {}
-        FunctionDeclaration(const std::string &name, const std::string &return_type, std::vector<std::shared_ptr<FunctionParameter>> parameters, uint64_t return_arr_size = 0) : Declaration(NodeType::FunctionDeclaration), m_return_type(return_type), m_parameters(parameters), m_name(name), m_return_arr_size(return_arr_size) {}
+        FunctionDeclaration(const std::string &name, const std::string &return_type, NodeList<FunctionParameter> parameters, uint64_t return_arr_size = 0) : Declaration(NodeType::FunctionDeclaration), m_return_type(return_type), m_parameters(parameters), m_name(name), m_return_arr_size(return_arr_size) {}
         virtual ~FunctionDeclaration() {}
 
         const std::string &return_type() const { return m_return_type; }
@@ -360,18 +334,15 @@ namespace jcc
         const uint64_t &return_arr_size() const { return m_return_arr_size; }
         uint64_t &return_arr_size() { return m_return_arr_size; }
 
-        const std::vector<std::shared_ptr<FunctionParameter>> &parameters() const { return m_parameters; }
-        std::vector<std::shared_ptr<FunctionParameter>> &parameters() { return m_parameters; }
+        const NodeList<FunctionParameter> &parameters() const { return m_parameters; }
+        NodeList<FunctionParameter> &parameters() { return m_parameters; }
 
         const std::string &name() const { return m_name; }
         std::string &name() { return m_name; }
 
-        std::string to_string() const override;
-        std::string to_json() const override;
-
     protected:
         std::string m_return_type;
-        std::vector<std::shared_ptr<FunctionParameter>> m_parameters;
+        NodeList<FunctionParameter> m_parameters;
         std::string m_name;
         uint64_t m_return_arr_size;
     };
@@ -386,9 +357,6 @@ namespace jcc
         const std::string &name() const { return m_name; }
         std::string &name() { return m_name; }
 
-        std::string to_string() const override;
-        std::string to_json() const override;
-
     protected:
         std::string m_name;
     };
@@ -397,18 +365,14 @@ namespace jcc
     {
     public:
         ExternalDeclaration(NodeType type = NodeType::ExternalDeclaration) : Declaration(type) {}
-        ExternalDeclaration(std::shared_ptr<Declaration> declaration) : Declaration(NodeType::ExternalDeclaration), m_declaration(declaration) {}
+        ExternalDeclaration(Declaration *declaration) : Declaration(NodeType::ExternalDeclaration), m_declaration(declaration) {}
         virtual ~ExternalDeclaration() {}
 
-        const std::shared_ptr<Declaration> &declaration() const { return m_declaration; }
-        std::shared_ptr<Declaration> &declaration() { return m_declaration; }
-
-        std::string to_string() const override { return "ExternalDeclaration(" + m_declaration->to_string() + ")"; }
-
-        std::string to_json() const override { return "{\"type\":\"external_declaration\",\"declaration\":" + m_declaration->to_json() + "}"; }
+        Declaration *declaration() const { return m_declaration; }
+        Declaration *&declaration() { return m_declaration; }
 
     protected:
-        std::shared_ptr<Declaration> m_declaration;
+        Declaration *m_declaration = nullptr;
     };
 
     class SubsystemDeclaration : public Declaration
@@ -424,9 +388,6 @@ namespace jcc
         const std::vector<std::string> &dependencies() const { return m_dependencies; }
         std::vector<std::string> &dependencies() { return m_dependencies; }
 
-        std::string to_string() const override { return "SubsystemDeclaration(" + m_name + ")"; }
-        std::string to_json() const override { return "{\"type\":\"subsystem_declaration\",\"name\":\"" + json_escape(m_name) + "\"}"; }
-
     protected:
         std::string m_name;
         std::vector<std::string> m_dependencies;
@@ -440,7 +401,7 @@ namespace jcc
     {
     public:
         SubsystemDefinition(NodeType type = NodeType::SubsystemDefinition) : Definition(type) {}
-        SubsystemDefinition(const std::string &name, std::shared_ptr<Block> block, const std::vector<std::string> &dependencies = {}) : Definition(NodeType::SubsystemDefinition), m_name(name), m_block(block), m_dependencies(dependencies) {}
+        SubsystemDefinition(const std::string &name, Block *block, const std::vector<std::string> &dependencies = {}) : Definition(NodeType::SubsystemDefinition), m_name(name), m_block(block), m_dependencies(dependencies) {}
         virtual ~SubsystemDefinition() {}
 
         const std::string &name() const { return m_name; }
@@ -449,15 +410,12 @@ namespace jcc
         const std::vector<std::string> &dependencies() const { return m_dependencies; }
         std::vector<std::string> &dependencies() { return m_dependencies; }
 
-        const std::shared_ptr<Block> &block() const { return m_block; }
-        std::shared_ptr<Block> &block() { return m_block; }
-
-        std::string to_string() const override;
-        std::string to_json() const override;
+        Block *block() const { return m_block; }
+        Block *&block() { return m_block; }
 
     protected:
         std::string m_name;
-        std::shared_ptr<Block> m_block;
+        Block *m_block = nullptr;
         std::vector<std::string> m_dependencies;
     };
 
@@ -474,9 +432,6 @@ namespace jcc
         const std::string &value() const { return m_value; }
         std::string &value() { return m_value; }
 
-        std::string to_string() const override { return "StructAttribute(" + m_name + ", " + m_value + ")"; }
-        std::string to_json() const override { return "{\"type\":\"struct_attribute\",\"name\":\"" + json_escape(m_name) + "\",\"value\":\"" + json_escape(m_value) + "\"}"; }
-
     protected:
         std::string m_name;
         std::string m_value;
@@ -486,14 +441,14 @@ namespace jcc
     {
     public:
         StructField(NodeType type = NodeType::StructField) : GenericNode(type), m_bitfield(0), m_arr_size(0) {}
-        StructField(const std::string &name, const std::string &type, uint64_t bitfield, const std::string &default_value, uint64_t arr_size = 0, const std::vector<std::shared_ptr<StructAttribute>> &attributes = {}) : GenericNode(NodeType::StructField), m_name(name), m_type(type), m_bitfield(bitfield), m_default_value(default_value), m_arr_size(arr_size), m_attributes(attributes) {}
+        StructField(Symbol name, Symbol type, uint64_t bitfield, const std::string &default_value, uint64_t arr_size = 0, const NodeList<StructAttribute> &attributes = {}) : GenericNode(NodeType::StructField), m_name(name), m_type(type), m_bitfield(bitfield), m_default_value(default_value), m_arr_size(arr_size), m_attributes(attributes) {}
         virtual ~StructField() {}
 
-        const std::string &name() const { return m_name; }
-        std::string &name() { return m_name; }
+        const Symbol &name() const { return m_name; }
+        Symbol &name() { return m_name; }
 
-        const std::string &type() const { return m_type; }
-        std::string &type() { return m_type; }
+        const Symbol &type() const { return m_type; }
+        Symbol &type() { return m_type; }
 
         const std::string &default_value() const { return m_default_value; }
         std::string &default_value() { return m_default_value; }
@@ -504,47 +459,41 @@ namespace jcc
         const uint64_t &arr_size() const { return m_arr_size; }
         uint64_t &arr_size() { return m_arr_size; }
 
-        const std::vector<std::shared_ptr<StructAttribute>> &attributes() const { return m_attributes; }
-        std::vector<std::shared_ptr<StructAttribute>> &attributes() { return m_attributes; }
-
-        std::string to_string() const override { return "StructField(" + m_name + ", " + m_type + ")"; }
-        std::string to_json() const override;
+        const NodeList<StructAttribute> &attributes() const { return m_attributes; }
+        NodeList<StructAttribute> &attributes() { return m_attributes; }
 
     protected:
-        std::string m_name;
-        std::string m_type;
+        Symbol m_name;
+        Symbol m_type;
         uint64_t m_bitfield;
         std::string m_default_value;
         uint64_t m_arr_size;
-        std::vector<std::shared_ptr<StructAttribute>> m_attributes;
+        NodeList<StructAttribute> m_attributes;
     };
 
     class UnionField : public GenericNode
     {
     public:
         UnionField(NodeType type = NodeType::UnionField) : GenericNode(type) {}
-        UnionField(const std::string &name, const std::shared_ptr<TypeNode> &type) : GenericNode(NodeType::UnionField), m_name(name), m_dtype(type) {}
+        UnionField(const std::string &name, TypeNode *type) : GenericNode(NodeType::UnionField), m_name(name), m_dtype(type) {}
         virtual ~UnionField() {}
 
         const std::string &name() const { return m_name; }
         std::string &name() { return m_name; }
 
-        const std::shared_ptr<TypeNode> &dtype() const { return m_dtype; }
-        std::shared_ptr<TypeNode> &dtype() { return m_dtype; }
-
-        std::string to_string() const override { return "UnionField(" + m_name + ", " + m_dtype->to_string() + ")"; }
-        std::string to_json() const override { return "{\"type\":\"union_field\",\"name\":\"" + json_escape(m_name) + "\",\"dtype\":" + m_dtype->to_json() + "}"; }
+        TypeNode *dtype() const { return m_dtype; }
+        TypeNode *&dtype() { return m_dtype; }
 
     protected:
         std::string m_name;
-        std::shared_ptr<TypeNode> m_dtype;
+        TypeNode *m_dtype = nullptr;
     };
 
     class StructMethod : public GenericNode
     {
     public:
         StructMethod(NodeType type = NodeType::StructMethod) : GenericNode(type) {}
-        StructMethod(const std::string &name, const std::string &type, const std::vector<std::shared_ptr<FunctionParameter>> &parameters, std::shared_ptr<Block> block) : GenericNode(NodeType::StructMethod), m_name(name), m_type(type), m_parameters(parameters), m_block(block) {}
+        StructMethod(const std::string &name, const std::string &type, const NodeList<FunctionParameter> &parameters, Block *block) : GenericNode(NodeType::StructMethod), m_name(name), m_type(type), m_parameters(parameters), m_block(block) {}
         virtual ~StructMethod() {}
 
         const std::string &name() const { return m_name; }
@@ -553,48 +502,47 @@ namespace jcc
         const std::string &type() const { return m_type; }
         std::string &type() { return m_type; }
 
-        const std::vector<std::shared_ptr<FunctionParameter>> &parameters() const { return m_parameters; }
-        std::vector<std::shared_ptr<FunctionParameter>> &parameters() { return m_parameters; }
+        const NodeList<FunctionParameter> &parameters() const { return m_parameters; }
+        NodeList<FunctionParameter> &parameters() { return m_parameters; }
 
-        const std::shared_ptr<Block> &block() const { return m_block; }
-        std::shared_ptr<Block> &block() { return m_block; }
+        Block *block() const { return m_block; }
+        Block *&block() { return m_block; }
 
-        std::string to_string() const override { return "StructMethod(" + m_name + ", " + m_type + ")"; }
-        std::string to_json() const override;
+        /// @brief Byte range of the body's braces, if a skim parse left `block()` null
+        const SourceRange &skipped_body() const { return m_skipped_body; }
+        SourceRange &skipped_body() { return m_skipped_body; }
 
     protected:
         std::string m_name;
         std::string m_type;
-        std::vector<std::shared_ptr<FunctionParameter>> m_parameters;
-        std::shared_ptr<Block> m_block;
+        NodeList<FunctionParameter> m_parameters;
+        Block *m_block = nullptr;
+        SourceRange m_skipped_body;
     };
 
     class StructDefinition : public Definition
     {
     public:
         StructDefinition(NodeType type = NodeType::StructDefinition) : Definition(type) {}
-        StructDefinition(const std::string &name, std::vector<std::shared_ptr<StructField>> fields, const std::vector<std::shared_ptr<StructMethod>> &methods, bool packed = false) : Definition(NodeType::StructDefinition), m_name(name), m_fields(fields), m_methods(methods), m_packed(packed) {}
+        StructDefinition(const std::string &name, NodeList<StructField> fields, const NodeList<StructMethod> &methods, bool packed = false) : Definition(NodeType::StructDefinition), m_name(name), m_fields(fields), m_methods(methods), m_packed(packed) {}
         virtual ~StructDefinition() {}
 
         const std::string &name() const { return m_name; }
         std::string &name() { return m_name; }
 
-        const std::vector<std::shared_ptr<StructField>> &fields() const { return m_fields; }
-        std::vector<std::shared_ptr<StructField>> &fields() { return m_fields; }
+        const NodeList<StructField> &fields() const { return m_fields; }
+        NodeList<StructField> &fields() { return m_fields; }
 
-        const std::vector<std::shared_ptr<StructMethod>> &methods() const { return m_methods; }
-        std::vector<std::shared_ptr<StructMethod>> &methods() { return m_methods; }
+        const NodeList<StructMethod> &methods() const { return m_methods; }
+        NodeList<StructMethod> &methods() { return m_methods; }
 
         const bool &packed() const { return m_packed; }
         bool &packed() { return m_packed; }
 
-        std::string to_string() const override;
-        std::string to_json() const override;
-
     protected:
         std::string m_name;
-        std::vector<std::shared_ptr<StructField>> m_fields;
-        std::vector<std::shared_ptr<StructMethod>> m_methods;
+        NodeList<StructField> m_fields;
+        NodeList<StructMethod> m_methods;
         bool m_packed;
     };
 
@@ -602,24 +550,21 @@ namespace jcc
     {
     public:
         UnionDefinition(NodeType type = NodeType::UnionDefinition) : Definition(type), m_packed(false) {}
-        UnionDefinition(const std::string &name, std::vector<std::shared_ptr<UnionField>> fields, bool packed = false) : Definition(NodeType::UnionDefinition), m_name(name), m_fields(fields), m_packed(packed) {}
+        UnionDefinition(const std::string &name, NodeList<UnionField> fields, bool packed = false) : Definition(NodeType::UnionDefinition), m_name(name), m_fields(fields), m_packed(packed) {}
         virtual ~UnionDefinition() {}
 
         const std::string &name() const { return m_name; }
         std::string &name() { return m_name; }
 
-        const std::vector<std::shared_ptr<UnionField>> &fields() const { return m_fields; }
-        std::vector<std::shared_ptr<UnionField>> &fields() { return m_fields; }
+        const NodeList<UnionField> &fields() const { return m_fields; }
+        NodeList<UnionField> &fields() { return m_fields; }
 
         const bool &packed() const { return m_packed; }
         bool &packed() { return m_packed; }
 
-        std::string to_string() const override { return "UnionDefinition(" + m_name + ")"; }
-        std::string to_json() const override;
-
     protected:
         std::string m_name;
-        std::vector<std::shared_ptr<UnionField>> m_fields;
+        NodeList<UnionField> m_fields;
         bool m_packed;
     };
 
@@ -627,7 +572,7 @@ namespace jcc
     {
     public:
         FunctionDefinition(NodeType type = NodeType::FunctionDefinition) : Definition(type), m_return_arr_size(0) {}
-        FunctionDefinition(const std::string &name, const std::string &return_type, std::vector<std::shared_ptr<FunctionParameter>> parameters, std::shared_ptr<Block> block, uint64_t return_arr_size = 0) : Definition(NodeType::FunctionDefinition), m_return_type(return_type), m_parameters(parameters), m_name(name), m_block(block), m_return_arr_size(return_arr_size) {}
+        FunctionDefinition(const std::string &name, const std::string &return_type, NodeList<FunctionParameter> parameters, Block *block, uint64_t return_arr_size = 0) : Definition(NodeType::FunctionDefinition), m_return_type(return_type), m_parameters(parameters), m_name(name), m_block(block), m_return_arr_size(return_arr_size) {}
         virtual ~FunctionDefinition() {}
 
         const std::string &return_type() const { return m_return_type; }
@@ -636,24 +581,26 @@ namespace jcc
         const uint64_t &return_arr_size() const { return m_return_arr_size; }
         uint64_t &return_arr_size() { return m_return_arr_size; }
 
-        const std::vector<std::shared_ptr<FunctionParameter>> &parameters() const { return m_parameters; }
-        std::vector<std::shared_ptr<FunctionParameter>> &parameters() { return m_parameters; }
+        const NodeList<FunctionParameter> &parameters() const { return m_parameters; }
+        NodeList<FunctionParameter> &parameters() { return m_parameters; }
 
         const std::string &name() const { return m_name; }
         std::string &name() { return m_name; }
 
-        const std::shared_ptr<Block> &block() const { return m_block; }
-        std::shared_ptr<Block> &block() { return m_block; }
+        Block *block() const { return m_block; }
+        Block *&block() { return m_block; }
 
-        std::string to_string() const override;
-        std::string to_json() const override;
+        /// @brief Byte range of the body's braces, if a skim parse left `block()` null
+        const SourceRange &skipped_body() const { return m_skipped_body; }
+        SourceRange &skipped_body() { return m_skipped_body; }
 
     protected:
         std::string m_return_type;
-        std::vector<std::shared_ptr<FunctionParameter>> m_parameters;
+        NodeList<FunctionParameter> m_parameters;
         std::string m_name;
-        std::shared_ptr<Block> m_block;
+        Block *m_block = nullptr;
         uint64_t m_return_arr_size;
+        SourceRange m_skipped_body;
     };
 
     ///=================================================================================================
@@ -664,67 +611,85 @@ namespace jcc
     {
     public:
         BinaryExpression(NodeType type = NodeType::BinaryExpression) : Expression(type) {}
-        BinaryExpression(const std::string &op, std::shared_ptr<Expression> left, std::shared_ptr<Expression> right) : Expression(NodeType::BinaryExpression), m_op(op), m_left(left), m_right(right) {}
+        BinaryExpression(Operator op, Expression *left, Expression *right) : Expression(NodeType::BinaryExpression), m_op(op), m_left(left), m_right(right) {}
         virtual ~BinaryExpression() {}
 
-        const std::string &op() const { return m_op; }
-        std::string &op() { return m_op; }
+        const Operator &op() const { return m_op; }
+        Operator &op() { return m_op; }
 
-        const std::shared_ptr<Expression> &left() const { return m_left; }
-        std::shared_ptr<Expression> &left() { return m_left; }
+        Expression *left() const { return m_left; }
+        Expression *&left() { return m_left; }
 
-        const std::shared_ptr<Expression> &right() const { return m_right; }
-        std::shared_ptr<Expression> &right() { return m_right; }
-
-        std::string to_string() const override { return "BinaryExpression(" + m_op + ", " + m_left->to_string() + ", " + m_right->to_string() + ")"; }
-        std::string to_json() const override { return "{\"type\":\"binary_expression\",\"op\":\"" + json_escape(m_op) + "\",\"left\":" + m_left->to_json() + ",\"right\":" + m_right->to_json() + "}"; }
+        Expression *right() const { return m_right; }
+        Expression *&right() { return m_right; }
 
     protected:
-        std::string m_op;
-        std::shared_ptr<Expression> m_left;
-        std::shared_ptr<Expression> m_right;
+        Operator m_op = Operator::Assign;
+        Expression *m_left = nullptr;
+        Expression *m_right = nullptr;
     };
 
     class UnaryExpression : public Expression
     {
     public:
         UnaryExpression(NodeType type = NodeType::UnaryExpression) : Expression(type) {}
-        UnaryExpression(const std::string &op, std::shared_ptr<Expression> expression) : Expression(NodeType::UnaryExpression), m_op(op), m_expression(expression) {}
+        UnaryExpression(Operator op, Expression *expression, bool postfix = false) : Expression(NodeType::UnaryExpression), m_op(op), m_expression(expression), m_postfix(postfix) {}
         virtual ~UnaryExpression() {}
 
-        const std::string &op() const { return m_op; }
-        std::string &op() { return m_op; }
+        const Operator &op() const { return m_op; }
+        Operator &op() { return m_op; }
+
+        Expression *expression() const { return m_expression; }
+        Expression *&expression() { return m_expression; }
 
-        const std::shared_ptr<Expression> &expression() const { return m_expression; }
-        std::shared_ptr<Expression> &expression() { return m_expression; }
+        /// @brief True for `x++`/`x--`, false for prefix operators
+        const bool &postfix() const { return m_postfix; }
+        bool &postfix() { return m_postfix; }
 
-        std::string to_string() const override { return "UnaryExpression(" + m_op + ", " + m_expression->to_string() + ")"; }
-        std::string to_json() const override { return "{\"type\":\"unary_expression\",\"op\":\"" + json_escape(m_op) + "\",\"expression\":" + m_expression->to_json() + "}"; }
+    protected:
+        Operator m_op = Operator::Plus;
+        Expression *m_expression = nullptr;
+        bool m_postfix = false;
+    };
+
+    class TernaryExpression : public Expression
+    {
+    public:
+        TernaryExpression(NodeType type = NodeType::TernaryExpression) : Expression(type) {}
+        TernaryExpression(Expression *condition, Expression *then_expression, Expression *else_expression) : Expression(NodeType::TernaryExpression), m_condition(condition), m_then(then_expression), m_else(else_expression) {}
+        virtual ~TernaryExpression() {}
+
+        Expression *condition() const { return m_condition; }
+        Expression *&condition() { return m_condition; }
+
+        Expression *then_expression() const { return m_then; }
+        Expression *&then_expression() { return m_then; }
+
+        Expression *else_expression() const { return m_else; }
+        Expression *&else_expression() { return m_else; }
 
     protected:
-        std::string m_op;
-        std::shared_ptr<Expression> m_expression;
+        Expression *m_condition = nullptr;
+        Expression *m_then = nullptr;
+        Expression *m_else = nullptr;
     };
 
     class CastExpression : public Expression
     {
     public:
         CastExpression(NodeType type = NodeType::CastExpression) : Expression(type) {}
-        CastExpression(const std::string &type, std::shared_ptr<Expression> expression) : Expression(NodeType::CastExpression), m_type(type), m_expression(expression) {}
+        CastExpression(Symbol type, Expression *expression) : Expression(NodeType::CastExpression), m_type(type), m_expression(expression) {}
         virtual ~CastExpression() {}
 
-        const std::string &type() const { return m_type; }
-        std::string &type() { return m_type; }
-
-        const std::shared_ptr<Expression> &expression() const { return m_expression; }
-        std::shared_ptr<Expression> &expression() { return m_expression; }
+        const Symbol &type() const { return m_type; }
+        Symbol &type() { return m_type; }
 
-        std::string to_string() const override { return "CastExpression(" + m_type + ", " + m_expression->to_string() + ")"; }
-        std::string to_json() const override { return "{\"type\":\"cast_expression\",\"type\":\"" + json_escape(m_type) + "\",\"expression\":" + m_expression->to_json() + "}"; }
+        Expression *expression() const { return m_expression; }
+        Expression *&expression() { return m_expression; }
 
     protected:
-        std::string m_type;
-        std::shared_ptr<Expression> m_expression;
+        Symbol m_type;
+        Expression *m_expression = nullptr;
     };
 
     class NullExpression : public Expression
@@ -737,9 +702,6 @@ namespace jcc
         const std::string &type() const { return m_type; }
         std::string &type() { return m_type; }
 
-        std::string to_string() const override { return "NullExpression(" + m_type + ")"; }
-        std::string to_json() const override { return "{\"type\":\"null_expression\",\"type\":\"" + json_escape(m_type) + "\"}"; }
-
     protected:
         std::string m_type;
     };
@@ -748,21 +710,32 @@ namespace jcc
     {
     public:
         CallExpression(NodeType type = NodeType::CallExpression) : Expression(type) {}
-        CallExpression(const std::string &name, std::vector<std::shared_ptr<Expression>> arguments) : Expression(NodeType::CallExpression), m_name(name), m_arguments(arguments) {}
+        CallExpression(const std::string &name, NodeList<Expression> arguments) : Expression(NodeType::CallExpression), m_name(name), m_arguments(arguments) {}
         virtual ~CallExpression() {}
 
         const std::string &name() const { return m_name; }
         std::string &name() { return m_name; }
 
-        const std::vector<std::shared_ptr<Expression>> &arguments() const { return m_arguments; }
-        std::vector<std::shared_ptr<Expression>> &arguments() { return m_arguments; }
-
-        std::string to_string() const override;
-        std::string to_json() const override;
+        const NodeList<Expression> &arguments() const { return m_arguments; }
+        NodeList<Expression> &arguments() { return m_arguments; }
 
     protected:
         std::string m_name;
-        std::vector<std::shared_ptr<Expression>> m_arguments;
+        NodeList<Expression> m_arguments;
+    };
+
+    class IdentifierExpression : public Expression
+    {
+    public:
+        IdentifierExpression(NodeType type = NodeType::IdentifierExpression) : Expression(type) {}
+        IdentifierExpression(Symbol name) : Expression(NodeType::IdentifierExpression), m_name(name) {}
+        virtual ~IdentifierExpression() {}
+
+        const Symbol &name() const { return m_name; }
+        Symbol &name() { return m_name; }
+
+    protected:
+        Symbol m_name;
     };
 
     class LiteralExpression : public Expression
@@ -775,9 +748,6 @@ namespace jcc
         const std::string &value() const { return m_value; }
         std::string &value() { return m_value; }
 
-        std::string to_string() const override { return "LiteralExpression(" + m_value + ")"; }
-        std::string to_json() const override { return "{\"type\":\"literal_expression\",\"value\":\"" + json_escape(m_value) + "\"}"; }
-
     protected:
         std::string m_value;
     };
@@ -788,9 +758,6 @@ namespace jcc
         StringLiteralExpression(NodeType type = NodeType::StringLiteralExpression) : LiteralExpression(type) {}
         StringLiteralExpression(const std::string &value) : LiteralExpression(value, NodeType::StringLiteralExpression) {}
         virtual ~StringLiteralExpression() {}
-
-        std::string to_string() const override { return "StringLiteralExpression(" + m_value + ")"; }
-        std::string to_json() const override { return "{\"type\":\"string_literal_expression\",\"value\":\"" + json_escape(m_value) + "\"}"; }
     };
 
     class CharLiteralExpression : public LiteralExpression
@@ -799,9 +766,6 @@ namespace jcc
         CharLiteralExpression(NodeType type = NodeType::CharLiteralExpression) : LiteralExpression(type) {}
         CharLiteralExpression(const std::string &value) : LiteralExpression(value, NodeType::CharLiteralExpression) {}
         virtual ~CharLiteralExpression() {}
-
-        std::string to_string() const override { return "CharLiteralExpression(" + m_value + ")"; }
-        std::string to_json() const override { return "{\"type\":\"char_literal_expression\",\"value\":\"" + json_escape(m_value) + "\"}"; }
     };
 
     class IntegerLiteralExpression : public LiteralExpression
@@ -810,9 +774,6 @@ namespace jcc
         IntegerLiteralExpression(NodeType type = NodeType::IntegerLiteralExpression) : LiteralExpression(type) {}
         IntegerLiteralExpression(const std::string &value) : LiteralExpression(value, NodeType::IntegerLiteralExpression) {}
         virtual ~IntegerLiteralExpression() {}
-
-        std::string to_string() const override { return "IntegerLiteralExpression(" + m_value + ")"; }
-        std::string to_json() const override { return "{\"type\":\"integer_literal_expression\",\"value\":\"" + json_escape(m_value) + "\"}"; }
     };
 
     class FloatingPointLiteralExpression : public LiteralExpression
@@ -821,9 +782,6 @@ namespace jcc
         FloatingPointLiteralExpression(NodeType type = NodeType::FloatingPointLiteralExpression) : LiteralExpression(type) {}
         FloatingPointLiteralExpression(const std::string &value) : LiteralExpression(value, NodeType::FloatingPointLiteralExpression) {}
         virtual ~FloatingPointLiteralExpression() {}
-
-        std::string to_string() const override { return "FloatingPointLiteralExpression(" + m_value + ")"; }
-        std::string to_json() const override { return "{\"type\":\"float_literal_expression\",\"value\":\"" + json_escape(m_value) + "\"}"; }
     };
 
     class BooleanLiteralExpression : public LiteralExpression
@@ -832,9 +790,6 @@ namespace jcc
         BooleanLiteralExpression(NodeType type = NodeType::BooleanLiteralExpression) : LiteralExpression(type) {}
         BooleanLiteralExpression(const std::string &value) : LiteralExpression(value, NodeType::BooleanLiteralExpression) {}
         virtual ~BooleanLiteralExpression() {}
-
-        std::string to_string() const override { return "BooleanLiteralExpression(" + m_value + ")"; }
-        std::string to_json() const override { return "{\"type\":\"boolean_literal_expression\",\"value\":\"" + json_escape(m_value) + "\"}"; }
     };
 
     ///=================================================================================================
@@ -845,36 +800,30 @@ namespace jcc
     {
     public:
         ReturnStatement(NodeType type = NodeType::ReturnStatement) : Statement(type) {}
-        ReturnStatement(std::shared_ptr<Expression> expression) : Statement(NodeType::ReturnStatement), m_expression(expression) {}
+        ReturnStatement(Expression *expression) : Statement(NodeType::ReturnStatement), m_expression(expression) {}
         virtual ~ReturnStatement() {}
 
-        const std::shared_ptr<Expression> &expression() const { return m_expression; }
-        std::shared_ptr<Expression> &expression() { return m_expression; }
-
-        std::string to_string() const override { return "ReturnStatement()"; }
-        std::string to_json() const override { return "{\"type\":\"return_statement\"}"; }
+        Expression *expression() const { return m_expression; }
+        Expression *&expression() { return m_expression; }
 
     protected:
-        std::shared_ptr<Expression> m_expression;
+        Expression *m_expression = nullptr;
     };
 
     class LetDeclaration : public Statement
     {
     public:
         LetDeclaration(NodeType type = NodeType::LetDeclaration) : Statement(type) {}
-        LetDeclaration(const std::shared_ptr<TypeNode> &type, const std::string &name) : Statement(NodeType::LetDeclaration), m_type(type), m_name(name) {}
+        LetDeclaration(TypeNode *type, const std::string &name) : Statement(NodeType::LetDeclaration), m_type(type), m_name(name) {}
 
-        const std::shared_ptr<TypeNode> &dtype() const { return m_type; }
-        std::shared_ptr<TypeNode> &dtype() { return m_type; }
+        TypeNode *dtype() const { return m_type; }
+        TypeNode *&dtype() { return m_type; }
 
         const std::string &name() const { return m_name; }
         std::string &name() { return m_name; }
 
-        std::string to_string() const override { return "LetDeclaration()"; }
-        std::string to_json() const override;
-
     protected:
-        std::shared_ptr<TypeNode> m_type;
+        TypeNode *m_type = nullptr;
         std::string m_name;
     };
 
@@ -882,26 +831,23 @@ namespace jcc
     {
     public:
         VarDeclaration(NodeType type = NodeType::VarDeclaration) : Statement(type) {}
-        VarDeclaration(const std::shared_ptr<TypeNode> &type, const std::string &name) : Statement(NodeType::VarDeclaration), m_type(type), m_name(name) {}
+        VarDeclaration(TypeNode *type, const std::string &name) : Statement(NodeType::VarDeclaration), m_type(type), m_name(name) {}
 
-        const std::shared_ptr<TypeNode> &dtype() const { return m_type; }
-        std::shared_ptr<TypeNode> &dtype() { return m_type; }
+        TypeNode *dtype() const { return m_type; }
+        TypeNode *&dtype() { return m_type; }
 
         const std::string &name() const { return m_name; }
         std::string &name() { return m_name; }
 
-        std::string to_string() const override { return "VarDeclaration()"; }
-        std::string to_json() const override;
-
     protected:
-        std::shared_ptr<TypeNode> m_type;
+        TypeNode *m_type = nullptr;
         std::string m_name;
     };
 }
 
 namespace std
 {
-    std::string to_string(const std::shared_ptr<jcc::GenericNode> value);
+    std::string to_string(const jcc::GenericNode *value);
 }
 
 #include "node.hpp"
@@ -910,27 +856,127 @@ namespace jcc
 {
     typedef GenericNode ASTNode;
 
+    /// @brief Default limit on how deeply subsystems and expressions may nest
+    constexpr size_t parseMaxNestingDefault = 256;
+
+    /// @brief How many versions' arenas a reparsed tree may keep alive.
+    /// @note A reused span pins the whole arena it was parsed into, including
+    /// the nodes of its version that were since replaced. A span is only reused
+    /// while its arena is younger than this many versions; older ones are
+    /// parsed again, so a chain of edits holds a bounded amount of memory.
+    constexpr uint32_t parseMaxRetainedVersions = 4;
+
+    /// @brief A top-level declaration of a source, with the statements that follow it up to the next one
+    struct TopLevelSpan
+    {
+        /// @brief Byte offset of the first token
+        uint32_t begin = 0;
+        /// @brief Byte offset of the next declaration, or the end of the source
+        uint32_t end = 0;
+        /// @brief Hash of the source bytes in [begin, end)
+        size_t hash = 0;
+        /// @brief Index of the span's first statement among the root's children
+        uint32_t first = 0;
+        /// @brief Number of root children the span contributes
+        uint32_t count = 0;
+        /// @brief Whether the span parsed without syntax errors, so that a later version may reuse it
+        bool clean = false;
+        /// @brief Arena owning the span's nodes
+        std::shared_ptr<AstArena> arena;
+        /// @brief Number of reparses the span's nodes were reused through, i.e. the age of its arena
+        uint32_t age = 0;
+    };
+
+    /// @brief Syntax tree of one compilation unit
+    /// @note Every node of the tree lives in an arena released with the tree;
+    /// nodes must not outlive it. A tree reparsed from an earlier one shares the
+    /// nodes of its unchanged top-level declarations, and keeps the arenas they
+    /// live in alive, for up to `parseMaxRetainedVersions` versions. Nodes are
+    /// never modified once parsed, except for the function bodies of a skimmed
+    /// tree, filled in when parsed on demand.
     class AbstractSyntaxTree
     {
     public:
-        AbstractSyntaxTree() {}
-        AbstractSyntaxTree(const std::shared_ptr<ASTNode> &root) : m_root(root) {}
+        AbstractSyntaxTree() : m_arena(std::make_shared<AstArena>()), m_root(nullptr) {}
+        AbstractSyntaxTree(std::shared_ptr<AstArena> arena, ASTNode *root) : m_arena(std::move(arena)), m_root(root) {}
+        AbstractSyntaxTree(std::shared_ptr<AstArena> arena, ASTNode *root, std::vector<TopLevelSpan> spans, const TokenList &source, std::shared_ptr<const TokenCursor> skimmed = nullptr) : m_arena(std::move(arena)), m_root(root), m_spans(std::move(spans)), m_skimmed(std::move(skimmed))
+        {
+            m_source.share_storage(source);
+        }
         virtual ~AbstractSyntaxTree() {}
 
-        const std::shared_ptr<ASTNode> &root() const { return m_root; }
-        std::shared_ptr<ASTNode> &root() { return m_root; }
+        ASTNode *root() const { return m_root; }
+        ASTNode *&root() { return m_root; }
+
+        /// @brief Get the arena owning the nodes parsed for this tree
+        /// @return AstArena
+        AstArena &arena() const { return *m_arena; }
+
+        /// @brief Get the top-level declarations of the tree, in source order
+        /// @return Spans partitioning the root's children
+        const std::vector<TopLevelSpan> &spans() const { return m_spans; }
+
+        /// @brief Get the source the tree was parsed from
+        /// @return std::string_view, empty if the tree does not keep it
+        std::string_view source() const { return m_source.source(); }
+
+        /// @brief Check if function bodies were skipped when parsing the tree
+        /// @return true for a tree from `CompilationUnit::skim`
+        bool skimmed() const { return m_skimmed != nullptr; }
+
+        /// @brief Get the tokens a skimmed tree parses its function bodies from
+        /// @return TokenCursor over the whole source, or nullptr if the tree is not skimmed
+        const TokenCursor *skimmed_tokens() const { return m_skimmed.get(); }
 
         std::string to_string() const { return m_root->to_string(); }
         std::string to_json() const { return m_root->to_json(); }
+        void to_json(JsonWriter &writer) const { m_root->to_json(writer); }
+
+        /// @brief Serialize the tree in the binary AST format (see astfile.hpp)
+        /// @param out Buffer the serialized tree is appended to
+        void write(std::string &out) const;
+
+        /// @brief Write the tree to a binary AST (`.jast`) file
+        /// @param path Path of the file, replaced atomically
+        /// @return True if the file was written, false otherwise
+        bool save(const std::string &path) const;
+
+        /// @brief Rebuild a tree from a binary AST
+        /// @param data Serialized tree, 4-byte aligned; nothing refers to it afterwards
+        /// @return AbstractSyntaxTree, or nullptr if the data is not a valid binary AST of this version
+        static std::shared_ptr<AbstractSyntaxTree> read(std::string_view data);
+
+        /// @brief Map a binary AST (`.jast`) file and rebuild its tree
+        /// @param path Path of the file
+        /// @return AbstractSyntaxTree, or nullptr if the file is missing or invalid
+        static std::shared_ptr<AbstractSyntaxTree> load(const std::string &path);
 
     protected:
-        std::shared_ptr<ASTNode> m_root;
+        std::shared_ptr<AstArena> m_arena;
+        ASTNode *m_root;
+        std::vector<TopLevelSpan> m_spans;
+        TokenList m_source;
+        std::shared_ptr<const TokenCursor> m_skimmed;
     };
 
     class ParserException : public std::runtime_error
     {
     public:
         ParserException(const std::string &message) : std::runtime_error(message) {}
+
+        /// @brief Source location of the offending token, if known (line 0 otherwise)
+        SourceLocation &location() { return m_location; }
+        const SourceLocation &location() const { return m_location; }
+
+    protected:
+        SourceLocation m_location;
+    };
+
+    /// @brief A syntax error reported by the parser
+    struct ParserDiagnostic
+    {
+        SourceLocation location;
+        std::string message;
     };
 
     class UnexpectedTokenError : public ParserException
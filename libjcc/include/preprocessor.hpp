@@ -2,6 +2,7 @@
 #define _JCC_PREPROCESSOR_HPP_
 
 #include <string>
+#include <string_view>
 #include <stdexcept>
 
 namespace jcc
@@ -43,7 +44,7 @@ namespace jcc
         /// @param source The source code
         /// @return std::string
         /// @throw PreprocessorException
-        static std::string preprocess(const std::string &source);
+        static std::string preprocess(std::string_view source);
 
     private:
         Preprocessor() = delete;
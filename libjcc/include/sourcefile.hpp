@@ -0,0 +1,62 @@
+#ifndef _JCC_SOURCEFILE_HPP_
+#define _JCC_SOURCEFILE_HPP_
+
+#include <string>
+#include <string_view>
+#include <cstddef>
+
+namespace jcc
+{
+    /// @brief Result of a UTF-8 scan
+    struct Utf8Scan
+    {
+        /// @brief The buffer is well-formed UTF-8 (no overlongs, surrogates or code points above U+10FFFF)
+        bool valid = true;
+        /// @brief Every byte of the buffer is below 0x80
+        bool ascii = true;
+    };
+
+    /// @brief Validate UTF-8 and detect pure ASCII in a single pass
+    /// @param data The buffer to scan
+    /// @param size The size of the buffer in bytes
+    /// @return Utf8Scan
+    /// @note ASCII runs are skipped a vector at a time (AVX2 or SSE2, picked at
+    /// runtime from the CPU features). Only the bytes around non-ASCII
+    /// characters go through the scalar decoder.
+    Utf8Scan scan_utf8(const char *data, size_t size);
+
+    /// @brief Read-only view of a file's contents, memory mapped when possible
+    class SourceFile
+    {
+    public:
+        SourceFile() = default;
+        ~SourceFile();
+
+        SourceFile(const SourceFile &) = delete;
+        SourceFile &operator=(const SourceFile &) = delete;
+
+        /// @brief Map a file, replacing the current contents
+        /// @param filepath The path to the file
+        /// @return True if successful, false otherwise
+        /// @note Falls back to reading the file into memory if it cannot be mapped.
+        bool open(const std::string &filepath);
+
+        /// @brief Unmap the file
+        void close();
+
+        /// @brief Get the contents of the file
+        /// @return std::string_view, valid until the file is closed
+        std::string_view contents() const { return std::string_view(m_data, m_size); }
+
+        size_t size() const { return m_size; }
+        bool empty() const { return m_size == 0; }
+
+    private:
+        const char *m_data = nullptr;
+        size_t m_size = 0;
+        bool m_mapped = false;
+        std::string m_buffer;
+    };
+}
+
+#endif // !_JCC_SOURCEFILE_HPP_
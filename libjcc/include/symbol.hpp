@@ -0,0 +1,72 @@
+#ifndef _JCC_SYMBOL_HPP_
+#define _JCC_SYMBOL_HPP_
+
+#include <string>
+#include <string_view>
+#include <cstdint>
+#include <cstddef>
+#include <functional>
+
+namespace jcc
+{
+    /// @brief Interned string handle.
+    /// @note Every distinct string is stored once, for the lifetime of the
+    /// process, in a thread-safe sharded table, and is identified by a 32-bit
+    /// ID. Two symbols are equal exactly when their IDs are equal. The default
+    /// symbol (ID 0) is the empty string. Interned strings are never freed,
+    /// so only names that come from source should be interned; strings a
+    /// pass builds for itself belong in that pass's own storage.
+    class Symbol
+    {
+    public:
+        Symbol() : m_id(0) {}
+
+        /// @brief Intern a string
+        /// @param str The string; copied into the table the first time it is seen
+        Symbol(std::string_view str) : m_id(intern(str)) {}
+        Symbol(const std::string &str) : m_id(intern(str)) {}
+        Symbol(const char *str) : m_id(intern(str)) {}
+
+        /// @brief Get the symbol with a known ID
+        /// @param id An ID previously returned by `id()`
+        /// @return Symbol
+        static Symbol from_id(uint32_t id)
+        {
+            Symbol symbol;
+            symbol.m_id = id;
+            return symbol;
+        }
+
+        /// @brief Recover the symbol of a view returned by `str()` without hashing
+        /// @param str A view returned by `Symbol::str()`
+        /// @return Symbol
+        static Symbol from_interned(std::string_view str);
+
+        /// @brief Get the ID of the symbol
+        /// @return uint32_t
+        uint32_t id() const { return m_id; }
+
+        /// @brief Get the interned text
+        /// @return std::string_view, valid for the lifetime of the process
+        std::string_view str() const;
+
+        bool empty() const { return m_id == 0; }
+
+        bool operator==(Symbol other) const { return m_id == other.m_id; }
+        bool operator!=(Symbol other) const { return m_id != other.m_id; }
+        bool operator<(Symbol other) const { return m_id < other.m_id; }
+
+    private:
+        uint32_t m_id;
+
+        static uint32_t intern(std::string_view str);
+    };
+}
+
+template <>
+struct std::hash<jcc::Symbol>
+{
+    size_t operator()(jcc::Symbol symbol) const noexcept { return symbol.id(); }
+};
+
+#endif // !_JCC_SYMBOL_HPP_
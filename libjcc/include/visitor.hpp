@@ -0,0 +1,104 @@
+#ifndef _JCC_VISITOR_HPP_
+#define _JCC_VISITOR_HPP_
+
+#include <stdexcept>
+#include <type_traits>
+#include "parser.hpp"
+
+/// @brief Invokes `X(Name)` for every node class, where `Name` is both the
+/// class and its `jcc::NodeType` enumerator. `NodeType::Invalid` has no class
+/// of its own and is left out.
+#define JCC_NODE_CLASSES(X)           \
+    X(Expression)                     \
+    X(Statement)                      \
+    X(Declaration)                    \
+    X(Definition)                     \
+    X(Block)                          \
+    X(TypeNode)                       \
+    X(RawNode)                        \
+    X(TypeDeclaration)                \
+    X(StructDeclaration)              \
+    X(UnionDeclaration)               \
+    X(EnumDeclaration)                \
+    X(FunctionParameter)              \
+    X(FunctionDeclaration)            \
+    X(ClassDeclaration)               \
+    X(ExternalDeclaration)            \
+    X(SubsystemDeclaration)           \
+    X(SubsystemDefinition)            \
+    X(StructField)                    \
+    X(StructMethod)                   \
+    X(StructAttribute)                \
+    X(StructDefinition)               \
+    X(UnionField)                     \
+    X(UnionDefinition)                \
+    X(FunctionDefinition)             \
+    X(BinaryExpression)               \
+    X(UnaryExpression)                \
+    X(TernaryExpression)              \
+    X(CastExpression)                 \
+    X(NullExpression)                 \
+    X(LiteralExpression)              \
+    X(CallExpression)                 \
+    X(IdentifierExpression)           \
+    X(StringLiteralExpression)        \
+    X(CharLiteralExpression)          \
+    X(IntegerLiteralExpression)       \
+    X(FloatingPointLiteralExpression) \
+    X(BooleanLiteralExpression)       \
+    X(ReturnStatement)                \
+    X(LetDeclaration)                 \
+    X(VarDeclaration)
+
+namespace jcc
+{
+    /// @brief Statically dispatched visitor over the node types of a syntax tree.
+    /// @tparam Derived The pass, which provides a `visit` overload per node class it handles
+    /// @tparam Result Type returned by `visit` and `dispatch`
+    /// @tparam Const Whether the pass visits `const` nodes
+    /// @note `dispatch` switches on `GenericNode::type()` and calls
+    /// `Derived::visit` with the node cast to its exact class, so the call is
+    /// resolved at compile time and can be inlined. The overload is taken by its
+    /// exact signature, `Result visit(Ptr<Class>)`, so a node class the pass has
+    /// no `visit` for fails to compile instead of reaching an overload for one of
+    /// its bases. `NodeType::Invalid` has no class and is never visited; it
+    /// throws. Adding a `NodeType` without adding it to `JCC_NODE_CLASSES` is
+    /// caught by `-Wswitch`.
+    template <typename Derived, typename Result = void, bool Const = false>
+    class NodeVisitor
+    {
+    public:
+        template <typename T>
+        using Ptr = std::conditional_t<Const, const T *, T *>;
+
+        /// @brief Visit a node as its exact class
+        /// @param node Node, not null
+        /// @return Result of the `visit` overload chosen for the node
+        Result dispatch(Ptr<GenericNode> node)
+        {
+            Derived &self = static_cast<Derived &>(*this);
+
+            switch (node->type())
+            {
+            case NodeType::Invalid:
+                throw std::runtime_error("Invalid node type");
+
+#define JCC_VISITOR_CASE(name) \
+    case NodeType::name:       \
+        return (self.*static_cast<Result (Derived::*)(Ptr<name>)>(&Derived::visit))(static_cast<Ptr<name>>(node));
+
+                JCC_NODE_CLASSES(JCC_VISITOR_CASE)
+
+#undef JCC_VISITOR_CASE
+            }
+
+            throw std::runtime_error("Unknown node type");
+        }
+    };
+
+    /// @brief Visitor over `const` nodes
+    template <typename Derived, typename Result = void>
+    using ConstNodeVisitor = NodeVisitor<Derived, Result, true>;
+}
+
+#endif // _JCC_VISITOR_HPP_
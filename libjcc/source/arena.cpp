@@ -0,0 +1,110 @@
+#include "arena.hpp"
+#include "compile.hpp"
+#include <algorithm>
+#include <cstdlib>
+#include <stdexcept>
+
+///=============================================================================
+/// jcc::AstArena class implementation
+///=============================================================================
+
+/// @brief Size of the blocks nodes are carved from; larger requests get a block of their own
+constexpr size_t AstArenaBlockSize = 64 * 1024;
+
+static thread_local jcc::AstArena *g_current_arena = nullptr;
+
+jcc::AstArena::~AstArena()
+{
+    for (Finalizer *finalizer = m_finalizers; finalizer != nullptr; finalizer = finalizer->next)
+    {
+        finalizer->destroy(finalizer->object);
+    }
+
+    while (m_blocks != nullptr)
+    {
+        Block *next = m_blocks->next;
+        std::free(m_blocks);
+        m_blocks = next;
+    }
+}
+
+void jcc::AstArena::grow(size_t size)
+{
+    constexpr size_t header = (sizeof(Block) + alignof(std::max_align_t) - 1) & ~(alignof(std::max_align_t) - 1);
+    size_t capacity = std::max(size, AstArenaBlockSize - header);
+
+    Block *block = static_cast<Block *>(std::malloc(header + capacity));
+    if (block == nullptr)
+    {
+        panic("Out of memory allocating an AST arena block");
+    }
+
+    block->next = m_blocks;
+    m_blocks = block;
+    m_cursor = reinterpret_cast<char *>(block) + header;
+    m_left = capacity;
+    m_reserved += header + capacity;
+}
+
+void jcc::AstArena::adopt(AstArena &other)
+{
+    if (other.m_blocks != nullptr)
+    {
+        Block *tail = other.m_blocks;
+        while (tail->next != nullptr)
+        {
+            tail = tail->next;
+        }
+
+        // this arena keeps allocating from its own current block
+        tail->next = m_blocks;
+        m_blocks = other.m_blocks;
+    }
+
+    if (other.m_finalizers != nullptr)
+    {
+        Finalizer *tail = other.m_finalizers;
+        while (tail->next != nullptr)
+        {
+            tail = tail->next;
+        }
+
+        tail->next = m_finalizers;
+        m_finalizers = other.m_finalizers;
+    }
+
+    m_used += other.m_used;
+    m_reserved += other.m_reserved;
+
+    other.m_blocks = nullptr;
+    other.m_cursor = nullptr;
+    other.m_left = 0;
+    other.m_finalizers = nullptr;
+    other.m_used = 0;
+    other.m_reserved = 0;
+}
+
+jcc::AstArena *jcc::AstArena::current()
+{
+    return g_current_arena;
+}
+
+jcc::AstArena &jcc::AstArena::active()
+{
+    if (g_current_arena == nullptr)
+    {
+        throw std::logic_error("No AstArena is current on this thread; nodes must be made inside an AstArena::Scope");
+    }
+
+    return *g_current_arena;
+}
+
+jcc::AstArena::Scope::Scope(AstArena &arena) : m_previous(g_current_arena)
+{
+    g_current_arena = &arena;
+}
+
+jcc::AstArena::Scope::~Scope()
+{
+    g_current_arena = m_previous;
+}
@@ -0,0 +1,943 @@
+#include "astfile.hpp"
+#include "visitor.hpp"
+#include "sourcefile.hpp"
+#include <vector>
+#include <unordered_map>
+#include <fstream>
+#include <random>
+#include <cstring>
+#include <cstdio>
+#include <stdexcept>
+
+using namespace jcc;
+
+///=============================================================================
+/// Binary AST (.jast)
+///
+/// A `.jast` file is a fixed header followed by two offset tables and the data
+/// they index:
+///
+///     JastHeader
+///     uint32_t string_offsets[strings + 1]   (into string_data)
+///     uint32_t node_offsets[nodes + 1]       (into node_data)
+///     char     string_data[]                 (each distinct string once)
+///     uint8_t  node_data[]                   (one record per node)
+///
+/// Integers in the header and tables are stored in host byte order; the magic
+/// doubles as a byte order check. A record is its NodeType followed by the
+/// node's fields, each an LEB128 varint:
+///
+///     number, flag   the value
+///     string         index into the string table
+///     node           child index + 1, or 0 for none
+///     list           element count, then one node per element
+///     range          begin, end (byte offsets of a skipped function body)
+///
+/// Node fields, in order (types without fields are omitted):
+///
+///     Block                  flag render_braces, list children
+///     TypeNode               string name, flag is_const, flag is_reference,
+///                            number arr_size, number bitfield, node default_value
+///     RawNode                string value
+///     TypeDeclaration        string alias, string type_name
+///     Struct/Union/Enum/ClassDeclaration   string name
+///     FunctionParameter      string name, string type, node default_value,
+///                            number arr_size, flag is_const, flag is_reference
+///     FunctionDeclaration    string name, string return_type, list parameters,
+///                            number return_arr_size
+///     ExternalDeclaration    node declaration
+///     SubsystemDeclaration   string name, number count, string dependencies[count]
+///     SubsystemDefinition    string name, node block, number count, string dependencies[count]
+///     StructField            string name, string type, number bitfield,
+///                            string default_value, number arr_size, list attributes
+///     StructMethod           string name, string type, list parameters, node block, range
+///     StructAttribute        string name, string value
+///     StructDefinition       string name, list fields, list methods, flag packed
+///     UnionField             string name, node dtype
+///     UnionDefinition        string name, list fields, flag packed
+///     FunctionDefinition     string name, string return_type, list parameters,
+///                            node block, number return_arr_size, range
+///     BinaryExpression       number op, node left, node right
+///     UnaryExpression        number op, node expression, flag postfix
+///     TernaryExpression      node condition, node then, node else
+///     CastExpression         string type, node expression
+///     NullExpression         string type
+///     CallExpression         string name, list arguments
+///     IdentifierExpression   string name
+///     *LiteralExpression     string value
+///     ReturnStatement        node expression
+///     Let/VarDeclaration     node dtype, string name
+///
+/// Nodes are numbered breadth first from the root, so a reader can rebuild
+/// the tree back to front without recursion.
+///=============================================================================
+
+struct JastHeader
+{
+    char magic[4];
+    uint32_t version;
+    uint32_t strings;
+    uint32_t nodes;
+    uint64_t string_data_size;
+    uint64_t node_data_size;
+};
+
+static_assert(sizeof(JastHeader) % sizeof(uint32_t) == 0, "JastHeader must keep the tables aligned");
+
+///=============================================================================
+/// Writer
+///=============================================================================
+
+/// @brief Encodes the nodes of a tree breadth first
+class AstFileEncoder : public ConstNodeVisitor<AstFileEncoder>
+{
+public:
+    void encode(const GenericNode *root)
+    {
+        m_queue.push_back(root);
+
+        // children are queued while their parent is encoded
+        for (size_t i = 0; i < m_queue.size(); i++)
+        {
+            m_node_offsets.push_back(static_cast<uint32_t>(m_node_data.size()));
+            number(static_cast<uint64_t>(m_queue[i]->type()));
+            dispatch(m_queue[i]);
+        }
+        m_node_offsets.push_back(static_cast<uint32_t>(m_node_data.size()));
+    }
+
+    void write(std::string &out) const
+    {
+        if (m_string_data.size() > UINT32_MAX || m_node_data.size() > UINT32_MAX)
+        {
+            throw std::runtime_error("Syntax tree is too large for the binary AST format");
+        }
+
+        JastHeader header = {};
+        std::memcpy(header.magic, "JAST", 4);
+        header.version = astFileVersion;
+        header.strings = static_cast<uint32_t>(m_string_offsets.size());
+        header.nodes = static_cast<uint32_t>(m_queue.size());
+        header.string_data_size = m_string_data.size();
+        header.node_data_size = m_node_data.size();
+
+        uint32_t string_end = static_cast<uint32_t>(m_string_data.size());
+
+        out.append(reinterpret_cast<const char *>(&header), sizeof(header));
+        out.append(reinterpret_cast<const char *>(m_string_offsets.data()), m_string_offsets.size() * sizeof(uint32_t));
+        out.append(reinterpret_cast<const char *>(&string_end), sizeof(uint32_t));
+        out.append(reinterpret_cast<const char *>(m_node_offsets.data()), m_node_offsets.size() * sizeof(uint32_t));
+        out.append(m_string_data);
+        out.append(reinterpret_cast<const char *>(m_node_data.data()), m_node_data.size());
+    }
+
+    // nodes of the abstract kinds have no fields
+    void visit(const Expression *) {}
+    void visit(const Statement *) {}
+    void visit(const Declaration *) {}
+    void visit(const Definition *) {}
+
+    void visit(const Block *node)
+    {
+        number(node->render_braces());
+        list(node->children());
+    }
+
+    void visit(const TypeNode *node)
+    {
+        symbol(node->name());
+        number(node->is_const());
+        number(node->is_reference());
+        number(node->arr_size());
+        number(node->bitfield());
+        child(node->default_value());
+    }
+
+    void visit(const RawNode *node) { string(node->value()); }
+
+    void visit(const TypeDeclaration *node)
+    {
+        string(node->alias());
+        string(node->type_name());
+    }
+
+    void visit(const StructDeclaration *node) { string(node->name()); }
+    void visit(const UnionDeclaration *node) { string(node->name()); }
+    void visit(const EnumDeclaration *node) { string(node->name()); }
+    void visit(const ClassDeclaration *node) { string(node->name()); }
+
+    void visit(const FunctionParameter *node)
+    {
+        symbol(node->name());
+        symbol(node->type());
+        child(node->default_value());
+        number(node->arr_size());
+        number(node->is_const());
+        number(node->is_reference());
+    }
+
+    void visit(const FunctionDeclaration *node)
+    {
+        string(node->name());
+        string(node->return_type());
+        list(node->parameters());
+        number(node->return_arr_size());
+    }
+
+    void visit(const ExternalDeclaration *node) { child(node->declaration()); }
+
+    void visit(const SubsystemDeclaration *node)
+    {
+        string(node->name());
+        strings(node->dependencies());
+    }
+
+    void visit(const SubsystemDefinition *node)
+    {
+        string(node->name());
+        child(node->block());
+        strings(node->dependencies());
+    }
+
+    void visit(const StructField *node)
+    {
+        symbol(node->name());
+        symbol(node->type());
+        number(node->bitfield());
+        string(node->default_value());
+        number(node->arr_size());
+        list(node->attributes());
+    }
+
+    void visit(const StructMethod *node)
+    {
+        string(node->name());
+        string(node->type());
+        list(node->parameters());
+        child(node->block());
+        range(node->skipped_body());
+    }
+
+    void visit(const StructAttribute *node)
+    {
+        string(node->name());
+        string(node->value());
+    }
+
+    void visit(const StructDefinition *node)
+    {
+        string(node->name());
+        list(node->fields());
+        list(node->methods());
+        number(node->packed());
+    }
+
+    void visit(const UnionField *node)
+    {
+        string(node->name());
+        child(node->dtype());
+    }
+
+    void visit(const UnionDefinition *node)
+    {
+        string(node->name());
+        list(node->fields());
+        number(node->packed());
+    }
+
+    void visit(const FunctionDefinition *node)
+    {
+        string(node->name());
+        string(node->return_type());
+        list(node->parameters());
+        child(node->block());
+        number(node->return_arr_size());
+        range(node->skipped_body());
+    }
+
+    void visit(const BinaryExpression *node)
+    {
+        number(static_cast<uint64_t>(node->op()));
+        child(node->left());
+        child(node->right());
+    }
+
+    void visit(const UnaryExpression *node)
+    {
+        number(static_cast<uint64_t>(node->op()));
+        child(node->expression());
+        number(node->postfix());
+    }
+
+    void visit(const TernaryExpression *node)
+    {
+        child(node->condition());
+        child(node->then_expression());
+        child(node->else_expression());
+    }
+
+    void visit(const CastExpression *node)
+    {
+        symbol(node->type());
+        child(node->expression());
+    }
+
+    void visit(const NullExpression *node) { string(node->type()); }
+
+    void visit(const CallExpression *node)
+    {
+        string(node->name());
+        list(node->arguments());
+    }
+
+    void visit(const IdentifierExpression *node) { symbol(node->name()); }
+
+    void visit(const LiteralExpression *node) { string(node->value()); }
+    void visit(const StringLiteralExpression *node) { string(node->value()); }
+    void visit(const CharLiteralExpression *node) { string(node->value()); }
+    void visit(const IntegerLiteralExpression *node) { string(node->value()); }
+    void visit(const FloatingPointLiteralExpression *node) { string(node->value()); }
+    void visit(const BooleanLiteralExpression *node) { string(node->value()); }
+
+    void visit(const ReturnStatement *node) { child(node->expression()); }
+
+    void visit(const LetDeclaration *node)
+    {
+        child(node->dtype());
+        string(node->name());
+    }
+
+    void visit(const VarDeclaration *node)
+    {
+        child(node->dtype());
+        string(node->name());
+    }
+
+private:
+    std::vector<const GenericNode *> m_queue;
+    std::vector<uint8_t> m_node_data;
+    std::vector<uint32_t> m_node_offsets;
+    std::string m_string_data;
+    std::vector<uint32_t> m_string_offsets;
+    std::unordered_map<std::string_view, uint32_t> m_string_index;
+    /// @brief String table index of each symbol ID, `AstFileRecord::null` until first written
+    std::vector<uint32_t> m_symbol_index;
+
+    void number(uint64_t value)
+    {
+        while (value >= 0x80)
+        {
+            m_node_data.push_back(static_cast<uint8_t>(value) | 0x80);
+            value >>= 7;
+        }
+        m_node_data.push_back(static_cast<uint8_t>(value));
+    }
+
+    /// @brief Get the string table index of a string, adding it if new
+    uint32_t intern(std::string_view str)
+    {
+        auto it = m_string_index.find(str);
+        if (it == m_string_index.end())
+        {
+            // the views point into the nodes, which outlive the encoder
+            it = m_string_index.emplace(str, static_cast<uint32_t>(m_string_offsets.size())).first;
+            m_string_offsets.push_back(static_cast<uint32_t>(m_string_data.size()));
+            m_string_data.append(str);
+        }
+        return it->second;
+    }
+
+    void string(std::string_view str) { number(intern(str)); }
+
+    /// @brief Write a symbol, looked up by ID rather than hashed after its first use
+    void symbol(Symbol sym)
+    {
+        if (sym.id() >= m_symbol_index.size())
+        {
+            m_symbol_index.resize(sym.id() + 1, AstFileRecord::null);
+        }
+        if (m_symbol_index[sym.id()] == AstFileRecord::null)
+        {
+            m_symbol_index[sym.id()] = intern(sym.str());
+        }
+        number(m_symbol_index[sym.id()]);
+    }
+
+    void strings(const std::vector<std::string> &values)
+    {
+        number(values.size());
+        for (const auto &value : values)
+        {
+            string(value);
+        }
+    }
+
+    void child(const GenericNode *node)
+    {
+        if (node == nullptr)
+        {
+            number(0);
+            return;
+        }
+
+        // the child's index is size() - 1, stored plus one to keep 0 for none
+        m_queue.push_back(node);
+        number(m_queue.size());
+    }
+
+    template <typename T>
+    void list(const NodeList<T> &nodes)
+    {
+        number(nodes.size());
+        for (T *node : nodes)
+        {
+            child(node);
+        }
+    }
+
+    void range(const SourceRange &range)
+    {
+        number(range.begin);
+        number(range.end);
+    }
+};
+
+void jcc::AbstractSyntaxTree::write(std::string &out) const
+{
+    AstFileEncoder encoder;
+    if (m_root != nullptr)
+    {
+        encoder.encode(m_root);
+    }
+    encoder.write(out);
+}
+
+bool jcc::AbstractSyntaxTree::save(const std::string &path) const
+{
+    std::string data;
+    write(data);
+
+    // write next to the destination and rename, so readers never see a partial file
+    std::string temp_path = path + ".tmp" + std::to_string(std::random_device{}());
+
+    {
+        std::ofstream out(temp_path, std::ios::binary | std::ios::trunc);
+        if (!out.is_open())
+        {
+            return false;
+        }
+
+        out.write(data.data(), data.size());
+
+        if (!out.good())
+        {
+            out.close();
+            std::remove(temp_path.c_str());
+            return false;
+        }
+    }
+
+    if (std::rename(temp_path.c_str(), path.c_str()) != 0)
+    {
+        std::remove(temp_path.c_str());
+        return false;
+    }
+
+    return true;
+}
+
+///=============================================================================
+/// jcc::AstFileRecord class implementation
+///=============================================================================
+
+static void malformed()
+{
+    throw std::runtime_error("Malformed binary AST");
+}
+
+jcc::AstFileRecord::AstFileRecord(const uint8_t *begin, const uint8_t *end, const uint32_t *string_offsets, const char *string_data, uint32_t strings, uint32_t nodes)
+    : m_cursor(begin), m_end(end), m_string_offsets(string_offsets), m_string_data(string_data), m_strings(strings), m_nodes(nodes)
+{
+    uint64_t type = number();
+    if (type > static_cast<uint64_t>(NodeType::VarDeclaration))
+    {
+        malformed();
+    }
+    m_type = static_cast<NodeType>(type);
+}
+
+uint64_t jcc::AstFileRecord::number()
+{
+    uint64_t value = 0;
+    for (unsigned shift = 0; shift < 64; shift += 7)
+    {
+        if (m_cursor == m_end)
+        {
+            malformed();
+        }
+
+        uint8_t byte = *m_cursor++;
+        value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+        if ((byte & 0x80) == 0)
+        {
+            return value;
+        }
+    }
+
+    malformed();
+    return 0;
+}
+
+std::string_view jcc::AstFileRecord::string()
+{
+    uint64_t index = number();
+    if (index >= m_strings)
+    {
+        malformed();
+    }
+
+    return std::string_view(m_string_data + m_string_offsets[index], m_string_offsets[index + 1] - m_string_offsets[index]);
+}
+
+uint32_t jcc::AstFileRecord::node()
+{
+    uint64_t ref = number();
+    if (ref == 0)
+    {
+        return null;
+    }
+    if (ref > m_nodes)
+    {
+        malformed();
+    }
+
+    return static_cast<uint32_t>(ref - 1);
+}
+
+uint32_t jcc::AstFileRecord::count()
+{
+    uint64_t count = number();
+
+    // every element takes at least a byte
+    if (count > static_cast<uint64_t>(m_end - m_cursor))
+    {
+        malformed();
+    }
+
+    return static_cast<uint32_t>(count);
+}
+
+///=============================================================================
+/// jcc::AstFileView class implementation
+///=============================================================================
+
+bool jcc::AstFileView::open(std::string_view data)
+{
+    *this = AstFileView();
+
+    JastHeader header;
+    if (data.size() < sizeof(header) || reinterpret_cast<uintptr_t>(data.data()) % alignof(uint32_t) != 0)
+    {
+        return false;
+    }
+    std::memcpy(&header, data.data(), sizeof(header));
+
+    if (std::memcmp(header.magic, "JAST", 4) != 0 || header.version != astFileVersion)
+    {
+        return false;
+    }
+
+    uint64_t expected_size = sizeof(header) + (uint64_t(header.strings) + 1 + uint64_t(header.nodes) + 1) * sizeof(uint32_t) +
+                             header.string_data_size + header.node_data_size;
+    if (data.size() != expected_size)
+    {
+        return false;
+    }
+
+    const char *cursor = data.data() + sizeof(header);
+    const uint32_t *string_offsets = reinterpret_cast<const uint32_t *>(cursor);
+    const uint32_t *node_offsets = string_offsets + header.strings + 1;
+    const char *string_data = reinterpret_cast<const char *>(node_offsets + header.nodes + 1);
+    const uint8_t *node_data = reinterpret_cast<const uint8_t *>(string_data + header.string_data_size);
+
+    // with sorted, bounded offsets every record and string lies inside the buffer
+    auto check = [](const uint32_t *offsets, uint32_t count, uint64_t size)
+    {
+        for (uint32_t i = 0; i < count; i++)
+        {
+            if (offsets[i] > offsets[i + 1])
+            {
+                return false;
+            }
+        }
+        return offsets[count] == size;
+    };
+
+    if (!check(string_offsets, header.strings, header.string_data_size) || !check(node_offsets, header.nodes, header.node_data_size))
+    {
+        return false;
+    }
+
+    m_string_offsets = string_offsets;
+    m_node_offsets = node_offsets;
+    m_string_data = string_data;
+    m_node_data = node_data;
+    m_strings = header.strings;
+    m_nodes = header.nodes;
+    return true;
+}
+
+std::string_view jcc::AstFileView::string(uint32_t index) const
+{
+    if (index >= m_strings)
+    {
+        malformed();
+    }
+
+    return std::string_view(m_string_data + m_string_offsets[index], m_string_offsets[index + 1] - m_string_offsets[index]);
+}
+
+jcc::AstFileRecord jcc::AstFileView::record(uint32_t index) const
+{
+    if (index >= m_nodes)
+    {
+        malformed();
+    }
+
+    return AstFileRecord(m_node_data + m_node_offsets[index], m_node_data + m_node_offsets[index + 1], m_string_offsets, m_string_data, m_strings, m_nodes);
+}
+
+///=============================================================================
+/// Reader
+///=============================================================================
+
+/// @brief Rebuilds the nodes of a binary AST, children before parents
+class AstFileDecoder
+{
+public:
+    AstFileDecoder(const AstFileView &view) : m_view(view), m_nodes(view.node_count(), nullptr) {}
+
+    GenericNode *decode()
+    {
+        if (m_nodes.empty())
+        {
+            return nullptr;
+        }
+
+        for (uint32_t i = static_cast<uint32_t>(m_nodes.size()); i-- > 0;)
+        {
+            m_index = i;
+            AstFileRecord record = m_view.record(i);
+            m_nodes[i] = node(record);
+            if (!record.done())
+            {
+                malformed();
+            }
+        }
+
+        return m_nodes[0];
+    }
+
+private:
+    const AstFileView &m_view;
+    std::vector<GenericNode *> m_nodes;
+    uint32_t m_index = 0;
+
+    /// @brief Take a child, which must already be decoded and belong to `T`
+    template <typename T>
+    T *child(AstFileRecord &record)
+    {
+        uint32_t index = record.node();
+        if (index == AstFileRecord::null)
+        {
+            return nullptr;
+        }
+
+        // breadth-first numbering puts children after their parent, and each is referenced once
+        if (index <= m_index || m_nodes[index] == nullptr)
+        {
+            malformed();
+        }
+
+        T *node = dynamic_cast<T *>(m_nodes[index]);
+        if (node == nullptr)
+        {
+            malformed();
+        }
+
+        m_nodes[index] = nullptr;
+        return node;
+    }
+
+    template <typename T>
+    T *required(AstFileRecord &record)
+    {
+        T *node = child<T>(record);
+        if (node == nullptr)
+        {
+            malformed();
+        }
+        return node;
+    }
+
+    template <typename T>
+    NodeList<T> list(AstFileRecord &record)
+    {
+        NodeList<T> nodes;
+        for (uint32_t count = record.count(); count > 0; count--)
+        {
+            nodes.push_back(required<T>(record));
+        }
+        return nodes;
+    }
+
+    static std::string string(AstFileRecord &record) { return std::string(record.string()); }
+    static Symbol symbol(AstFileRecord &record) { return Symbol(record.string()); }
+
+    static std::vector<std::string> strings(AstFileRecord &record)
+    {
+        std::vector<std::string> values(record.count());
+        for (auto &value : values)
+        {
+            value = string(record);
+        }
+        return values;
+    }
+
+    static SourceRange range(AstFileRecord &record)
+    {
+        SourceRange range;
+        range.begin = static_cast<uint32_t>(record.number());
+        range.end = static_cast<uint32_t>(record.number());
+        return range;
+    }
+
+    static Operator op(AstFileRecord &record)
+    {
+        uint64_t value = record.number();
+        if (lexOperatorMapReverse.find(static_cast<Operator>(value)) == lexOperatorMapReverse.end())
+        {
+            malformed();
+        }
+        return static_cast<Operator>(value);
+    }
+
+    GenericNode *node(AstFileRecord &record)
+    {
+        switch (record.type())
+        {
+        case NodeType::Invalid:
+            // never written: a tree with invalid nodes cannot be visited
+            break;
+        case NodeType::Expression:
+            return make_node<Expression>();
+        case NodeType::Statement:
+            return make_node<Statement>();
+        case NodeType::Declaration:
+            return make_node<Declaration>();
+        case NodeType::Definition:
+            return make_node<Definition>();
+        case NodeType::Block:
+        {
+            bool render_braces = record.flag();
+            return make_node<Block>(list<GenericNode>(record), render_braces);
+        }
+        case NodeType::TypeNode:
+        {
+            Symbol name = symbol(record);
+            bool is_const = record.flag();
+            bool is_reference = record.flag();
+            size_t arr_size = record.number();
+            size_t bitfield = record.number();
+            return make_node<TypeNode>(name, is_const, is_reference, arr_size, bitfield, child<Expression>(record));
+        }
+        case NodeType::RawNode:
+            return make_node<RawNode>(string(record));
+        case NodeType::TypeDeclaration:
+        {
+            std::string alias = string(record);
+            return make_node<TypeDeclaration>(alias, string(record));
+        }
+        case NodeType::StructDeclaration:
+            return make_node<StructDeclaration>(string(record));
+        case NodeType::UnionDeclaration:
+            return make_node<UnionDeclaration>(string(record));
+        case NodeType::EnumDeclaration:
+            return make_node<EnumDeclaration>(string(record));
+        case NodeType::ClassDeclaration:
+            return make_node<ClassDeclaration>(string(record));
+        case NodeType::FunctionParameter:
+        {
+            Symbol name = symbol(record);
+            Symbol type = symbol(record);
+            Expression *default_value = child<Expression>(record);
+            uint64_t arr_size = record.number();
+            bool is_const = record.flag();
+            return make_node<FunctionParameter>(name, type, default_value, arr_size, is_const, record.flag());
+        }
+        case NodeType::FunctionDeclaration:
+        {
+            std::string name = string(record);
+            std::string return_type = string(record);
+            NodeList<FunctionParameter> parameters = list<FunctionParameter>(record);
+            return make_node<FunctionDeclaration>(name, return_type, parameters, record.number());
+        }
+        case NodeType::ExternalDeclaration:
+            return make_node<ExternalDeclaration>(required<Declaration>(record));
+        case NodeType::SubsystemDeclaration:
+        {
+            std::string name = string(record);
+            return make_node<SubsystemDeclaration>(name, strings(record));
+        }
+        case NodeType::SubsystemDefinition:
+        {
+            std::string name = string(record);
+            Block *block = required<Block>(record);
+            return make_node<SubsystemDefinition>(name, block, strings(record));
+        }
+        case NodeType::StructField:
+        {
+            Symbol name = symbol(record);
+            Symbol type = symbol(record);
+            uint64_t bitfield = record.number();
+            std::string default_value = string(record);
+            uint64_t arr_size = record.number();
+            return make_node<StructField>(name, type, bitfield, default_value, arr_size, list<StructAttribute>(record));
+        }
+        case NodeType::StructMethod:
+        {
+            std::string name = string(record);
+            std::string type = string(record);
+            NodeList<FunctionParameter> parameters = list<FunctionParameter>(record);
+            auto method = make_node<StructMethod>(name, type, parameters, child<Block>(record));
+            method->skipped_body() = range(record);
+            return method;
+        }
+        case NodeType::StructAttribute:
+        {
+            std::string name = string(record);
+            return make_node<StructAttribute>(name, string(record));
+        }
+        case NodeType::StructDefinition:
+        {
+            std::string name = string(record);
+            NodeList<StructField> fields = list<StructField>(record);
+            NodeList<StructMethod> methods = list<StructMethod>(record);
+            return make_node<StructDefinition>(name, fields, methods, record.flag());
+        }
+        case NodeType::UnionField:
+        {
+            std::string name = string(record);
+            return make_node<UnionField>(name, required<TypeNode>(record));
+        }
+        case NodeType::UnionDefinition:
+        {
+            std::string name = string(record);
+            NodeList<UnionField> fields = list<UnionField>(record);
+            return make_node<UnionDefinition>(name, fields, record.flag());
+        }
+        case NodeType::FunctionDefinition:
+        {
+            std::string name = string(record);
+            std::string return_type = string(record);
+            NodeList<FunctionParameter> parameters = list<FunctionParameter>(record);
+            Block *block = child<Block>(record);
+            auto function = make_node<FunctionDefinition>(name, return_type, parameters, block, record.number());
+            function->skipped_body() = range(record);
+            return function;
+        }
+        case NodeType::BinaryExpression:
+        {
+            Operator binop = op(record);
+            Expression *left = required<Expression>(record);
+            return make_node<BinaryExpression>(binop, left, required<Expression>(record));
+        }
+        case NodeType::UnaryExpression:
+        {
+            Operator unop = op(record);
+            Expression *expression = required<Expression>(record);
+            return make_node<UnaryExpression>(unop, expression, record.flag());
+        }
+        case NodeType::TernaryExpression:
+        {
+            Expression *condition = required<Expression>(record);
+            Expression *then_expression = required<Expression>(record);
+            return make_node<TernaryExpression>(condition, then_expression, required<Expression>(record));
+        }
+        case NodeType::CastExpression:
+        {
+            Symbol type = symbol(record);
+            return make_node<CastExpression>(type, required<Expression>(record));
+        }
+        case NodeType::NullExpression:
+            return make_node<NullExpression>(string(record));
+        case NodeType::CallExpression:
+        {
+            std::string name = string(record);
+            return make_node<CallExpression>(name, list<Expression>(record));
+        }
+        case NodeType::IdentifierExpression:
+            return make_node<IdentifierExpression>(symbol(record));
+        case NodeType::LiteralExpression:
+            return make_node<LiteralExpression>(string(record));
+        case NodeType::StringLiteralExpression:
+            return make_node<StringLiteralExpression>(string(record));
+        case NodeType::CharLiteralExpression:
+            return make_node<CharLiteralExpression>(string(record));
+        case NodeType::IntegerLiteralExpression:
+            return make_node<IntegerLiteralExpression>(string(record));
+        case NodeType::FloatingPointLiteralExpression:
+            return make_node<FloatingPointLiteralExpression>(string(record));
+        case NodeType::BooleanLiteralExpression:
+            return make_node<BooleanLiteralExpression>(string(record));
+        case NodeType::ReturnStatement:
+            return make_node<ReturnStatement>(child<Expression>(record));
+        case NodeType::LetDeclaration:
+        {
+            TypeNode *dtype = required<TypeNode>(record);
+            return make_node<LetDeclaration>(dtype, string(record));
+        }
+        case NodeType::VarDeclaration:
+        {
+            TypeNode *dtype = required<TypeNode>(record);
+            return make_node<VarDeclaration>(dtype, string(record));
+        }
+        }
+
+        malformed();
+        return nullptr;
+    }
+};
+
+std::shared_ptr<jcc::AbstractSyntaxTree> jcc::AbstractSyntaxTree::read(std::string_view data)
+{
+    AstFileView view;
+    if (!view.open(data))
+    {
+        return nullptr;
+    }
+
+    auto arena = std::make_shared<AstArena>();
+    AstArena::Scope scope(*arena);
+
+    try
+    {
+        GenericNode *root = AstFileDecoder(view).decode();
+        return std::make_shared<AbstractSyntaxTree>(std::move(arena), root);
+    }
+    catch (const std::runtime_error &)
+    {
+        return nullptr;
+    }
+}
+
+std::shared_ptr<jcc::AbstractSyntaxTree> jcc::AbstractSyntaxTree::load(const std::string &path)
+{
+    SourceFile file;
+    if (!file.open(path))
+    {
+        return nullptr;
+    }
+
+    return read(file.contents());
+}
@@ -269,6 +269,7 @@ jcc::CompilationUnit::CompilationUnit()
     m_cxx_temp_files = {};
     m_obj_temp_files = {};
     m_success = false;
+    m_max_nesting = parseMaxNestingDefault;
 }
 
 jcc::CompilationUnit::~CompilationUnit()
@@ -310,6 +311,16 @@ void jcc::CompilationUnit::set_output_file(const std::string &file)
     m_output_file = file;
 }
 
+void jcc::CompilationUnit::set_token_cache(const std::string &directory)
+{
+    m_token_cache = directory;
+}
+
+void jcc::CompilationUnit::set_max_nesting(size_t depth)
+{
+    m_max_nesting = depth;
+}
+
 const std::vector<std::string> &jcc::CompilationUnit::files() const
 {
     return m_files;
@@ -447,6 +458,7 @@ void jcc::CompilationUnit::reset_instance()
     this->m_cxx_temp_files.clear();
     this->m_obj_temp_files.clear();
     this->m_success = false;
+    this->m_source.reset();
 }
 
 bool jcc::CompilationUnit::build()
@@ -570,140 +582,81 @@ bool jcc::CompilationUnit::build()
     return true;
 }
 
-// https://stackoverflow.com/questions/28270310/how-to-easily-detect-utf8-encoding-in-the-string
-static bool is_valid_utf8(const std::string &input)
-{
-    if (input.empty())
-        return true;
-
-    const unsigned char *bytes = (const unsigned char *)input.c_str();
-    unsigned int cp;
-    int num;
-
-    while (*bytes != 0x00)
-    {
-        if ((*bytes & 0x80) == 0x00)
-        {
-            // U+0000 to U+007F
-            cp = (*bytes & 0x7F);
-            num = 1;
-        }
-        else if ((*bytes & 0xE0) == 0xC0)
-        {
-            // U+0080 to U+07FF
-            cp = (*bytes & 0x1F);
-            num = 2;
-        }
-        else if ((*bytes & 0xF0) == 0xE0)
-        {
-            // U+0800 to U+FFFF
-            cp = (*bytes & 0x0F);
-            num = 3;
-        }
-        else if ((*bytes & 0xF8) == 0xF0)
-        {
-            // U+10000 to U+10FFFF
-            cp = (*bytes & 0x07);
-            num = 4;
-        }
-        else
-            return false;
-
-        bytes += 1;
-        for (int i = 1; i < num; ++i)
-        {
-            if ((*bytes & 0xC0) != 0x80)
-                return false;
-            cp = (cp << 6) | (*bytes & 0x3F);
-            bytes += 1;
-        }
-
-        if ((cp > 0x10FFFF) ||
-            ((cp >= 0xD800) && (cp <= 0xDFFF)) ||
-            ((cp <= 0x007F) && (num != 1)) ||
-            ((cp >= 0x0080) && (cp <= 0x07FF) && (num != 2)) ||
-            ((cp >= 0x0800) && (cp <= 0xFFFF) && (num != 3)) ||
-            ((cp >= 0x10000) && (cp <= 0x1FFFFF) && (num != 4)))
-            return false;
-    }
-
-    return true;
-}
-
-bool jcc::CompilationUnit::read_source_code(const std::string &filepath, std::string &source_code)
+bool jcc::CompilationUnit::read_source_code(const std::string &filepath, SourceFile &source_code)
 {
-    std::ifstream file(filepath, std::ios::binary | std::ios::ate);
-
-    if (!file.is_open())
+    if (!source_code.open(filepath))
     {
         this->push_message(CompilerMessageType::Error, "Unable to open file '" + filepath + "' for reading");
         return false;
     }
 
-    std::streampos sizepos = file.tellg();
+    // validate UTF-8 and look for non-ASCII bytes in the same pass
+    Utf8Scan scan = scan_utf8(source_code.contents().data(), source_code.size());
 
-    if (file.fail())
+    if (!scan.valid)
     {
-        this->push_message(CompilerMessageType::Error, "Unable to get size of file '" + filepath + "'");
-        file.close();
+        this->push_message(CompilerMessageType::Error, "File '" + filepath + "' is not a valid J++ source file (invalid UTF-8)");
         return false;
     }
 
-    if (sizepos == 0)
+    if (!scan.ascii)
     {
-        file.close();
-        source_code = "";
-        return true;
+        this->push_message(CompilerMessageType::Info, "File contains non-ASCII characters. This is fine, just a heads up.");
     }
 
-    if (sizepos == INT64_MAX)
+    return true;
+}
+
+jcc::TokenList jcc::CompilationUnit::lex_cached(LexMode mode)
+{
+    if (m_token_cache.empty())
     {
-        this->push_message(CompilerMessageType::Error, "Unable to get size of file '" + filepath + "'");
-        file.close();
-        return false;
+        return lex(m_source, mode);
     }
 
-    file.seekg(0, std::ios::beg);
-
-    source_code.resize(sizepos);
+    std::string key = crypto::sha256(m_source->data(), m_source->size());
 
-    if (!file.read(source_code.data(), sizepos))
+    static const char hex[] = "0123456789abcdef";
+    std::string name;
+    for (unsigned char c : key)
     {
-        this->push_message(CompilerMessageType::Error, "Unable to read file '" + filepath + "'");
-        file.close();
-        return false;
+        name += hex[c >> 4];
+        name += hex[c & 0xf];
     }
-
-    file.close();
-
-    // prelininary check for UTF-8
-    if (!is_valid_utf8(source_code))
+    if (mode == LexMode::Full)
     {
-        this->push_message(CompilerMessageType::Error, "File '" + filepath + "' is not a valid J++ source file (invalid UTF-8)");
-        return false;
+        name += "-full";
     }
 
-    bool found_non_ascii = false;
-    for (const auto &c : source_code)
+    std::string path = (std::filesystem::path(m_token_cache) / (name + ".jtok")).string();
+
+    TokenList tokens;
+    if (tokens.load(path, m_source, key, mode))
     {
-        if (c & 0x80)
-        {
-            found_non_ascii = true;
-            break;
-        }
+        return tokens;
     }
-    if (found_non_ascii)
+
+    tokens = lex(m_source, mode);
+
+    // the cache is an optimization; a read-only or missing directory only costs the relex
+    std::error_code ec;
+    std::filesystem::create_directories(m_token_cache, ec);
+    if (!tokens.save(path, key, mode) && m_flags.find(CompileFlag::Verbose) != m_flags.end())
     {
-        this->push_message(CompilerMessageType::Info, "File contains non-ASCII characters. This is fine, just a heads up.");
+        this->push_message(CompilerMessageType::Warning, "Unable to write token cache '" + path + "'");
     }
 
-    return true;
+    return tokens;
 }
 
 bool jcc::CompilationUnit::compile_file(const std::string &file)
 {
-    std::string source_code, preprocessed_code;
+    SourceFile source_code;
+    std::string preprocessed_code;
     TokenList tokens;
+    bool dump_tokens = m_flags.find(CompileFlag::DumpTokens) != m_flags.end();
+    bool dump_ast = m_flags.find(CompileFlag::DumpAst) != m_flags.end();
+    bool emit_ast_binary = m_flags.find(CompileFlag::EmitAstBinary) != m_flags.end();
 
     if (!read_source_code(file, source_code))
     {
@@ -719,7 +672,7 @@ bool jcc::CompilationUnit::compile_file(const std::string &file)
 
     try
     {
-        preprocessed_code = Preprocessor::preprocess(source_code);
+        preprocessed_code = Preprocessor::preprocess(source_code.contents());
     }
     catch (const PreprocessorImportNotFoundException &e)
     {
@@ -756,7 +709,10 @@ bool jcc::CompilationUnit::compile_file(const std::string &file)
 
     try
     {
-        tokens = lex(preprocessed_code);
+        m_source = std::make_shared<const std::string>(std::move(preprocessed_code));
+
+        // comments only matter to the token dump
+        tokens = lex_cached(dump_tokens ? LexMode::Full : LexMode::NoTrivia);
     }
     catch (const LexerException &e)
     {
@@ -770,43 +726,68 @@ bool jcc::CompilationUnit::compile_file(const std::string &file)
         return false;
     }
 
-    std::ofstream lexOut(file + ".lex.json");
-    if (lexOut.is_open())
+    if (dump_tokens)
     {
-        lexOut << tokens.to_json();
-        lexOut.close();
+        std::ofstream lexOut(file + ".lex.json");
+        if (lexOut.is_open())
+        {
+            JsonWriter writer(lexOut);
+            tokens.to_json(writer);
+            writer.flush();
+            lexOut.close();
+        }
     }
 
     std::shared_ptr<AbstractSyntaxTree> ast;
 
+    std::vector<ParserDiagnostic> diagnostics;
+
     try
     {
-        ast = parse(tokens);
+        // declarations unchanged since the last build of the file are not parsed again
+        TokenCursor cursor(tokens);
+        std::shared_ptr<AbstractSyntaxTree> &previous = m_trees[file];
+        ast = reparse(cursor, previous, diagnostics, m_max_nesting);
+
+        // a version with syntax errors is a poor base for the next one, which is likely to fix them
+        if (diagnostics.empty() || previous == nullptr)
+        {
+            previous = ast;
+        }
     }
-    catch (const SyntaxError &e)
+    catch (const std::exception &e)
     {
-        this->push_message(CompilerMessageType::Error, "Syntax error: " + std::string(e.what()));
+        this->push_message(CompilerMessageType::Error, "Internal compiler error: Parser::parse(" + std::string(e.what()) + ")");
+        panic("Caught unexpected exception in Parser::parse()");
         return false;
     }
-    catch (const SemanticError &e)
+
+    // the recovered tree is dumped too, so tools can inspect a file with syntax errors
+    if (dump_ast && ast != nullptr)
     {
-        this->push_message(CompilerMessageType::Error, "Semantic error: " + std::string(e.what()));
-        return false;
+        std::ofstream astOut(file + ".ast.json");
+        if (astOut.is_open())
+        {
+            JsonWriter writer(astOut);
+            ast->to_json(writer);
+            writer.flush();
+            astOut.close();
+        }
     }
-    catch (const UnexpectedTokenError &e)
+
+    if (emit_ast_binary && ast != nullptr && !ast->save(file + ".jast"))
     {
-        this->push_message(CompilerMessageType::Error, "Unexpected token: " + std::string(e.what()));
-        return false;
+        this->push_message(CompilerMessageType::Warning, "Unable to write binary AST for '" + file + "'");
     }
-    catch (const ParserException &e)
+
+    // the parser recovers from syntax errors, so all of them are reported at once
+    for (const auto &diagnostic : diagnostics)
     {
-        this->push_message(CompilerMessageType::Error, "Parser error: " + std::string(e.what()));
-        return false;
+        this->push_message(CompilerMessageType::Error, "Syntax error: " + diagnostic.message, "", diagnostic.location.line, diagnostic.location.column);
     }
-    catch (const std::exception &e)
+
+    if (!diagnostics.empty())
     {
-        this->push_message(CompilerMessageType::Error, "Internal compiler error: Parser::parse(" + std::string(e.what()) + ")");
-        panic("Caught unexpected exception in Parser::parse()");
         return false;
     }
 
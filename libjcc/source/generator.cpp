@@ -1,4 +1,5 @@
 #include <string>
+#include <string_view>
 #include <vector>
 #include <iostream>
 #include <memory>
@@ -8,6 +9,8 @@
 #include <ctime>
 #include <limits>
 #include <map>
+#include <unordered_map>
+#include <unordered_set>
 #include <cstdint>
 #include <cstddef>
 #include <mutex>
@@ -15,12 +18,15 @@
 #define _JCC_BACKEND_
 #include "sha256.hpp"
 #include "compile.hpp"
+#include "visitor.hpp"
 
 #define INDENT_SIZE 4
 
 using namespace jcc;
 
 static std::map<size_t, std::string> g_typenames_mapping;
+/// @brief The qualified names in g_typenames_mapping, viewing the strings it owns
+static std::unordered_set<std::string_view> g_defined_typenames;
 static std::mutex g_typenames_mapping_mutex;
 static bool g_has_main = false;
 static std::mutex g_has_main_mutex;
@@ -75,6 +81,34 @@ static std::string rectify_type(const std::string &type)
     return string;
 }
 
+/// @brief Rectify an interned name, memoized per symbol
+static const std::string &rectify_name(Symbol name)
+{
+    thread_local std::unordered_map<uint32_t, std::string> cache;
+
+    auto it = cache.find(name.id());
+    if (it == cache.end())
+    {
+        it = cache.emplace(name.id(), rectify_name(std::string(name.str()))).first;
+    }
+
+    return it->second;
+}
+
+/// @brief Rectify an interned type name, memoized per symbol
+static const std::string &rectify_type(Symbol type)
+{
+    thread_local std::unordered_map<uint32_t, std::string> cache;
+
+    auto it = cache.find(type.id());
+    if (it == cache.end())
+    {
+        it = cache.emplace(type.id(), rectify_type(std::string(type.str()))).first;
+    }
+
+    return it->second;
+}
+
 static std::string string_escape_string(const std::string &s)
 {
     std::string result;
@@ -150,80 +184,146 @@ static std::string mkpadding(uint32_t indent)
     return result;
 }
 
-static std::string generate_node_cxx(const std::shared_ptr<jcc::GenericNode> &node, uint32_t &indent, std::string &_subsystem);
+static std::string generate_node_cxx(jcc::GenericNode *node, uint32_t &indent, std::string &_subsystem);
 
-static std::string generate_block_cxx(const std::shared_ptr<jcc::GenericNode> &node, uint32_t &indent, std::string &_subsystem)
+static std::string generate_subsystem_head_cxx(jcc::GenericNode *node, uint32_t &indent, std::string &_subsystem);
+
+/// @brief A block whose children generate_block_cxx is emitting
+struct BlockFrame
 {
-    std::string result;
+    Block *block;
+    size_t next;
+    /// @brief Set for a subsystem body: the enclosing subsystem, restored once the body is closed
+    bool subsystem;
+    std::string enclosing;
+};
 
-    auto block = std::static_pointer_cast<Block>(node);
+/// @note Nested blocks and subsystem bodies are walked with an explicit stack
+/// on the heap, so the nesting depth of a tree does not bound the native stack.
+static std::string generate_block_cxx(jcc::GenericNode *node, uint32_t &indent, std::string &_subsystem)
+{
+    std::string result;
+    std::vector<BlockFrame> stack;
 
-    if (block->render_braces())
+    auto open = [&](jcc::GenericNode *body)
     {
-        result += mkpadding(indent) + "{\n";
-        indent += INDENT_SIZE;
-    }
+        if (body == nullptr)
+        {
+            // bodies left out by CompilationUnit::skim must be parsed before generating code
+            throw std::runtime_error("Function body was not parsed");
+        }
 
-    for (const auto &child : block->children())
-    {
-        result += generate_node_cxx(child, indent, _subsystem);
-    }
+        auto block = static_cast<Block *>(body);
 
-    if (block->render_braces())
+        if (block->render_braces())
+        {
+            result += mkpadding(indent) + "{\n";
+            indent += INDENT_SIZE;
+        }
+
+        stack.push_back({block, 0, false, {}});
+    };
+
+    open(node);
+
+    while (!stack.empty())
     {
-        indent -= INDENT_SIZE;
-        result += mkpadding(indent) + "}\n";
+        BlockFrame &frame = stack.back();
+
+        if (frame.next == frame.block->children().size())
+        {
+            if (frame.block->render_braces())
+            {
+                indent -= INDENT_SIZE;
+                result += mkpadding(indent) + "}\n";
+            }
+
+            if (frame.subsystem)
+            {
+                result += "\n";
+                _subsystem = std::move(frame.enclosing);
+            }
+
+            stack.pop_back();
+            continue;
+        }
+
+        jcc::GenericNode *child = frame.block->children()[frame.next++];
+
+        switch (child->type())
+        {
+        case NodeType::Block:
+            open(child);
+            break;
+        case NodeType::SubsystemDefinition:
+        {
+            auto subsysdef = static_cast<SubsystemDefinition *>(child);
+            std::string enclosing = _subsystem;
+
+            result += generate_subsystem_head_cxx(child, indent, _subsystem);
+            _subsystem = get_qualified_typename(rectify_name(subsysdef->name()), _subsystem);
+
+            open(subsysdef->block());
+            stack.back().subsystem = true;
+            stack.back().enclosing = std::move(enclosing);
+            break;
+        }
+        default:
+            result += generate_node_cxx(child, indent, _subsystem);
+            break;
+        }
     }
+
     return result;
 }
 
-static std::string generate_typedef_cxx(const std::shared_ptr<jcc::GenericNode> &node, uint32_t &indent, std::string &_subsystem)
+static std::string generate_typedef_cxx(jcc::GenericNode *node, uint32_t &indent, std::string &_subsystem)
 {
     (void)_subsystem;
 
-    auto typedefdef = std::static_pointer_cast<TypeDeclaration>(node);
+    auto typedefdef = static_cast<TypeDeclaration *>(node);
     std::string result = mkpadding(indent) + "typedef " + rectify_type(typedefdef->type_name()) + " " + rectify_type(typedefdef->alias()) + ";\n";
 
     return result;
 }
 
-static std::string generate_struct_declaration_cxx(const std::shared_ptr<jcc::GenericNode> &node, uint32_t &indent, std::string &_subsystem)
+static std::string generate_struct_declaration_cxx(jcc::GenericNode *node, uint32_t &indent, std::string &_subsystem)
 {
     (void)_subsystem;
 
-    auto structdef = std::static_pointer_cast<StructDeclaration>(node);
+    auto structdef = static_cast<StructDeclaration *>(node);
     std::string result = mkpadding(indent) + "struct " + rectify_name(structdef->name()) + ";\n";
 
     return result;
 }
 
-static std::string generate_union_declaration_cxx(const std::shared_ptr<jcc::GenericNode> &node, uint32_t &indent, std::string &_subsystem)
+static std::string generate_union_declaration_cxx(jcc::GenericNode *node, uint32_t &indent, std::string &_subsystem)
 {
     (void)_subsystem;
 
-    auto uniondef = std::static_pointer_cast<UnionDeclaration>(node);
+    auto uniondef = static_cast<UnionDeclaration *>(node);
     std::string result = mkpadding(indent) + "union " + rectify_name(uniondef->name()) + ";\n";
 
     return result;
 }
 
-static std::string generate_enum_declaration_cxx(const std::shared_ptr<jcc::GenericNode> &node, uint32_t &indent, std::string &_subsystem)
+static std::string generate_enum_declaration_cxx(jcc::GenericNode *node, uint32_t &indent, std::string &_subsystem)
 {
     (void)_subsystem;
 
-    auto enumdef = std::static_pointer_cast<EnumDeclaration>(node);
+    auto enumdef = static_cast<EnumDeclaration *>(node);
     std::string result = mkpadding(indent) + "enum " + rectify_name(enumdef->name()) + ";\n";
 
     return result;
 }
 
-static std::string generate_let_declaration_cxx(const std::shared_ptr<jcc::GenericNode> &node, uint32_t &indent, std::string &_subsystem)
+static std::string generate_let_declaration_cxx(jcc::GenericNode *node, uint32_t &indent, std::string &_subsystem)
 {
     (void)_subsystem;
 
     std::string result = mkpadding(indent);
 
-    auto letdef = std::static_pointer_cast<LetDeclaration>(node);
+    auto letdef = static_cast<LetDeclaration *>(node);
     auto type = letdef->dtype();
 
     if (type->is_const())
@@ -260,9 +360,9 @@ static std::string generate_let_declaration_cxx(const std::shared_ptr<jcc::Gener
     return result;
 }
 
-static std::string generate_function_parameter_cxx(const std::shared_ptr<jcc::GenericNode> &node, uint32_t &indent, std::string &_subsystem)
+static std::string generate_function_parameter_cxx(jcc::GenericNode *node, uint32_t &indent, std::string &_subsystem)
 {
-    auto param = std::static_pointer_cast<FunctionParameter>(node);
+    auto param = static_cast<FunctionParameter *>(node);
     std::string result;
 
     if (param->arr_size() == std::numeric_limits<uint64_t>::max())
@@ -310,20 +410,19 @@ static std::string generate_function_parameter_cxx(const std::shared_ptr<jcc::Ge
     return result;
 }
 
-static std::string generate_function_declaration_cxx(const std::shared_ptr<jcc::GenericNode> &node, uint32_t &indent, std::string &_subsystem)
+static std::string generate_function_declaration_cxx(jcc::GenericNode *node, uint32_t &indent, std::string &_subsystem)
 {
-    auto func = std::static_pointer_cast<FunctionDeclaration>(node);
+    auto func = static_cast<FunctionDeclaration *>(node);
     std::string result = mkpadding(indent);
 
-    if (func->name() == "Main" && _subsystem.empty())
+    // the tree is never modified; it may be shared with a later version of the source
+    std::string return_type = func->return_type();
+    if (func->name() == "Main" && _subsystem.empty() && return_type == "void")
     {
-        if (func->return_type() == "void")
-        {
-            func->return_type() = "int";
-        }
+        return_type = "int";
     }
 
-    if (func->return_type().empty())
+    if (return_type.empty())
     {
         result += "[[noreturn]] _void";
     }
@@ -331,15 +430,15 @@ static std::string generate_function_declaration_cxx(const std::shared_ptr<jcc::
     {
         if (func->return_arr_size() == std::numeric_limits<uint64_t>::max())
         {
-            result += "std::vector<" + rectify_type(func->return_type()) + ">";
+            result += "std::vector<" + rectify_type(return_type) + ">";
         }
         else if (func->return_arr_size() > 0)
         {
-            result += "std::array<" + rectify_type(func->return_type()) + ", " + std::to_string(func->return_arr_size()) + "> ";
+            result += "std::array<" + rectify_type(return_type) + ", " + std::to_string(func->return_arr_size()) + "> ";
         }
         else
         {
-            result += rectify_type(func->return_type());
+            result += rectify_type(return_type);
         }
     }
 
@@ -360,22 +459,23 @@ static std::string generate_function_declaration_cxx(const std::shared_ptr<jcc::
     return result;
 }
 
-static std::string generate_class_declaration_cxx(const std::shared_ptr<jcc::GenericNode> &node, uint32_t &indent, std::string &_subsystem)
+static std::string generate_class_declaration_cxx(jcc::GenericNode *node, uint32_t &indent, std::string &_subsystem)
 {
     (void)_subsystem;
 
-    auto classdef = std::static_pointer_cast<ClassDeclaration>(node);
+    auto classdef = static_cast<ClassDeclaration *>(node);
     std::string result = mkpadding(indent) + "class " + rectify_name(classdef->name()) + ";\n";
 
     return result;
 }
 
-static std::string generate_extern_declaration_cxx(const std::shared_ptr<jcc::GenericNode> &node, uint32_t &indent, std::string &_subsystem)
+static std::string generate_extern_declaration_cxx(jcc::GenericNode *node, uint32_t &indent, std::string &_subsystem)
 {
     (void)_subsystem;
 
-    auto externdef = std::static_pointer_cast<ExternalDeclaration>(node);
+    auto externdef = static_cast<ExternalDeclaration *>(node);
 
+    (void)externdef;
     (void)indent;
 
     /// TODO: Implement this function.
@@ -384,11 +484,11 @@ static std::string generate_extern_declaration_cxx(const std::shared_ptr<jcc::Ge
     return "";
 }
 
-static std::string generate_subsystem_declaration_cxx(const std::shared_ptr<jcc::GenericNode> &node, uint32_t &indent, std::string &_subsystem)
+static std::string generate_subsystem_declaration_cxx(jcc::GenericNode *node, uint32_t &indent, std::string &_subsystem)
 {
     (void)_subsystem;
 
-    auto subsysdecl = std::static_pointer_cast<SubsystemDeclaration>(node);
+    auto subsysdecl = static_cast<SubsystemDeclaration *>(node);
 
     std::string result;
     result += mkpadding(indent) + "/* [";
@@ -407,9 +507,10 @@ static std::string generate_subsystem_declaration_cxx(const std::shared_ptr<jcc:
     return result;
 }
 
-static std::string generate_subsystem_definition_cxx(const std::shared_ptr<jcc::GenericNode> &node, uint32_t &indent, std::string &_subsystem)
+/// @brief Emit the dependency comment and namespace line that precede a subsystem body
+static std::string generate_subsystem_head_cxx(jcc::GenericNode *node, uint32_t &indent, std::string &_subsystem)
 {
-    auto subsysdef = std::static_pointer_cast<SubsystemDefinition>(node);
+    auto subsysdef = static_cast<SubsystemDefinition *>(node);
 
     std::string result;
 
@@ -426,6 +527,15 @@ static std::string generate_subsystem_definition_cxx(const std::shared_ptr<jcc::
 
     result += mkpadding(indent) + "namespace " + rectify_name(subsysdef->name()) + "\n";
 
+    return result;
+}
+
+static std::string generate_subsystem_definition_cxx(jcc::GenericNode *node, uint32_t &indent, std::string &_subsystem)
+{
+    auto subsysdef = static_cast<SubsystemDefinition *>(node);
+
+    std::string result = generate_subsystem_head_cxx(node, indent, _subsystem);
+
     std::string tmp = _subsystem;
 
     _subsystem = get_qualified_typename(rectify_name(subsysdef->name()), _subsystem);
@@ -437,13 +547,13 @@ static std::string generate_subsystem_definition_cxx(const std::shared_ptr<jcc::
     return result;
 }
 
-static std::string generate_struct_definition_cxx(const std::shared_ptr<jcc::GenericNode> &node, uint32_t &indent, std::string &_subsystem)
+static std::string generate_struct_definition_cxx(jcc::GenericNode *node, uint32_t &indent, std::string &_subsystem)
 {
     static size_t object_id = 0;
     static std::mutex object_id_mutex;
     std::string result;
 
-    auto structdef = std::static_pointer_cast<StructDefinition>(node);
+    auto structdef = static_cast<StructDefinition *>(node);
     std::string struct_name = rectify_name(structdef->name());
 
     result += mkpadding(indent) + "/* Begin Structure " + struct_name + " */\n";
@@ -459,20 +569,12 @@ static std::string generate_struct_definition_cxx(const std::shared_ptr<jcc::Gen
     result += mkpadding(indent) + "class " + struct_name + " : public StructGeneric<" + std::to_string(object_id) + ">\n" + mkpadding(indent) + "{\n";
 
     // check if struct is already defined
-    bool already_defined = false;
-    for (const auto &entry : g_typenames_mapping)
+    std::string qualified_name = get_qualified_typename(structdef->name(), _subsystem);
+    if (!g_defined_typenames.contains(qualified_name))
     {
-        if (entry.second == get_qualified_typename(structdef->name(), _subsystem))
-        {
-            already_defined = true;
-            break;
-        }
-    }
-    if (!already_defined)
-    {
-        g_typenames_mapping.insert({object_id, get_qualified_typename(structdef->name(), _subsystem)});
+        g_defined_typenames.insert(g_typenames_mapping.insert({object_id, qualified_name}).first->second);
         ReflectiveEntry reflective_entry;
-        reflective_entry.type = get_qualified_typename(structdef->name(), _subsystem);
+        reflective_entry.type = qualified_name;
         for (const auto &field : structdef->fields())
         {
             reflective_entry.field_name = rectify_name(field->name());
@@ -626,11 +728,11 @@ static std::string generate_struct_definition_cxx(const std::shared_ptr<jcc::Gen
     return result;
 }
 
-static std::string generate_union_definition_cxx(const std::shared_ptr<jcc::GenericNode> &node, uint32_t &indent, std::string &_subsystem)
+static std::string generate_union_definition_cxx(jcc::GenericNode *node, uint32_t &indent, std::string &_subsystem)
 {
     (void)_subsystem;
 
-    auto uniondef = std::static_pointer_cast<UnionDefinition>(node);
+    auto uniondef = static_cast<UnionDefinition *>(node);
     std::string result = mkpadding(indent) + "union " + rectify_name(uniondef->name()) + "\n" + mkpadding(indent) + "{\n";
 
     indent += INDENT_SIZE;
@@ -665,11 +767,15 @@ static std::string generate_union_definition_cxx(const std::shared_ptr<jcc::Gene
     return result;
 }
 
-static std::string generate_function_definition_cxx(const std::shared_ptr<jcc::GenericNode> &node, uint32_t &indent, std::string &_subsystem)
+static std::string generate_function_definition_cxx(jcc::GenericNode *node, uint32_t &indent, std::string &_subsystem)
 {
-    auto funcdef = std::static_pointer_cast<FunctionDefinition>(node);
+    auto funcdef = static_cast<FunctionDefinition *>(node);
     std::string result = mkpadding(indent);
 
+    // the tree is never modified; it may be shared with a later version of the source
+    std::string return_type = funcdef->return_type();
+    bool return_zero = false;
+
     if (funcdef->name() == "Main" && _subsystem.empty())
     {
         g_has_main_mutex.lock();
@@ -683,12 +789,12 @@ static std::string generate_function_definition_cxx(const std::shared_ptr<jcc::G
 
         if (funcdef->return_type() == "void")
         {
-            funcdef->return_type() = "int";
-            funcdef->block()->children().push_back(std::make_shared<ReturnStatement>(std::static_pointer_cast<Expression>(std::make_shared<IntegerLiteralExpression>("0"))));
+            return_type = "int";
+            return_zero = true;
         }
     }
 
-    if (funcdef->return_type().empty())
+    if (return_type.empty())
     {
         result += "[[noreturn]] _void";
     }
@@ -696,15 +802,15 @@ static std::string generate_function_definition_cxx(const std::shared_ptr<jcc::G
     {
         if (funcdef->return_arr_size() == std::numeric_limits<uint64_t>::max())
         {
-            result += "std::vector<" + rectify_type(funcdef->return_type()) + ">";
+            result += "std::vector<" + rectify_type(return_type) + ">";
         }
         else if (funcdef->return_arr_size() > 0)
         {
-            result += "std::array<" + rectify_type(funcdef->return_type()) + ", " + std::to_string(funcdef->return_arr_size()) + "> ";
+            result += "std::array<" + rectify_type(return_type) + ", " + std::to_string(funcdef->return_arr_size()) + "> ";
         }
         else
         {
-            result += rectify_type(funcdef->return_type());
+            result += rectify_type(return_type);
         }
     }
 
@@ -724,7 +830,13 @@ static std::string generate_function_definition_cxx(const std::shared_ptr<jcc::G
 
     result += generate_block_cxx(funcdef->block(), indent, _subsystem);
 
-    if (funcdef->return_type().empty())
+    if (return_zero)
+    {
+        // the closing brace is preceded by the padding of the current indent
+        result = result.substr(0, result.size() - 2);
+        result += mkpadding(INDENT_SIZE) + "return 0;\n" + mkpadding(indent) + "}\n\n";
+    }
+    else if (return_type.empty())
     {
         indent += INDENT_SIZE;
         result = result.substr(0, result.size() - 2);
@@ -740,9 +852,9 @@ static std::string generate_function_definition_cxx(const std::shared_ptr<jcc::G
     return result;
 }
 
-static std::string generate_struct_method_cxx(const std::shared_ptr<jcc::GenericNode> &node, uint32_t &indent, std::string &_subsystem)
+static std::string generate_struct_method_cxx(jcc::GenericNode *node, uint32_t &indent, std::string &_subsystem)
 {
-    auto funcdef = std::static_pointer_cast<StructMethod>(node);
+    auto funcdef = static_cast<StructMethod *>(node);
     std::string result = mkpadding(indent);
 
     if (funcdef->type().empty())
@@ -775,57 +887,40 @@ static std::string generate_struct_method_cxx(const std::shared_ptr<jcc::Generic
     return result;
 }
 
-static std::string generate_node_cxx(const std::shared_ptr<jcc::GenericNode> &node, uint32_t &indent, std::string &_subsystem)
+/// @brief Emits C++ for a node; statement kinds are delegated to the generate_*_cxx functions above
+/// @note Expressions are emitted recursively, one call per level. This relies on
+/// the parser, which rejects expressions more than max_nesting levels deep.
+class CxxGenerator : public NodeVisitor<CxxGenerator, std::string>
 {
-    if (node == nullptr)
+public:
+    CxxGenerator(uint32_t &indent, std::string &_subsystem) : m_indent(indent), m_subsystem(_subsystem) {}
+
+    std::string visit(Block *node) { return generate_block_cxx(node, m_indent, m_subsystem); }
+    std::string visit(TypeDeclaration *node) { return generate_typedef_cxx(node, m_indent, m_subsystem); }
+    std::string visit(StructDeclaration *node) { return generate_struct_declaration_cxx(node, m_indent, m_subsystem); }
+    std::string visit(UnionDeclaration *node) { return generate_union_declaration_cxx(node, m_indent, m_subsystem); }
+    std::string visit(EnumDeclaration *node) { return generate_enum_declaration_cxx(node, m_indent, m_subsystem); }
+
+    std::string visit(LetDeclaration *node) { return generate_let_declaration_cxx(node, m_indent, m_subsystem); }
+
+    std::string visit(FunctionDeclaration *node) { return generate_function_declaration_cxx(node, m_indent, m_subsystem); }
+    std::string visit(ClassDeclaration *node) { return generate_class_declaration_cxx(node, m_indent, m_subsystem); }
+    std::string visit(ExternalDeclaration *node) { return generate_extern_declaration_cxx(node, m_indent, m_subsystem); }
+    std::string visit(SubsystemDeclaration *node) { return generate_subsystem_declaration_cxx(node, m_indent, m_subsystem); }
+
+    std::string visit(SubsystemDefinition *node) { return generate_subsystem_definition_cxx(node, m_indent, m_subsystem); }
+    std::string visit(StructDefinition *node) { return generate_struct_definition_cxx(node, m_indent, m_subsystem); }
+    std::string visit(StructMethod *node) { return generate_struct_method_cxx(node, m_indent, m_subsystem); }
+    std::string visit(UnionDefinition *node) { return generate_union_definition_cxx(node, m_indent, m_subsystem); }
+    std::string visit(FunctionDefinition *node) { return generate_function_definition_cxx(node, m_indent, m_subsystem); }
+
+    std::string visit(ReturnStatement *node)
     {
-        throw std::runtime_error("Node is null");
-    }
+        std::string result = mkpadding(m_indent) + "return";
 
-    switch (node->type())
-    {
-    case NodeType::Block:
-        return generate_block_cxx(node, indent, _subsystem);
-    case NodeType::TypeDeclaration:
-        return generate_typedef_cxx(node, indent, _subsystem);
-    case NodeType::StructDeclaration:
-        return generate_struct_declaration_cxx(node, indent, _subsystem);
-    case NodeType::UnionDeclaration:
-        return generate_union_declaration_cxx(node, indent, _subsystem);
-    case NodeType::EnumDeclaration:
-        return generate_enum_declaration_cxx(node, indent, _subsystem);
-
-    case NodeType::LetDeclaration:
-        return generate_let_declaration_cxx(node, indent, _subsystem);
-
-    case NodeType::FunctionDeclaration:
-        return generate_function_declaration_cxx(node, indent, _subsystem);
-    case NodeType::ClassDeclaration:
-        return generate_class_declaration_cxx(node, indent, _subsystem);
-    case NodeType::ExternalDeclaration:
-        return generate_extern_declaration_cxx(node, indent, _subsystem);
-    case NodeType::SubsystemDeclaration:
-        return generate_subsystem_declaration_cxx(node, indent, _subsystem);
-
-    case NodeType::SubsystemDefinition:
-        return generate_subsystem_definition_cxx(node, indent, _subsystem);
-    case NodeType::StructDefinition:
-        return generate_struct_definition_cxx(node, indent, _subsystem);
-    case NodeType::StructMethod:
-        return generate_struct_method_cxx(node, indent, _subsystem);
-    case NodeType::UnionDefinition:
-        return generate_union_definition_cxx(node, indent, _subsystem);
-    case NodeType::FunctionDefinition:
-        return generate_function_definition_cxx(node, indent, _subsystem);
-
-    case NodeType::ReturnStatement:
-    {
-        auto retstmt = std::static_pointer_cast<ReturnStatement>(node);
-        std::string result = mkpadding(indent) + "return";
-
-        if (retstmt->expression() != nullptr)
+        if (node->expression() != nullptr)
         {
-            result += " " + generate_node_cxx(retstmt->expression(), indent, _subsystem);
+            result += " " + generate(node->expression());
         }
 
         result += ";\n";
@@ -833,44 +928,142 @@ static std::string generate_node_cxx(const std::shared_ptr<jcc::GenericNode> &no
         return result;
     }
 
-    case NodeType::BinaryExpression:
-        return generate_node_cxx(std::static_pointer_cast<BinaryExpression>(node)->left(), indent, _subsystem) + " " + std::static_pointer_cast<BinaryExpression>(node)->op() + " " + generate_node_cxx(std::static_pointer_cast<BinaryExpression>(node)->right(), indent, _subsystem);
-    case NodeType::UnaryExpression:
-        return std::static_pointer_cast<UnaryExpression>(node)->op() + generate_node_cxx(std::static_pointer_cast<UnaryExpression>(node)->expression(), indent, _subsystem);
-    case NodeType::CastExpression:
-        return "(" + std::static_pointer_cast<CastExpression>(node)->type() + ")" + generate_node_cxx(std::static_pointer_cast<CastExpression>(node)->expression(), indent, _subsystem);
-    case NodeType::LiteralExpression:
-        return std::static_pointer_cast<LiteralExpression>(node)->value();
-    case NodeType::CallExpression:
+    std::string visit(BinaryExpression *node)
     {
-        auto callexpr = std::static_pointer_cast<CallExpression>(node);
-        std::string result = rectify_name(callexpr->name()) + "(";
+        switch (node->op())
+        {
+        case Operator::Xor:
+            // C++ has no logical xor
+            return "(!" + generate(node->left()) + " != !" + generate(node->right()) + ")";
+        case Operator::XorEquals:
+        {
+            std::string left = generate_variable(node);
+            return "(" + left + " = (!" + left + " != !" + generate(node->right()) + "))";
+        }
+        case Operator::OrEquals:
+        {
+            // the right operand is only evaluated if the variable is false
+            std::string left = generate_variable(node);
+            return "(" + left + " = (" + left + " || " + generate(node->right()) + "))";
+        }
+        case Operator::AndEquals:
+        {
+            // the right operand is only evaluated if the variable is true
+            std::string left = generate_variable(node);
+            return "(" + left + " = (" + left + " && " + generate(node->right()) + "))";
+        }
+        case Operator::NullCoalesce:
+        {
+            // the right operand is only evaluated if the variable is null
+            std::string left = generate_variable(node);
+            return "(" + left + " != nullptr ? " + left + " : " + generate(node->right()) + ")";
+        }
+        case Operator::UnsignedRightShiftEquals:
+            return "_unsigned_right_shift_assign(" + generate(node->left()) + ", " + generate(node->right()) + ")";
+        case Operator::FloorDivide:
+            return "_floor_divide(" + generate(node->left()) + ", " + generate(node->right()) + ")";
+        case Operator::At:
+            throw std::runtime_error("Unsupported operator: @");
+        default:
+            return "(" + generate(node->left()) + " " + lexOperatorMapReverse.at(node->op()) + " " + generate(node->right()) + ")";
+        }
+    }
 
-        for (const auto &arg : callexpr->arguments())
+    std::string visit(UnaryExpression *node)
+    {
+        if (node->postfix())
         {
-            result += generate_node_cxx(arg, indent, _subsystem);
+            return "(" + generate(node->expression()) + lexOperatorMapReverse.at(node->op()) + ")";
+        }
+        return "(" + std::string(lexOperatorMapReverse.at(node->op())) + generate(node->expression()) + ")";
+    }
+
+    std::string visit(TernaryExpression *node)
+    {
+        return "(" + generate(node->condition()) + " ? " + generate(node->then_expression()) + " : " + generate(node->else_expression()) + ")";
+    }
+
+    std::string visit(CastExpression *node) { return "((" + rectify_type(node->type()) + ")" + generate(node->expression()) + ")"; }
+    std::string visit(NullExpression *) { return "nullptr"; }
+    std::string visit(IdentifierExpression *node) { return rectify_name(node->name()); }
+
+    std::string visit(CallExpression *node)
+    {
+        std::string result = rectify_name(node->name()) + "(";
+
+        for (size_t i = 0; i < node->arguments().size(); i++)
+        {
+            if (i > 0)
+            {
+                result += ", ";
+            }
+            result += generate(node->arguments()[i]);
         }
 
         result += ")";
 
         return result;
     }
-    case NodeType::StringLiteralExpression:
-        return "\"" + std::static_pointer_cast<StringLiteralExpression>(node)->value() + "\"";
-    case NodeType::CharLiteralExpression:
-        return "'" + std::static_pointer_cast<CharLiteralExpression>(node)->value() + "'";
-    case NodeType::IntegerLiteralExpression:
-        return std::static_pointer_cast<IntegerLiteralExpression>(node)->value();
-    case NodeType::FloatingPointLiteralExpression:
-        return std::static_pointer_cast<FloatingPointLiteralExpression>(node)->value();
-    case NodeType::BooleanLiteralExpression:
-        return std::static_pointer_cast<BooleanLiteralExpression>(node)->value();
-    case NodeType::RawNode:
-        return mkpadding(indent) + std::static_pointer_cast<RawNode>(node)->value() + "\n";
-
-    default:
-        throw std::runtime_error("Unknown node type");
+
+    std::string visit(LiteralExpression *node) { return node->value(); }
+    std::string visit(StringLiteralExpression *node) { return "\"" + node->value() + "\""; }
+    std::string visit(CharLiteralExpression *node) { return "'" + node->value() + "'"; }
+    std::string visit(IntegerLiteralExpression *node) { return node->value(); }
+    std::string visit(FloatingPointLiteralExpression *node) { return node->value(); }
+    std::string visit(BooleanLiteralExpression *node) { return node->value(); }
+    std::string visit(RawNode *node) { return mkpadding(m_indent) + node->value() + "\n"; }
+
+    // nodes that are only generated as part of their parent, and the abstract kinds
+    std::string visit(Expression *) { return unsupported(); }
+    std::string visit(Statement *) { return unsupported(); }
+    std::string visit(Declaration *) { return unsupported(); }
+    std::string visit(Definition *) { return unsupported(); }
+    std::string visit(TypeNode *) { return unsupported(); }
+    std::string visit(FunctionParameter *) { return unsupported(); }
+    std::string visit(StructField *) { return unsupported(); }
+    std::string visit(StructAttribute *) { return unsupported(); }
+    std::string visit(UnionField *) { return unsupported(); }
+    std::string visit(VarDeclaration *) { return unsupported(); }
+
+private:
+    uint32_t &m_indent;
+    std::string &m_subsystem;
+
+    std::string generate(GenericNode *node)
+    {
+        if (node == nullptr)
+        {
+            throw std::runtime_error("Node is null");
+        }
+
+        return dispatch(node);
+    }
+
+    /// @brief Generate the left operand of an operator that is lowered to an
+    /// expression naming it twice, so it must not have side effects
+    /// @param node Binary expression
+    /// @return C++ name of the variable
+    std::string generate_variable(BinaryExpression *node)
+    {
+        if (node->left() == nullptr || node->left()->type() != NodeType::IdentifierExpression)
+        {
+            throw std::runtime_error(std::string("The left operand of '") + lexOperatorMapReverse.at(node->op()) + "' must be a variable");
+        }
+
+        return generate(node->left());
+    }
+
+    static std::string unsupported() { throw std::runtime_error("Unknown node type"); }
+};
+
+static std::string generate_node_cxx(jcc::GenericNode *node, uint32_t &indent, std::string &_subsystem)
+{
+    if (node == nullptr)
+    {
+        throw std::runtime_error("Node is null");
     }
+
+    return CxxGenerator(indent, _subsystem).dispatch(node);
 }
 
 std::string jcc::CompilationUnit::generate(const std::shared_ptr<jcc::AbstractSyntaxTree> &ast, TargetLanguage target)
@@ -884,6 +1077,9 @@ std::string jcc::CompilationUnit::generate(const std::shared_ptr<jcc::AbstractSy
         panic("Unsupported target language");
     }
 
+    // nodes synthesized during lowering belong to the tree like the parsed ones
+    AstArena::Scope scope(ast->arena());
+
     result += generate_node_cxx(ast->root(), indent, current_subsystem);
 
     return result;
@@ -893,10 +1089,13 @@ const std::string typedef_commons = R"(#include <cstdint>
 #include <cstddef>
 #include <vector>
 #include <string>
+#include <string_view>
 #include <map>
 #include <cstring>
 #include <iostream>
 #include <cstdlib>
+#include <cmath>
+#include <type_traits>
 
 typedef bool _bool;
 typedef int8_t _char;
@@ -916,6 +1115,33 @@ typedef const char *_string;
 typedef void *_routine;
 #define _null nullptr
 #define _void void
+
+template <typename L, typename R>
+static inline auto _floor_divide(L left, R right)
+{
+    if constexpr (std::is_floating_point_v<decltype(left / right)>)
+    {
+        return std::floor(left / right);
+    }
+    else
+    {
+        auto quotient = left / right;
+        if constexpr (std::is_signed_v<decltype(quotient)>)
+        {
+            if (quotient * right != left && (left < 0) != (right < 0))
+            {
+                return quotient - 1;
+            }
+        }
+        return quotient;
+    }
+}
+
+template <typename L, typename R>
+static inline L &_unsigned_right_shift_assign(L &left, R right)
+{
+    return left = static_cast<L>(static_cast<std::make_unsigned_t<L>>(left) >> right);
+}
 )";
 
 const std::string structure_generic_baseclass = R"(/* Begin Common Sink functions */
@@ -1292,7 +1518,7 @@ std::string jcc::CompilationUnit::compile(const std::string &source, jcc::Target
         panic("Unsupported target language");
     }
 
-    TokenList tokens = lex(source);
+    TokenList tokens = lex(std::make_shared<const std::string>(source), LexMode::NoTrivia);
 
     std::shared_ptr<AbstractSyntaxTree> ast = parse(tokens);
 
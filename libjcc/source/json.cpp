@@ -0,0 +1,202 @@
+#include "json.hpp"
+#include <charconv>
+#include <stdexcept>
+#include <cerrno>
+
+#if defined(__linux__)
+#include <unistd.h>
+#else
+#error "Cross-platform support is not implemented yet"
+#endif
+
+///=============================================================================
+/// Escape tables
+///=============================================================================
+
+/// @brief Storage for the `\u00XX` escapes of the control characters without a short form
+struct JsonControlEscapes
+{
+    char text[32][6];
+};
+
+static constexpr JsonControlEscapes build_control_escapes()
+{
+    constexpr char hex[] = "0123456789abcdef";
+
+    JsonControlEscapes escapes{};
+    for (size_t i = 0; i < 32; i++)
+    {
+        escapes.text[i][0] = '\\';
+        escapes.text[i][1] = 'u';
+        escapes.text[i][2] = '0';
+        escapes.text[i][3] = '0';
+        escapes.text[i][4] = hex[i >> 4];
+        escapes.text[i][5] = hex[i & 0xf];
+    }
+    return escapes;
+}
+
+static constexpr JsonControlEscapes controlEscapes = build_control_escapes();
+
+static constexpr jcc::JsonWriter::EscapeTable build_json_escapes()
+{
+    jcc::JsonWriter::EscapeTable table{};
+    for (size_t i = 0; i < 32; i++)
+    {
+        table[i] = std::string_view(controlEscapes.text[i], 6);
+    }
+
+    table['"'] = "\\\"";
+    table['\\'] = "\\\\";
+    table['\b'] = "\\b";
+    table['\f'] = "\\f";
+    table['\n'] = "\\n";
+    table['\r'] = "\\r";
+    table['\t'] = "\\t";
+    return table;
+}
+
+static constexpr jcc::JsonWriter::EscapeTable jsonEscapes = build_json_escapes();
+
+const jcc::JsonWriter::EscapeTable &jcc::JsonWriter::json_escapes()
+{
+    return jsonEscapes;
+}
+
+///=============================================================================
+/// jcc::JsonWriter class implementation
+///=============================================================================
+
+jcc::JsonWriter::JsonWriter(std::string &out) : m_out(&out), m_stream(nullptr), m_fd(-1), m_after_key(false) {}
+
+jcc::JsonWriter::JsonWriter(std::ostream &out) : m_out(&m_buffer), m_stream(&out), m_fd(-1), m_after_key(false)
+{
+    m_buffer.reserve(FlushSize);
+}
+
+jcc::JsonWriter::JsonWriter(int fd) : m_out(&m_buffer), m_stream(nullptr), m_fd(fd), m_after_key(false)
+{
+    m_buffer.reserve(FlushSize);
+}
+
+jcc::JsonWriter::~JsonWriter()
+{
+    try
+    {
+        flush();
+    }
+    catch (const std::exception &)
+    {
+        // callers that care about write errors flush before the writer goes away
+    }
+}
+
+void jcc::JsonWriter::begin_object()
+{
+    separate();
+    put('{');
+    m_nonempty.push_back(false);
+}
+
+void jcc::JsonWriter::end_object()
+{
+    m_nonempty.pop_back();
+    put('}');
+}
+
+void jcc::JsonWriter::begin_array()
+{
+    separate();
+    put('[');
+    m_nonempty.push_back(false);
+}
+
+void jcc::JsonWriter::end_array()
+{
+    m_nonempty.pop_back();
+    put(']');
+}
+
+void jcc::JsonWriter::key(std::string_view name)
+{
+    separate();
+    put('"');
+    put(name);
+    put("\":");
+    m_after_key = true;
+}
+
+void jcc::JsonWriter::value(std::string_view str, const EscapeTable &escapes)
+{
+    separate();
+    put('"');
+    escape(str, escapes);
+    put('"');
+}
+
+void jcc::JsonWriter::value(uint64_t number)
+{
+    char digits[24];
+    auto result = std::to_chars(digits, digits + sizeof(digits), number);
+
+    separate();
+    put(std::string_view(digits, result.ptr - digits));
+}
+
+void jcc::JsonWriter::null()
+{
+    separate();
+    put("null");
+}
+
+void jcc::JsonWriter::escape(std::string_view str, const EscapeTable &escapes)
+{
+    size_t start = 0;
+    for (size_t i = 0; i < str.size(); i++)
+    {
+        std::string_view sequence = escapes[static_cast<unsigned char>(str[i])];
+        if (sequence.empty())
+        {
+            continue;
+        }
+
+        put(str.substr(start, i - start));
+        put(sequence);
+        start = i + 1;
+    }
+
+    put(str.substr(start));
+}
+
+void jcc::JsonWriter::flush()
+{
+    if (m_out != &m_buffer || m_buffer.empty())
+    {
+        return;
+    }
+
+    if (m_stream != nullptr)
+    {
+        m_stream->write(m_buffer.data(), m_buffer.size());
+    }
+    else
+    {
+        size_t written = 0;
+        while (written < m_buffer.size())
+        {
+            ssize_t count = ::write(m_fd, m_buffer.data() + written, m_buffer.size() - written);
+            if (count < 0 && errno == EINTR)
+            {
+                continue;
+            }
+            if (count <= 0)
+            {
+                m_buffer.clear();
+                throw std::runtime_error("Unable to write JSON output");
+            }
+            written += count;
+        }
+    }
+
+    m_buffer.clear();
+}
@@ -5,12 +5,15 @@
 #include <string>
 #include <vector>
 #include <cstring>
-#include <regex>
-#include <sstream>
-#include <cmath>
-#include <iomanip>
-
-#define FLOATING_POINT_LITERAL_ROUND_DIGITS 32
+#include <charconv>
+#include <array>
+#include <cstdint>
+#include <algorithm>
+#include <thread>
+#include <exception>
+#include <fstream>
+#include <cstdio>
+#include <random>
 
 ///=============================================================================
 /// jcc::Token class implementation
@@ -33,23 +36,56 @@ static std::map<jcc::TokenType, std::string> tokenTypeMap = {
 
 jcc::Token::Token()
 {
+    m_data = nullptr;
+    m_length = 0;
     m_type = jcc::TokenType::Unknown;
+    m_kind = 0;
+}
+
+jcc::Token::Token(jcc::TokenType type, std::string_view text)
+{
+    if (type == TokenType::Identifier)
+    {
+        text = Symbol(text).str();
+    }
+
+    m_data = text.data();
+    m_length = static_cast<uint32_t>(text.size());
+    m_type = type;
+    m_kind = 0;
 }
 
-jcc::Token::Token(jcc::TokenType type, TokenValueType value)
+jcc::Token::Token(jcc::Symbol identifier)
 {
+    std::string_view text = identifier.str();
+    m_data = text.data();
+    m_length = static_cast<uint32_t>(text.size());
+    m_type = TokenType::Identifier;
+    m_kind = 0;
+}
+
+jcc::Token::Token(jcc::TokenType type, jcc::Keyword keyword)
+{
+    m_data = nullptr;
+    m_length = 0;
     m_type = type;
-    m_value = value;
+    m_kind = static_cast<uint8_t>(keyword);
 }
 
-jcc::TokenType jcc::Token::type() const
+jcc::Token::Token(jcc::TokenType type, jcc::Operator op)
 {
-    return m_type;
+    m_data = nullptr;
+    m_length = 0;
+    m_type = type;
+    m_kind = static_cast<uint8_t>(op);
 }
 
-const jcc::TokenValueType &jcc::Token::value() const
+jcc::Token::Token(jcc::TokenType type, jcc::Punctuator punctuator)
 {
-    return m_value;
+    m_data = nullptr;
+    m_length = 0;
+    m_type = type;
+    m_kind = static_cast<uint8_t>(punctuator);
 }
 
 std::string jcc::Token::to_string() const
@@ -57,36 +93,36 @@ std::string jcc::Token::to_string() const
     switch (this->m_type)
     {
     case TokenType::Identifier:
-        return std::string("Identifier(\"" + std::get<std::string>(m_value) + "\")");
+        return std::string("Identifier(\"" + std::string(text()) + "\")");
         break;
     case TokenType::Keyword:
-        return std::string("Keyword(" + std::string(lexKeywordMapReverse.at(std::get<Keyword>(m_value))) + ")");
+        return std::string("Keyword(" + std::string(lexKeywordMapReverse.at(keyword())) + ")");
         break;
     case TokenType::NumberLiteral:
-        return std::string("NumberLiteral(" + std::get<std::string>(m_value) + ")");
+        return std::string("NumberLiteral(" + std::string(text()) + ")");
         break;
     case TokenType::FloatingPointLiteral:
-        return std::string("FloatingPointLiteral(" + std::get<std::string>(m_value) + ")");
+        return std::string("FloatingPointLiteral(" + std::string(text()) + ")");
     case TokenType::StringLiteral:
-        return std::string("StringLiteral(\"" + std::get<std::string>(m_value) + "\")");
+        return std::string("StringLiteral(\"" + std::string(text()) + "\")");
         break;
     case TokenType::Operator:
-        return std::string("Operator('" + std::string(lexOperatorMapReverse.at(std::get<Operator>(m_value))) + "')");
+        return std::string("Operator('" + std::string(lexOperatorMapReverse.at(op())) + "')");
         break;
     case TokenType::Punctuator:
-        return std::string("Punctuator('" + std::string(lexPunctuatorMapReverse.at(std::get<Punctuator>(m_value))) + "')");
+        return std::string("Punctuator('" + std::string(lexPunctuatorMapReverse.at(punctuator())) + "')");
         break;
     case TokenType::SingleLineComment:
-        return std::string("SingleLineComment(\"" + std::get<std::string>(m_value) + "\")");
+        return std::string("SingleLineComment(\"" + std::string(text()) + "\")");
         break;
     case TokenType::MultiLineComment:
-        return std::string("MultiLineComment(\"" + std::get<std::string>(m_value) + "\")");
+        return std::string("MultiLineComment(\"" + std::string(text()) + "\")");
         break;
     case TokenType::Whitespace:
         return std::string("Whitespace()");
         break;
     case TokenType::Raw:
-        return std::string("Raw(\"" + std::get<std::string>(m_value) + "\")");
+        return std::string("Raw(\"" + std::string(text()) + "\")");
         break;
     default:
         return std::string("Unknown()");
@@ -96,7 +132,58 @@ std::string jcc::Token::to_string() const
 
 bool jcc::Token::operator==(const jcc::Token &other) const
 {
-    return this->m_type == other.m_type && this->m_value == other.m_value;
+    if (this->m_type != other.m_type)
+    {
+        return false;
+    }
+
+    switch (this->m_type)
+    {
+    case TokenType::Keyword:
+    case TokenType::Operator:
+    case TokenType::Punctuator:
+        return this->m_kind == other.m_kind;
+    default:
+        return this->text() == other.text();
+    }
+}
+
+///=============================================================================
+/// jcc::LineIndex class implementation
+///=============================================================================
+
+jcc::LineIndex::LineIndex(std::shared_ptr<const std::string> source)
+{
+    m_source = std::move(source);
+}
+
+jcc::SourceLocation jcc::LineIndex::locate(uint32_t offset) const
+{
+    std::call_once(m_built, [this]()
+                   {
+                       m_line_starts.push_back(0);
+                       if (!m_source)
+                       {
+                           return;
+                       }
+
+                       const char *begin = m_source->data();
+                       const char *end = begin + m_source->size();
+                       for (const char *p = begin; (p = static_cast<const char *>(std::memchr(p, '\n', end - p))) != nullptr; p++)
+                       {
+                           m_line_starts.push_back(static_cast<uint32_t>(p - begin + 1));
+                       }
+                   });
+
+    if (m_source && offset > m_source->size())
+    {
+        offset = static_cast<uint32_t>(m_source->size());
+    }
+
+    auto it = std::upper_bound(m_line_starts.begin(), m_line_starts.end(), offset);
+    size_t line = it - m_line_starts.begin();
+
+    return {static_cast<uint32_t>(line), offset - m_line_starts[line - 1] + 1};
 }
 
 ///=============================================================================
@@ -105,38 +192,135 @@ bool jcc::Token::operator==(const jcc::Token &other) const
 
 jcc::TokenList::TokenList()
 {
-    this->m_tokens = std::vector<Token>();
+    m_pos = 0;
 }
 
 jcc::TokenList::TokenList(const std::vector<jcc::Token> &tokens)
 {
-    this->m_tokens = tokens;
+    m_pos = 0;
+    push_back(tokens);
 }
 
 void jcc::TokenList::push_back(const jcc::Token &token)
 {
-    m_tokens.push_back(token);
+    switch (token.type())
+    {
+    case TokenType::Keyword:
+        push_back(token.type(), static_cast<uint32_t>(token.keyword()), 0, 0);
+        return;
+    case TokenType::Operator:
+        push_back(token.type(), static_cast<uint32_t>(token.op()), 0, 0);
+        return;
+    case TokenType::Punctuator:
+        push_back(token.type(), static_cast<uint32_t>(token.punctuator()), 0, 0);
+        return;
+    case TokenType::Identifier:
+        push_back(token.type(), token.symbol().id(), 0, static_cast<uint32_t>(token.text().size()));
+        return;
+    default:
+        break;
+    }
+
+    std::string_view text = token.text();
+    if (m_source && text.data() >= m_source->data() && text.data() + text.size() <= m_source->data() + m_source->size())
+    {
+        push_back(token.type(), 0, static_cast<uint32_t>(text.data() - m_source->data()), static_cast<uint32_t>(text.size()));
+    }
+    else
+    {
+        push_back(token.type(), materialize(std::string(text)), 0, 0);
+    }
 }
 
 void jcc::TokenList::push_back(const std::vector<jcc::Token> &tokens)
 {
-    m_tokens.insert(m_tokens.end(), tokens.begin(), tokens.end());
+    reserve(m_types.size() + tokens.size());
+    for (const auto &token : tokens)
+    {
+        push_back(token);
+    }
+}
+
+void jcc::TokenList::push_back(const TokenList &other, size_t index)
+{
+    size_t i = other.m_pos + index;
+    push_back(other.m_types[i], other.m_payloads[i], other.m_offsets[i], other.m_lengths[i]);
 }
 
 void jcc::TokenList::done()
 {
-    std::reverse(m_tokens.begin(), m_tokens.end());
+    m_pos = 0;
+}
+
+void jcc::TokenList::reserve(size_t count)
+{
+    m_types.reserve(count);
+    m_payloads.reserve(count);
+    m_offsets.reserve(count);
+    m_lengths.reserve(count);
+}
+
+void jcc::TokenList::pin_source(std::shared_ptr<const std::string> source)
+{
+    m_source = std::move(source);
+    m_lines = std::make_shared<LineIndex>(m_source);
+}
+
+void jcc::TokenList::share_storage(const TokenList &other)
+{
+    m_source = other.m_source;
+    m_strings = other.m_strings;
+    m_lines = other.m_lines;
+}
+
+uint32_t jcc::TokenList::materialize(std::string text)
+{
+    if (!m_strings)
+    {
+        m_strings = std::make_shared<std::deque<std::string>>();
+    }
+
+    // std::deque never relocates existing elements on push_back, so
+    // views handed out by peek() stay valid.
+    m_strings->emplace_back(std::move(text));
+    return static_cast<uint32_t>(m_strings->size());
+}
+
+std::string_view jcc::TokenList::source() const
+{
+    return m_source ? std::string_view(*m_source) : std::string_view();
+}
+
+jcc::SourceLocation jcc::TokenList::locate(uint32_t offset) const
+{
+    if (!m_lines)
+    {
+        return {};
+    }
+
+    return m_lines->locate(offset);
+}
+
+jcc::SourceLocation jcc::TokenList::location(size_t index) const
+{
+    size_t i = m_pos + index;
+    if (i >= m_types.size())
+    {
+        return locate(static_cast<uint32_t>(source().size()));
+    }
+
+    return locate(m_offsets[i]);
 }
 
 std::string jcc::TokenList::to_string() const
 {
     std::string result = "TokenList(";
 
-    for (size_t i = m_tokens.size(); i > 0; i--)
+    for (size_t i = m_pos; i < m_types.size(); i++)
     {
-        result += m_tokens[i - 1].to_string();
+        result += (*this)[i].to_string();
 
-        if (i != 1)
+        if (i + 1 != m_types.size())
         {
             result += ", ";
         }
@@ -147,448 +331,1073 @@ std::string jcc::TokenList::to_string() const
 
 std::string jcc::TokenList::to_json() const
 {
-    std::string result = "[";
-    for (auto it = m_tokens.rbegin(); it != m_tokens.rend(); ++it)
+    std::string result;
+    JsonWriter writer(result);
+    to_json(writer);
+    return result;
+}
+
+/// @brief Escapes of the token dump, which spells newlines, tabs and NULs as `\n`, `\t` and `\0` once decoded
+static constexpr jcc::JsonWriter::EscapeTable build_token_escapes()
+{
+    jcc::JsonWriter::EscapeTable table{};
+    table['\n'] = "\\\\n";
+    table['\t'] = "\\\\t";
+    table['\r'] = "\\\\r";
+    table['\0'] = "\\\\0";
+    table['\\'] = "\\\\";
+    table['"'] = "\\\"";
+    return table;
+}
+
+static constexpr jcc::JsonWriter::EscapeTable tokenEscapes = build_token_escapes();
+
+void jcc::TokenList::to_json(JsonWriter &writer) const
+{
+    writer.raw("[");
+    for (size_t i = m_pos; i < m_types.size(); i++)
     {
-        const auto &token = *it;
-        std::string dataString = "", escapedString = "";
+        const Token token = (*this)[i];
+        std::string_view dataString;
         if (token.type() == TokenType::Whitespace)
         {
             continue;
         }
-        result += "{";
-        result += "\"t\":\"" + tokenTypeMap[static_cast<jcc::TokenType>(token.type())] + "\",";
+        writer.raw("{\"t\":\"");
+        writer.raw(tokenTypeMap[static_cast<jcc::TokenType>(token.type())]);
+        writer.raw("\",");
 
         switch (token.type())
         {
         case TokenType::Identifier:
-            dataString = std::get<std::string>(token.value());
+            dataString = token.text();
             break;
         case TokenType::Keyword:
-            dataString = std::string(lexKeywordMapReverse.at(std::get<Keyword>(token.value())));
+            dataString = lexKeywordMapReverse.at(token.keyword());
             break;
         case TokenType::NumberLiteral:
-            dataString = std::get<std::string>(token.value());
+            dataString = token.text();
             break;
         case TokenType::FloatingPointLiteral:
-            dataString = std::get<std::string>(token.value());
+            dataString = token.text();
             break;
         case TokenType::StringLiteral:
-            dataString = std::get<std::string>(token.value());
+            dataString = token.text();
             break;
         case TokenType::Operator:
-            dataString = std::string(lexOperatorMapReverse.at(std::get<Operator>(token.value())));
+            dataString = lexOperatorMapReverse.at(token.op());
             break;
         case TokenType::Punctuator:
-            dataString = std::string(lexPunctuatorMapReverse.at(std::get<Punctuator>(token.value())));
+            dataString = lexPunctuatorMapReverse.at(token.punctuator());
             break;
         case TokenType::SingleLineComment:
-            dataString = std::get<std::string>(token.value());
+            dataString = token.text();
             break;
         case TokenType::MultiLineComment:
-            dataString = std::get<std::string>(token.value());
+            dataString = token.text();
             break;
         case TokenType::Raw:
-            dataString = std::get<std::string>(token.value());
+            dataString = token.text();
             break;
         default:
             break;
         }
 
-        for (auto c : dataString)
-        {
-            switch (c)
-            {
-            case '\n':
-                escapedString += "\\\\n";
-                break;
-            case '\t':
-                escapedString += "\\\\t";
-                break;
-            case '\r':
-                escapedString += "\\\\r";
-                break;
-            case '\0':
-                escapedString += "\\\\0";
-                break;
-            case '\\':
-                escapedString += "\\\\";
-                break;
-            case '"':
-                escapedString += "\\\"";
-                break;
-            default:
-                escapedString += c;
-                break;
-            }
-        }
-
-        result += "\"v\":\"" + escapedString + "\"";
+        writer.raw("\"v\":\"");
+        writer.escape(dataString, tokenEscapes);
+        writer.raw("\"}");
 
-        result += "}";
-
-        if (it + 1 != m_tokens.rend())
+        if (i + 1 != m_types.size())
         {
-            result += ", ";
+            writer.raw(", ");
         }
     }
-    return result + "]";
+    writer.raw("]");
 }
 
-const jcc::Token &jcc::TokenList::operator[](size_t index) const
+jcc::Token jcc::TokenList::operator[](size_t index) const
 {
-    return m_tokens.at(index);
+    if (index >= m_types.size())
+    {
+        panic("Unable to index TokenList, index out of bounds");
+    }
+
+    return token(index);
 }
 
-void jcc::TokenList::pop(size_t count)
+jcc::Token jcc::TokenList::token(size_t index) const
 {
-    if (count > m_tokens.size())
+    TokenType type = m_types[index];
+    uint32_t payload = m_payloads[index];
+
+    switch (type)
     {
-        panic("Unable to pop from TokenList, count is greater than size");
+    case TokenType::Keyword:
+        return Token(type, static_cast<Keyword>(payload));
+    case TokenType::Operator:
+        return Token(type, static_cast<Operator>(payload));
+    case TokenType::Punctuator:
+        return Token(type, static_cast<Punctuator>(payload));
+    case TokenType::Identifier:
+        return Token(Symbol::from_id(payload));
+    default:
+        break;
+    }
+
+    if (payload != 0)
+    {
+        return Token(type, std::string_view((*m_strings)[payload - 1]));
     }
 
-    m_tokens.pop_back();
-    for (size_t i = 0; i < count - 1; i++)
+    return Token(type, std::string_view(m_source->data() + m_offsets[index], m_lengths[index]));
+}
+
+void jcc::TokenList::pop(size_t count)
+{
+    if (count > size())
     {
-        m_tokens.pop_back();
+        panic("Unable to pop from TokenList, count is greater than size");
     }
+
+    m_pos += count;
 }
 
 bool jcc::TokenList::eof() const
 {
-    return m_tokens.empty();
+    return m_pos >= m_types.size();
 }
 
-const jcc::Token &jcc::TokenList::peek(size_t index) const
+jcc::Token jcc::TokenList::peek(size_t index) const
 {
-    if (index >= m_tokens.size())
+    if (index >= size())
     {
         panic("Unable to peek TokenList, index out of bounds");
     }
 
-    return m_tokens[m_tokens.size() - index - 1];
+    return (*this)[m_pos + index];
 }
 
 size_t jcc::TokenList::size() const
 {
-    return m_tokens.size();
+    return m_types.size() - m_pos;
 }
 
 ///=============================================================================
-/// jcc::Lexer class implementation
+/// Token cache (.jtok)
+///
+/// A `.jtok` file is a fixed header followed by the TokenList's arrays, each
+/// starting on a 4-byte boundary:
+///
+///     JtokHeader
+///     int8_t   types[count]       (padded to 4 bytes)
+///     uint32_t payloads[count]    (0 for identifiers)
+///     uint32_t offsets[count]
+///     uint32_t lengths[count]
+///     uint32_t string_lengths[strings]
+///     char     string_data[]      (materialized strings, back to back)
+///
+/// Integers are stored in host byte order; the magic doubles as a byte order
+/// check.
 ///=============================================================================
 
-enum class LexerState
-{
-    Default,
-    StringLiteral,
-    NumberLiteral,
-    SingleLineComment,
-    MultiLineComment,
-    Identifier,
-    Operator,
-    Punctuator,
-    Whitespace,
-    Raw
-};
+constexpr uint32_t jtokVersion = 1;
+constexpr size_t jtokKeySize = 32;
 
-enum class LexerStateModifier
+struct JtokHeader
 {
-    None,
-    StringEscape,
-    StringSingleQuote,
-    StringSingleQuoteEscape
-};
-
-static std::vector<std::pair<const char *, unsigned int>> lexPunctuators = {
-    {"(", 1},  // left parenthesis
-    {")", 1},  // right parenthesis
-    {"{", 1},  // left brace
-    {"}", 1},  // right brace
-    {"[", 1},  // left bracket
-    {"]", 1},  // right bracket
-    {";", 1},  // semicolon
-    {",", 1},  // comma
-    {":", 1},  // colon
-    {".", 1},  // dot
-};
-
-static std::vector<std::pair<const char *, unsigned int>> lexOperators = {
-    {"+=", 2}, // plus equals
-    {"-=", 2}, // minus equals
-    {"*=", 2}, // times equals
-    {"/=", 2}, // floating divide equals
-    {"%=", 2}, // modulus equals
-
-    {"^^=", 3},  // xor equals
-    {"||=", 3},  // or equals
-    {"&&=", 3},  // and equals
-    {"<<=", 3},  // left shift equals
-    {">>=", 3},  // arithmetic right shift equals
-    {">>>=", 4}, // unsigned right shift equals
-    {"|=", 2},   // bitwise or equals
-    {"&=", 2},   // bitwise and equals
-    {"^=", 2},   // bitwise xor equals
-
-    {"<<", 2}, // left shift
-    {">>", 2}, // right shift
-    {"==", 2}, // equals
-    {"!=", 2}, // not equals
-    {"&&", 2}, // and
-    {"||", 2}, // or
-    {"^^", 2}, // xor
-    {"<=", 2}, // less than or equal
-    {">=", 2}, // greater than or equal
-    {"<", 1},  // less than
-    {">", 1},  // greater than
-
-    {"=", 1}, // assign
-    {"??", 2},
-    {"@", 1},
-
-    {"//", 2}, // floor divide
-    {"++", 2}, // increment
-    {"--", 2}, // decrement
-    {"+", 1},  // plus
-    {"-", 1},  // minus
-    {"*", 1},  // times
-    {"/", 1},  // floating divide
-    {"%", 1},  // modulus
-    {"&", 1},  // bitwise and
-    {"|", 1},  // bitwise or
-    {"^", 1},  // bitwise xor
-    {"~", 1},  // bitwise not
-    {"!", 1},  // not
-
-    {"?", 1}, // ternary
+    char magic[4];
+    uint32_t version;
+    uint8_t key[jtokKeySize];
+    uint64_t source_size;
+    uint32_t mode;
+    uint32_t count;
+    uint32_t strings;
+    uint32_t reserved;
+    uint64_t strings_size;
 };
 
-static char lexKeywordStartChars[] = "nsielvruftcpoamwdbq";
+static_assert(sizeof(JtokHeader) % sizeof(uint32_t) == 0, "JtokHeader must keep the arrays aligned");
 
-static const char lexIdentifierChars[] = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789_:";
-static const size_t lexIdentifierCharsLength = (sizeof(lexIdentifierChars) - 1) / sizeof(char);
+static void jtok_fill_key(uint8_t (&dst)[jtokKeySize], const std::string &key)
+{
+    std::memset(dst, 0, jtokKeySize);
+    std::memcpy(dst, key.data(), std::min(key.size(), jtokKeySize));
+}
 
-enum class NumberLiteralType
+static size_t jtok_types_size(size_t count)
 {
-    Invalid,
-    Decimal,
-    DecimalExplicit,
-    Hexadecimal,
-    Binary,
-    Octal,
-    Floating,
-};
+    return (count + sizeof(uint32_t) - 1) & ~(sizeof(uint32_t) - 1);
+}
 
-static NumberLiteralType check_number_literal_type(std::string input)
+bool jcc::TokenList::save(const std::string &path, const std::string &key, LexMode mode) const
 {
-    if (input[0] == '-')
+    if (!m_source || key.size() > jtokKeySize)
     {
-        input = input.substr(1);
+        return false;
     }
 
-    if (input.length() < 3)
+    size_t count = m_types.size();
+    std::vector<uint32_t> payloads(m_payloads);
+    for (size_t i = 0; i < count; i++)
     {
-        if (std::isdigit(input[0]))
+        if (m_types[i] != TokenType::Identifier)
         {
-            return NumberLiteralType::Decimal;
-        }
-        else
-        {
-            return NumberLiteralType::Invalid;
+            continue;
         }
-    }
-
-    std::string prefix = input.substr(0, 2);
 
-    if (prefix == "0x")
-    {
-        for (size_t i = 2; i < input.length(); i++)
+        // identifiers are interned again from their spelling on load
+        if (Symbol::from_id(payloads[i]).str() != std::string_view(m_source->data() + m_offsets[i], m_lengths[i]))
         {
-            if (!((input[i] >= '0' && input[i] <= '9') || (input[i] >= 'a' && input[i] <= 'f')))
-            {
-                return NumberLiteralType::Invalid;
-            }
+            return false;
         }
-        return NumberLiteralType::Hexadecimal;
+        payloads[i] = 0;
     }
-    else if (prefix == "0b")
+
+    std::vector<uint32_t> string_lengths;
+    uint64_t strings_size = 0;
+    if (m_strings)
     {
-        for (size_t i = 2; i < input.length(); i++)
+        string_lengths.reserve(m_strings->size());
+        for (const auto &str : *m_strings)
         {
-            if (!(input[i] == '0' || input[i] == '1'))
-            {
-                return NumberLiteralType::Invalid;
-            }
+            string_lengths.push_back(static_cast<uint32_t>(str.size()));
+            strings_size += str.size();
         }
-        return NumberLiteralType::Binary;
     }
-    else if (prefix == "0o")
+
+    JtokHeader header = {};
+    std::memcpy(header.magic, "JTOK", 4);
+    header.version = jtokVersion;
+    jtok_fill_key(header.key, key);
+    header.source_size = m_source->size();
+    header.mode = static_cast<uint32_t>(mode);
+    header.count = static_cast<uint32_t>(count);
+    header.strings = static_cast<uint32_t>(string_lengths.size());
+    header.strings_size = strings_size;
+
+    // write next to the destination and rename, so concurrent builds never
+    // see a partial file
+    std::string temp_path = path + ".tmp" + std::to_string(std::random_device{}());
+
     {
-        for (size_t i = 2; i < input.length(); i++)
+        std::ofstream out(temp_path, std::ios::binary | std::ios::trunc);
+        if (!out.is_open())
         {
-            if (!(input[i] >= '0' && input[i] <= '7'))
-            {
-                return NumberLiteralType::Invalid;
-            }
+            return false;
         }
-        return NumberLiteralType::Octal;
-    }
-    else if (prefix == "0d")
-    {
-        for (size_t i = 2; i < input.length(); i++)
+
+        const char padding[sizeof(uint32_t)] = {};
+
+        out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+        out.write(reinterpret_cast<const char *>(m_types.data()), count);
+        out.write(padding, jtok_types_size(count) - count);
+        out.write(reinterpret_cast<const char *>(payloads.data()), count * sizeof(uint32_t));
+        out.write(reinterpret_cast<const char *>(m_offsets.data()), count * sizeof(uint32_t));
+        out.write(reinterpret_cast<const char *>(m_lengths.data()), count * sizeof(uint32_t));
+        out.write(reinterpret_cast<const char *>(string_lengths.data()), string_lengths.size() * sizeof(uint32_t));
+        if (m_strings)
         {
-            if (!(input[i] >= '0' && input[i] <= '9'))
+            for (const auto &str : *m_strings)
             {
-                return NumberLiteralType::Invalid;
+                out.write(str.data(), str.size());
             }
         }
-        return NumberLiteralType::DecimalExplicit;
-    }
-    else
-    {
-        for (size_t i = 0; i < input.length(); i++)
+
+        if (!out.good())
         {
-            if (!(input[i] >= '0' && input[i] <= '9'))
-            {
-                goto test_float;
-            }
+            out.close();
+            std::remove(temp_path.c_str());
+            return false;
         }
-        return NumberLiteralType::Decimal;
     }
 
-test_float:
-    auto regexpFloat = std::regex("^([0-9]+(\\.[0-9]+)?)?(e[+-]?([0-9]+(\\.?[0-9]+)?)+)*$");
-
-    // slow operation
-    if (std::regex_match(input, regexpFloat))
+    if (std::rename(temp_path.c_str(), path.c_str()) != 0)
     {
-        std::cout << "Floating point number literal detected:" << input << std::endl;
-        return NumberLiteralType::Floating;
+        std::remove(temp_path.c_str());
+        return false;
     }
 
-    return NumberLiteralType::Invalid;
+    return true;
 }
 
-static std::string normalize_float(const std::string &input)
+bool jcc::TokenList::load(const std::string &path, std::shared_ptr<const std::string> source, const std::string &key, LexMode mode)
 {
-    double mantissa = 0;
-    double exponent = 0;
-    double x = 0;
-
-    size_t e_pos = input.find('e');
-
-    if (e_pos == std::string::npos)
+    SourceFile file;
+    if (!source || key.size() > jtokKeySize || !file.open(path))
     {
-        return input;
+        return false;
     }
 
-    mantissa = std::stod(input.substr(0, e_pos));
-    exponent = std::stod(input.substr(e_pos + 1));
+    std::string_view data = file.contents();
 
-    x = mantissa * std::pow(10.0, exponent);
-    std::stringstream ss;
-    ss << std::setprecision(FLOATING_POINT_LITERAL_ROUND_DIGITS) << x;
-    return ss.str();
-}
+    JtokHeader header;
+    if (data.size() < sizeof(header))
+    {
+        return false;
+    }
+    std::memcpy(&header, data.data(), sizeof(header));
 
-std::string normalize_number_literal(std::string &number, size_t column, size_t line)
-{
-    uint64_t x = 0;
+    uint8_t expected_key[jtokKeySize];
+    jtok_fill_key(expected_key, key);
 
-    for (size_t i = 0; i < number.length(); i++)
+    if (std::memcmp(header.magic, "JTOK", 4) != 0 || header.version != jtokVersion ||
+        std::memcmp(header.key, expected_key, jtokKeySize) != 0 || header.source_size != source->size() ||
+        header.mode != static_cast<uint32_t>(mode))
     {
-        number[i] = std::tolower(number[i]);
+        return false;
     }
 
-    NumberLiteralType type = check_number_literal_type(number);
-    if (type == NumberLiteralType::Invalid)
+    size_t count = header.count;
+    uint64_t expected_size = sizeof(header) + jtok_types_size(count) + 3 * uint64_t(count) * sizeof(uint32_t) +
+                             uint64_t(header.strings) * sizeof(uint32_t) + header.strings_size;
+    if (data.size() != expected_size)
     {
-        throw jcc::LexerExceptionInvalidLiteral("Number literal not valid at line " + std::to_string(line) + ", column " + std::to_string(column));
+        return false;
     }
 
-    switch (type)
+    const char *cursor = data.data() + sizeof(header);
+    auto read_array = [&cursor](auto &vec, size_t n, size_t advance)
     {
-    case NumberLiteralType::Hexadecimal:
-        for (size_t i = 2; i < number.length(); ++i)
+        vec.resize(n);
+        std::memcpy(vec.data(), cursor, n * sizeof(vec[0]));
+        cursor += advance;
+    };
+
+    std::vector<TokenType> types;
+    std::vector<uint32_t> payloads, offsets, lengths, string_lengths;
+    read_array(types, count, jtok_types_size(count));
+    read_array(payloads, count, count * sizeof(uint32_t));
+    read_array(offsets, count, count * sizeof(uint32_t));
+    read_array(lengths, count, count * sizeof(uint32_t));
+    read_array(string_lengths, header.strings, header.strings * sizeof(uint32_t));
+
+    std::shared_ptr<std::deque<std::string>> strings;
+    if (header.strings > 0)
+    {
+        strings = std::make_shared<std::deque<std::string>>();
+        const char *end = data.data() + data.size();
+        for (uint32_t length : string_lengths)
         {
-            // check for overflow
-            if (x & 0xF000000000000000)
-            {
-                throw jcc::LexerExceptionInvalidLiteral("Hexadecimal number literal at line " + std::to_string(line) + ", column " + std::to_string(column) + " is too large. Will not fit in 64 bits.");
-            }
-
-            if (number[i] >= '0' && number[i] <= '9')
-            {
-                x = (x << 4) + (number[i] - '0');
-            }
-            else if (number[i] >= 'a' && number[i] <= 'f')
-            {
-                x = (x << 4) + (number[i] - 'a' + 10);
-            }
-            else
+            if (length > static_cast<size_t>(end - cursor))
             {
-                throw jcc::LexerExceptionInvalidLiteral("Hexadecimal number literal not valid at line " + std::to_string(line) + ", column " + std::to_string(column));
+                return false;
             }
+            strings->emplace_back(cursor, length);
+            cursor += length;
         }
-        break;
-    case NumberLiteralType::Binary:
-        for (size_t i = 2; i < number.length(); ++i)
-        {
-            // check for overflow
-            if (x & 0x8000000000000000)
-            {
-                throw jcc::LexerExceptionInvalidLiteral("Binary number literal at line " + std::to_string(line) + ", column " + std::to_string(column) + " is too large. Will not fit in 64 bits.");
-            }
+    }
 
-            x = (x << 1) + (number[i] - '0');
+    for (size_t i = 0; i < count; i++)
+    {
+        if (static_cast<uint64_t>(offsets[i]) + lengths[i] > source->size())
+        {
+            return false;
         }
-        break;
-    case NumberLiteralType::Octal:
-        for (size_t i = 2; i < number.length(); ++i)
+
+        switch (types[i])
         {
-            // check for overflow
-            if (x & 0xE000000000000000)
+        case TokenType::Keyword:
+        case TokenType::Operator:
+        case TokenType::Punctuator:
+            break;
+        case TokenType::Identifier:
+            payloads[i] = Symbol(std::string_view(source->data() + offsets[i], lengths[i])).id();
+            break;
+        case TokenType::NumberLiteral:
+        case TokenType::FloatingPointLiteral:
+        case TokenType::StringLiteral:
+        case TokenType::MultiLineComment:
+        case TokenType::SingleLineComment:
+        case TokenType::Raw:
+        case TokenType::Whitespace:
+            if (payloads[i] > header.strings)
             {
-                throw jcc::LexerExceptionInvalidLiteral("Octal number literal at line " + std::to_string(line) + ", column " + std::to_string(column) + " is too large. Will not fit in 64 bits.");
+                return false;
             }
-
-            x = (x << 3) + (number[i] - '0');
+            break;
+        default:
+            return false;
         }
-        break;
-    case NumberLiteralType::DecimalExplicit:
-        x = std::stoull(number.substr(2));
-        break;
-    case NumberLiteralType::Decimal:
-        x = std::stoull(number);
-        break;
-    default:
-        break;
     }
 
-    /// TODO: Verify correctness of literal normalization
-    return std::to_string(x);
+    m_types = std::move(types);
+    m_payloads = std::move(payloads);
+    m_offsets = std::move(offsets);
+    m_lengths = std::move(lengths);
+    m_strings = std::move(strings);
+    pin_source(std::move(source));
+    done();
+
+    return true;
 }
 
-/// @brief Lex the source code into a list of tokens
-/// @param source JXX source code raw string
-/// @param preprocess Whether to preprocess the source code
-/// @return A vector of tokens
-/// @note This is probably the most complex I have ever written. So expect bugs.
-jcc::TokenList jcc::CompilationUnit::lex(const std::string &source)
-{
-    /// TODO: Run unit tests on this function
-    std::string current_token;
-    TokenList result;
-    result.m_tokens.reserve((float)source.length() / 10);
-    LexerState state = LexerState::Default;
-    LexerStateModifier modifier = LexerStateModifier::None;
-    size_t i = 0, src_length, line = 1, column = 1;
-    bool found = false;
+///=============================================================================
+/// Lexer tables
+///=============================================================================
 
-    src_length = source.length();
+enum class LexerState
+{
+    Default,
+    StringLiteral,
+    SingleLineComment,
+    MultiLineComment,
+    Identifier,
+    Operator,
+    Punctuator,
+    Whitespace,
+    Raw
+};
+
+enum class LexerStateModifier
+{
+    None,
+    StringEscape,
+    StringSingleQuote,
+    StringSingleQuoteEscape
+};
+
+/// @brief Operator spelling table used by the lexer's DFA scanner.
+/// @note Entries are grouped by their first character, and within a group they
+/// are ordered longest first, so the first hit while walking a group is the
+/// longest match (maximal munch).
+struct LexOperatorEntry
+{
+    const char *text;
+    uint8_t length;
+    jcc::Operator op;
+};
+
+static constexpr LexOperatorEntry lexOperators[] = {
+    {"+=", 2, jcc::Operator::PlusEquals},
+    {"++", 2, jcc::Operator::Increment},
+    {"+", 1, jcc::Operator::Plus},
+
+    {"-=", 2, jcc::Operator::MinusEquals},
+    {"--", 2, jcc::Operator::Decrement},
+    {"-", 1, jcc::Operator::Minus},
+
+    {"*=", 2, jcc::Operator::TimesEquals},
+    {"*", 1, jcc::Operator::Times},
+
+    {"/=", 2, jcc::Operator::FloatingDivideEquals},
+    {"//", 2, jcc::Operator::FloorDivide},
+    {"/", 1, jcc::Operator::FloatingDivide},
+
+    {"%=", 2, jcc::Operator::ModulusEquals},
+    {"%", 1, jcc::Operator::Modulus},
+
+    {"^^=", 3, jcc::Operator::XorEquals},
+    {"^=", 2, jcc::Operator::BitwiseXorEquals},
+    {"^^", 2, jcc::Operator::Xor},
+    {"^", 1, jcc::Operator::BitwiseXor},
+
+    {"||=", 3, jcc::Operator::OrEquals},
+    {"|=", 2, jcc::Operator::BitwiseOrEquals},
+    {"||", 2, jcc::Operator::Or},
+    {"|", 1, jcc::Operator::BitwiseOr},
+
+    {"&&=", 3, jcc::Operator::AndEquals},
+    {"&=", 2, jcc::Operator::BitwiseAndEquals},
+    {"&&", 2, jcc::Operator::And},
+    {"&", 1, jcc::Operator::BitwiseAnd},
+
+    {"<<=", 3, jcc::Operator::LeftShiftEquals},
+    {"<<", 2, jcc::Operator::LeftShift},
+    {"<=", 2, jcc::Operator::LessThanOrEqual},
+    {"<", 1, jcc::Operator::LessThan},
+
+    {">>>=", 4, jcc::Operator::UnsignedRightShiftEquals},
+    {">>=", 3, jcc::Operator::ArithmeticRightShiftEquals},
+    {">>", 2, jcc::Operator::RightShift},
+    {">=", 2, jcc::Operator::GreaterThanOrEqual},
+    {">", 1, jcc::Operator::GreaterThan},
+
+    {"==", 2, jcc::Operator::Equals},
+    {"=", 1, jcc::Operator::Assign},
+
+    {"!=", 2, jcc::Operator::NotEquals},
+    {"!", 1, jcc::Operator::Not},
+
+    {"??", 2, jcc::Operator::NullCoalesce},
+    {"?", 1, jcc::Operator::Ternary},
+
+    {"@", 1, jcc::Operator::At},
+    {"~", 1, jcc::Operator::BitwiseNot},
+};
+
+/// @brief Per-byte dispatch entry: the slice of `lexOperators` that starts
+/// with this byte, and the punctuator this byte spells (if any).
+struct LexDispatchEntry
+{
+    uint8_t op_begin = 0;
+    uint8_t op_count = 0;
+    bool is_punctuator = false;
+    jcc::Punctuator punctuator = jcc::Punctuator::OpenParen;
+};
+
+static constexpr std::array<LexDispatchEntry, 256> lexBuildDispatchTable()
+{
+    std::array<LexDispatchEntry, 256> table{};
+
+    for (size_t i = 0; i < std::size(lexOperators); i++)
+    {
+        auto &entry = table[static_cast<uint8_t>(lexOperators[i].text[0])];
+        if (entry.op_count == 0)
+        {
+            entry.op_begin = static_cast<uint8_t>(i);
+        }
+        else if (entry.op_begin + entry.op_count != i)
+        {
+            throw "lexOperators must be grouped by first character";
+        }
+        entry.op_count++;
+    }
+
+    constexpr std::pair<char, jcc::Punctuator> punctuators[] = {
+        {'(', jcc::Punctuator::OpenParen},
+        {')', jcc::Punctuator::CloseParen},
+        {'{', jcc::Punctuator::OpenBrace},
+        {'}', jcc::Punctuator::CloseBrace},
+        {'[', jcc::Punctuator::OpenBracket},
+        {']', jcc::Punctuator::CloseBracket},
+        {';', jcc::Punctuator::Semicolon},
+        {',', jcc::Punctuator::Comma},
+        {':', jcc::Punctuator::Colon},
+        {'.', jcc::Punctuator::Period},
+    };
+
+    for (const auto &p : punctuators)
+    {
+        table[static_cast<uint8_t>(p.first)].is_punctuator = true;
+        table[static_cast<uint8_t>(p.first)].punctuator = p.second;
+    }
+
+    return table;
+}
+
+static constexpr std::array<LexDispatchEntry, 256> lexDispatchTable = lexBuildDispatchTable();
+
+/// @brief Match the longest operator starting at `src`
+/// @param src Pointer to the first character of the candidate operator
+/// @param remaining Number of readable bytes starting at `src`
+/// @param op Receives the matched operator
+/// @return Length of the match, or 0 if no operator starts here
+static inline size_t lex_match_operator(const char *src, size_t remaining, jcc::Operator &op)
+{
+    const LexDispatchEntry &entry = lexDispatchTable[static_cast<uint8_t>(src[0])];
+
+    for (size_t k = entry.op_begin; k < (size_t)entry.op_begin + entry.op_count; k++)
+    {
+        const LexOperatorEntry &candidate = lexOperators[k];
+        if (candidate.length > remaining)
+        {
+            continue;
+        }
+
+        size_t j = 1;
+        while (j < candidate.length && src[j] == candidate.text[j])
+        {
+            j++;
+        }
+
+        if (j == candidate.length)
+        {
+            op = candidate.op;
+            return candidate.length;
+        }
+    }
+
+    return 0;
+}
+
+/// @brief Byte classes used when scanning identifiers and keywords
+static constexpr std::array<bool, 256> lexBuildIdentifierCharTable()
+{
+    std::array<bool, 256> table{};
+    for (int c = 0; c < 256; c++)
+    {
+        table[c] = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_';
+    }
+    return table;
+}
+
+static constexpr std::array<bool, 256> lexIdentifierChars = lexBuildIdentifierCharTable();
+
+///=============================================================================
+/// Keyword perfect hash
+///
+/// Every spelling in `jcc::lexKeywordMapReverse` is hashed into a table of
+/// `lexKeywordHashSlots` entries. The seed is searched at compile time so that
+/// no two keywords share a slot; a lookup is then one hash, one table load and
+/// one length + memcmp check.
+///=============================================================================
+
+static constexpr size_t lexKeywordHashBits = 9;
+static constexpr size_t lexKeywordHashSlots = 1 << lexKeywordHashBits;
+static constexpr uint8_t lexKeywordHashEmpty = 0xFF;
+
+static_assert(jcc::lexKeywordCount < lexKeywordHashEmpty, "Keyword index must fit the hash table entries");
+
+static constexpr uint32_t lex_keyword_hash(const char *str, size_t length, uint32_t seed)
+{
+    // FNV-1a with a seeded basis
+    uint32_t hash = 2166136261u ^ seed;
+    for (size_t i = 0; i < length; i++)
+    {
+        hash ^= static_cast<uint8_t>(str[i]);
+        hash *= 16777619u;
+    }
+    return hash >> (32 - lexKeywordHashBits);
+}
+
+static constexpr size_t lex_constexpr_strlen(const char *str)
+{
+    size_t length = 0;
+    while (str[length] != '\0')
+    {
+        length++;
+    }
+    return length;
+}
+
+static constexpr std::array<uint8_t, jcc::lexKeywordCount> lexBuildKeywordLengths()
+{
+    std::array<uint8_t, jcc::lexKeywordCount> lengths{};
+    for (size_t i = 0; i < jcc::lexKeywordCount; i++)
+    {
+        lengths[i] = static_cast<uint8_t>(lex_constexpr_strlen(jcc::lexKeywordMapReverse.m_values[i]));
+    }
+    return lengths;
+}
+
+static constexpr std::array<uint8_t, jcc::lexKeywordCount> lexKeywordLengths = lexBuildKeywordLengths();
+
+static constexpr bool lex_try_keyword_seed(uint32_t seed, std::array<uint8_t, lexKeywordHashSlots> &table)
+{
+    for (auto &slot : table)
+    {
+        slot = lexKeywordHashEmpty;
+    }
+
+    for (size_t i = 0; i < jcc::lexKeywordCount; i++)
+    {
+        uint32_t slot = lex_keyword_hash(jcc::lexKeywordMapReverse.m_values[i], lexKeywordLengths[i], seed);
+        if (table[slot] != lexKeywordHashEmpty)
+        {
+            return false;
+        }
+        table[slot] = static_cast<uint8_t>(i);
+    }
+
+    return true;
+}
+
+static constexpr uint32_t lex_find_keyword_seed()
+{
+    std::array<uint8_t, lexKeywordHashSlots> table{};
+    for (uint32_t seed = 0;; seed++)
+    {
+        if (lex_try_keyword_seed(seed, table))
+        {
+            return seed;
+        }
+    }
+}
+
+static constexpr uint32_t lexKeywordHashSeed = lex_find_keyword_seed();
+
+static constexpr std::array<uint8_t, lexKeywordHashSlots> lexBuildKeywordHashTable()
+{
+    std::array<uint8_t, lexKeywordHashSlots> table{};
+    lex_try_keyword_seed(lexKeywordHashSeed, table);
+    return table;
+}
+
+static constexpr std::array<uint8_t, lexKeywordHashSlots> lexKeywordHashTable = lexBuildKeywordHashTable();
+
+static constexpr size_t lexBuildKeywordMaxLength()
+{
+    size_t max = 0;
+    for (auto length : lexKeywordLengths)
+    {
+        max = length > max ? length : max;
+    }
+    return max;
+}
+
+static constexpr size_t lexKeywordMaxLength = lexBuildKeywordMaxLength();
+
+/// @brief Classify a complete identifier as a keyword
+/// @param str Pointer to the first character of the identifier
+/// @param length Length of the identifier
+/// @param kw Receives the keyword on success
+/// @return True if the identifier spells a keyword
+static inline bool lex_classify_keyword(const char *str, size_t length, jcc::Keyword &kw)
+{
+    if (length > lexKeywordMaxLength)
+    {
+        return false;
+    }
+
+    uint8_t index = lexKeywordHashTable[lex_keyword_hash(str, length, lexKeywordHashSeed)];
+    if (index == lexKeywordHashEmpty || lexKeywordLengths[index] != length || std::memcmp(str, jcc::lexKeywordMapReverse.m_values[index], length) != 0)
+    {
+        return false;
+    }
+
+    kw = static_cast<jcc::Keyword>(index);
+    return true;
+}
+
+/// @brief Value of a digit in any base up to 16
+/// @return The digit value, or 0xff if `c` is not a hexadecimal digit
+static constexpr unsigned lex_digit_value(char c)
+{
+    if (c >= '0' && c <= '9')
+    {
+        return c - '0';
+    }
+    if (c >= 'a' && c <= 'f')
+    {
+        return c - 'a' + 10;
+    }
+    if (c >= 'A' && c <= 'F')
+    {
+        return c - 'A' + 10;
+    }
+    return 0xff;
+}
+
+/// @brief Largest normalized spelling of a number literal: 20 digits for an
+/// integer, 24 characters for the shortest round-trip form of a double
+constexpr size_t lexNumberMaxNormalized = 32;
+
+/// @brief Scan a number literal in a single pass
+/// @param src Start of the literal; the first character is a digit
+/// @param remaining Number of bytes available at `src`
+/// @param type Receives NumberLiteral or FloatingPointLiteral
+/// @param normalized Buffer of `lexNumberMaxNormalized` bytes that receives the normalized spelling
+/// @param normalized_length Receives the normalized length, or 0 if the source spelling is already normal
+/// @param where Callable returning the "line X, column Y" of an offset relative to `src`, only invoked on error
+/// @return The length of the literal in the source
+/// @note Integers (`0x`, `0b`, `0o`, `0d` prefixed or plain decimal) normalize
+/// to their decimal value. Floats with an exponent normalize to the shortest
+/// spelling that round-trips to the same double; other floats are kept as is.
+template <typename Where>
+static size_t lex_scan_number(const char *src, size_t remaining, jcc::TokenType &type, char *normalized, size_t &normalized_length, Where where)
+{
+    size_t i = 0;
+    uint64_t x = 0;
+    unsigned base = 10;
+    const char *kind = "Decimal";
+
+    type = jcc::TokenType::NumberLiteral;
+    normalized_length = 0;
+
+    if (remaining >= 2 && src[0] == '0')
+    {
+        switch (src[1])
+        {
+        case 'x':
+            base = 16;
+            kind = "Hexadecimal";
+            break;
+        case 'b':
+            base = 2;
+            kind = "Binary";
+            break;
+        case 'o':
+            base = 8;
+            kind = "Octal";
+            break;
+        case 'd':
+            base = 10;
+            break;
+        default:
+            kind = nullptr;
+            break;
+        }
+    }
+    else
+    {
+        kind = nullptr;
+    }
+
+    if (kind != nullptr)
+    {
+        for (i = 2; i < remaining; i++)
+        {
+            unsigned digit = lex_digit_value(src[i]);
+            if (digit >= base)
+            {
+                break;
+            }
+
+            // check for overflow
+            if (x > (UINT64_MAX - digit) / base)
+            {
+                throw jcc::LexerExceptionInvalidLiteral(std::string(kind) + " number literal at " + where(0) + " is too large. Will not fit in 64 bits.");
+            }
+            x = x * base + digit;
+        }
+
+        if (i == 2 || (i < remaining && lexIdentifierChars[static_cast<uint8_t>(src[i])]))
+        {
+            throw jcc::LexerExceptionInvalidLiteral(std::string(kind) + " number literal not valid at " + where(i));
+        }
+
+        normalized_length = std::to_chars(normalized, normalized + lexNumberMaxNormalized, x).ptr - normalized;
+        return i;
+    }
+
+    bool overflow = false;
+    while (i < remaining && src[i] >= '0' && src[i] <= '9')
+    {
+        unsigned digit = src[i] - '0';
+        if (x > (UINT64_MAX - digit) / 10)
+        {
+            overflow = true;
+        }
+        x = x * 10 + digit;
+        i++;
+    }
+
+    // `..` after an integer is a range, not a fraction
+    bool is_range = i + 1 < remaining && src[i] == '.' && src[i + 1] == '.';
+
+    if (i < remaining && src[i] == '.' && !is_range)
+    {
+        type = jcc::TokenType::FloatingPointLiteral;
+        i++;
+        while (i < remaining && src[i] >= '0' && src[i] <= '9')
+        {
+            i++;
+        }
+    }
+
+    bool has_exponent = false;
+    if (i < remaining && (src[i] == 'e' || src[i] == 'E'))
+    {
+        type = jcc::TokenType::FloatingPointLiteral;
+        has_exponent = true;
+        i++;
+        if (i < remaining && (src[i] == '+' || src[i] == '-'))
+        {
+            i++;
+        }
+
+        size_t exponent_start = i;
+        while (i < remaining && src[i] >= '0' && src[i] <= '9')
+        {
+            i++;
+        }
+
+        if (i == exponent_start)
+        {
+            throw jcc::LexerExceptionInvalidLiteral("Number literal not valid at " + where(i));
+        }
+    }
+
+    if (i < remaining && (lexIdentifierChars[static_cast<uint8_t>(src[i])] || (src[i] == '.' && !is_range)))
+    {
+        throw jcc::LexerExceptionInvalidLiteral("Number literal not valid at " + where(i));
+    }
+
+    if (type == jcc::TokenType::NumberLiteral)
+    {
+        if (overflow)
+        {
+            throw jcc::LexerExceptionInvalidLiteral("Decimal number literal at " + where(0) + " is too large. Will not fit in 64 bits.");
+        }
+
+        // only leading zeros can make the decimal spelling differ
+        if (src[0] == '0' && i > 1)
+        {
+            normalized_length = std::to_chars(normalized, normalized + lexNumberMaxNormalized, x).ptr - normalized;
+        }
+        return i;
+    }
+
+    if (has_exponent)
+    {
+        double value;
+        std::from_chars_result parsed = std::from_chars(src, src + i, value);
+        if (parsed.ec != std::errc() || parsed.ptr != src + i)
+        {
+            throw jcc::LexerExceptionInvalidLiteral("Floating point number literal at " + where(0) + " is out of range");
+        }
+
+        normalized_length = std::to_chars(normalized, normalized + lexNumberMaxNormalized, value).ptr - normalized;
+    }
+
+    return i;
+}
+
+/// @brief Decode the escape sequences of a string literal body
+/// @param body The literal text between the quotes, as it appears in the source
+/// @return The decoded string
+static std::string lex_decode_escapes(std::string_view body)
+{
+    std::string decoded;
+    decoded.reserve(body.size());
+
+    for (size_t i = 0; i < body.size(); i++)
+    {
+        if (body[i] != '\\' || i + 1 == body.size())
+        {
+            decoded += body[i];
+            continue;
+        }
+
+        switch (body[++i])
+        {
+        case 'n':
+            decoded += '\n';
+            break;
+        case 't':
+            decoded += '\t';
+            break;
+        case 'r':
+            decoded += '\r';
+            break;
+        case '0':
+            decoded += '\0';
+            break;
+        default:
+            decoded += body[i];
+            break;
+        }
+    }
+
+    return decoded;
+}
+
+///=============================================================================
+/// jcc::Lexer class implementation
+///=============================================================================
+
+namespace jcc
+{
+    class Lexer;
+}
+
+/// @brief Resumable lexer state machine over a pinned source buffer.
+/// @note `next()` runs the state machine until one token has been recognized
+/// and returns it; `CompilationUnit::lex` drains it into a TokenList, one
+/// chunk of the source per thread.
+class jcc::Lexer
+{
+public:
+    /// @brief A recognized token, with a TokenList payload (see TokenList)
+    struct Lexeme
+    {
+        TokenType type;
+        uint32_t payload;
+        uint32_t offset;
+        uint32_t length;
+
+        /// @brief The text differs from the source spelling and must be taken from `decoded()`
+        bool is_decoded() const
+        {
+            switch (type)
+            {
+            case TokenType::Keyword:
+            case TokenType::Operator:
+            case TokenType::Punctuator:
+            case TokenType::Identifier:
+                return false;
+            default:
+                return payload != 0;
+            }
+        }
+    };
+
+    Lexer(std::shared_ptr<const std::string> source, LexMode mode)
+        : Lexer(source, mode, 0, source->size())
+    {
+    }
+
+    /// @brief Lex only the bytes [begin, end) of the source
+    /// @note `end` must be the end of the source or directly follow a newline
+    /// that is followed by a non-space character, outside any string, raw
+    /// block or comment (see `lex_find_chunk_boundary`).
+    Lexer(std::shared_ptr<const std::string> source, LexMode mode, size_t begin, size_t end)
+        : m_source(std::move(source)), m_lines(m_source), m_keep_trivia(mode == LexMode::Full), m_end(end), m_pos(begin)
+    {
+    }
+
+    /// @brief Recognize the next token
+    /// @param out Receives the token
+    /// @return False once the end of the input has been reached
+    /// @throw LexerException
+    bool next(Lexeme &out);
+
+    /// @brief Decoded text of the last text token with a non-zero payload
+    std::string &decoded() { return m_decoded; }
+
+    const std::shared_ptr<const std::string> &source() const { return m_source; }
+
+    SourceLocation locate(uint32_t offset) const { return m_lines.locate(offset); }
+
+private:
+    std::shared_ptr<const std::string> m_source;
+    LineIndex m_lines;
+    bool m_keep_trivia;
+    size_t m_end;
+
+    size_t m_pos;
+    size_t m_token_start = 0;
+    bool m_has_escape = false;
+    LexerState m_state = LexerState::Default;
+    LexerStateModifier m_modifier = LexerStateModifier::None;
+    std::string m_decoded;
+
+    bool m_has_lexeme = false;
+    Lexeme m_lexeme;
+
+    void emit(TokenType type, uint32_t payload, size_t offset, size_t length)
+    {
+        if (!m_keep_trivia && (type == TokenType::Whitespace || type == TokenType::SingleLineComment || type == TokenType::MultiLineComment))
+        {
+            return;
+        }
+
+        m_lexeme = {type, payload, static_cast<uint32_t>(offset), static_cast<uint32_t>(length)};
+        m_has_lexeme = true;
+    }
+
+    uint32_t decode(std::string text)
+    {
+        m_decoded = std::move(text);
+        return 1;
+    }
+
+    // Line and column are only derived when an error is reported
+    std::string where(size_t offset) const
+    {
+        SourceLocation loc = m_lines.locate(static_cast<uint32_t>(offset));
+        return "line " + std::to_string(loc.line) + ", column " + std::to_string(loc.column);
+    }
+};
+
+bool jcc::Lexer::next(Lexeme &out)
+{
+    /// TODO: Run unit tests on this function
+    const std::string &source = *m_source;
+    const size_t src_length = m_end;
+    size_t &i = m_pos;
+    size_t &token_start = m_token_start;
+    bool &has_escape = m_has_escape;
+    LexerState &state = m_state;
+    LexerStateModifier &modifier = m_modifier;
+
+    while (i < src_length)
+    {
+        if (m_has_lexeme)
+        {
+            break;
+        }
 
-    while (i < src_length)
-    {
         char current_char = source[i];
 
         switch (state)
@@ -597,22 +1406,41 @@ jcc::TokenList jcc::CompilationUnit::lex(const std::string &source)
             // Check for whitespace
             if (std::isspace(current_char))
             {
+                if (!m_keep_trivia)
+                {
+                    break;
+                }
+
                 state = LexerState::Whitespace;
+                token_start = i;
                 continue;
             }
             // Check for number literal
             if (std::isdigit(current_char))
             {
-                state = LexerState::NumberLiteral;
-                continue;
+                TokenType number_type;
+                char normalized[lexNumberMaxNormalized];
+                size_t normalized_length;
+                size_t length = lex_scan_number(source.data() + i, src_length - i, number_type, normalized, normalized_length, [&](size_t offset)
+                                                 { return where(i + offset); });
+
+                // Only keep a copy when normalization changed the spelling
+                uint32_t payload = 0;
+                if (normalized_length != 0 && std::string_view(normalized, normalized_length) != std::string_view(source.data() + i, length))
+                {
+                    payload = decode(std::string(normalized, normalized_length));
+                }
+                emit(number_type, payload, i, length);
+                i += length - 1;
+                break;
             }
 
             // Check for single line comment
             if (src_length - i >= 2 && current_char == '/' && source[i + 1] == '/')
             {
                 state = LexerState::SingleLineComment;
+                token_start = i + 2;
                 i++;
-                column++;
                 break;
             }
 
@@ -620,455 +1448,140 @@ jcc::TokenList jcc::CompilationUnit::lex(const std::string &source)
             if (src_length - i >= 2 && current_char == '/' && source[i + 1] == '*')
             {
                 state = LexerState::MultiLineComment;
+                token_start = i + 2;
                 i++;
-                column++;
                 break;
             }
 
             // Check for operator
-            found = false;
-            for (const auto &op : lexOperators)
             {
-                if (src_length - i >= op.second)
+                Operator op;
+                size_t op_length = lex_match_operator(source.data() + i, src_length - i, op);
+                if (op_length != 0)
                 {
-                    switch (op.second)
-                    {
-                    case 1:
-                        if (current_char == op.first[0])
-                        {
-                            result.push_back(Token(TokenType::Operator, lexOperatorMap.at(op.first)));
-                            i += op.second - 1;
-                            found = true;
-                        }
-                        break;
-                    case 2:
-                        if (current_char == op.first[0] && source[i + 1] == op.first[1])
-                        {
-                            result.push_back(Token(TokenType::Operator, lexOperatorMap.at(op.first)));
-                            i += op.second - 1;
-                            found = true;
-                        }
-                        break;
-                    case 3:
-                        if (current_char == op.first[0] && source[i + 1] == op.first[1] && source[i + 2] == op.first[2])
-                        {
-                            result.push_back(Token(TokenType::Operator, lexOperatorMap.at(op.first)));
-                            i += op.second - 1;
-                            found = true;
-                        }
-                        break;
-                    case 4:
-                        if (current_char == op.first[0] && source[i + 1] == op.first[1] && source[i + 2] == op.first[2] && source[i + 3] == op.first[3])
-                        {
-                            result.push_back(Token(TokenType::Operator, lexOperatorMap.at(op.first)));
-                            i += op.second - 1;
-                            found = true;
-                        }
-                        break;
-                    case 6:
-                        if (current_char == op.first[0] && source[i + 1] == op.first[1] && source[i + 2] == op.first[2] && source[i + 3] == op.first[3] && source[i + 4] == op.first[4] && source[i + 5] == op.first[5])
-                        {
-                            result.push_back(Token(TokenType::Operator, lexOperatorMap.at(op.first)));
-                            i += op.second - 1;
-                            found = true;
-                        }
-
-                    default:
-                        break;
-                    }
-
-                    if (found)
-                    {
-                        break;
-                    }
+                    emit(TokenType::Operator, static_cast<uint32_t>(op), i, op_length);
+                    i += op_length - 1;
+                    break;
                 }
             }
-            if (found)
-            {
-                break;
-            }
 
             // Check for Punctuator
-            found = false;
-            for (const auto &sep : lexPunctuators)
-            {
-                if (src_length - i >= sep.second)
-                {
-                    switch (sep.second)
-                    {
-                    case 1:
-                        if (current_char == sep.first[0])
-                        {
-                            if (src_length - i >= 2 && source[i+1] == ':')
-                            {
-                                break;
-                            }
-                            result.push_back(Token(TokenType::Punctuator, lexPunctuatorMap.at(sep.first)));
-                            found = true;
-                        }
-                        break;
-                    case 2:
-                        if (current_char == sep.first[0] && source[i + 1] == sep.first[1])
-                        {
-                            result.push_back(Token(TokenType::Punctuator, lexPunctuatorMap.at(sep.first)));
-                            i++;
-                            found = true;
-                        }
-                        break;
-
-                    default:
-                        break;
-                    }
-
-                    if (found)
-                    {
-                        break;
-                    }
-                }
-            }
-            if (found)
+            if (lexDispatchTable[static_cast<uint8_t>(current_char)].is_punctuator && (src_length - i < 2 || source[i + 1] != ':'))
             {
+                emit(TokenType::Punctuator, static_cast<uint32_t>(lexDispatchTable[static_cast<uint8_t>(current_char)].punctuator), i, 1);
                 break;
             }
-
             // Check for string literals
             if (current_char == '"')
             {
                 state = LexerState::StringLiteral;
-                modifier = LexerStateModifier::None;
-                break;
-            }
-            else if (current_char == '\'')
-            {
-                state = LexerState::StringLiteral;
-                modifier = LexerStateModifier::StringSingleQuote;
-                break;
-            }
-
-            // Check for keyword
-            found = false;
-            // check lexKeywordStartChars
-            for (size_t j = 0; j < sizeof(lexKeywordStartChars) / sizeof(char); j++)
-            {
-                if (current_char == lexKeywordStartChars[j])
-                {
-                    for (auto kw : lexKeywordMap)
-                    {
-                        size_t kw_length = strlen(kw.first);
-                        if (src_length - i >= kw_length && source.substr(i, kw_length) == kw.first)
-                        {
-                            // verify next character is not an identifier character
-                            if (src_length - i > kw_length && std::strchr(lexIdentifierChars, source[i + kw_length]))
-                            {
-                                break;
-                            }
-
-                            result.push_back(Token(TokenType::Keyword, kw.second));
-                            i += kw_length - 1;
-                            found = true;
-                            break;
-                        }
-                    }
-                    break;
-                }
-            }
-            if (found)
-            {
-                break;
-            }
-
-            if (current_char == '`')
-            {
-                state = LexerState::Raw;
-                continue;
-            }
-
-            // Check for identifier
-            if (!std::isdigit(current_char))
-            {
-                if (std::isalpha(current_char) || current_char == '_' || current_char == ':')
-                {
-                    state = LexerState::Identifier;
-                    continue;
-                }
-            }
-
-            // invalid state
-            throw LexerExceptionUnexpected("Unexpected token at line " + std::to_string(line) + ", column " + std::to_string(column) + ": '" + current_char + "': '" + current_token + "'");
-
-            break;
-        case LexerState::StringLiteral:
-            if (current_char == '\n' || src_length - i == 0)
-            {
-                throw LexerExceptionInvalidLiteral("String literal not terminated. Expected '\"' at line " + std::to_string(line) + ", column " + std::to_string(column));
-            }
-
-            if (modifier == LexerStateModifier::StringSingleQuote || modifier == LexerStateModifier::StringSingleQuoteEscape)
-            {
-                if (modifier == LexerStateModifier::StringSingleQuoteEscape)
-                {
-                    switch (current_char)
-                    {
-                    case 'n':
-                        current_token += '\n';
-                        break;
-                    case 't':
-                        current_token += '\t';
-                        break;
-                    case 'r':
-                        current_token += '\r';
-                        break;
-                    case '0':
-                        current_token += '\0';
-                        break;
-                    case '\\':
-                        current_token += '\\';
-                        break;
-
-                    default:
-                        current_token += current_char;
-                        break;
-                    }
-                    modifier = LexerStateModifier::StringSingleQuote;
-                }
-                else if (current_char == '\\')
-                {
-                    modifier = LexerStateModifier::StringSingleQuoteEscape;
-                }
-                else if (current_char == '\'')
-                {
-                    result.push_back(Token(TokenType::StringLiteral, current_token));
-                    current_token.clear();
-                    state = LexerState::Default;
-                    modifier = LexerStateModifier::None;
-                }
-                else
-                {
-                    current_token += current_char;
-                }
-
-                break;
-            }
-            else
-            {
-
-                if (modifier == LexerStateModifier::StringEscape)
-                {
-                    switch (current_char)
-                    {
-                    case 'n':
-                        current_token += '\n';
-                        break;
-                    case 't':
-                        current_token += '\t';
-                        break;
-                    case 'r':
-                        current_token += '\r';
-                        break;
-                    case '0':
-                        current_token += '\0';
-                        break;
-                    case '\\':
-                        current_token += '\\';
-                        break;
-
-                    default:
-                        current_token += current_char;
-                        break;
-                    }
-                    modifier = LexerStateModifier::None;
-                }
-                else if (current_char == '\\')
-                {
-                    modifier = LexerStateModifier::StringEscape;
-                }
-                else if (current_char == '"')
-                {
-                    result.push_back(Token(TokenType::StringLiteral, current_token));
-                    current_token.clear();
-                    state = LexerState::Default;
-                }
-                else
-                {
-                    current_token += current_char;
-                }
+                modifier = LexerStateModifier::None;
+                token_start = i + 1;
+                has_escape = false;
+                break;
             }
-            break;
-        case LexerState::NumberLiteral:
-            if ((current_token.empty() || current_token.size() == 1))
+            else if (current_char == '\'')
             {
-                if (!std::isdigit(current_char) && (current_char != 'b' && current_char != 'o' && current_char != 'x' && current_char != 'd' && current_char != '.'))
-                {
-                    if (current_token.size() > 1)
-                    {
-                        throw LexerExceptionInvalidLiteral("Number literal not valid at line " + std::to_string(line) + ", column " + std::to_string(column));
-                    }
-                    else
-                    {
-                        goto finish_number_literal;
-                    }
-                }
-
-                current_token += current_char;
+                state = LexerState::StringLiteral;
+                modifier = LexerStateModifier::StringSingleQuote;
+                token_start = i + 1;
+                has_escape = false;
                 break;
             }
 
-            switch (current_token[0])
+            // Check for keyword or identifier
+            if (std::isalpha(current_char) || current_char == '_')
             {
-            case '0':
-                if (current_token.size() >= 2 && current_token[1] == 'x')
-                {
-                    if ((current_char >= '0' && current_char <= '9') || (current_char >= 'a' && current_char <= 'f') || (current_char >= 'A' && current_char <= 'F'))
-                    {
-                        current_token += current_char;
-                    }
-                    else if (current_token.length() == 2)
-                    {
-                        throw LexerExceptionInvalidLiteral("Hexadecimal number literal not valid at line " + std::to_string(line) + ", column " + std::to_string(column));
-                    }
-                    else if (isalnum(current_char) || current_char == '_')
-                    {
-                        throw LexerExceptionInvalidLiteral("Hexadecimal number literal not valid at line " + std::to_string(line) + ", column " + std::to_string(column));
-                    }
-                    else
-                    {
-                        goto finish_number_literal;
-                    }
-                }
-                else if (current_token.size() >= 2 && current_token[1] == 'b')
-                {
-                    if (current_char == '0' || current_char == '1')
-                    {
-                        current_token += current_char;
-                    }
-                    else if (current_token.length() == 2)
-                    {
-                        throw LexerExceptionInvalidLiteral("Binary number literal not valid at line " + std::to_string(line) + ", column " + std::to_string(column));
-                    }
-                    else if (isalnum(current_char) || current_char == '_')
-                    {
-                        throw LexerExceptionInvalidLiteral("Binary number literal not valid at line " + std::to_string(line) + ", column " + std::to_string(column));
-                    }
-                    else
-                    {
-                        goto finish_number_literal;
-                    }
-                }
-                else if (current_token.size() >= 2 && current_token[1] == 'o')
+                size_t end = i + 1;
+                while (end < src_length && lexIdentifierChars[static_cast<uint8_t>(source[end])])
                 {
-                    if (current_char >= '0' && current_char <= '7')
-                    {
-                        current_token += current_char;
-                    }
-                    else if (current_token.length() == 2)
-                    {
-                        throw LexerExceptionInvalidLiteral("Octal number literal not valid at line " + std::to_string(line) + ", column " + std::to_string(column));
-                    }
-                    else if (isalnum(current_char) || current_char == '_')
-                    {
-                        throw LexerExceptionInvalidLiteral("Octal number literal not valid at line " + std::to_string(line) + ", column " + std::to_string(column));
-                    }
-                    else
-                    {
-                        goto finish_number_literal;
-                    }
+                    end++;
                 }
-                else if (current_token.size() >= 2 && current_token[1] == 'd')
+
+                // Scoped names (`a::b`) are assembled by the identifier state
+                if (end == src_length || source[end] != ':')
                 {
-                    if (current_char >= '0' && current_char <= '9')
-                    {
-                        current_token += current_char;
-                    }
-                    else if (current_token.length() == 2)
+                    Keyword kw;
+                    if (lex_classify_keyword(source.data() + i, end - i, kw))
                     {
-                        throw LexerExceptionInvalidLiteral("Decimal number literal not valid at line " + std::to_string(line) + ", column " + std::to_string(column));
-                    }
-                    else if (isalnum(current_char) || current_char == '_')
-                    {
-                        throw LexerExceptionInvalidLiteral("Decimal number literal not valid at line " + std::to_string(line) + ", column " + std::to_string(column));
+                        emit(TokenType::Keyword, static_cast<uint32_t>(kw), i, end - i);
                     }
                     else
                     {
-                        goto finish_number_literal;
+                        emit(TokenType::Identifier, Symbol(std::string_view(source.data() + i, end - i)).id(), i, end - i);
                     }
+                    i = end - 1;
+                    break;
                 }
-                else if ((current_char >= '0' && current_char <= '9') || current_char == '.')
-                {
-                    current_token += current_char;
-                }
-                else
-                {
-                    goto finish_number_literal;
-                }
-                break;
-            case '1':
-            case '2':
-            case '3':
-            case '4':
-            case '5':
-            case '6':
-            case '7':
-            case '8':
-            case '9':
-                if ((current_char >= '0' && current_char <= '9') || current_char == '.' || current_char == 'e')
-                {
-                    current_token += current_char;
-                }
-                else if (isalnum(current_char) || current_char == '_')
-                {
-                    throw LexerExceptionInvalidLiteral("Number literal not valid at line " + std::to_string(line) + ", column " + std::to_string(column));
-                }
-                else
-                {
-                    goto finish_number_literal;
-                }
-                break;
-            default:
-                throw LexerExceptionInvalidLiteral("Number literal not valid at line " + std::to_string(line) + ", column " + std::to_string(column));
+
+                state = LexerState::Identifier;
+                token_start = i;
+                continue;
+            }
+
+            if (current_char == '`')
+            {
+                state = LexerState::Raw;
+                token_start = i + 1;
+                continue;
             }
+
+            // Check for identifier
+            if (current_char == ':')
+            {
+                state = LexerState::Identifier;
+                token_start = i;
+                continue;
+            }
+
+            // invalid state
+            throw LexerExceptionUnexpected("Unexpected token at " + where(i) + ": '" + current_char + "'");
+
             break;
+        case LexerState::StringLiteral:
+            if (current_char == '\n' || src_length - i == 0)
+            {
+                throw LexerExceptionInvalidLiteral("String literal not terminated. Expected '\"' at " + where(i));
+            }
 
-        finish_number_literal:
-            if (current_token.find('.') != std::string::npos || current_token.find('e') != std::string::npos)
+            if (modifier == LexerStateModifier::StringEscape || modifier == LexerStateModifier::StringSingleQuoteEscape)
             {
-                result.push_back(Token(TokenType::FloatingPointLiteral, normalize_float(current_token)));
+                // The escaped character is decoded once the literal is complete
+                modifier = modifier == LexerStateModifier::StringEscape ? LexerStateModifier::None : LexerStateModifier::StringSingleQuote;
             }
-            else
+            else if (current_char == '\\')
             {
-                result.push_back(Token(TokenType::NumberLiteral, normalize_number_literal(current_token, column, line)));
+                modifier = modifier == LexerStateModifier::StringSingleQuote ? LexerStateModifier::StringSingleQuoteEscape : LexerStateModifier::StringEscape;
+                has_escape = true;
             }
-            current_token.clear();
-            state = LexerState::Default;
-            continue;
-        case LexerState::SingleLineComment:
-            if (current_char != '\n' || src_length - i == 0)
+            else if (current_char == (modifier == LexerStateModifier::StringSingleQuote ? '\'' : '"'))
             {
-                current_token += current_char;
+                uint32_t payload = 0;
+                if (has_escape)
+                {
+                    payload = decode(lex_decode_escapes(std::string_view(source.data() + token_start, i - token_start)));
+                }
+                emit(TokenType::StringLiteral, payload, token_start, i - token_start);
+                state = LexerState::Default;
+                modifier = LexerStateModifier::None;
             }
-            else
+            break;
+        case LexerState::SingleLineComment:
+            if (current_char == '\n')
             {
-                result.push_back(Token(TokenType::SingleLineComment, current_token));
-                current_token.clear();
+                emit(TokenType::SingleLineComment, 0, token_start, i - token_start);
                 state = LexerState::Default;
-                line++;
-                column = 1;
                 continue;
             }
             break;
         case LexerState::MultiLineComment:
             if (src_length - i >= 2 && current_char == '*' && source[i + 1] == '/')
             {
+                emit(TokenType::MultiLineComment, 0, token_start, i - token_start);
                 i += 2;
-                column += 2;
-                result.push_back(Token(TokenType::MultiLineComment, current_token));
-                current_token.clear();
                 state = LexerState::Default;
                 continue;
             }
-            else
-            {
-                current_token += current_char;
-            }
             break;
         case LexerState::Identifier:
             if (std::isalnum(current_char) || current_char == '_' || current_char == ':')
@@ -1078,26 +1591,20 @@ jcc::TokenList jcc::CompilationUnit::lex(const std::string &source)
                 {
                     if ((src_length - i < 2 || source[i + 1] != ':'))
                     {
-                        result.push_back(Token(TokenType::Identifier, current_token));
-                        current_token.clear();
+                        emit(TokenType::Identifier, Symbol(std::string_view(source.data() + token_start, i - token_start)).id(), token_start, i - token_start);
                         state = LexerState::Default;
                         continue;
                     }
                     else
                     {
-                        current_token += "::";
                         i++;
-                        column++;
                         break;
                     }
                 }
-
-                current_token += current_char;
             }
             else
             {
-                result.push_back(Token(TokenType::Identifier, current_token));
-                current_token.clear();
+                emit(TokenType::Identifier, Symbol(std::string_view(source.data() + token_start, i - token_start)).id(), token_start, i - token_start);
                 state = LexerState::Default;
                 i--;
             }
@@ -1110,44 +1617,25 @@ jcc::TokenList jcc::CompilationUnit::lex(const std::string &source)
             break;
         case LexerState::Whitespace:
 
-            if (std::isspace(current_char))
+            if (!std::isspace(current_char))
             {
-                current_token += current_char;
-            }
-            else
-            {
-                result.push_back(Token(TokenType::Whitespace, current_token));
-                current_token.clear();
+                emit(TokenType::Whitespace, 0, token_start, i - token_start);
                 state = LexerState::Default;
                 continue;
             }
-
-            // handle newlines
-            if (current_char == '\n')
-            {
-                line++;
-                column = 0;
-                break;
-            }
-
             break;
         case LexerState::Raw:
             if (current_char == '`')
             {
                 if (modifier == LexerStateModifier::StringEscape)
                 {
-                    result.push_back(Token(TokenType::Raw, current_token));
-                    current_token.clear();
+                    emit(TokenType::Raw, 0, token_start, i - token_start);
                     state = LexerState::Default;
                     modifier = LexerStateModifier::None;
                     break;
                 }
                 modifier = LexerStateModifier::StringEscape;
             }
-            else
-            {
-                current_token += current_char;
-            }
             break;
 
         default:
@@ -1156,7 +1644,21 @@ jcc::TokenList jcc::CompilationUnit::lex(const std::string &source)
         }
 
         i++;
-        column++;
+    }
+
+    // A chunk ends right before a non-space character, so its trailing
+    // whitespace run is complete. Trailing whitespace of the source is dropped.
+    if (!m_has_lexeme && state == LexerState::Whitespace && m_end < source.length())
+    {
+        emit(TokenType::Whitespace, 0, token_start, i - token_start);
+        state = LexerState::Default;
+    }
+
+    if (m_has_lexeme)
+    {
+        m_has_lexeme = false;
+        out = m_lexeme;
+        return true;
     }
 
     if (state != LexerState::Default)
@@ -1166,30 +1668,27 @@ jcc::TokenList jcc::CompilationUnit::lex(const std::string &source)
         case LexerState::StringLiteral:
             if (modifier == LexerStateModifier::StringSingleQuote || modifier == LexerStateModifier::StringSingleQuoteEscape)
             {
-                throw LexerExceptionInvalidLiteral("String literal not terminated. Expected \"'\" at line " + std::to_string(line) + ", column " + std::to_string(column));
+                throw LexerExceptionInvalidLiteral("String literal not terminated. Expected \"'\" at " + where(i));
             }
             else
             {
-                throw LexerExceptionInvalidLiteral("String literal not terminated. Expected '\"' at line " + std::to_string(line) + ", column " + std::to_string(column));
+                throw LexerExceptionInvalidLiteral("String literal not terminated. Expected '\"' at " + where(i));
             }
             break;
-        case LexerState::NumberLiteral:
-            throw LexerExceptionInvalidLiteral("Number literal not valid at line " + std::to_string(line) + ", column " + std::to_string(column));
-            break;
         case LexerState::SingleLineComment:
-            throw LexerExceptionInvalid("Single line comment not valid at line " + std::to_string(line) + ", column " + std::to_string(column));
+            throw LexerExceptionInvalid("Single line comment not valid at " + where(i));
             break;
         case LexerState::MultiLineComment:
-            throw LexerExceptionInvalid("Multi line comment not terminated. Expected '*/' at line " + std::to_string(line) + ", column " + std::to_string(column));
+            throw LexerExceptionInvalid("Multi line comment not terminated. Expected '*/' at " + where(i));
             break;
         case LexerState::Identifier:
-            throw LexerExceptionInvalidIdentifier("Invalid identifier \"" + current_token + "\" at line " + std::to_string(line) + ", column " + std::to_string(column));
+            throw LexerExceptionInvalidIdentifier("Invalid identifier \"" + source.substr(token_start) + "\" at " + where(i));
             break;
         case LexerState::Operator:
-            throw LexerExceptionInvalidOperator("Invalid operator \"" + current_token + "\" at line " + std::to_string(line) + ", column " + std::to_string(column));
+            throw LexerExceptionInvalidOperator("Invalid operator \"" + source.substr(token_start) + "\" at " + where(i));
             break;
         case LexerState::Punctuator:
-            throw LexerExceptionInvalidPunctuator("Invalid punctuator \"" + current_token + "\" at line " + std::to_string(line) + ", column " + std::to_string(column));
+            throw LexerExceptionInvalidPunctuator("Invalid punctuator \"" + source.substr(token_start) + "\" at " + where(i));
             break;
 
         default:
@@ -1197,7 +1696,294 @@ jcc::TokenList jcc::CompilationUnit::lex(const std::string &source)
         }
     }
 
+    return false;
+}
+
+jcc::TokenList jcc::CompilationUnit::lex(const std::string &source, LexMode mode, size_t threads)
+{
+    return lex(std::make_shared<const std::string>(source), mode, threads);
+}
+
+/// @brief Sources smaller than this per available thread are lexed sequentially
+constexpr size_t lexParallelMinChunk = 1 << 20;
+
+/// @brief Find the first chunk boundary at or after a byte offset
+/// @param source The source buffer
+/// @param from Offset of the previous boundary; lexing state is Default there
+/// @param target Offset to search from
+/// @return Offset of a byte that starts a line with a non-space character in
+/// the Default lexer state, or the end of the source if there is none
+/// @note Only tracks what can span or hide a newline: string literals, raw
+/// blocks and comments. This mirrors the lexer's state machine for those.
+static size_t lex_find_chunk_boundary(const std::string &source, size_t from, size_t target)
+{
+    enum class ScanState
+    {
+        Default,
+        String,
+        Raw,
+        SingleLineComment,
+        MultiLineComment,
+    };
+
+    ScanState state = ScanState::Default;
+    char quote = 0;
+
+    for (size_t i = from; i < source.size(); i++)
+    {
+        char c = source[i];
+        switch (state)
+        {
+        case ScanState::Default:
+            if (c == '\n' && i >= target && i + 1 < source.size() && !std::isspace(source[i + 1]))
+            {
+                return i + 1;
+            }
+            if (c == '"' || c == '\'')
+            {
+                state = ScanState::String;
+                quote = c;
+            }
+            else if (c == '`')
+            {
+                state = ScanState::Raw;
+            }
+            else if (c == '/' && i + 1 < source.size() && source[i + 1] == '/')
+            {
+                state = ScanState::SingleLineComment;
+                i++;
+            }
+            else if (c == '/' && i + 1 < source.size() && source[i + 1] == '*')
+            {
+                state = ScanState::MultiLineComment;
+                i++;
+            }
+            break;
+        case ScanState::String:
+            if (c == '\\')
+            {
+                i++;
+            }
+            else if (c == quote || c == '\n')
+            {
+                state = ScanState::Default;
+            }
+            break;
+        case ScanState::Raw:
+            if (c == '`')
+            {
+                state = ScanState::Default;
+            }
+            break;
+        case ScanState::SingleLineComment:
+            if (c == '\n')
+            {
+                // reconsider the newline as a boundary
+                state = ScanState::Default;
+                i--;
+            }
+            break;
+        case ScanState::MultiLineComment:
+            if (c == '*' && i + 1 < source.size() && source[i + 1] == '/')
+            {
+                state = ScanState::Default;
+                i++;
+            }
+            break;
+        }
+    }
+
+    return source.size();
+}
+
+/// @brief Tokens of one chunk of a source lexed on its own thread
+struct LexChunk
+{
+    size_t begin;
+    size_t end;
+    std::vector<jcc::Lexer::Lexeme> lexemes;
+    std::deque<std::string> decoded;
+    std::exception_ptr error;
+};
+
+/// @brief Lex the source code into a list of tokens
+/// @param buffer JXX source code raw string. The returned list keeps it alive.
+/// @param mode Whether to keep whitespace and comment tokens
+/// @param threads Number of threads, or 0 for one per `lexParallelMinChunk`
+/// bytes of source, up to the number of cores
+/// @return A vector of tokens
+/// @note This is probably the most complex I have ever written. So expect bugs.
+/// @note Large sources are split into chunks at line starts and lexed in
+/// parallel. The result is identical to lexing sequentially, including which
+/// error is reported first.
+jcc::TokenList jcc::CompilationUnit::lex(std::shared_ptr<const std::string> buffer, LexMode mode, size_t threads)
+{
+    TokenList result;
+    result.pin_source(buffer);
+    result.reserve((float)buffer->length() / 10);
+
+    if (threads == 0)
+    {
+        threads = std::min<size_t>(std::thread::hardware_concurrency(), buffer->size() / lexParallelMinChunk);
+    }
+
+    if (threads < 2)
+    {
+        Lexer lexer(buffer, mode);
+        Lexer::Lexeme lexeme;
+
+        while (lexer.next(lexeme))
+        {
+            uint32_t payload = lexeme.payload;
+            if (lexeme.is_decoded())
+            {
+                payload = result.materialize(std::move(lexer.decoded()));
+            }
+
+            result.push_back(lexeme.type, payload, lexeme.offset, lexeme.length);
+        }
+
+        result.done();
+
+        return result;
+    }
+
+    std::vector<LexChunk> chunks;
+    size_t begin = 0;
+    while (begin < buffer->size())
+    {
+        size_t target = begin + buffer->size() / threads;
+        size_t end = lex_find_chunk_boundary(*buffer, begin, target);
+        chunks.push_back({begin, end, {}, {}, nullptr});
+        begin = end;
+    }
+
+    std::vector<std::thread> workers;
+    for (auto &chunk : chunks)
+    {
+        workers.emplace_back([&buffer, &chunk, mode]()
+                             {
+            try
+            {
+                Lexer lexer(buffer, mode, chunk.begin, chunk.end);
+                Lexer::Lexeme lexeme;
+
+                chunk.lexemes.reserve((chunk.end - chunk.begin) / 10);
+                while (lexer.next(lexeme))
+                {
+                    if (lexeme.is_decoded())
+                    {
+                        chunk.decoded.push_back(std::move(lexer.decoded()));
+                        lexeme.payload = chunk.decoded.size();
+                    }
+                    chunk.lexemes.push_back(lexeme);
+                }
+            }
+            catch (...)
+            {
+                chunk.error = std::current_exception();
+            } });
+    }
+
+    for (auto &worker : workers)
+    {
+        worker.join();
+    }
+
+    // stitch the chunks together in source order
+    for (auto &chunk : chunks)
+    {
+        if (chunk.error)
+        {
+            std::rethrow_exception(chunk.error);
+        }
+
+        for (const auto &lexeme : chunk.lexemes)
+        {
+            uint32_t payload = lexeme.payload;
+            if (lexeme.is_decoded())
+            {
+                payload = result.materialize(std::move(chunk.decoded[payload - 1]));
+            }
+
+            result.push_back(lexeme.type, payload, lexeme.offset, lexeme.length);
+        }
+    }
+
     result.done();
 
     return result;
-}
\ No newline at end of file
+}
+
+///=============================================================================
+/// jcc::TokenCursor class implementation
+///=============================================================================
+
+jcc::TokenCursor::TokenCursor(const TokenList &tokens) : m_list(&tokens)
+{
+    init();
+}
+
+jcc::TokenCursor::TokenCursor(std::shared_ptr<const TokenList> tokens) : m_list(tokens.get()), m_owner(std::move(tokens))
+{
+    init();
+}
+
+void jcc::TokenCursor::init()
+{
+    m_index = nullptr;
+    m_first = m_list->m_pos;
+    m_count = m_list->m_types.size() - m_first;
+    m_pos = 0;
+    m_end_offset = static_cast<uint32_t>(source().size());
+
+    auto is_trivia = [](TokenType type)
+    {
+        return type == TokenType::Whitespace || type == TokenType::SingleLineComment || type == TokenType::MultiLineComment;
+    };
+
+    auto begin = m_list->m_types.begin() + m_first;
+    if (std::none_of(begin, m_list->m_types.end(), is_trivia))
+    {
+        return;
+    }
+
+    m_index_array.reserve(m_count);
+    for (size_t i = m_first; i < m_list->m_types.size(); i++)
+    {
+        if (!is_trivia(m_list->m_types[i]))
+        {
+            m_index_array.push_back(static_cast<uint32_t>(i));
+        }
+    }
+
+    m_index = m_index_array.data();
+    m_count = m_index_array.size();
+}
+
+jcc::TokenCursor::TokenCursor(const TokenCursor &parent, size_t begin, size_t end)
+    : m_list(parent.m_list), m_index(parent.m_index != nullptr ? parent.m_index + begin : nullptr), m_first(parent.m_first + begin), m_count(end - begin), m_pos(0)
+{
+    // past its range the view reports the location of the token that follows it
+    m_end_offset = end < parent.m_count ? parent.m_list->m_offsets[parent.entry(end)] : parent.m_end_offset;
+}
+
+size_t jcc::TokenCursor::find(uint32_t offset) const
+{
+    size_t low = 0, high = m_count;
+
+    while (low < high)
+    {
+        size_t mid = low + (high - low) / 2;
+        if (m_list->m_offsets[entry(mid)] < offset)
+        {
+            low = mid + 1;
+        }
+        else
+        {
+            high = mid;
+        }
+    }
+
+    return low;
+}
@@ -5,6 +5,12 @@
 #include <vector>
 #include <iostream>
 #include <memory>
+#include <thread>
+#include <exception>
+#include <algorithm>
+#include <charconv>
+#include <functional>
+#include <unordered_map>
 
 ///=============================================================================
 /// Common
@@ -19,636 +25,322 @@ namespace jcc
         DeclarationOrDefinition,
     };
 
-    struct ExpNode
-    {
-        jcc::Token value;
-        std::vector<ExpNode> children;
-        ExpNode() = default;
-        ExpNode(const jcc::Token &value, const std::vector<ExpNode> &children) : value(value), children(children) {}
-
-        std::string print_tree(const ExpNode node, const std::string prefix, bool is_tail, std::string str) const
-        {
-            str += prefix + (is_tail ? "└── " : "├── ");
-            switch (node.value.type())
-            {
-            case jcc::TokenType::Identifier:
-                str += std::get<std::string>(value.value());
-                break;
-            case jcc::TokenType::Operator:
-                str += jcc::lexOperatorMapReverse.at(std::get<jcc::Operator>(value.value()));
-                break;
-            case jcc::TokenType::NumberLiteral:
-                str += std::get<std::string>(value.value());
-                break;
-            case jcc::TokenType::StringLiteral:
-                str += std::get<std::string>(value.value());
-                break;
-            case jcc::TokenType::Keyword:
-                str += lexKeywordMapReverse.at(std::get<jcc::Keyword>(value.value()));
-                break;
-            case jcc::TokenType::Punctuator:
-                str += jcc::lexPunctuatorMapReverse.at(std::get<jcc::Punctuator>(value.value()));
-                break;
-            case jcc::TokenType::FloatingPointLiteral:
-                str += std::get<std::string>(value.value());
-                break;
-            default:
-                str += "Unknown";
-                break;
-            }
-            str += "\n";
-            for (size_t i = 0; i < node.children.size(); i++)
-            {
-                str = print_tree(node.children[i], prefix + (is_tail ? "    " : "│   "), i == node.children.size() - 1, str);
-            }
-            return str;
-        }
-
-        std::string to_string() const
-        {
-            // std::string str = "Node(";
-            // switch (value.type())
-            // {
-            // case jcc::TokenType::Identifier:
-            //     str += std::get<std::string>(value.value());
-            //     break;
-            // case jcc::TokenType::Operator:
-            //     str += jcc::lexOperatorMapReverse.at(std::get<jcc::Operator>(value.value()));
-            //     break;
-            // case jcc::TokenType::NumberLiteral:
-            //     str += std::to_string(std::get<uint64_t>(value.value()));
-            //     break;
-            // case jcc::TokenType::StringLiteral:
-            //     str += std::get<std::string>(value.value());
-            //     break;
-            // case jcc::TokenType::Keyword:
-            //     str += std::get<std::string>(value.value());
-            //     break;
-            // case jcc::TokenType::Punctuator:
-            //     str += jcc::lexPunctuatorMapReverse.at(std::get<jcc::Punctuator>(value.value()));
-            //     break;
-            // default:
-            //     break;
-            // }
-            // str += ", [";
-            // for (const auto &child : children)
-            // {
-            //     str += child.to_string() + ", ";
-            // }
-
-            // if (children.size() > 0)
-            // {
-            //     str.pop_back();
-            //     str.pop_back();
-            // }
-
-            // str += "])";
-
-            // return str;
-
-            return print_tree(*this, "", true, "");
-        }
-    };
-
-}
-
-static bool is_builtin_type(const std::string &type)
-{
-    // integers and floating point numbers
-    if (type == "bool" || type == "byte" || type == "char" || type == "word" || type == "short" || type == "dword" || type == "int" || type == "qword" || type == "long" || type == "float" || type == "double" || type == "intn" || type == "uintn" || type == "address" || type == "routine")
-    {
-        return true;
-    }
-
-    if (type == "void" || type == "null")
-    {
-        return true;
-    }
-
-    // complex types
-    if (type == "bigfloat" || type == "bigint" || type == "biguint" || type == "arbint" || type == "arbuint" || type == "real" || type == "complex" || type == "string" || type == "map" || type == "tensor")
-    {
-        return true;
-    }
-
-    return false;
 }
 
-///=============================================================================
-/// GenericNode
-///=============================================================================
-
-std::string jcc::GenericNode::json_escape(const std::string &str) const
+static constexpr jcc::EnumTable<jcc::Keyword, bool, jcc::lexKeywordCount> build_builtin_type_table()
 {
-    std::string escaped;
-    escaped.reserve(str.size());
-    for (auto &c : str)
-    {
-        switch (c)
-        {
-        case '"':
-            escaped += "\\\"";
-            break;
-        case '\\':
-            escaped += "\\\\";
-            break;
-        case '\b':
-            escaped += "\\b";
-            break;
-        case '\f':
-            escaped += "\\f";
-            break;
-        case '\n':
-            escaped += "\\n";
-            break;
-        case '\r':
-            escaped += "\\r";
-            break;
-        case '\t':
-            escaped += "\\t";
-            break;
-        default:
-            escaped += c;
-            break;
-        }
-    }
-    return escaped;
-}
+    using jcc::Keyword;
 
-///=============================================================================
-/// Block
-///=============================================================================
-
-std::string jcc::Block::to_string() const
-{
-    std::string str = "Block([";
-    for (auto &child : m_children)
-    {
-        str += child->to_string() + ", ";
-    }
+    constexpr Keyword builtins[] = {
+        // integers and floating point numbers
+        Keyword::Bool, Keyword::Byte, Keyword::Char, Keyword::Word, Keyword::Short, Keyword::Dword, Keyword::Int, Keyword::Qword, Keyword::Long, Keyword::Float, Keyword::Double, Keyword::Intn, Keyword::Uintn, Keyword::Address, Keyword::Routine,
 
-    if (m_children.size() > 0)
-    {
-        str.pop_back();
-        str.pop_back();
-    }
+        Keyword::Void, Keyword::Null,
 
-    str += "])";
-    return str;
-}
+        // complex types
+        Keyword::Bigfloat, Keyword::Bigint, Keyword::Biguint, Keyword::Arbint, Keyword::Arbuint, Keyword::Real, Keyword::Complex, Keyword::String, Keyword::Map, Keyword::Tensor};
 
-std::string jcc::Block::to_json() const
-{
-    std::string str = "{\"type\":\"block\",\"children\":[";
-    for (auto &child : m_children)
-    {
-        str += child->to_json() + ",";
-    }
-    if (m_children.size() > 0)
+    jcc::EnumTable<Keyword, bool, jcc::lexKeywordCount> table{};
+    for (auto kw : builtins)
     {
-        str.pop_back();
+        table.m_values[static_cast<size_t>(kw)] = true;
     }
-    str += "]}";
-    return str;
-}
-
-///=============================================================================
-/// StructDeclaration
-///=============================================================================
-
-std::string jcc::StructDeclaration::to_string() const
-{
-    std::string str = "StructDeclaration(" + m_name + ")";
-    return str;
-}
-
-std::string jcc::StructDeclaration::to_json() const
-{
-    std::string str = "{\"type\":\"struct_declaration\",\"name\":\"" + json_escape(m_name) + "\"}";
-    return str;
-}
-
-///=============================================================================
-/// UnionDeclaration
-///=============================================================================
-
-std::string jcc::UnionDeclaration::to_string() const
-{
-    std::string str = "UnionDeclaration(" + m_name + ")";
-    return str;
-}
-
-std::string jcc::UnionDeclaration::to_json() const
-{
-    std::string str = "{\"type\":\"union_declaration\",\"name\":\"" + json_escape(m_name) + "\"}";
-    return str;
-}
-
-///=============================================================================
-/// EnumDeclaration
-///=============================================================================
-
-std::string jcc::EnumDeclaration::to_string() const
-{
-    std::string str = "EnumDeclaration(" + m_name + ")";
-    return str;
+    return table;
 }
 
-std::string jcc::EnumDeclaration::to_json() const
-{
-    std::string str = "{\"type\":\"enum_declaration\",\"name\":\"" + json_escape(m_name) + "\"}";
-    return str;
-}
-
-///=============================================================================
-/// FunctionParameter
-///=============================================================================
+static constexpr jcc::EnumTable<jcc::Keyword, bool, jcc::lexKeywordCount> builtinTypeTable = build_builtin_type_table();
 
-std::string jcc::FunctionParameter::to_string() const
+static constexpr bool is_builtin_type(jcc::Keyword type)
 {
-    std::string str = "FunctionParameter(" + m_name + ", " + m_type + ")";
-    return str;
+    return builtinTypeTable.at(type);
 }
 
-std::string jcc::FunctionParameter::to_json() const
+static constexpr jcc::EnumTable<jcc::Keyword, bool, jcc::lexKeywordCount> build_statement_keyword_table()
 {
-    std::string str = "{\"type\":\"function_parameter\",\"name\":\"" + json_escape(m_name) + "\",\"dtype\":\"" + json_escape(m_type) + "\"}";
-    return str;
-}
-
-///=============================================================================
-/// FunctionDeclaration
-///=============================================================================
+    using jcc::Keyword;
 
-std::string jcc::FunctionDeclaration::to_string() const
-{
-    std::string str = "FunctionDeclaration(" + m_name + ", " + m_return_type + ", [";
-    for (auto &parameter : m_parameters)
-    {
-        str += parameter->to_string() + ", ";
-    }
+    // keywords that can only begin a statement; error recovery resumes at them
+    constexpr Keyword keywords[] = {
+        Keyword::Subsystem, Keyword::Import, Keyword::Export, Keyword::Extern, Keyword::Let, Keyword::Var, Keyword::Struct, Keyword::Region, Keyword::Union, Keyword::Func, Keyword::Typedef, Keyword::Volatile, Keyword::Class, Keyword::Enum, Keyword::Return};
 
-    if (m_parameters.size() > 0)
+    jcc::EnumTable<Keyword, bool, jcc::lexKeywordCount> table{};
+    for (auto kw : keywords)
     {
-        str.pop_back();
-        str.pop_back();
+        table.m_values[static_cast<size_t>(kw)] = true;
     }
-
-    str += "])";
-    return str;
+    return table;
 }
 
-std::string jcc::FunctionDeclaration::to_json() const
-{
-    std::string str = "{\"type\":\"function_declaration\",\"name\":\"" + json_escape(m_name) + "\",\"return_type\":\"" + json_escape(m_return_type) + "\",\"parameters\":[";
-    for (auto &parameter : m_parameters)
-    {
-        str += parameter->to_json() + ",";
-    }
-    if (m_parameters.size() > 0)
-    {
-        str.pop_back();
-    }
-    str += "]}";
-    return str;
-}
+static constexpr jcc::EnumTable<jcc::Keyword, bool, jcc::lexKeywordCount> statementKeywordTable = build_statement_keyword_table();
 
 ///=============================================================================
-/// ClassDeclaration
+/// Parser
 ///=============================================================================
 
-std::string jcc::ClassDeclaration::to_string() const
-{
-    std::string str = "ClassDeclaration(" + m_name + ")";
-    return str;
-}
-
-std::string jcc::ClassDeclaration::to_json() const
-{
-    std::string str = "{\"type\":\"class_declaration\",\"name\":\"" + json_escape(m_name) + "\"}";
-    return str;
-}
-
-std::string std::to_string(const std::shared_ptr<jcc::GenericNode> value)
+namespace jcc
 {
-    if (value == nullptr)
-        return "{}";
-
-    return value->to_json();
-}
+    /// @brief The state of one parse, passed to every parse function
+    /// @note Nodes are made in the arena (see `make_node`) for as long as the
+    /// context exists.
+    struct ParseContext
+    {
+        /// @brief Construct a new ParseContext object
+        /// @param tokens Token cursor to consume
+        /// @param arena Arena that receives the nodes
+        /// @param diagnostics Receives the syntax errors
+        /// @param skim Whether to skip function and method bodies
+        /// @param max_nesting How deeply subsystems and expressions may nest
+        ParseContext(TokenCursor &tokens, AstArena &arena, std::vector<ParserDiagnostic> &diagnostics, bool skim, size_t max_nesting)
+            : tokens(tokens), diagnostics(diagnostics), panicking(false), skim(skim), max_nesting(max_nesting), depth(0), m_scope(arena) {}
 
-///=============================================================================
-/// SubsystemDefinition
-///=============================================================================
+        ParseContext(const ParseContext &) = delete;
+        ParseContext &operator=(const ParseContext &) = delete;
 
-std::string jcc::SubsystemDefinition::to_string() const
-{
-    std::string str = "SubsystemDefinition(" + m_name + ", {" + m_block->to_string() + "})";
-    return str;
-}
+        TokenCursor &tokens;
+        std::vector<ParserDiagnostic> &diagnostics;
 
-std::string jcc::SubsystemDefinition::to_json() const
-{
-    std::string str = "{\"type\":\"subsystem_definition\",\"name\":\"" + json_escape(m_name) + "\",\"block\":" + m_block->to_json() + "}";
-    return str;
-}
+        /// @brief Set by the first error of a malformed construct and cleared once the
+        /// parser has resynchronized, so the errors cascading from it are not reported
+        bool panicking;
 
-///=============================================================================
-/// StructField
-///=============================================================================
+        /// @brief Set while skimming: function and method bodies are skipped, not parsed
+        bool skim;
 
-std::string jcc::StructField::to_json() const
-{
-    std::string str = "{\"type\":\"struct_field\",\"name\":\"" + json_escape(m_name) + "\",\"dtype\":\"" + json_escape(m_type) + "\",\"default_value\":\"" + json_escape(m_default_value) + "\",\"bitfield\":" + std::to_string(m_bitfield) + ",\"arr_size\":";
-    if (!m_arr_size)
-    {
-        str += "\"dynamic\"";
-    }
-    else
-    {
-        str += std::to_string(m_arr_size);
-    }
-    str += ",\"attributes\":[";
-    for (auto &attribute : m_attributes)
-    {
-        str += attribute->to_json();
+        /// @brief How deeply subsystems and expressions may nest
+        size_t max_nesting;
 
-        if (attribute != m_attributes.back())
-        {
-            str += ",";
-        }
-    }
+        /// @brief How many expressions are being parsed inside one another
+        size_t depth;
 
-    str += "]}";
+    private:
+        AstArena::Scope m_scope;
+    };
 
-    return str;
+    static bool parse_union_keyword(jcc::ParseContext &ctx, jcc::GenericNode *&node, bool packed);
+    static bool parse_struct_keyword(jcc::ParseContext &ctx, jcc::GenericNode *&node, bool packed);
+    static bool parse_class_keyword(jcc::ParseContext &ctx, jcc::GenericNode *&node);
+    static bool parse_enum_keyword(jcc::ParseContext &ctx, jcc::GenericNode *&node);
+    static bool parse_typedef_keyword(jcc::ParseContext &ctx, jcc::GenericNode *&node);
+    static bool parse_namespace_keyword(jcc::ParseContext &ctx, jcc::GenericNode *&node);
+    struct OpenSubsystem;
+    static bool parse_subsystem_keyword(jcc::ParseContext &ctx, jcc::GenericNode *&node, OpenSubsystem &body);
+    static bool parse_function_parameters(jcc::ParseContext &ctx, jcc::NodeList<jcc::FunctionParameter> &params);
+    static bool parse_func_keyword(jcc::ParseContext &ctx, jcc::GenericNode *&node, jcc::FunctionParseMode mode);
+    static bool parse_return_keyword(jcc::ParseContext &ctx, jcc::GenericNode *&node);
+    static bool parse_block(jcc::ParseContext &ctx, jcc::GenericNode *&node, bool functional);
+    static bool parse_expression(jcc::ParseContext &ctx, jcc::GenericNode *&node);
+    static bool parse_expression_operand(jcc::ParseContext &ctx, jcc::Expression *&node, size_t &height);
+    static bool parse_expression_prec(jcc::ParseContext &ctx, uint8_t min_prec, jcc::Expression *&node, size_t &height);
+    static bool parse_expression_climb(jcc::ParseContext &ctx, uint8_t min_prec, jcc::Expression *&node, size_t &height);
+    static bool expression_too_deep(jcc::ParseContext &ctx);
+    static bool parse_structural_block(jcc::ParseContext &ctx, jcc::GenericNode *&node, bool top_level = false);
+    static bool parse_functional_block(jcc::ParseContext &ctx, jcc::GenericNode *&node);
+    static bool parse_var_keyword(jcc::ParseContext &ctx, jcc::GenericNode *&node);
+    static bool parse_let_keyword(jcc::ParseContext &ctx, jcc::GenericNode *&node);
+    static bool parse_export_keyword(jcc::ParseContext &ctx, jcc::GenericNode *&node);
+    static bool parse_import_keyword(jcc::ParseContext &ctx, jcc::GenericNode *&node);
+    static bool parse_extern_keyword(jcc::ParseContext &ctx, jcc::GenericNode *&node);
+    static bool parse_volatile_keyword(jcc::ParseContext &ctx, jcc::GenericNode *&node);
+    static bool parse_type(jcc::ParseContext &ctx, bool allow_bitfield, bool allow_arr_size, bool allow_default_value, jcc::TypeNode *&node);
+    static bool parse_struct_member(jcc::ParseContext &ctx, jcc::StructField *&field, jcc::NodeList<jcc::StructField> &fields, jcc::NodeList<jcc::StructMethod> &methods);
+    static bool syntax_error(jcc::ParseContext &ctx, const std::string &message);
+    static bool parse_integer(jcc::ParseContext &ctx, const char *what, uint64_t &value);
+    static void synchronize(jcc::ParseContext &ctx, size_t start);
+    static bool skip_body(jcc::ParseContext &ctx, jcc::SourceRange &range);
 }
 
-///=============================================================================
-/// StructMethod
-///=============================================================================
-
-std::string jcc::StructMethod::to_json() const
+namespace jcc
 {
-    std::string str = "{\"type\":\"struct_member\",\"name\":\"" + json_escape(m_name) + "\",\"return_type\":\"" + json_escape(m_type) + "\",\"parameters\":[";
-    for (auto &parameter : m_parameters)
-    {
-        str += parameter->to_json() + ",";
-    }
-    if (m_parameters.size() > 0)
+    /// @brief A subsystem definition whose body is being parsed
+    struct OpenSubsystem
     {
-        str.pop_back();
-    }
-    str += "],\"block\":" + m_block->to_json() + "}";
-    return str;
+        bool defined = false;
+        std::string name;
+        std::vector<std::string> dependencies;
+        Block *block = nullptr;
+        /// @brief Mark where the subsystem statement began
+        size_t statement = 0;
+    };
 }
 
-///=============================================================================
-/// StructDefinition
-///=============================================================================
-
-std::string jcc::StructDefinition::to_string() const
+/// @brief Report a syntax error at the current token
+/// @param tokens Token cursor
+/// @param message Error message
+/// @return false, so a parse function can `return syntax_error(...)`
+static bool jcc::syntax_error(jcc::ParseContext &ctx, const std::string &message)
 {
-    std::string str = "StructDefinition(" + m_name + ", [";
-    for (const auto &child : m_fields)
-    {
-        str += child->to_string() + ", ";
-    }
+    TokenCursor &tokens = ctx.tokens;
 
-    if (m_fields.size() > 0)
+    if (!ctx.panicking)
     {
-        str.pop_back();
-        str.pop_back();
+        ctx.panicking = true;
+        ctx.diagnostics.push_back({tokens.location(), message});
     }
 
-    str += "])";
-
-    return str;
-}
-
-std::string jcc::StructDefinition::to_json() const
-{
-    std::string str = "{\"type\":\"struct_definition\",\"name\":\"" + json_escape(m_name) + "\",\"fields\":[";
-    for (const auto &child : m_fields)
-    {
-        str += child->to_json() + ",";
-    }
-    if (m_fields.size() > 0)
-    {
-        str.pop_back();
-    }
-    str += "]}";
-    return str;
+    return false;
 }
 
-///=============================================================================
-/// UnionDefinition
-///=============================================================================
-
-std::string jcc::UnionDefinition::to_json() const
+/// @brief Read the value of the integer literal at the current token
+/// @param tokens Token cursor at a number literal, which is not consumed
+/// @param what What the literal gives, for the error message
+/// @param value Receives the value
+/// @return false after reporting a syntax error if the literal is not an
+/// integer that fits in 64 bits
+static bool jcc::parse_integer(jcc::ParseContext &ctx, const char *what, uint64_t &value)
 {
-    std::string str = "{\"type\":\"union_definition\",\"name\":\"" + json_escape(m_name) + "\",\"fields\":[";
-    for (const auto &child : m_fields)
-    {
-        str += child->to_json() + ",";
-    }
-    if (m_fields.size() > 0)
-    {
-        str.pop_back();
-    }
-    str += "]}";
-    return str;
-}
+    TokenCursor &tokens = ctx.tokens;
 
-///=============================================================================
-/// FunctionDefinition
-///=============================================================================
-
-std::string jcc::FunctionDefinition::to_string() const
-{
-    std::string str = "FunctionDefinition(" + m_name + ", " + m_return_type + ", [";
-    for (auto &parameter : m_parameters)
-    {
-        str += parameter->to_string() + ", ";
-    }
+    std::string_view text = tokens.peek().text();
+    std::from_chars_result result = std::from_chars(text.data(), text.data() + text.size(), value);
 
-    if (m_parameters.size() > 0)
+    if (result.ec != std::errc() || result.ptr != text.data() + text.size())
     {
-        str.pop_back();
-        str.pop_back();
+        return syntax_error(ctx, std::string("Expected an integer ") + what + " that fits in 64 bits: " + std::string(text));
     }
 
-    str += "], {" + m_block->to_string() + "})";
-    return str;
+    return true;
 }
 
-std::string jcc::FunctionDefinition::to_json() const
+/// @brief Panic-mode recovery: skip the rest of a malformed statement or field
+/// @param tokens Token cursor, somewhere inside the malformed construct
+/// @param start Mark taken where the construct began
+/// @note Stops after a `;` or a `{...}` body closing at the construct's own
+/// level, or before a `}` closing the enclosing block or a keyword that begins
+/// a statement. At least one token is consumed, so the caller always makes progress.
+static void jcc::synchronize(jcc::ParseContext &ctx, size_t start)
 {
-    std::string str = "{\"type\":\"function_definition\",\"name\":\"" + json_escape(m_name) + "\",\"return_type\":\"" + json_escape(m_return_type) + "\",\"parameters\":[";
-    for (auto &parameter : m_parameters)
-    {
-        str += parameter->to_json() + ",";
-    }
-    if (m_parameters.size() > 0)
-    {
-        str.pop_back();
-    }
-    str += "],\"block\":" + m_block->to_json() + "}";
-    return str;
-}
+    TokenCursor &tokens = ctx.tokens;
 
-///=============================================================================
-/// CallExpression
-///=============================================================================
+    bool progressed = tokens.mark() != start;
+    size_t depth = 0;
 
-std::string jcc::CallExpression::to_string() const
-{
-    std::string str = "CallExpression(" + m_name + ", [";
-    for (auto &child : m_arguments)
-    {
-        str += child->to_string() + ", ";
-    }
+    ctx.panicking = false;
 
-    if (m_arguments.size() > 0)
+    while (!tokens.eof())
     {
-        str.pop_back();
-        str.pop_back();
-    }
+        Token tok = tokens.peek();
 
-    str += "])";
-    return str;
-}
+        if (tok.type() == TokenType::Punctuator)
+        {
+            switch (tok.punctuator())
+            {
+            case Punctuator::OpenBrace:
+                depth++;
+                break;
+            case Punctuator::CloseBrace:
+                if (depth == 0 && progressed)
+                {
+                    return;
+                }
+                if (depth != 0 && --depth == 0)
+                {
+                    tokens.pop();
+                    return;
+                }
+                break;
+            case Punctuator::Semicolon:
+                if (depth == 0)
+                {
+                    tokens.pop();
+                    return;
+                }
+                break;
+            default:
+                break;
+            }
+        }
+        else if (tok.type() == TokenType::Keyword && depth == 0 && progressed && statementKeywordTable.at(tok.keyword()))
+        {
+            return;
+        }
 
-std::string jcc::CallExpression::to_json() const
-{
-    std::string str = "{\"type\":\"call_expression\",\"name\":\"" + json_escape(m_name) + "\",\"arguments\":[";
-    for (auto &child : m_arguments)
-    {
-        str += child->to_json() + ",";
-    }
-    if (m_arguments.size() > 0)
-    {
-        str.pop_back();
+        tokens.pop();
+        progressed = true;
     }
-    str += "]}";
-    return str;
 }
 
-std::string jcc::TypeNode::to_json() const
+/// @brief Skip a `{...}` body by brace counting, without building any node
+/// @param tokens Token cursor at the opening brace
+/// @param range Receives the byte range of the body, braces included
+/// @return true if the closing brace was found
+static bool jcc::skip_body(jcc::ParseContext &ctx, jcc::SourceRange &range)
 {
-    std::string str = "{\"type\":\"type_node\",\"name\":\"" + json_escape(m_name) + "\",\"is_const\":" + std::to_string(m_is_const) + ",\"is_ref\":" + std::to_string(m_is_reference) + ",";
-    if (m_arr_size == std::numeric_limits<size_t>::max())
-    {
-        str += "\"arr_size\":\"dynamic\"";
-    }
-    else
-    {
-        str += "\"arr_size\":" + std::to_string(m_arr_size);
-    }
-    str += ",\"bitfield\":" + std::to_string(m_bitfield);
+    TokenCursor &tokens = ctx.tokens;
+
+    Token open = tokens.peek();
 
-    if (m_default_value)
+    if (open.type() != TokenType::Punctuator || open.punctuator() != Punctuator::OpenBrace)
     {
-        str += ",\"default_value\":" + m_default_value->to_json();
+        return syntax_error(ctx, "Expected opening brace for block");
     }
-    str += "}";
-    return str;
-}
-
-///=============================================================================
-/// LetDeclaration
-///=============================================================================
 
-std::string jcc::LetDeclaration::to_json() const
-{
-    std::string str = "{\"type\":\"let_declaration\",\"name\":\"" + json_escape(m_name) + "\",\"dtype\":" + m_type->to_json() + "}";
+    range.begin = tokens.offset();
+    size_t depth = 0;
 
-    return str;
-}
+    while (!tokens.eof())
+    {
+        Token tok = tokens.peek();
 
-///=============================================================================
-/// VarDeclaration
-///=============================================================================
+        if (tok.type() == TokenType::Punctuator)
+        {
+            if (tok.punctuator() == Punctuator::OpenBrace)
+            {
+                depth++;
+            }
+            else if (tok.punctuator() == Punctuator::CloseBrace && --depth == 0)
+            {
+                range.end = tokens.offset() + 1;
+                tokens.pop();
+                return true;
+            }
+        }
 
-std::string jcc::VarDeclaration::to_json() const
-{
-    std::string str = "{\"type\":\"var_declaration\",\"name\":\"" + json_escape(m_name) + "\",\"dtype\":" + m_type->to_json() + "}";
+        tokens.pop();
+    }
 
-    return str;
+    return syntax_error(ctx, "Expected closing brace for block");
 }
 
-///=============================================================================
-/// Parser
-///=============================================================================
-
-namespace jcc
+bool jcc::parse_type(jcc::ParseContext &ctx, bool allow_bitfield, bool allow_arr_size, bool allow_default_value, jcc::TypeNode *&node)
 {
+    TokenCursor &tokens = ctx.tokens;
 
-    static bool parse_union_keyword(jcc::TokenList &tokens, std::shared_ptr<jcc::GenericNode> &node, bool packed);
-    static bool parse_struct_keyword(jcc::TokenList &tokens, std::shared_ptr<jcc::GenericNode> &node, bool packed);
-    static bool parse_class_keyword(jcc::TokenList &tokens, std::shared_ptr<jcc::GenericNode> &node);
-    static bool parse_enum_keyword(jcc::TokenList &tokens, std::shared_ptr<jcc::GenericNode> &node);
-    static bool parse_typedef_keyword(jcc::TokenList &tokens, std::shared_ptr<jcc::GenericNode> &node);
-    static bool parse_namespace_keyword(jcc::TokenList &tokens, std::shared_ptr<jcc::GenericNode> &node);
-    static bool parse_subsystem_keyword(jcc::TokenList &tokens, std::shared_ptr<jcc::GenericNode> &node);
-    static bool parse_function_parameters(jcc::TokenList &tokens, std::vector<std::shared_ptr<jcc::FunctionParameter>> &params);
-    static bool parse_func_keyword(jcc::TokenList &tokens, std::shared_ptr<jcc::GenericNode> &node, jcc::FunctionParseMode mode);
-    static bool parse_return_keyword(jcc::TokenList &tokens, std::shared_ptr<jcc::GenericNode> &node);
-    static bool parse_block(jcc::TokenList &tokens, std::shared_ptr<jcc::GenericNode> &node, bool functional);
-    static bool parse_expression(jcc::TokenList &tokens, std::shared_ptr<jcc::GenericNode> &node);
-    static bool parse_expression_helper(jcc::TokenList &tokens, jcc::ExpNode &output);
-    static bool parse_structural_block(jcc::TokenList &tokens, std::shared_ptr<jcc::GenericNode> &node);
-    static bool parse_functional_block(jcc::TokenList &tokens, std::shared_ptr<jcc::GenericNode> &node);
-    static bool parse_var_keyword(jcc::TokenList &tokens, std::shared_ptr<jcc::GenericNode> &node);
-    static bool parse_let_keyword(jcc::TokenList &tokens, std::shared_ptr<jcc::GenericNode> &node);
-    static bool parse_export_keyword(jcc::TokenList &tokens, std::shared_ptr<jcc::GenericNode> &node);
-    static bool parse_import_keyword(jcc::TokenList &tokens, std::shared_ptr<jcc::GenericNode> &node);
-    static bool parse_extern_keyword(jcc::TokenList &tokens, std::shared_ptr<jcc::GenericNode> &node);
-    static bool parse_volatile_keyword(jcc::TokenList &tokens, std::shared_ptr<jcc::GenericNode> &node);
-    static bool parse_type(jcc::TokenList &tokens, bool allow_bitfield, bool allow_arr_size, bool allow_default_value, std::shared_ptr<jcc::TypeNode> &node);
-}
-
-bool jcc::parse_type(jcc::TokenList &tokens, bool allow_bitfield, bool allow_arr_size, bool allow_default_value, std::shared_ptr<jcc::TypeNode> &node)
-{
     // [const] [ref] {typename} [[arr_size]|bitfield] [= default_value]
 
     bool is_const = false;
     bool is_ref = false;
     bool is_bitfield = false;
-    std::string type;
-    std::shared_ptr<GenericNode> default_value;
-    size_t arr_size = 0;
-    size_t bitfield = 0;
+    Symbol type;
+    GenericNode *default_value = nullptr;
+    uint64_t arr_size = 0;
+    uint64_t bitfield = 0;
 
     if (tokens.size() < 1)
     {
-        throw SyntaxError("Expected typename");
-        return false;
+        return syntax_error(ctx, "Expected typename");
     }
 
     // check for const
     Token curtok = tokens.peek();
-    if (curtok.type() == TokenType::Keyword && std::get<Keyword>(curtok.value()) == Keyword::Const)
+    if (curtok.type() == TokenType::Keyword && curtok.keyword() == Keyword::Const)
     {
         is_const = true;
         tokens.pop();
         if (tokens.eof())
         {
-            throw SyntaxError("Expected typename");
-            return false;
+            return syntax_error(ctx, "Expected typename");
         }
         curtok = tokens.peek();
     }
 
     // check for ref
-    if (curtok.type() == TokenType::Keyword && std::get<Keyword>(curtok.value()) == Keyword::Ref)
+    if (curtok.type() == TokenType::Keyword && curtok.keyword() == Keyword::Ref)
     {
         is_ref = true;
         tokens.pop();
         if (tokens.eof())
         {
-            throw SyntaxError("Expected typename");
-            return false;
+            return syntax_error(ctx, "Expected typename");
         }
         curtok = tokens.peek();
     }
@@ -656,83 +348,77 @@ bool jcc::parse_type(jcc::TokenList &tokens, bool allow_bitfield, bool allow_arr
     // check for typename
     if (curtok.type() == TokenType::Identifier)
     {
-        type = std::get<std::string>(curtok.value());
+        type = curtok.symbol();
         tokens.pop();
         if (tokens.eof())
         {
-            throw SyntaxError("Expected typename");
-            return false;
+            return syntax_error(ctx, "Expected typename");
         }
         curtok = tokens.peek();
     }
     else if (curtok.type() == TokenType::Keyword)
     {
-        type = lexKeywordMapReverse.at(std::get<Keyword>(curtok.value()));
+        type = lexKeywordMapReverse.at(curtok.keyword());
         tokens.pop();
         if (tokens.eof())
         {
-            throw SyntaxError("Expected typename");
-            return false;
+            return syntax_error(ctx, "Expected typename");
         }
         curtok = tokens.peek();
     }
     else
     {
-        throw SyntaxError("Expected typename");
-        return false;
+        return syntax_error(ctx, "Expected typename");
     }
 
     // check for bitfield
-    if (allow_bitfield && curtok.type() == TokenType::Punctuator && std::get<Punctuator>(curtok.value()) == Punctuator::Colon)
+    if (allow_bitfield && curtok.type() == TokenType::Punctuator && curtok.punctuator() == Punctuator::Colon)
     {
         is_bitfield = true;
         tokens.pop();
         if (tokens.eof())
         {
-            throw SyntaxError("Expected bitfield");
-            return false;
+            return syntax_error(ctx, "Expected bitfield");
         }
         curtok = tokens.peek();
         if (curtok.type() != TokenType::NumberLiteral)
         {
-            throw SyntaxError("Expected bitfield");
+            return syntax_error(ctx, "Expected bitfield");
+        }
+        if (!parse_integer(ctx, "bitfield", bitfield))
+        {
             return false;
         }
-        bitfield = std::stoll(std::get<std::string>(curtok.value()));
         tokens.pop();
         if (tokens.eof())
         {
-            throw SyntaxError("Expected typename");
-            return false;
+            return syntax_error(ctx, "Expected typename");
         }
         curtok = tokens.peek();
     }
 
     // check for arr_size
-    if (allow_arr_size && curtok.type() == TokenType::Punctuator && std::get<Punctuator>(curtok.value()) == Punctuator::OpenBracket)
+    if (allow_arr_size && curtok.type() == TokenType::Punctuator && curtok.punctuator() == Punctuator::OpenBracket)
     {
         // we can't have both bitfield and arr_size
         if (is_bitfield)
         {
-            throw SyntaxError("Unexpected arr_size");
-            return false;
+            return syntax_error(ctx, "Unexpected arr_size");
         }
 
         tokens.pop();
         if (tokens.eof())
         {
-            throw SyntaxError("Expected arr_size");
-            return false;
+            return syntax_error(ctx, "Expected arr_size");
         }
         curtok = tokens.peek();
-        if (curtok.type() == TokenType::Punctuator && std::get<Punctuator>(curtok.value()) == Punctuator::CloseBracket)
+        if (curtok.type() == TokenType::Punctuator && curtok.punctuator() == Punctuator::CloseBracket)
         {
             // dynamic array
             tokens.pop();
             if (tokens.eof())
             {
-                throw SyntaxError("Expected typename");
-                return false;
+                return syntax_error(ctx, "Expected typename");
             }
             curtok = tokens.peek();
             arr_size = std::numeric_limits<size_t>::max();
@@ -740,203 +426,239 @@ bool jcc::parse_type(jcc::TokenList &tokens, bool allow_bitfield, bool allow_arr
         else if (curtok.type() == TokenType::NumberLiteral)
         {
             // fixed array
-            arr_size = std::stoll(std::get<std::string>(curtok.value()));
+            if (!parse_integer(ctx, "array size", arr_size))
+            {
+                return false;
+            }
             tokens.pop();
             if (tokens.eof())
             {
-                throw SyntaxError("Expected typename");
-                return false;
+                return syntax_error(ctx, "Expected typename");
             }
             curtok = tokens.peek();
-            if (curtok.type() != TokenType::Punctuator || std::get<Punctuator>(curtok.value()) != Punctuator::CloseBracket)
+            if (curtok.type() != TokenType::Punctuator || curtok.punctuator() != Punctuator::CloseBracket)
             {
-                throw SyntaxError("Expected closing bracket");
-                return false;
+                return syntax_error(ctx, "Expected closing bracket");
             }
             tokens.pop();
             if (tokens.eof())
             {
-                throw SyntaxError("Expected typename");
-                return false;
+                return syntax_error(ctx, "Expected typename");
             }
             curtok = tokens.peek();
         }
         else
         {
-            throw SyntaxError("Expected arr_size");
-            return false;
+            return syntax_error(ctx, "Expected arr_size");
         }
     }
 
     // check for default value
-    if (allow_default_value && curtok.type() == TokenType::Operator && std::get<Operator>(curtok.value()) == Operator::Assign)
+    if (allow_default_value && curtok.type() == TokenType::Operator && curtok.op() == Operator::Assign)
     {
         tokens.pop();
-        if (!parse_expression(tokens, default_value))
+        if (!parse_expression(ctx, default_value))
         {
-            throw SyntaxError("Expected default value");
-            return false;
+            return syntax_error(ctx, "Expected default value");
         }
     }
 
-    node = std::make_shared<TypeNode>(type, is_const, is_ref, arr_size, bitfield, std::static_pointer_cast<Expression>(default_value));
+    node = make_node<TypeNode>(type, is_const, is_ref, arr_size, bitfield, static_cast<Expression *>(default_value));
 
     return true;
 }
 
-static bool jcc::parse_structural_block(jcc::TokenList &tokens, std::shared_ptr<jcc::GenericNode> &node)
+static bool jcc::parse_structural_block(jcc::ParseContext &ctx, jcc::GenericNode *&node, bool top_level)
 {
-    if (tokens.size() < 2)
+    TokenCursor &tokens = ctx.tokens;
+
+    // the top level block runs to the end of the input and has no braces
+    if (!top_level)
     {
-        throw SyntaxError("Expected punctuator on block");
-        return false;
-    }
+        if (tokens.size() < 2)
+        {
+            return syntax_error(ctx, "Expected punctuator on block");
+        }
 
-    Token next_1 = tokens.peek(0);
+        Token next_1 = tokens.peek(0);
 
-    if (next_1.type() != TokenType::Punctuator || std::get<Punctuator>(next_1.value()) != Punctuator::OpenBrace)
-    {
-        throw SyntaxError("Expected opening brace for block");
-        return false;
+        if (next_1.type() != TokenType::Punctuator || next_1.punctuator() != Punctuator::OpenBrace)
+        {
+            return syntax_error(ctx, "Expected opening brace for block");
+        }
+
+        tokens.pop(1);
     }
 
-    tokens.pop(1);
+    Block *block = make_node<Block>();
 
-    std::shared_ptr<GenericNode> tmp;
-    std::shared_ptr<Block> block = std::make_shared<Block>();
+    // subsystems opened inside the block, innermost last; `block` is the body being filled
+    std::vector<OpenSubsystem> open;
 
     bool is_looping = true;
 
-    while (!tokens.eof() && is_looping)
+    while (is_looping)
     {
+        if (tokens.eof())
+        {
+            if (open.empty())
+            {
+                break;
+            }
+
+            // each unclosed subsystem is reported and dropped
+            syntax_error(ctx, "Expected closing brace for block");
+            synchronize(ctx, open.back().statement);
+
+            block = open.back().block;
+            open.pop_back();
+            continue;
+        }
+
         Token curtok = tokens.peek();
+        size_t statement = tokens.mark();
+        GenericNode *tmp = nullptr;
+        bool ok = true;
 
         switch (curtok.type())
         {
         case TokenType::Identifier:
-            throw SyntaxError("Unexpected identifier: " + std::get<std::string>(curtok.value()));
+            ok = syntax_error(ctx, "Unexpected identifier: " + std::string(curtok.text()));
             break; // implement this
         case TokenType::Keyword:
-            switch (std::get<jcc::Keyword>(curtok.value()))
+            switch (curtok.keyword())
             {
             case Keyword::Subsystem:
-                if (!parse_subsystem_keyword(tokens, tmp))
-                    return false;
-                block->push(tmp);
-                break;
+            {
+                OpenSubsystem subsystem;
+                ok = parse_subsystem_keyword(ctx, tmp, subsystem);
+                if (!ok || !subsystem.defined)
+                {
+                    break;
+                }
+
+                if (tokens.size() < 2)
+                {
+                    ok = syntax_error(ctx, "Expected punctuator on block");
+                    break;
+                }
+
+                if (open.size() >= ctx.max_nesting)
+                {
+                    ok = syntax_error(ctx, "Subsystems nested more than " + std::to_string(ctx.max_nesting) + " levels deep");
+                    break;
+                }
+
+                // parse the body in place; the enclosing block is resumed at its closing brace
+                tokens.pop();
+                subsystem.statement = statement;
+                subsystem.block = block;
+                open.push_back(std::move(subsystem));
+                block = make_node<Block>();
+                continue;
+            }
 
             case Keyword::Import:
-                if (!parse_import_keyword(tokens, tmp))
-                    return false;
-                block->push(tmp);
+                ok = parse_import_keyword(ctx, tmp);
                 break;
             case Keyword::Export:
-                if (!parse_export_keyword(tokens, tmp))
-                    return false;
-                block->push(tmp);
+                ok = parse_export_keyword(ctx, tmp);
                 break;
             case Keyword::Extern:
-                if (!parse_extern_keyword(tokens, tmp))
-                    return false;
-                block->push(tmp);
+                ok = parse_extern_keyword(ctx, tmp);
                 break;
 
             case Keyword::Let:
-                if (!parse_let_keyword(tokens, tmp))
-                    return false;
-                block->push(tmp);
+                ok = parse_let_keyword(ctx, tmp);
                 break;
             case Keyword::Var:
-                if (!parse_var_keyword(tokens, tmp))
-                    return false;
-                block->push(tmp);
+                ok = parse_var_keyword(ctx, tmp);
                 break;
 
             case Keyword::Struct:
-                if (!parse_struct_keyword(tokens, tmp, false))
-                    return false;
-                block->push(tmp);
+                ok = parse_struct_keyword(ctx, tmp, false);
                 break;
             case Keyword::Region:
-                if (!parse_struct_keyword(tokens, tmp, true))
-                    return false;
-                block->push(tmp);
+                ok = parse_struct_keyword(ctx, tmp, true);
                 break;
             case Keyword::Union:
-                if (!parse_union_keyword(tokens, tmp, false))
-                    return false;
-                block->push(tmp);
+                ok = parse_union_keyword(ctx, tmp, false);
                 break;
 
             case Keyword::Func:
-                if (!parse_func_keyword(tokens, tmp, FunctionParseMode::DeclarationOrDefinition))
-                    return false;
-                block->push(tmp);
+                ok = parse_func_keyword(ctx, tmp, FunctionParseMode::DeclarationOrDefinition);
                 break;
 
             case Keyword::Typedef:
-                if (!parse_typedef_keyword(tokens, tmp))
-                    return false;
-                block->push(tmp);
+                ok = parse_typedef_keyword(ctx, tmp);
                 break;
             case Keyword::Volatile:
-                if (!parse_volatile_keyword(tokens, tmp))
-                    return false;
-                block->push(tmp);
+                ok = parse_volatile_keyword(ctx, tmp);
                 break;
 
             case Keyword::Class:
-                if (!parse_class_keyword(tokens, tmp))
-                    return false;
-                block->push(tmp);
+                ok = parse_class_keyword(ctx, tmp);
                 break;
 
             case Keyword::Enum:
-                if (!parse_enum_keyword(tokens, tmp))
-                    return false;
-                block->push(tmp);
+                ok = parse_enum_keyword(ctx, tmp);
                 break;
             default:
-                throw SyntaxError("Unexpected keyword: " + std::string(lexKeywordMapReverse.at(std::get<jcc::Keyword>(curtok.value()))));
+                ok = syntax_error(ctx, "Unexpected keyword: " + std::string(lexKeywordMapReverse.at(curtok.keyword())));
+                break;
             }
             break;
         case TokenType::Punctuator:
-            switch (std::get<Punctuator>(curtok.value()))
+            switch (curtok.punctuator())
             {
             case Punctuator::OpenBrace:
-                throw SyntaxError("Unexpected opening brace");
+                ok = syntax_error(ctx, "Unexpected opening brace");
                 break;
             case Punctuator::CloseBrace:
+                if (!open.empty())
+                {
+                    tokens.pop();
+                    tmp = make_node<SubsystemDefinition>(open.back().name, block, open.back().dependencies);
+                    block = open.back().block;
+                    open.pop_back();
+                    break;
+                }
+                if (top_level)
+                {
+                    ok = syntax_error(ctx, "Unexpected closing brace");
+                    break;
+                }
                 is_looping = false;
                 break;
             case Punctuator::OpenParen:
-                throw SyntaxError("Unexpected opening parenthesis");
+                ok = syntax_error(ctx, "Unexpected opening parenthesis");
                 break;
             case Punctuator::CloseParen:
-                throw SyntaxError("Unexpected closing parenthesis");
+                ok = syntax_error(ctx, "Unexpected closing parenthesis");
                 break;
             case Punctuator::OpenBracket:
-                throw SyntaxError("Unexpected opening bracket");
+                ok = syntax_error(ctx, "Unexpected opening bracket");
                 break;
             case Punctuator::CloseBracket:
-                throw SyntaxError("Unexpected closing bracket");
+                ok = syntax_error(ctx, "Unexpected closing bracket");
                 break;
             case Punctuator::Semicolon:
                 // ignore semicolons
                 tokens.pop();
                 break;
             case Punctuator::Colon:
-                throw SyntaxError("Unexpected colon");
+                ok = syntax_error(ctx, "Unexpected colon");
                 break;
             case Punctuator::Comma:
-                throw SyntaxError("Unexpected comma");
+                ok = syntax_error(ctx, "Unexpected comma");
                 break;
             case Punctuator::Period:
-                throw SyntaxError("Unexpected period");
+                ok = syntax_error(ctx, "Unexpected period");
                 break;
 
             default:
-                throw SyntaxError("Unexpected punctuator: " + std::string(lexPunctuatorMapReverse.at(std::get<Punctuator>(curtok.value()))));
+                ok = syntax_error(ctx, "Unexpected punctuator: " + std::string(lexPunctuatorMapReverse.at(curtok.punctuator())));
+                break;
             }
             break;
         case TokenType::MultiLineComment:
@@ -944,28 +666,44 @@ static bool jcc::parse_structural_block(jcc::TokenList &tokens, std::shared_ptr<
         case TokenType::Whitespace:
             tokens.pop();
             break; // skip comments and whitespace
+        case TokenType::NumberLiteral:
+        case TokenType::FloatingPointLiteral:
+        case TokenType::StringLiteral:
+            ok = syntax_error(ctx, "Unexpected literal: " + std::string(curtok.text()));
+            break;
+        case TokenType::Operator:
+            ok = syntax_error(ctx, "Unexpected operator: " + std::string(lexOperatorMapReverse.at(curtok.op())));
+            break;
         case TokenType::Raw:
-            block->push(std::make_shared<RawNode>(std::get<std::string>(curtok.value())));
+            tmp = make_node<RawNode>(std::string(curtok.text()));
             tokens.pop();
             break;
         default:
             panic("Unknown token type: " + std::to_string((int)curtok.type()));
             break;
         }
+
+        if (!ok)
+        {
+            // skip the rest of the statement and carry on with the next one
+            synchronize(ctx, statement);
+        }
+        else if (tmp != nullptr)
+        {
+            block->push(tmp);
+        }
     }
 
-    if (tokens.eof())
+    if (top_level)
     {
-        throw SyntaxError("Expected closing brace for block");
-        return false;
-    }
+        node = block;
 
-    Token next_2 = tokens.peek(0);
+        return true;
+    }
 
-    if (next_2.type() != TokenType::Punctuator || std::get<Punctuator>(next_2.value()) != Punctuator::CloseBrace)
+    if (tokens.eof())
     {
-        throw SyntaxError("Expected closing brace for block");
-        return false;
+        return syntax_error(ctx, "Expected closing brace for block");
     }
 
     tokens.pop();
@@ -975,105 +713,101 @@ static bool jcc::parse_structural_block(jcc::TokenList &tokens, std::shared_ptr<
     return true;
 }
 
-static bool jcc::parse_functional_block(jcc::TokenList &tokens, std::shared_ptr<jcc::GenericNode> &node)
+static bool jcc::parse_functional_block(jcc::ParseContext &ctx, jcc::GenericNode *&node)
 {
+    TokenCursor &tokens = ctx.tokens;
+
     if (tokens.size() < 2)
     {
-        throw SyntaxError("Expected punctuator on block");
-        return false;
+        return syntax_error(ctx, "Expected punctuator on block");
     }
 
     Token next_1 = tokens.peek(0);
 
-    if (next_1.type() != TokenType::Punctuator || std::get<Punctuator>(next_1.value()) != Punctuator::OpenBrace)
+    if (next_1.type() != TokenType::Punctuator || next_1.punctuator() != Punctuator::OpenBrace)
     {
-        throw SyntaxError("Expected opening brace for block");
-        return false;
+        return syntax_error(ctx, "Expected opening brace for block");
     }
 
     tokens.pop(1);
 
-    std::shared_ptr<GenericNode> tmp;
-    std::shared_ptr<Block> block = std::make_shared<Block>();
+    Block *block = make_node<Block>();
 
     bool is_looping = true;
 
     while (!tokens.eof() && is_looping)
     {
         Token curtok = tokens.peek();
+        size_t statement = tokens.mark();
+        GenericNode *tmp = nullptr;
+        bool ok = true;
 
         switch (curtok.type())
         {
         case TokenType::Identifier:
-            throw SyntaxError("Unexpected identifier: " + std::get<std::string>(curtok.value()));
+            ok = syntax_error(ctx, "Unexpected identifier: " + std::string(curtok.text()));
             break; // implement this
         case TokenType::Keyword:
-            switch (std::get<jcc::Keyword>(curtok.value()))
+            switch (curtok.keyword())
             {
             case Keyword::Import:
-                if (!parse_import_keyword(tokens, tmp))
-                    return false;
-                block->push(tmp);
+                ok = parse_import_keyword(ctx, tmp);
                 break;
 
             case Keyword::Let:
-                if (!parse_let_keyword(tokens, tmp))
-                    return false;
-                block->push(tmp);
+                ok = parse_let_keyword(ctx, tmp);
                 break;
             case Keyword::Var:
-                if (!parse_var_keyword(tokens, tmp))
-                    return false;
-                block->push(tmp);
+                ok = parse_var_keyword(ctx, tmp);
                 break;
 
             case Keyword::Volatile:
-                if (!parse_volatile_keyword(tokens, tmp))
-                    return false;
-                block->push(tmp);
+                ok = parse_volatile_keyword(ctx, tmp);
                 break;
 
             default:
-                throw SyntaxError("Unexpected keyword: " + std::string(lexKeywordMapReverse.at(std::get<jcc::Keyword>(curtok.value()))));
+                ok = syntax_error(ctx, "Unexpected keyword: " + std::string(lexKeywordMapReverse.at(curtok.keyword())));
+                break;
             }
             break;
         case TokenType::Punctuator:
-            switch (std::get<Punctuator>(curtok.value()))
+            switch (curtok.punctuator())
             {
             case Punctuator::OpenBrace:
-                throw SyntaxError("Unexpected opening brace");
+                ok = syntax_error(ctx, "Unexpected opening brace");
                 break;
             case Punctuator::CloseBrace:
                 is_looping = false;
                 break;
             case Punctuator::OpenParen:
-                throw SyntaxError("Unexpected opening parenthesis");
+                ok = syntax_error(ctx, "Unexpected opening parenthesis");
                 break;
             case Punctuator::CloseParen:
-                throw SyntaxError("Unexpected closing parenthesis");
+                ok = syntax_error(ctx, "Unexpected closing parenthesis");
                 break;
             case Punctuator::OpenBracket:
-                throw SyntaxError("Unexpected opening bracket");
+                ok = syntax_error(ctx, "Unexpected opening bracket");
                 break;
             case Punctuator::CloseBracket:
-                throw SyntaxError("Unexpected closing bracket");
+                ok = syntax_error(ctx, "Unexpected closing bracket");
                 break;
             case Punctuator::Semicolon:
                 // ignore semicolons
                 tokens.pop();
                 break;
             case Punctuator::Colon:
-                throw SyntaxError("Unexpected colon");
+                ok = syntax_error(ctx, "Unexpected colon");
                 break;
             case Punctuator::Comma:
-                throw SyntaxError("Unexpected comma");
+                ok = syntax_error(ctx, "Unexpected comma");
                 break;
             case Punctuator::Period:
-                throw SyntaxError("Unexpected period");
+                ok = syntax_error(ctx, "Unexpected period");
                 break;
 
             default:
-                throw SyntaxError("Unexpected punctuator: " + std::string(lexPunctuatorMapReverse.at(std::get<Punctuator>(curtok.value()))));
+                ok = syntax_error(ctx, "Unexpected punctuator: " + std::string(lexPunctuatorMapReverse.at(curtok.punctuator())));
+                break;
             }
             break;
         case TokenType::MultiLineComment:
@@ -1081,28 +815,37 @@ static bool jcc::parse_functional_block(jcc::TokenList &tokens, std::shared_ptr<
         case TokenType::Whitespace:
             tokens.pop();
             break; // skip comments and whitespace
+        case TokenType::NumberLiteral:
+        case TokenType::FloatingPointLiteral:
+        case TokenType::StringLiteral:
+            ok = syntax_error(ctx, "Unexpected literal: " + std::string(curtok.text()));
+            break;
+        case TokenType::Operator:
+            ok = syntax_error(ctx, "Unexpected operator: " + std::string(lexOperatorMapReverse.at(curtok.op())));
+            break;
         case TokenType::Raw:
-            block->push(std::make_shared<RawNode>(std::get<std::string>(curtok.value())));
+            tmp = make_node<RawNode>(std::string(curtok.text()));
             tokens.pop();
             break;
         default:
             panic("Unknown token type: " + std::to_string((int)curtok.type()));
             break;
         }
-    }
 
-    if (tokens.eof())
-    {
-        throw SyntaxError("Expected closing brace for block");
-        return false;
+        if (!ok)
+        {
+            // skip the rest of the statement and carry on with the next one
+            synchronize(ctx, statement);
+        }
+        else if (tmp != nullptr)
+        {
+            block->push(tmp);
+        }
     }
 
-    Token next_2 = tokens.peek(0);
-
-    if (next_2.type() != TokenType::Punctuator || std::get<Punctuator>(next_2.value()) != Punctuator::CloseBrace)
+    if (tokens.eof())
     {
-        throw SyntaxError("Expected closing brace for block");
-        return false;
+        return syntax_error(ctx, "Expected closing brace for block");
     }
 
     tokens.pop();
@@ -1112,12 +855,13 @@ static bool jcc::parse_functional_block(jcc::TokenList &tokens, std::shared_ptr<
     return true;
 }
 
-static bool jcc::parse_var_keyword(jcc::TokenList &tokens, std::shared_ptr<jcc::GenericNode> &node)
+static bool jcc::parse_var_keyword(jcc::ParseContext &ctx, jcc::GenericNode *&node)
 {
+    TokenCursor &tokens = ctx.tokens;
+
     if (tokens.size() < 2)
     {
-        throw SyntaxError("Expected identifier after var keyword");
-        return false;
+        return syntax_error(ctx, "Expected identifier after var keyword");
     }
 
     tokens.pop();
@@ -1125,43 +869,40 @@ static bool jcc::parse_var_keyword(jcc::TokenList &tokens, std::shared_ptr<jcc::
     Token curtok = tokens.peek();
     if (curtok.type() != TokenType::Identifier)
     {
-        throw SyntaxError("Expected identifier after var keyword");
-        return false;
+        return syntax_error(ctx, "Expected identifier after var keyword");
     }
-    std::string name = std::get<std::string>(curtok.value());
+    std::string name(curtok.text());
     tokens.pop();
     if (tokens.eof())
     {
-        throw SyntaxError("Expected typename after var keyword");
-        return false;
+        return syntax_error(ctx, "Expected typename after var keyword");
     }
     curtok = tokens.peek();
-    if (curtok.type() != TokenType::Punctuator || std::get<Punctuator>(curtok.value()) != Punctuator::Colon)
+    if (curtok.type() != TokenType::Punctuator || curtok.punctuator() != Punctuator::Colon)
     {
-        throw SyntaxError("Expected colon after var keyword");
-        return false;
+        return syntax_error(ctx, "Expected colon after var keyword");
     }
     tokens.pop();
 
-    std::shared_ptr<TypeNode> type;
+    TypeNode *type = nullptr;
 
-    if (!parse_type(tokens, false, true, true, type))
+    if (!parse_type(ctx, false, true, true, type))
     {
-        throw SyntaxError("Expected typename after var keyword");
-        return false;
+        return syntax_error(ctx, "Expected typename after var keyword");
     }
 
-    node = std::make_shared<VarDeclaration>(type, name);
+    node = make_node<VarDeclaration>(type, name);
 
     return true;
 }
 
-static bool jcc::parse_let_keyword(jcc::TokenList &tokens, std::shared_ptr<jcc::GenericNode> &node)
+static bool jcc::parse_let_keyword(jcc::ParseContext &ctx, jcc::GenericNode *&node)
 {
+    TokenCursor &tokens = ctx.tokens;
+
     if (tokens.size() < 2)
     {
-        throw SyntaxError("Expected identifier after let keyword");
-        return false;
+        return syntax_error(ctx, "Expected identifier after let keyword");
     }
 
     tokens.pop();
@@ -1169,82 +910,75 @@ static bool jcc::parse_let_keyword(jcc::TokenList &tokens, std::shared_ptr<jcc::
     Token curtok = tokens.peek();
     if (curtok.type() != TokenType::Identifier)
     {
-        throw SyntaxError("Expected identifier after let keyword");
-        return false;
+        return syntax_error(ctx, "Expected identifier after let keyword");
     }
-    std::string name = std::get<std::string>(curtok.value());
+    std::string name(curtok.text());
     tokens.pop();
     if (tokens.eof())
     {
-        throw SyntaxError("Expected typename after let keyword");
-        return false;
+        return syntax_error(ctx, "Expected typename after let keyword");
     }
     curtok = tokens.peek();
-    if (curtok.type() != TokenType::Punctuator || std::get<Punctuator>(curtok.value()) != Punctuator::Colon)
+    if (curtok.type() != TokenType::Punctuator || curtok.punctuator() != Punctuator::Colon)
     {
-        throw SyntaxError("Expected colon after let keyword");
-        return false;
+        return syntax_error(ctx, "Expected colon after let keyword");
     }
     tokens.pop();
 
-    std::shared_ptr<TypeNode> type;
+    TypeNode *type = nullptr;
 
-    if (!parse_type(tokens, false, true, true, type))
+    if (!parse_type(ctx, false, true, true, type))
     {
-        throw SyntaxError("Expected typename after let keyword");
-        return false;
+        return syntax_error(ctx, "Expected typename after let keyword");
     }
 
-    node = std::make_shared<LetDeclaration>(type, name);
+    node = make_node<LetDeclaration>(type, name);
 
     return true;
 }
 
-static bool jcc::parse_import_keyword(jcc::TokenList &tokens, std::shared_ptr<jcc::GenericNode> &node)
+static bool jcc::parse_import_keyword(jcc::ParseContext &ctx, jcc::GenericNode *&node)
 {
-    (void)tokens;
     (void)node;
     /// TODO: implement
-    return false;
+    return syntax_error(ctx, "Unsupported keyword: import");
 }
 
-static bool jcc::parse_export_keyword(jcc::TokenList &tokens, std::shared_ptr<jcc::GenericNode> &node)
+static bool jcc::parse_export_keyword(jcc::ParseContext &ctx, jcc::GenericNode *&node)
 {
-    (void)tokens;
     (void)node;
     /// TODO: implement
-    return false;
+    return syntax_error(ctx, "Unsupported keyword: export");
 }
 
-static bool jcc::parse_extern_keyword(jcc::TokenList &tokens, std::shared_ptr<jcc::GenericNode> &node)
+static bool jcc::parse_extern_keyword(jcc::ParseContext &ctx, jcc::GenericNode *&node)
 {
-    (void)tokens;
     (void)node;
     /// TODO: implement
-    return false;
+    return syntax_error(ctx, "Unsupported keyword: extern");
 }
 
-static bool jcc::parse_volatile_keyword(jcc::TokenList &tokens, std::shared_ptr<jcc::GenericNode> &node)
+static bool jcc::parse_volatile_keyword(jcc::ParseContext &ctx, jcc::GenericNode *&node)
 {
-    (void)tokens;
     (void)node;
     /// TODO: implement
-    return false;
+    return syntax_error(ctx, "Unsupported keyword: volatile");
 }
 
-static bool jcc::parse_block(jcc::TokenList &tokens, std::shared_ptr<jcc::GenericNode> &node, bool functional)
+static bool jcc::parse_block(jcc::ParseContext &ctx, jcc::GenericNode *&node, bool functional)
 {
-    return functional ? parse_functional_block(tokens, node) : parse_structural_block(tokens, node);
+    return functional ? parse_functional_block(ctx, node) : parse_structural_block(ctx, node);
 }
 
-static bool jcc::parse_struct_keyword(jcc::TokenList &tokens, std::shared_ptr<jcc::GenericNode> &node, bool packed)
+static bool jcc::parse_struct_keyword(jcc::ParseContext &ctx, jcc::GenericNode *&node, bool packed)
 {
     using namespace jcc;
 
+    TokenCursor &tokens = ctx.tokens;
+
     if (tokens.size() < 3)
     {
-        throw SyntaxError("Expected identifier after struct keyword");
-        return false;
+        return syntax_error(ctx, "Expected identifier after struct keyword");
     }
 
     Token next_1 = tokens.peek(1);
@@ -1252,28 +986,25 @@ static bool jcc::parse_struct_keyword(jcc::TokenList &tokens, std::shared_ptr<jc
 
     if (next_1.type() != TokenType::Identifier)
     {
-        throw SyntaxError("Expected identifier after struct keyword");
-        return false;
+        return syntax_error(ctx, "Expected identifier after struct keyword");
     }
 
     if (next_2.type() != TokenType::Punctuator)
     {
-        throw SyntaxError("Expected punctuator after struct identifier");
-        return false;
+        return syntax_error(ctx, "Expected punctuator after struct identifier");
     }
 
-    if (std::get<Punctuator>(next_2.value()) == Punctuator::Semicolon)
+    if (next_2.punctuator() == Punctuator::Semicolon)
     {
-        std::shared_ptr<StructDeclaration> struct_ptr = std::make_shared<StructDeclaration>(std::get<std::string>(next_1.value()));
+        StructDeclaration *struct_ptr = make_node<StructDeclaration>(std::string(next_1.text()));
         node = struct_ptr;
         tokens.pop(3);
 
         return true;
     }
-    else if (std::get<Punctuator>(next_2.value()) != Punctuator::OpenBrace)
+    else if (next_2.punctuator() != Punctuator::OpenBrace)
     {
-        throw SyntaxError("Expected punctuator after struct identifier");
-        return false;
+        return syntax_error(ctx, "Expected punctuator after struct identifier");
     }
 
     /*
@@ -1284,418 +1015,415 @@ static bool jcc::parse_struct_keyword(jcc::TokenList &tokens, std::shared_ptr<jc
 
     if (tokens.size() < 1)
     {
-        throw SyntaxError("Expected closing brace for struct");
-        return false;
+        return syntax_error(ctx, "Expected closing brace for struct");
     }
 
     // should be identifier
-    std::vector<std::shared_ptr<StructField>> fields;
+    NodeList<StructField> fields;
 
-    std::shared_ptr<StructField> field = std::make_shared<StructField>();
-    std::vector<std::shared_ptr<StructMethod>> functions;
+    StructField *field = make_node<StructField>();
+    NodeList<StructMethod> functions;
 
     while (1)
     {
+        if (tokens.eof())
+        {
+            return syntax_error(ctx, "Expected closing brace for struct");
+        }
+
         Token curtok = tokens.peek();
 
-        if (curtok.type() == TokenType::Punctuator && std::get<Punctuator>(curtok.value()) == Punctuator::CloseBrace)
+        if (curtok.type() == TokenType::Punctuator && curtok.punctuator() == Punctuator::CloseBrace)
         {
             tokens.pop();
             break;
         }
 
-        if (curtok.type() == TokenType::Operator && std::get<Operator>(curtok.value()) == Operator::At)
+        size_t member = tokens.mark();
+        if (!parse_struct_member(ctx, field, fields, functions))
         {
-            tokens.pop();
-            if (tokens.eof())
-            {
-                throw SyntaxError("Expected attribute in struct field");
-                return false;
-            }
+            // skip the rest of the field and carry on with the next one
+            synchronize(ctx, member);
+            field = make_node<StructField>();
+        }
+    }
 
-            curtok = tokens.peek();
-            if (curtok.type() != TokenType::Punctuator || std::get<Punctuator>(curtok.value()) != Punctuator::Colon)
-            {
-                throw SyntaxError("Expected attribute in struct field");
-                return false;
-            }
-            tokens.pop();
-            if (tokens.eof())
-            {
-                throw SyntaxError("Expected attribute name in struct field");
-                return false;
-            }
+    node = make_node<StructDefinition>(std::string(next_1.text()), fields, functions, packed);
 
-            curtok = tokens.peek();
-            if (curtok.type() != TokenType::Identifier)
-            {
-                throw SyntaxError("Expected attribute name in struct field");
-                return false;
-            }
-            tokens.pop();
+    return true;
+}
 
-            std::shared_ptr<StructAttribute> attribute = std::make_shared<StructAttribute>();
-            attribute->name() = std::get<std::string>(curtok.value());
+static bool jcc::parse_struct_member(jcc::ParseContext &ctx, jcc::StructField *&field, jcc::NodeList<jcc::StructField> &fields, jcc::NodeList<jcc::StructMethod> &methods)
+{
+    TokenCursor &tokens = ctx.tokens;
 
-            if (tokens.eof())
-            {
-                throw SyntaxError("Expected attribute value in struct field");
-                return false;
-            }
-            curtok = tokens.peek();
-            if (curtok.type() != TokenType::Punctuator || std::get<Punctuator>(curtok.value()) != Punctuator::OpenParen)
-            {
-                throw SyntaxError("Expected attribute value in struct field");
-                return false;
-            }
-            tokens.pop();
+    Token curtok = tokens.peek();
 
-            if (tokens.eof())
-            {
-                throw SyntaxError("Expected attribute value in struct field");
-                return false;
-            }
-            curtok = tokens.peek();
-            if (curtok.type() != TokenType::StringLiteral && curtok.type() != TokenType::NumberLiteral)
-            {
-                throw SyntaxError("Expected attribute value in struct field");
-                return false;
-            }
+    if (curtok.type() == TokenType::Operator && curtok.op() == Operator::At)
+    {
+        tokens.pop();
+        if (tokens.eof())
+        {
+            return syntax_error(ctx, "Expected attribute in struct field");
+        }
 
-            switch (curtok.type())
-            {
-            case TokenType::StringLiteral:
-                attribute->value() = "\"" + std::get<std::string>(curtok.value()) + "\"";
-                break;
-            case TokenType::NumberLiteral:
-                attribute->value() = std::get<std::string>(curtok.value());
-                break;
-            default:
-                break;
-            }
+        curtok = tokens.peek();
+        if (curtok.type() != TokenType::Punctuator || curtok.punctuator() != Punctuator::Colon)
+        {
+            return syntax_error(ctx, "Expected attribute in struct field");
+        }
+        tokens.pop();
+        if (tokens.eof())
+        {
+            return syntax_error(ctx, "Expected attribute name in struct field");
+        }
 
-            tokens.pop();
+        curtok = tokens.peek();
+        if (curtok.type() != TokenType::Identifier)
+        {
+            return syntax_error(ctx, "Expected attribute name in struct field");
+        }
+        tokens.pop();
 
-            if (tokens.eof())
-            {
-                throw SyntaxError("Expected attribute value in struct field");
-                return false;
-            }
+        StructAttribute *attribute = make_node<StructAttribute>();
+        attribute->name() = curtok.text();
 
-            curtok = tokens.peek();
+        if (tokens.eof())
+        {
+            return syntax_error(ctx, "Expected attribute value in struct field");
+        }
+        curtok = tokens.peek();
+        if (curtok.type() != TokenType::Punctuator || curtok.punctuator() != Punctuator::OpenParen)
+        {
+            return syntax_error(ctx, "Expected attribute value in struct field");
+        }
+        tokens.pop();
 
-            if (curtok.type() != TokenType::Punctuator || std::get<Punctuator>(curtok.value()) != Punctuator::CloseParen)
-            {
-                throw SyntaxError("Expected attribute value in struct field");
-                return false;
-            }
+        if (tokens.eof())
+        {
+            return syntax_error(ctx, "Expected attribute value in struct field");
+        }
+        curtok = tokens.peek();
+        if (curtok.type() != TokenType::StringLiteral && curtok.type() != TokenType::NumberLiteral)
+        {
+            return syntax_error(ctx, "Expected attribute value in struct field");
+        }
 
-            tokens.pop();
+        switch (curtok.type())
+        {
+        case TokenType::StringLiteral:
+            attribute->value() = "\"" + std::string(curtok.text()) + "\"";
+            break;
+        case TokenType::NumberLiteral:
+            attribute->value() = curtok.text();
+            break;
+        default:
+            break;
+        }
+
+        tokens.pop();
 
-            field->attributes().push_back(attribute);
+        if (tokens.eof())
+        {
+            return syntax_error(ctx, "Expected attribute value in struct field");
         }
-        else
+
+        curtok = tokens.peek();
+
+        if (curtok.type() != TokenType::Punctuator || curtok.punctuator() != Punctuator::CloseParen)
         {
-            if (curtok.type() == TokenType::Punctuator && std::get<Punctuator>(curtok.value()) == Punctuator::Semicolon)
-            {
-                tokens.pop();
-                continue;
-            }
+            return syntax_error(ctx, "Expected attribute value in struct field");
+        }
 
-            // name
-            if (curtok.type() != TokenType::Identifier)
-            {
-                throw SyntaxError("Expected identifier in struct field");
-                return false;
-            }
-            field->name() = std::get<std::string>(curtok.value());
-            tokens.pop();
-            if (tokens.eof())
-            {
-                throw SyntaxError("Expected seperator in struct field");
-                return false;
-            }
+        tokens.pop();
 
-            curtok = tokens.peek();
-            if (curtok.type() != TokenType::Punctuator && std::get<Punctuator>(curtok.value()) != Punctuator::Colon)
+        field->attributes().push_back(attribute);
+    }
+    else
+    {
+        if (curtok.type() == TokenType::Punctuator && curtok.punctuator() == Punctuator::Semicolon)
+        {
+            tokens.pop();
+            return true;
+        }
+
+        // name
+        if (curtok.type() != TokenType::Identifier)
+        {
+            return syntax_error(ctx, "Expected identifier in struct field");
+        }
+        field->name() = curtok.symbol();
+        tokens.pop();
+        if (tokens.eof())
+        {
+            return syntax_error(ctx, "Expected seperator in struct field");
+        }
+
+        curtok = tokens.peek();
+        if (curtok.type() != TokenType::Punctuator || curtok.punctuator() != Punctuator::Colon)
+        {
+            return syntax_error(ctx, "Expected seperator in struct field");
+        }
+        tokens.pop();
+
+        if (tokens.eof())
+        {
+            return syntax_error(ctx, "Expected type in struct field");
+        }
+
+        // type
+        curtok = tokens.peek();
+        if (curtok.type() != TokenType::Identifier && curtok.type() != TokenType::Keyword && curtok.type() != TokenType::Punctuator)
+        {
+            return syntax_error(ctx, "Expected type in struct field");
+        }
+
+        switch (curtok.type())
+        {
+        case TokenType::Identifier:
+            field->type() = curtok.symbol();
+            break;
+        case TokenType::Keyword:
+            // check if
+            if (is_builtin_type(curtok.keyword()))
+            {
+                field->type() = lexKeywordMapReverse.at(curtok.keyword());
+            }
+            else
+            {
+                return syntax_error(ctx, "Expected type in struct field");
+            }
+            break;
+        case TokenType::Punctuator:
+        {
+            NodeList<FunctionParameter> params;
+            if (!parse_function_parameters(ctx, params))
             {
-                throw SyntaxError("Expected seperator in struct field");
                 return false;
             }
-            tokens.pop();
 
             if (tokens.eof())
             {
-                throw SyntaxError("Expected type in struct field");
-                return false;
+                return syntax_error(ctx, "Expected block in struct field");
             }
 
-            // type
             curtok = tokens.peek();
-            if (curtok.type() != TokenType::Identifier && curtok.type() != TokenType::Keyword && curtok.type() != TokenType::Punctuator)
-            {
-                throw SyntaxError("Expected type in struct field");
-                return false;
-            }
 
-            switch (curtok.type())
-            {
-            case TokenType::Identifier:
-                field->type() = std::get<std::string>(curtok.value());
-                break;
-            case TokenType::Keyword:
-                // check if
-                if (is_builtin_type(lexKeywordMapReverse.at(std::get<Keyword>(curtok.value()))))
-                {
-                    field->type() = lexKeywordMapReverse.at(std::get<Keyword>(curtok.value()));
-                }
-                else
-                {
-                    throw SyntaxError("Expected type in struct field");
-                    return false;
-                }
-                break;
-            case TokenType::Punctuator:
+            std::string return_type = "void";
+
+            if (curtok.type() == TokenType::Punctuator && curtok.punctuator() == Punctuator::Colon)
             {
-                std::vector<std::shared_ptr<FunctionParameter>> params;
-                if (!parse_function_parameters(tokens, params))
-                {
-                    return false;
-                }
+                tokens.pop();
 
                 if (tokens.eof())
                 {
-                    throw SyntaxError("Expected block in struct field");
-                    return false;
+                    return syntax_error(ctx, "Expected type in struct field");
                 }
 
                 curtok = tokens.peek();
 
-                std::string return_type = "void";
-
-                if (curtok.type() == TokenType::Punctuator && std::get<Punctuator>(curtok.value()) == Punctuator::Colon)
+                if (curtok.type() != TokenType::Identifier && curtok.type() != TokenType::Keyword)
                 {
-                    tokens.pop();
-
-                    if (tokens.eof())
-                    {
-                        throw SyntaxError("Expected type in struct field");
-                        return false;
-                    }
-
-                    curtok = tokens.peek();
-
-                    if (curtok.type() != TokenType::Identifier && curtok.type() != TokenType::Keyword)
-                    {
-                        throw SyntaxError("Expected type in struct field");
-                        return false;
-                    }
+                    return syntax_error(ctx, "Expected type in struct field");
+                }
 
-                    switch (curtok.type())
+                switch (curtok.type())
+                {
+                case TokenType::Identifier:
+                    return_type = curtok.text();
+                    break;
+                case TokenType::Keyword:
+                    // check if
+                    if (is_builtin_type(curtok.keyword()))
                     {
-                    case TokenType::Identifier:
-                        return_type = std::get<std::string>(curtok.value());
-                        break;
-                    case TokenType::Keyword:
-                        // check if
-                        if (is_builtin_type(lexKeywordMapReverse.at(std::get<Keyword>(curtok.value()))))
-                        {
-                            return_type = lexKeywordMapReverse.at(std::get<Keyword>(curtok.value()));
-                        }
-                        else
-                        {
-                            throw SyntaxError("Expected type in struct field");
-                            return false;
-                        }
-                        break;
-                    default:
-                        break;
+                        return_type = lexKeywordMapReverse.at(curtok.keyword());
                     }
-
-                    if (tokens.eof())
+                    else
                     {
-                        throw SyntaxError("Expected block in struct field");
-                        return false;
+                        return syntax_error(ctx, "Expected type in struct field");
                     }
-                    tokens.pop();
-                    curtok = tokens.peek();
+                    break;
+                default:
+                    break;
                 }
 
-                std::shared_ptr<GenericNode> block;
-                if (!parse_block(tokens, block, true))
+                if (tokens.eof())
                 {
-                    return false;
+                    return syntax_error(ctx, "Expected block in struct field");
                 }
+                tokens.pop();
+                curtok = tokens.peek();
+            }
 
-                std::shared_ptr<StructMethod> function = std::make_shared<StructMethod>(field->name(), return_type, params, std::static_pointer_cast<Block>(block));
-                functions.push_back(function);
-                continue;
+            GenericNode *block = nullptr;
+            SourceRange body;
+            if (ctx.skim ? !skip_body(ctx, body) : !parse_block(ctx, block, true))
+            {
+                return false;
             }
+
+            StructMethod *function = make_node<StructMethod>(std::string(field->name().str()), return_type, params, static_cast<Block *>(block));
+            function->skipped_body() = body;
+            methods.push_back(function);
+            return true;
+        }
+        break;
+
+        default:
             break;
+        }
+        tokens.pop();
+        if (tokens.eof())
+        {
+            return syntax_error(ctx, "Expected seperator in struct field");
+        }
 
-            default:
-                break;
-            }
-            tokens.pop();
+        curtok = tokens.peek();
+
+        if (curtok.type() == TokenType::Punctuator && curtok.punctuator() == Punctuator::OpenBracket)
+        {
             if (tokens.eof())
             {
-                throw SyntaxError("Expected seperator in struct field");
-                return false;
+                return syntax_error(ctx, "Expected number in array size");
             }
 
+            tokens.pop();
+
             curtok = tokens.peek();
 
-            if (curtok.type() == TokenType::Punctuator && std::get<Punctuator>(curtok.value()) == Punctuator::OpenBracket)
+            if (curtok.type() == TokenType::Punctuator && curtok.punctuator() == Punctuator::CloseBracket)
             {
-                if (tokens.eof())
-                {
-                    throw SyntaxError("Expected number in array size");
-                    return false;
-                }
-
-                tokens.pop();
+                field->arr_size() = std::numeric_limits<uint64_t>::max();
+                goto skip_array_size;
+            }
 
-                curtok = tokens.peek();
+            if (curtok.type() != TokenType::NumberLiteral)
+            {
+                return syntax_error(ctx, "Expected number in array size");
+            }
 
-                if (curtok.type() == TokenType::Punctuator && std::get<Punctuator>(curtok.value()) == Punctuator::CloseBracket)
-                {
-                    field->arr_size() = std::numeric_limits<uint64_t>::max();
-                    goto skip_array_size;
-                }
+            if (!parse_integer(ctx, "array size", field->arr_size()))
+            {
+                return false;
+            }
+            tokens.pop();
 
-                if (curtok.type() != TokenType::NumberLiteral)
-                {
-                    throw SyntaxError("Expected number in array size");
-                    return false;
-                }
+            if (tokens.eof())
+            {
+                return syntax_error(ctx, "Expected closing bracket in array size");
+            }
 
-                field->arr_size() = std::stoi(std::get<std::string>(curtok.value()));
-                tokens.pop();
+            curtok = tokens.peek();
 
-                if (tokens.eof())
-                {
-                    throw SyntaxError("Expected closing bracket in array size");
-                    return false;
-                }
+            if (curtok.type() != TokenType::Punctuator || curtok.punctuator() != Punctuator::CloseBracket)
+            {
+                return syntax_error(ctx, "Expected closing bracket in array size");
+            }
 
-                curtok = tokens.peek();
+        skip_array_size:
 
-                if (curtok.type() != TokenType::Punctuator || std::get<Punctuator>(curtok.value()) != Punctuator::CloseBracket)
-                {
-                    throw SyntaxError("Expected closing bracket in array size");
-                    return false;
-                }
+            tokens.pop();
 
-            skip_array_size:
+            if (tokens.eof())
+            {
+                return syntax_error(ctx, "Expected seperator in struct field");
+            }
 
-                tokens.pop();
+            curtok = tokens.peek();
+        }
 
-                if (tokens.eof())
-                {
-                    throw SyntaxError("Expected seperator in struct field");
-                    return false;
-                }
+        if (curtok.type() == TokenType::Punctuator && curtok.punctuator() == Punctuator::Colon)
+        {
+            tokens.pop();
 
-                curtok = tokens.peek();
+            if (tokens.eof())
+            {
+                return syntax_error(ctx, "Expected bitfield in struct field");
             }
 
-            if (curtok.type() == TokenType::Punctuator && std::get<Punctuator>(curtok.value()) == Punctuator::Colon)
-            {
-                tokens.pop();
+            curtok = tokens.peek();
 
-                if (tokens.eof())
-                {
-                    throw SyntaxError("Expected bitfield in struct field");
-                    return false;
-                }
+            if (curtok.type() != TokenType::NumberLiteral)
+            {
+                return syntax_error(ctx, "Expected bitfield in struct field");
+            }
 
-                curtok = tokens.peek();
+            if (!parse_integer(ctx, "bitfield", field->bitfield()))
+            {
+                return false;
+            }
+            tokens.pop();
+        }
 
-                if (curtok.type() != TokenType::NumberLiteral)
-                {
-                    throw SyntaxError("Expected bitfield in struct field");
-                    return false;
-                }
+        if (tokens.eof())
+        {
+            return syntax_error(ctx, "Expected seperator in struct field");
+        }
 
-                field->bitfield() = std::stoi(std::get<std::string>(curtok.value()));
-                tokens.pop();
-            }
+        curtok = tokens.peek();
+        if (curtok.type() == TokenType::Operator && curtok.op() == Operator::Assign)
+        {
+            tokens.pop();
 
             if (tokens.eof())
             {
-                throw SyntaxError("Expected seperator in struct field");
-                return false;
+                return syntax_error(ctx, "Expected default value in struct field");
             }
 
             curtok = tokens.peek();
-            if (curtok.type() == TokenType::Operator && std::get<Operator>(curtok.value()) == Operator::Assign)
+
+            if (curtok.type() != TokenType::StringLiteral && curtok.type() != TokenType::NumberLiteral && curtok.type() != TokenType::FloatingPointLiteral && curtok.type() != TokenType::Identifier && curtok.type() != TokenType::Keyword)
             {
-                tokens.pop();
+                return syntax_error(ctx, "Expected default value in struct field");
+            }
 
-                if (tokens.eof())
+            switch (curtok.type())
+            {
+            case TokenType::StringLiteral:
+                field->default_value() = "\"" + std::string(curtok.text()) + "\"";
+                break;
+            case TokenType::NumberLiteral:
+                field->default_value() = curtok.text();
+                break;
+            case TokenType::FloatingPointLiteral:
+                field->default_value() = curtok.text();
+                break;
+            case TokenType::Identifier:
+                field->default_value() = curtok.text();
+                break;
+            case TokenType::Keyword:
+                if (is_builtin_type(curtok.keyword()))
                 {
-                    throw SyntaxError("Expected default value in struct field");
-                    return false;
+                    field->default_value() = lexKeywordMapReverse.at(curtok.keyword());
                 }
-
-                curtok = tokens.peek();
-
-                if (curtok.type() != TokenType::StringLiteral && curtok.type() != TokenType::NumberLiteral && curtok.type() != TokenType::FloatingPointLiteral && curtok.type() != TokenType::Identifier && curtok.type() != TokenType::Keyword)
+                else
                 {
-                    throw SyntaxError("Expected default value in struct field");
-                    return false;
+                    return syntax_error(ctx, "Expected default value in struct field");
                 }
+                break;
 
-                switch (curtok.type())
-                {
-                case TokenType::StringLiteral:
-                    field->default_value() = "\"" + std::get<std::string>(curtok.value()) + "\"";
-                    break;
-                case TokenType::NumberLiteral:
-                    field->default_value() = std::get<std::string>(curtok.value());
-                    break;
-                case TokenType::FloatingPointLiteral:
-                    field->default_value() = std::get<std::string>(curtok.value());
-                    break;
-                case TokenType::Identifier:
-                    field->default_value() = std::get<std::string>(curtok.value());
-                    break;
-                case TokenType::Keyword:
-                    if (is_builtin_type(lexKeywordMapReverse.at(std::get<Keyword>(curtok.value()))))
-                    {
-                        field->default_value() = lexKeywordMapReverse.at(std::get<Keyword>(curtok.value()));
-                    }
-                    else
-                    {
-                        throw SyntaxError("Expected default value in struct field");
-                        return false;
-                    }
-                    break;
-
-                default:
-                    break;
-                }
-                tokens.pop();
+            default:
+                break;
             }
-
-            fields.push_back(field);
-            field = std::make_shared<StructField>();
+            tokens.pop();
         }
-    }
 
-    node = std::make_shared<StructDefinition>(std::get<std::string>(next_1.value()), fields, functions, packed);
+        fields.push_back(field);
+        field = make_node<StructField>();
+    }
 
     return true;
 }
 
-static bool jcc::parse_union_keyword(jcc::TokenList &tokens, std::shared_ptr<jcc::GenericNode> &node, bool packed)
+static bool jcc::parse_union_keyword(jcc::ParseContext &ctx, jcc::GenericNode *&node, bool packed)
 {
+    TokenCursor &tokens = ctx.tokens;
+
     (void)packed;
     (void)node;
     if (tokens.size() < 2)
     {
-        throw SyntaxError("Expected identifier after union keyword");
-        return false;
+        return syntax_error(ctx, "Expected identifier after union keyword");
     }
 
     tokens.pop();
@@ -1703,111 +1431,111 @@ static bool jcc::parse_union_keyword(jcc::TokenList &tokens, std::shared_ptr<jcc
     Token curtok = tokens.peek();
     if (curtok.type() != TokenType::Identifier)
     {
-        throw SyntaxError("Expected identifier after union keyword");
-        return false;
+        return syntax_error(ctx, "Expected identifier after union keyword");
     }
-    std::string name = std::get<std::string>(curtok.value());
+    std::string name(curtok.text());
 
     tokens.pop();
     if (tokens.eof())
     {
-        node = std::make_shared<UnionDeclaration>(name);
+        node = make_node<UnionDeclaration>(name);
         return true;
     }
     curtok = tokens.peek();
-    if (curtok.type() != TokenType::Punctuator || std::get<Punctuator>(curtok.value()) != Punctuator::OpenBrace)
+    if (curtok.type() != TokenType::Punctuator || curtok.punctuator() != Punctuator::OpenBrace)
     {
-        node = std::make_shared<UnionDeclaration>(name);
+        node = make_node<UnionDeclaration>(name);
         return true;
     }
     tokens.pop();
 
-    std::vector<std::shared_ptr<UnionField>> fields;
+    NodeList<UnionField> fields;
 
     while (1)
     {
         if (tokens.eof())
         {
-            throw SyntaxError("Expected closing brace in union");
-            return false;
+            return syntax_error(ctx, "Expected closing brace in union");
         }
         std::string name;
+        size_t member = tokens.mark();
         curtok = tokens.peek();
-        if (curtok.type() == TokenType::Punctuator && std::get<Punctuator>(curtok.value()) == Punctuator::Semicolon)
+        if (curtok.type() == TokenType::Punctuator && curtok.punctuator() == Punctuator::Semicolon)
         {
             tokens.pop();
             continue;
         }
-        else if (curtok.type() == TokenType::Punctuator && std::get<Punctuator>(curtok.value()) == Punctuator::CloseBrace)
+        else if (curtok.type() == TokenType::Punctuator && curtok.punctuator() == Punctuator::CloseBrace)
         {
             tokens.pop();
             break;
         }
         else if (curtok.type() == TokenType::Identifier)
         {
-            name = std::get<std::string>(curtok.value());
+            name = curtok.text();
             tokens.pop();
         }
         else
         {
-            throw SyntaxError("Expected identifier in union field");
-            return false;
-        }
-        if (tokens.eof())
-        {
-            throw SyntaxError("Expected colon in union field");
-            return false;
+            syntax_error(ctx, "Expected identifier in union field");
+            synchronize(ctx, member);
+            continue;
         }
         curtok = tokens.peek();
-        if (curtok.type() != TokenType::Punctuator || std::get<Punctuator>(curtok.value()) != Punctuator::Colon)
+        if (curtok.type() != TokenType::Punctuator || curtok.punctuator() != Punctuator::Colon)
         {
-            throw SyntaxError("Expected colon in union field");
-            return false;
+            syntax_error(ctx, "Expected colon in union field");
+            synchronize(ctx, member);
+            continue;
         }
         tokens.pop();
 
-        std::shared_ptr<TypeNode> type;
-        if (!parse_type(tokens, true, true, true, type))
+        TypeNode *type = nullptr;
+        if (!parse_type(ctx, true, true, true, type))
         {
-            throw SyntaxError("Expected type in union field");
-            return false;
+            syntax_error(ctx, "Expected type in union field");
+            synchronize(ctx, member);
+            continue;
         }
-        fields.push_back(std::make_shared<UnionField>(name, type));
+        fields.push_back(make_node<UnionField>(name, type));
     }
 
-    node = std::make_shared<UnionDefinition>(name, fields);
+    node = make_node<UnionDefinition>(name, fields);
 
     return true;
 }
 
-static bool jcc::parse_class_keyword(jcc::TokenList &tokens, std::shared_ptr<jcc::GenericNode> &node)
+static bool jcc::parse_class_keyword(jcc::ParseContext &ctx, jcc::GenericNode *&node)
 {
-    (void)tokens;
     (void)node;
     /// TODO: implement this
-    return false;
+    return syntax_error(ctx, "Unsupported keyword: class");
 }
 
-static bool jcc::parse_enum_keyword(jcc::TokenList &tokens, std::shared_ptr<jcc::GenericNode> &node)
+static bool jcc::parse_enum_keyword(jcc::ParseContext &ctx, jcc::GenericNode *&node)
 {
-    (void)tokens;
     (void)node;
-    return false;
+    return syntax_error(ctx, "Unsupported keyword: enum");
 }
 
-static bool jcc::parse_typedef_keyword(jcc::TokenList &tokens, std::shared_ptr<jcc::GenericNode> &node)
+static bool jcc::parse_typedef_keyword(jcc::ParseContext &ctx, jcc::GenericNode *&node)
 {
-    (void)tokens;
     (void)node;
-    return false;
+    return syntax_error(ctx, "Unsupported keyword: typedef");
 }
 
-static bool jcc::parse_subsystem_keyword(jcc::TokenList &tokens, std::shared_ptr<jcc::GenericNode> &node)
+/// @brief Parse a subsystem declaration, or a definition up to the opening brace of its body
+/// @param tokens Token cursor at the `subsystem` keyword
+/// @param node Receives a SubsystemDeclaration
+/// @param body Receives the name and dependencies of a definition, whose body the caller parses
+/// @return true if successful
+static bool jcc::parse_subsystem_keyword(jcc::ParseContext &ctx, jcc::GenericNode *&node, OpenSubsystem &body)
 {
+    TokenCursor &tokens = ctx.tokens;
+
     if (tokens.size() < 3)
     {
-        throw SyntaxError("Expected identifier after subsystem keyword");
-        return false;
+        return syntax_error(ctx, "Expected identifier after subsystem keyword");
     }
 
     Token next_1 = tokens.peek(1);
@@ -1815,34 +1543,26 @@ static bool jcc::parse_subsystem_keyword(jcc::TokenList &tokens, std::shared_ptr
 
     if (next_1.type() != TokenType::Identifier)
     {
-        throw SyntaxError("Expected identifier after subsystem keyword");
-        return false;
+        return syntax_error(ctx, "Expected identifier after subsystem keyword");
     }
 
     if (next_2.type() != TokenType::Punctuator)
     {
-        node = std::make_shared<SubsystemDeclaration>(std::get<std::string>(next_1.value()));
+        node = make_node<SubsystemDeclaration>(std::string(next_1.text()));
         tokens.pop(2);
         return true;
     }
 
-    if (std::get<Punctuator>(next_2.value()) == Punctuator::OpenBrace)
+    if (next_2.punctuator() == Punctuator::OpenBrace)
     {
+        body.defined = true;
+        body.name = std::string(next_1.text());
         tokens.pop(2);
-        std::shared_ptr<GenericNode> block = std::make_shared<Block>();
-
-        if (!parse_block(tokens, block, false))
-        {
-            return false;
-        }
-
-        node = std::make_shared<SubsystemDefinition>(std::get<std::string>(next_1.value()), std::static_pointer_cast<Block>(block));
         return true;
     }
-    else if (std::get<Punctuator>(next_2.value()) != Punctuator::Colon)
+    else if (next_2.punctuator() != Punctuator::Colon)
     {
-        throw SyntaxError("Expected punctuator after subsystem identifier");
-        return false;
+        return syntax_error(ctx, "Expected punctuator after subsystem identifier");
     }
 
     tokens.pop(3);
@@ -1856,63 +1576,57 @@ static bool jcc::parse_subsystem_keyword(jcc::TokenList &tokens, std::shared_ptr
 
         if (curtok.type() != TokenType::Identifier)
         {
-            throw SyntaxError("Expected identifier in subsystem dependencies");
-            return false;
+            return syntax_error(ctx, "Expected identifier in subsystem dependencies");
         }
 
-        dependencies.push_back(std::get<std::string>(curtok.value()));
+        dependencies.push_back(std::string(curtok.text()));
 
         tokens.pop();
 
         if (tokens.eof())
         {
-            throw SyntaxError("Expected seperator in subsystem dependencies");
-            return false;
+            return syntax_error(ctx, "Expected seperator in subsystem dependencies");
         }
 
         curtok = tokens.peek();
 
-        if (curtok.type() == TokenType::Punctuator && std::get<Punctuator>(curtok.value()) == Punctuator::Comma)
+        if (curtok.type() == TokenType::Punctuator && curtok.punctuator() == Punctuator::Comma)
         {
             tokens.pop();
             continue;
         }
-        else if (curtok.type() == TokenType::Punctuator && std::get<Punctuator>(curtok.value()) == Punctuator::OpenBrace)
+        else if (curtok.type() == TokenType::Punctuator && curtok.punctuator() == Punctuator::OpenBrace)
         {
             break;
         }
         else
         {
             // done with declaration
-            node = std::make_shared<SubsystemDeclaration>(std::get<std::string>(next_1.value()), dependencies);
+            node = make_node<SubsystemDeclaration>(std::string(next_1.text()), dependencies);
             return true;
         }
     }
 
-    std::shared_ptr<GenericNode> block = std::make_shared<Block>();
-    if (!parse_block(tokens, block, false))
-    {
-        return false;
-    }
-
-    node = std::make_shared<SubsystemDefinition>(std::get<std::string>(next_1.value()), std::static_pointer_cast<Block>(block), dependencies);
+    body.defined = true;
+    body.name = std::string(next_1.text());
+    body.dependencies = std::move(dependencies);
     return true;
 }
 
-static bool jcc::parse_function_parameters(jcc::TokenList &tokens, std::vector<std::shared_ptr<jcc::FunctionParameter>> &params)
+static bool jcc::parse_function_parameters(jcc::ParseContext &ctx, jcc::NodeList<jcc::FunctionParameter> &params)
 {
+    TokenCursor &tokens = ctx.tokens;
+
     if (tokens.size() < 2)
     {
-        throw SyntaxError("Expected closing parenthesis in function parameters");
-        return false;
+        return syntax_error(ctx, "Expected closing parenthesis in function parameters");
     }
 
     Token curtok = tokens.peek();
 
-    if (curtok.type() != TokenType::Punctuator || std::get<Punctuator>(curtok.value()) != Punctuator::OpenParen)
+    if (curtok.type() != TokenType::Punctuator || curtok.punctuator() != Punctuator::OpenParen)
     {
-        throw SyntaxError("Expected opening parenthesis in function parameters");
-        return false;
+        return syntax_error(ctx, "Expected opening parenthesis in function parameters");
     }
     tokens.pop();
     curtok = tokens.peek();
@@ -1922,7 +1636,7 @@ static bool jcc::parse_function_parameters(jcc::TokenList &tokens, std::vector<s
     {
         Token curtok = tokens.peek();
 
-        if (curtok.type() == TokenType::Punctuator && std::get<Punctuator>(curtok.value()) == Punctuator::CloseParen)
+        if (curtok.type() == TokenType::Punctuator && curtok.punctuator() == Punctuator::CloseParen)
         {
             tokens.pop();
             is_looping = false;
@@ -1930,24 +1644,21 @@ static bool jcc::parse_function_parameters(jcc::TokenList &tokens, std::vector<s
         }
         if (curtok.type() != TokenType::Identifier)
         {
-            throw SyntaxError("Expected identifier in function parameter");
-            return false;
+            return syntax_error(ctx, "Expected identifier in function parameter");
         }
 
-        std::shared_ptr<FunctionParameter> parameter = std::make_shared<FunctionParameter>();
-        parameter->name() = std::get<std::string>(curtok.value());
+        FunctionParameter *parameter = make_node<FunctionParameter>();
+        parameter->name() = curtok.symbol();
 
         tokens.pop();
         if (tokens.eof())
         {
-            throw SyntaxError("Expected seperator in function parameter");
-            return false;
+            return syntax_error(ctx, "Expected seperator in function parameter");
         }
         curtok = tokens.peek();
-        if (curtok.type() != TokenType::Punctuator || std::get<Punctuator>(curtok.value()) != Punctuator::Colon)
+        if (curtok.type() != TokenType::Punctuator || curtok.punctuator() != Punctuator::Colon)
         {
-            throw SyntaxError("Expected seperator in function parameter");
-            return false;
+            return syntax_error(ctx, "Expected seperator in function parameter");
         }
         tokens.pop();
 
@@ -1957,20 +1668,18 @@ static bool jcc::parse_function_parameters(jcc::TokenList &tokens, std::vector<s
         {
             if (tokens.eof())
             {
-                throw SyntaxError("Expected seperator in function parameter");
-                return false;
+                return syntax_error(ctx, "Expected seperator in function parameter");
             }
             curtok = tokens.peek();
             if (curtok.type() != TokenType::Identifier && curtok.type() != TokenType::Keyword)
             {
-                throw SyntaxError("Expected type in function parameter type");
-                return false;
+                return syntax_error(ctx, "Expected type in function parameter type");
             }
 
             switch (curtok.type())
             {
             case TokenType::Identifier:
-                parameter->type() = std::get<std::string>(curtok.value());
+                parameter->type() = curtok.symbol();
                 tokens.pop();
                 state = 0;
                 break;
@@ -1979,7 +1688,7 @@ static bool jcc::parse_function_parameters(jcc::TokenList &tokens, std::vector<s
                 {
                     if (state == 2)
                     {
-                        if (std::get<Keyword>(curtok.value()) == Keyword::Const)
+                        if (curtok.keyword() == Keyword::Const)
                         {
                             parameter->is_const() = true;
                             tokens.pop();
@@ -1987,7 +1696,7 @@ static bool jcc::parse_function_parameters(jcc::TokenList &tokens, std::vector<s
                             continue;
                         }
 
-                        if (std::get<Keyword>(curtok.value()) == Keyword::Ref)
+                        if (curtok.keyword() == Keyword::Ref)
                         {
                             parameter->is_reference() = true;
                             parameter->is_const() = false;
@@ -1997,16 +1706,16 @@ static bool jcc::parse_function_parameters(jcc::TokenList &tokens, std::vector<s
                         }
                     }
 
-                    std::string tmp = lexKeywordMapReverse.at(std::get<Keyword>(curtok.value()));
-                    if (is_builtin_type(tmp))
+                    std::string tmp = lexKeywordMapReverse.at(curtok.keyword());
+                    if (is_builtin_type(curtok.keyword()))
                     {
                         if (tmp == "null")
                         {
-                            throw SyntaxError("Parameter type cannot be null");
+                            return syntax_error(ctx, "Parameter type cannot be null");
                         }
                         else if (tmp == "void")
                         {
-                            throw SyntaxError("Parameter type cannot be void");
+                            return syntax_error(ctx, "Parameter type cannot be void");
                         }
                         parameter->type() = tmp;
                         tokens.pop();
@@ -2015,8 +1724,7 @@ static bool jcc::parse_function_parameters(jcc::TokenList &tokens, std::vector<s
                     }
                     else
                     {
-                        throw SyntaxError("Expected type annotation in function parameter");
-                        return false;
+                        return syntax_error(ctx, "Expected type annotation in function parameter");
                     }
                 }
                 break;
@@ -2027,29 +1735,29 @@ static bool jcc::parse_function_parameters(jcc::TokenList &tokens, std::vector<s
         }
         if (tokens.eof())
         {
-            throw SyntaxError("Expected seperator in function declaration");
-            return false;
+            return syntax_error(ctx, "Expected seperator in function declaration");
         }
         curtok = tokens.peek();
 
         // check for array
-        if (curtok.type() == TokenType::Punctuator && std::get<Punctuator>(curtok.value()) == Punctuator::OpenBracket)
+        if (curtok.type() == TokenType::Punctuator && curtok.punctuator() == Punctuator::OpenBracket)
         {
             tokens.pop();
             if (tokens.eof())
             {
-                throw SyntaxError("Expected closing bracket in function parameter");
-                return false;
+                return syntax_error(ctx, "Expected closing bracket in function parameter");
             }
             curtok = tokens.peek();
             if (curtok.type() == TokenType::NumberLiteral)
             {
-                parameter->arr_size() = std::stoi(std::get<std::string>(curtok.value()));
+                if (!parse_integer(ctx, "array size", parameter->arr_size()))
+                {
+                    return false;
+                }
                 tokens.pop();
                 if (tokens.eof())
                 {
-                    throw SyntaxError("Expected closing bracket in function parameter");
-                    return false;
+                    return syntax_error(ctx, "Expected closing bracket in function parameter");
                 }
                 curtok = tokens.peek();
             }
@@ -2058,78 +1766,73 @@ static bool jcc::parse_function_parameters(jcc::TokenList &tokens, std::vector<s
                 parameter->arr_size() = std::numeric_limits<uint64_t>::max();
             }
 
-            if (curtok.type() == TokenType::Punctuator && std::get<Punctuator>(curtok.value()) == Punctuator::CloseBracket)
+            if (curtok.type() == TokenType::Punctuator && curtok.punctuator() == Punctuator::CloseBracket)
             {
                 tokens.pop();
             }
             else
             {
-                throw SyntaxError("Expected closing bracket in function parameter");
-                return false;
+                return syntax_error(ctx, "Expected closing bracket in function parameter");
             }
             if (tokens.eof())
             {
-                throw SyntaxError("Expected closing bracket in function parameter");
-                return false;
+                return syntax_error(ctx, "Expected closing bracket in function parameter");
             }
             curtok = tokens.peek();
         }
 
-        if (curtok.type() == TokenType::Operator && std::get<Operator>(curtok.value()) == Operator::Assign)
+        if (curtok.type() == TokenType::Operator && curtok.op() == Operator::Assign)
         {
             tokens.pop();
             if (tokens.eof())
             {
-                throw SyntaxError("Expected default value in function parameter");
-                return false;
+                return syntax_error(ctx, "Expected default value in function parameter");
             }
             curtok = tokens.peek();
             if (curtok.type() != TokenType::StringLiteral && curtok.type() != TokenType::NumberLiteral && curtok.type() != TokenType::FloatingPointLiteral && curtok.type() != TokenType::Identifier && curtok.type() != TokenType::Keyword && curtok.type() != TokenType::Punctuator)
             {
-                throw SyntaxError("Expected default value in function parameter");
-                return false;
+                return syntax_error(ctx, "Expected default value in function parameter");
             }
 
             switch (curtok.type())
             {
             case TokenType::StringLiteral:
-                parameter->default_value() = std::make_shared<StringLiteralExpression>(std::get<std::string>(curtok.value()));
+                parameter->default_value() = make_node<StringLiteralExpression>(std::string(curtok.text()));
                 break;
             case TokenType::NumberLiteral:
-                parameter->default_value() = std::make_shared<IntegerLiteralExpression>(std::get<std::string>(curtok.value()));
+                parameter->default_value() = make_node<IntegerLiteralExpression>(std::string(curtok.text()));
                 break;
             case TokenType::FloatingPointLiteral:
-                parameter->default_value() = std::make_shared<FloatingPointLiteralExpression>(std::get<std::string>(curtok.value()));
+                parameter->default_value() = make_node<FloatingPointLiteralExpression>(std::string(curtok.text()));
                 break;
             case TokenType::Identifier:
             {
-                std::shared_ptr<GenericNode> expr;
-                if (!parse_expression(tokens, expr))
+                GenericNode *expr = nullptr;
+                if (!parse_expression(ctx, expr))
                 {
                     return false;
                 }
-                parameter->default_value() = std::static_pointer_cast<Expression>(expr);
+                parameter->default_value() = static_cast<Expression *>(expr);
                 break;
             }
             case TokenType::Keyword:
-                if (std::get<Keyword>(curtok.value()) == Keyword::Null)
+                if (curtok.keyword() == Keyword::Null)
                 {
-                    parameter->default_value() = std::make_shared<NullExpression>();
+                    parameter->default_value() = make_node<NullExpression>();
                 }
                 else
                 {
-                    throw SyntaxError("Expected default value in function parameter");
-                    return false;
+                    return syntax_error(ctx, "Expected default value in function parameter");
                 }
                 break;
             default:
             {
-                std::shared_ptr<GenericNode> expr;
-                if (!parse_expression(tokens, expr))
+                GenericNode *expr = nullptr;
+                if (!parse_expression(ctx, expr))
                 {
                     return false;
                 }
-                parameter->default_value() = std::static_pointer_cast<Expression>(expr);
+                parameter->default_value() = static_cast<Expression *>(expr);
             }
             }
 
@@ -2139,7 +1842,7 @@ static bool jcc::parse_function_parameters(jcc::TokenList &tokens, std::vector<s
         params.push_back(parameter);
 
         curtok = tokens.peek();
-        if (curtok.type() == TokenType::Punctuator && std::get<Punctuator>(curtok.value()) == Punctuator::Comma)
+        if (curtok.type() == TokenType::Punctuator && curtok.punctuator() == Punctuator::Comma)
         {
             tokens.pop();
         }
@@ -2148,78 +1851,73 @@ static bool jcc::parse_function_parameters(jcc::TokenList &tokens, std::vector<s
     return true;
 }
 
-static bool jcc::parse_func_keyword(jcc::TokenList &tokens, std::shared_ptr<jcc::GenericNode> &node, jcc::FunctionParseMode mode)
+static bool jcc::parse_func_keyword(jcc::ParseContext &ctx, jcc::GenericNode *&node, jcc::FunctionParseMode mode)
 {
+    TokenCursor &tokens = ctx.tokens;
+
     // func name ([[name:type[=default]]...]) [-> return_type] [block]
 
     if (tokens.size() < 4)
     {
-        throw SyntaxError("Expected identifier after func keyword");
-        return false;
+        return syntax_error(ctx, "Expected identifier after func keyword");
     }
 
     Token next_1 = tokens.peek(1);
-    Token next_2 = tokens.peek(2);
 
     if (next_1.type() != TokenType::Identifier)
     {
-        throw SyntaxError("Expected identifier after func keyword");
-        return false;
+        return syntax_error(ctx, "Expected identifier after func keyword");
     }
 
     // parse parameters
-    std::vector<std::shared_ptr<FunctionParameter>> parameters;
+    NodeList<FunctionParameter> parameters;
 
     tokens.pop(2);
 
-    if (!parse_function_parameters(tokens, parameters))
+    if (!parse_function_parameters(ctx, parameters))
     {
         return false;
     }
 
     if (tokens.eof())
     {
-        throw SyntaxError("Expected seperator in function declaration");
-        return false;
+        return syntax_error(ctx, "Expected seperator in function declaration");
     }
 
     Token curtok = tokens.peek();
     std::string return_type;
     uint64_t return_arr_size = 0;
 
-    if (curtok.type() == TokenType::Punctuator && std::get<Punctuator>(curtok.value()) == Punctuator::Colon)
+    if (curtok.type() == TokenType::Punctuator && curtok.punctuator() == Punctuator::Colon)
     {
         tokens.pop();
         if (tokens.eof())
         {
-            throw SyntaxError("Expected colon in function declaration");
-            return false;
+            return syntax_error(ctx, "Expected colon in function declaration");
         }
         curtok = tokens.peek();
 
         // parse return type
         if (tokens.eof())
         {
-            throw SyntaxError("Expected return type in function declaration");
-            return false;
+            return syntax_error(ctx, "Expected return type in function declaration");
         }
         curtok = tokens.peek();
 
         if (curtok.type() != TokenType::Identifier && curtok.type() != TokenType::Keyword)
         {
-            throw SyntaxError("Expected return type in function declaration");
-            return false;
+            return syntax_error(ctx, "Expected return type in function declaration");
         }
 
         if (curtok.type() == TokenType::Identifier)
         {
-            return_type = std::get<std::string>(curtok.value());
+            return_type = curtok.text();
         }
         else if (curtok.type() == TokenType::Keyword)
         {
-            if (is_builtin_type(lexKeywordMapReverse.at(std::get<Keyword>(curtok.value()))))
+            if (is_builtin_type(curtok.keyword()))
             {
-                return_type = lexKeywordMapReverse.at(std::get<Keyword>(curtok.value()));
+                return_type = lexKeywordMapReverse.at(curtok.keyword());
                 if (return_type == "null")
                 {
                     return_type = "";
@@ -2227,8 +1925,7 @@ static bool jcc::parse_func_keyword(jcc::TokenList &tokens, std::shared_ptr<jcc:
             }
             else
             {
-                throw SyntaxError("Expected return type in function declaration");
-                return false;
+                return syntax_error(ctx, "Expected return type in function declaration");
             }
         }
         tokens.pop();
@@ -2236,27 +1933,27 @@ static bool jcc::parse_func_keyword(jcc::TokenList &tokens, std::shared_ptr<jcc:
         // check for array
         if (tokens.eof())
         {
-            throw SyntaxError("Expected token in function parameter");
-            return false;
+            return syntax_error(ctx, "Expected token in function parameter");
         }
         curtok = tokens.peek();
-        if (curtok.type() == TokenType::Punctuator && std::get<Punctuator>(curtok.value()) == Punctuator::OpenBracket)
+        if (curtok.type() == TokenType::Punctuator && curtok.punctuator() == Punctuator::OpenBracket)
         {
             tokens.pop();
             if (tokens.eof())
             {
-                throw SyntaxError("Expected closing bracket in function parameter");
-                return false;
+                return syntax_error(ctx, "Expected closing bracket in function parameter");
             }
             curtok = tokens.peek();
             if (curtok.type() == TokenType::NumberLiteral)
             {
-                return_arr_size = std::stoi(std::get<std::string>(curtok.value()));
+                if (!parse_integer(ctx, "array size", return_arr_size))
+                {
+                    return false;
+                }
                 tokens.pop();
                 if (tokens.eof())
                 {
-                    throw SyntaxError("Expected closing bracket in function parameter");
-                    return false;
+                    return syntax_error(ctx, "Expected closing bracket in function parameter");
                 }
                 curtok = tokens.peek();
             }
@@ -2265,27 +1962,25 @@ static bool jcc::parse_func_keyword(jcc::TokenList &tokens, std::shared_ptr<jcc:
                 return_arr_size = std::numeric_limits<uint64_t>::max();
             }
 
-            if (curtok.type() == TokenType::Punctuator && std::get<Punctuator>(curtok.value()) == Punctuator::CloseBracket)
+            if (curtok.type() == TokenType::Punctuator && curtok.punctuator() == Punctuator::CloseBracket)
             {
                 tokens.pop();
             }
             else
             {
-                throw SyntaxError("Expected closing bracket in function parameter");
-                return false;
+                return syntax_error(ctx, "Expected closing bracket in function parameter");
             }
             if (tokens.eof())
             {
-                throw SyntaxError("Expected closing bracket in function parameter");
-                return false;
+                return syntax_error(ctx, "Expected closing bracket in function parameter");
             }
             curtok = tokens.peek();
         }
     }
-    else if (curtok.type() != TokenType::Punctuator || std::get<Punctuator>(curtok.value()) != Punctuator::OpenBrace)
+    else if (curtok.type() != TokenType::Punctuator || curtok.punctuator() != Punctuator::OpenBrace)
     {
         return_type = "void"; // implicit void return type
-        std::shared_ptr<FunctionDeclaration> func_ptr = std::make_shared<FunctionDeclaration>(std::get<std::string>(next_1.value()), return_type, parameters, return_arr_size);
+        FunctionDeclaration *func_ptr = make_node<FunctionDeclaration>(std::string(next_1.text()), return_type, parameters, return_arr_size);
         node = func_ptr;
 
         return true;
@@ -2297,188 +1992,863 @@ static bool jcc::parse_func_keyword(jcc::TokenList &tokens, std::shared_ptr<jcc:
 
     if (tokens.eof())
     {
-        throw SyntaxError("Expected opening brace in function declaration");
-        return false;
+        return syntax_error(ctx, "Expected opening brace in function declaration");
     }
 
     curtok = tokens.peek();
 
-    if (curtok.type() != TokenType::Punctuator || std::get<Punctuator>(curtok.value()) != Punctuator::OpenBrace)
+    if (curtok.type() != TokenType::Punctuator || curtok.punctuator() != Punctuator::OpenBrace)
     {
         if (mode != FunctionParseMode::DeclarationOnly && mode != FunctionParseMode::DeclarationOrDefinition)
         {
-            throw SyntaxError("Function definition expected but only declaration found");
-            return false;
+            return syntax_error(ctx, "Function definition expected but only declaration found");
         }
 
-        node = std::make_shared<FunctionDeclaration>(std::get<std::string>(next_1.value()), return_type, parameters, return_arr_size);
+        node = make_node<FunctionDeclaration>(std::string(next_1.text()), return_type, parameters, return_arr_size);
     }
     else
     {
         if (mode != FunctionParseMode::DefinitionOnly && mode != FunctionParseMode::DeclarationOrDefinition)
         {
-            throw SyntaxError("Function declaration expected but definition found");
-            return false;
+            return syntax_error(ctx, "Function declaration expected but definition found");
         }
-        std::shared_ptr<GenericNode> block = std::make_shared<Block>();
+        GenericNode *block = nullptr;
+        SourceRange body;
 
-        if (!parse_block(tokens, block, true))
+        if (ctx.skim ? !skip_body(ctx, body) : !parse_block(ctx, block, true))
         {
             return false;
         }
 
-        node = std::make_shared<FunctionDefinition>(std::get<std::string>(next_1.value()), return_type, parameters, std::static_pointer_cast<Block>(block), return_arr_size);
+        FunctionDefinition *function = make_node<FunctionDefinition>(std::string(next_1.text()), return_type, parameters, static_cast<Block *>(block), return_arr_size);
+        function->skipped_body() = body;
+        node = function;
     }
 
     return true;
 }
 
-static bool jcc::parse_return_keyword(jcc::TokenList &tokens, std::shared_ptr<jcc::GenericNode> &node)
+static bool jcc::parse_return_keyword(jcc::ParseContext &ctx, jcc::GenericNode *&node)
 {
+    TokenCursor &tokens = ctx.tokens;
+
     if (tokens.size() < 1)
     {
-        throw SyntaxError("Expected return value after return keyword");
-        return false;
+        return syntax_error(ctx, "Expected return value after return keyword");
     }
 
     tokens.pop();
 
     if (tokens.eof())
     {
-        node = std::make_shared<ReturnStatement>(nullptr);
+        node = make_node<ReturnStatement>(nullptr);
         return true;
     }
 
-    std::shared_ptr<GenericNode> expr;
-    if (!parse_expression(tokens, expr))
+    GenericNode *expr = nullptr;
+    if (!parse_expression(ctx, expr))
     {
-        node = std::make_shared<ReturnStatement>(nullptr);
+        node = make_node<ReturnStatement>(nullptr);
     }
     else
     {
-        node = std::make_shared<ReturnStatement>(std::static_pointer_cast<Expression>(expr));
+        node = make_node<ReturnStatement>(static_cast<Expression *>(expr));
     }
 
     return true;
 }
 
-std::map<std::string, uint32_t> operator_precedence = {
-    {"++", 13},
-    {"--", 13},
-    {"+=", 13},
-    {"-=", 13},
-    {"*=", 13},
-    {"/=", 13},
-    {"%=", 13},
-    {"^^=", 13},
-    {"||=", 13},
-    {"&&=", 13},
-    {"<<=", 13},
-    {">>=", 13},
-    {">>>=", 13},
-    {"|=", 13},
-    {"&=", 13},
-    {"^=", 13},
-    {"<<", 12},
-    {">>", 12},
-    {"==", 11},
-    {"!=", 11},
-    {"&&", 10},
-    {"||", 9},
-    {"^^", 8},
-    {"<=", 7},
-    {">=", 7},
-    {"<", 7},
-    {">", 7},
-    {"=", 6},
-    {"??", 5},
-    {"@", 5},
-    {"//", 4},
-    {"+", 3},
-    {"-", 3},
-    {"*", 3},
-    {"/", 3},
-    {"%", 3},
-    {"&", 2},
-    {"|", 2},
-    {"^", 2},
-    {"~", 2},
-    {"!", 2},
-    {"?", 1},
-    {"#", 1},
-    {".", 1},
-    {",", 1},
-    // Add other custom operators here with their respective precedence
+///=============================================================================
+/// Expressions
+///
+/// Expressions are parsed by precedence climbing (a Pratt parser). The binding
+/// powers of every operator come from `operatorBindingTable`, which is indexed
+/// directly by `jcc::Operator`, so no spelling is looked up while parsing.
+///=============================================================================
+
+/// @brief Expression precedence levels, loosest first
+enum ExpressionPrecedence : uint8_t
+{
+    PrecNone = 0,
+    PrecAssign,
+    PrecTernary,
+    PrecNullCoalesce,
+    PrecOr,
+    PrecXor,
+    PrecAnd,
+    PrecBitwiseOr,
+    PrecBitwiseXor,
+    PrecBitwiseAnd,
+    PrecEquality,
+    PrecRelational,
+    PrecShift,
+    PrecAdditive,
+    PrecMultiplicative,
+    PrecCast,
+    PrecPrefix,
+    PrecPostfix,
 };
 
-static bool jcc::parse_expression_helper(jcc::TokenList &tokens, jcc::ExpNode &output)
+/// @brief How an operator binds in each position; PrecNone if it cannot appear there
+struct OperatorBinding
 {
-    /// TODO: implement this
-    (void)tokens;
-    output = ExpNode(Token(TokenType::NumberLiteral, ""), {});
+    uint8_t infix = PrecNone;
+    uint8_t prefix = PrecNone;
+    uint8_t postfix = PrecNone;
+    bool right_assoc = false;
+};
 
-    tokens.pop();
+constexpr std::size_t operatorCount = static_cast<std::size_t>(jcc::Operator::Ternary) + 1;
 
-    return true;
+static constexpr jcc::EnumTable<jcc::Operator, OperatorBinding, operatorCount> build_operator_binding_table()
+{
+    using jcc::Operator;
+
+    jcc::EnumTable<Operator, OperatorBinding, operatorCount> table{};
+    auto infix = [&table](Operator op, uint8_t prec, bool right_assoc = false)
+    {
+        table.m_values[static_cast<std::size_t>(op)].infix = prec;
+        table.m_values[static_cast<std::size_t>(op)].right_assoc = right_assoc;
+    };
+
+    for (auto op : {Operator::Assign, Operator::PlusEquals, Operator::MinusEquals, Operator::TimesEquals, Operator::FloatingDivideEquals, Operator::ModulusEquals,
+                    Operator::XorEquals, Operator::OrEquals, Operator::AndEquals, Operator::LeftShiftEquals, Operator::ArithmeticRightShiftEquals,
+                    Operator::UnsignedRightShiftEquals, Operator::BitwiseOrEquals, Operator::BitwiseAndEquals, Operator::BitwiseXorEquals})
+    {
+        infix(op, PrecAssign, true);
+    }
+
+    infix(Operator::Ternary, PrecTernary, true);
+    infix(Operator::NullCoalesce, PrecNullCoalesce, true);
+    infix(Operator::Or, PrecOr);
+    infix(Operator::Xor, PrecXor);
+    infix(Operator::And, PrecAnd);
+    infix(Operator::BitwiseOr, PrecBitwiseOr);
+    infix(Operator::BitwiseXor, PrecBitwiseXor);
+    infix(Operator::BitwiseAnd, PrecBitwiseAnd);
+    infix(Operator::Equals, PrecEquality);
+    infix(Operator::NotEquals, PrecEquality);
+    infix(Operator::LessThan, PrecRelational);
+    infix(Operator::LessThanOrEqual, PrecRelational);
+    infix(Operator::GreaterThan, PrecRelational);
+    infix(Operator::GreaterThanOrEqual, PrecRelational);
+    infix(Operator::LeftShift, PrecShift);
+    infix(Operator::RightShift, PrecShift);
+    infix(Operator::ArithmeticRightShift, PrecShift);
+    infix(Operator::Plus, PrecAdditive);
+    infix(Operator::Minus, PrecAdditive);
+    infix(Operator::Times, PrecMultiplicative);
+    infix(Operator::FloatingDivide, PrecMultiplicative);
+    infix(Operator::FloorDivide, PrecMultiplicative);
+    infix(Operator::Modulus, PrecMultiplicative);
+    infix(Operator::At, PrecMultiplicative);
+
+    for (auto op : {Operator::Plus, Operator::Minus, Operator::Not, Operator::BitwiseNot, Operator::Increment, Operator::Decrement})
+    {
+        table.m_values[static_cast<std::size_t>(op)].prefix = PrecPrefix;
+    }
+
+    for (auto op : {Operator::Increment, Operator::Decrement})
+    {
+        table.m_values[static_cast<std::size_t>(op)].postfix = PrecPostfix;
+    }
+
+    return table;
 }
 
-static bool jcc::parse_expression(jcc::TokenList &tokens, std::shared_ptr<jcc::GenericNode> &node)
+static constexpr jcc::EnumTable<jcc::Operator, OperatorBinding, operatorCount> operatorBindingTable = build_operator_binding_table();
+
+/// @brief `expr as type` is spelled with an identifier, not a keyword
+static const jcc::Symbol castSymbol("as");
+static const jcc::Symbol trueSymbol("true");
+static const jcc::Symbol falseSymbol("false");
+
+/// @brief Report an expression nested more than `max_nesting` levels deep
+/// @return false, so a parse function can `return expression_too_deep(...)`
+static bool jcc::expression_too_deep(jcc::ParseContext &ctx)
 {
-    ExpNode output;
-    parse_expression_helper(tokens, output);
+    return syntax_error(ctx, "Expression nested more than " + std::to_string(ctx.max_nesting) + " levels deep");
+}
+
+/// @brief Parse a literal, identifier, call, parenthesized or prefix expression
+/// @param height Receives the height of the parsed tree
+static bool jcc::parse_expression_operand(jcc::ParseContext &ctx, jcc::Expression *&node, size_t &height)
+{
+    TokenCursor &tokens = ctx.tokens;
+
+    height = 1;
+
+    if (tokens.eof())
+    {
+        return syntax_error(ctx, "Expected expression");
+    }
+
+    // the offending token is left unconsumed on error, so recovery can resume at it
+    size_t start = tokens.mark();
+    Token curtok = tokens.next();
+
+    switch (curtok.type())
+    {
+    case TokenType::NumberLiteral:
+        node = make_node<IntegerLiteralExpression>(std::string(curtok.text()));
+        return true;
+    case TokenType::FloatingPointLiteral:
+        node = make_node<FloatingPointLiteralExpression>(std::string(curtok.text()));
+        return true;
+    case TokenType::StringLiteral:
+        node = make_node<StringLiteralExpression>(std::string(curtok.text()));
+        return true;
+    case TokenType::Keyword:
+        if (curtok.keyword() == Keyword::Null)
+        {
+            node = make_node<NullExpression>();
+            return true;
+        }
+        tokens.rewind(start);
+        return syntax_error(ctx, "Unexpected keyword in expression: " + std::string(lexKeywordMapReverse.at(curtok.keyword())));
+    case TokenType::Identifier:
+    {
+        Symbol name = curtok.symbol();
+        if (name == trueSymbol || name == falseSymbol)
+        {
+            node = make_node<BooleanLiteralExpression>(std::string(name.str()));
+            return true;
+        }
+
+        if (tokens.eof() || tokens.peek().type() != TokenType::Punctuator || tokens.peek().punctuator() != Punctuator::OpenParen)
+        {
+            node = make_node<IdentifierExpression>(name);
+            return true;
+        }
+
+        // function call
+        tokens.pop();
+        NodeList<Expression> arguments;
+        while (true)
+        {
+            if (tokens.eof())
+            {
+                return syntax_error(ctx, "Expected closing parenthesis for function call");
+            }
+
+            curtok = tokens.peek();
+            if (curtok.type() == TokenType::Punctuator && curtok.punctuator() == Punctuator::CloseParen)
+            {
+                tokens.pop();
+                break;
+            }
+
+            if (!arguments.empty())
+            {
+                if (curtok.type() != TokenType::Punctuator || curtok.punctuator() != Punctuator::Comma)
+                {
+                    return syntax_error(ctx, "Expected comma between function call arguments");
+                }
+                tokens.pop();
+            }
+
+            Expression *argument = nullptr;
+            size_t argument_height = 0;
+            if (!parse_expression_prec(ctx, PrecAssign, argument, argument_height))
+            {
+                return false;
+            }
+            arguments.push_back(argument);
+            height = std::max(height, argument_height + 1);
+        }
+
+        if (height > ctx.max_nesting)
+        {
+            return expression_too_deep(ctx);
+        }
+
+        node = make_node<CallExpression>(std::string(name.str()), arguments);
+        return true;
+    }
+    case TokenType::Punctuator:
+        if (curtok.punctuator() == Punctuator::OpenParen)
+        {
+            if (!parse_expression_prec(ctx, PrecAssign, node, height))
+            {
+                return false;
+            }
+
+            if (tokens.eof() || tokens.peek().type() != TokenType::Punctuator || tokens.peek().punctuator() != Punctuator::CloseParen)
+            {
+                return syntax_error(ctx, "Expected closing parenthesis in expression");
+            }
+            tokens.pop();
+            return true;
+        }
+        tokens.rewind(start);
+        return syntax_error(ctx, "Unexpected punctuator in expression: " + std::string(lexPunctuatorMapReverse.at(curtok.punctuator())));
+    case TokenType::Operator:
+    {
+        uint8_t prec = operatorBindingTable.at(curtok.op()).prefix;
+        if (prec == PrecNone)
+        {
+            tokens.rewind(start);
+            return syntax_error(ctx, "Unexpected operator in expression: " + std::string(lexOperatorMapReverse.at(curtok.op())));
+        }
+
+        Expression *operand = nullptr;
+        if (!parse_expression_prec(ctx, prec, operand, height))
+        {
+            return false;
+        }
+
+        if (++height > ctx.max_nesting)
+        {
+            return expression_too_deep(ctx);
+        }
+
+        node = make_node<UnaryExpression>(curtok.op(), operand);
+        return true;
+    }
+    default:
+        tokens.rewind(start);
+        return syntax_error(ctx, "Expected expression");
+    }
+}
+
+/// @brief Parse an expression whose operators bind at least as tightly as `min_prec`
+/// @param height Receives the height of the parsed tree
+/// @note Every nested expression passes through here, so this is where the
+/// recursion is bounded: no more than `max_nesting` calls are active at once,
+/// and no tree is made taller than `max_nesting` nodes, which is what lets the
+/// printers and the generator walk expressions recursively.
+static bool jcc::parse_expression_prec(jcc::ParseContext &ctx, uint8_t min_prec, jcc::Expression *&node, size_t &height)
+{
+    if (ctx.depth >= ctx.max_nesting)
+    {
+        return expression_too_deep(ctx);
+    }
+
+    ctx.depth++;
+    bool ok = parse_expression_climb(ctx, min_prec, node, height);
+    ctx.depth--;
+
+    return ok;
+}
+
+static bool jcc::parse_expression_climb(jcc::ParseContext &ctx, uint8_t min_prec, jcc::Expression *&node, size_t &height)
+{
+    TokenCursor &tokens = ctx.tokens;
+
+    Expression *left = nullptr;
+    if (!parse_expression_operand(ctx, left, height))
+    {
+        return false;
+    }
+
+    while (!tokens.eof())
+    {
+        Token curtok = tokens.peek();
+
+        if (curtok.type() == TokenType::Identifier && curtok.symbol() == castSymbol)
+        {
+            if (PrecCast < min_prec)
+            {
+                break;
+            }
+            tokens.pop();
+
+            if (tokens.eof())
+            {
+                return syntax_error(ctx, "Expected typename after 'as'");
+            }
+
+            curtok = tokens.next();
+            Symbol type;
+            if (curtok.type() == TokenType::Identifier)
+            {
+                type = curtok.symbol();
+            }
+            else if (curtok.type() == TokenType::Keyword && is_builtin_type(curtok.keyword()))
+            {
+                type = Symbol(lexKeywordMapReverse.at(curtok.keyword()));
+            }
+            else
+            {
+                return syntax_error(ctx, "Expected typename after 'as'");
+            }
+
+            if (++height > ctx.max_nesting)
+            {
+                return expression_too_deep(ctx);
+            }
+
+            left = make_node<CastExpression>(type, left);
+            continue;
+        }
+
+        if (curtok.type() != TokenType::Operator)
+        {
+            break;
+        }
+
+        Operator op = curtok.op();
+        const OperatorBinding &binding = operatorBindingTable.at(op);
 
-    auto item = std::make_shared<LiteralExpression>(std::get<std::string>(output.value.value()));
+        if (binding.postfix != PrecNone)
+        {
+            if (binding.postfix < min_prec)
+            {
+                break;
+            }
+            tokens.pop();
+
+            if (++height > ctx.max_nesting)
+            {
+                return expression_too_deep(ctx);
+            }
+
+            left = make_node<UnaryExpression>(op, left, true);
+            continue;
+        }
 
-    node = std::static_pointer_cast<GenericNode>(item);
+        if (binding.infix == PrecNone || binding.infix < min_prec)
+        {
+            break;
+        }
+
+        // reserved: `@` is bound so that it is reported here, but has no meaning yet
+        if (op == Operator::At)
+        {
+            return syntax_error(ctx, "Unsupported operator: @");
+        }
+        tokens.pop();
+
+        // a right associative operator lets an operator of the same level bind its right operand
+        uint8_t next_prec = binding.right_assoc ? binding.infix : binding.infix + 1;
+
+        if (op == Operator::Ternary)
+        {
+            Expression *then_expression = nullptr, *else_expression = nullptr;
+            size_t then_height = 0, else_height = 0;
+            if (!parse_expression_prec(ctx, PrecAssign, then_expression, then_height))
+            {
+                return false;
+            }
+
+            if (tokens.eof() || tokens.peek().type() != TokenType::Punctuator || tokens.peek().punctuator() != Punctuator::Colon)
+            {
+                return syntax_error(ctx, "Expected colon in ternary expression");
+            }
+            tokens.pop();
+
+            if (!parse_expression_prec(ctx, next_prec, else_expression, else_height))
+            {
+                return false;
+            }
+
+            height = std::max({height, then_height, else_height}) + 1;
+            if (height > ctx.max_nesting)
+            {
+                return expression_too_deep(ctx);
+            }
+
+            left = make_node<TernaryExpression>(left, then_expression, else_expression);
+            continue;
+        }
+
+        Expression *right = nullptr;
+        size_t right_height = 0;
+        if (!parse_expression_prec(ctx, next_prec, right, right_height))
+        {
+            return false;
+        }
+
+        height = std::max(height, right_height) + 1;
+        if (height > ctx.max_nesting)
+        {
+            return expression_too_deep(ctx);
+        }
+
+        left = make_node<BinaryExpression>(op, left, right);
+    }
+
+    node = left;
+
+    return true;
+}
+
+static bool jcc::parse_expression(jcc::ParseContext &ctx, jcc::GenericNode *&node)
+{
+    Expression *expression = nullptr;
+    size_t height = 0;
+    if (!parse_expression_prec(ctx, PrecAssign, expression, height))
+    {
+        return false;
+    }
+
+    node = expression;
 
     return true;
 }
 
 std::shared_ptr<jcc::AbstractSyntaxTree> jcc::CompilationUnit::parse(const jcc::TokenList &tokens)
 {
-    TokenList tokens_copy = tokens;
+    TokenCursor cursor(tokens);
 
-    // remove whitespace and comments
-    auto shouldRemove = [](const Token &token)
+    return parse(cursor);
+}
+
+std::shared_ptr<jcc::AbstractSyntaxTree> jcc::CompilationUnit::parse(jcc::TokenCursor &tokens)
+{
+    std::vector<ParserDiagnostic> diagnostics;
+
+    std::shared_ptr<AbstractSyntaxTree> ast = parse(tokens, diagnostics);
+
+    if (!diagnostics.empty())
     {
-        return token.type() == TokenType::Whitespace ||
-               token.type() == TokenType::SingleLineComment ||
-               token.type() == TokenType::MultiLineComment;
-    };
+        SyntaxError error(diagnostics.front().message);
+        error.location() = diagnostics.front().location;
+        throw error;
+    }
+
+    return ast;
+}
 
-    // Use remove_if along with erase to remove elements matching the condition
-    tokens_copy.m_tokens.erase(std::remove_if(tokens_copy.m_tokens.begin(), tokens_copy.m_tokens.end(), shouldRemove), tokens_copy.m_tokens.end());
+/// @brief Sources with fewer tokens than this per available thread are parsed sequentially
+constexpr size_t parseParallelMinTokens = 1 << 16;
 
-    std::shared_ptr<GenericNode> rootnode;
+/// @brief Find the top-level declarations a token range can be split at
+/// @param tokens Token cursor; only the tokens after it are scanned
+/// @return Marks of the `subsystem`, `struct`, `region`, `packet`, `union` and
+/// `func` keywords outside of any braces, or nothing if the braces do not balance
+static std::vector<size_t> find_top_level_declarations(const jcc::TokenCursor &tokens)
+{
+    using namespace jcc;
 
-    // reuse parse block code by
-    // wrapping source in a block
-    // and parsing it
-    // tokens array is reversed
-    tokens_copy.m_tokens.insert(tokens_copy.m_tokens.begin(), Token(TokenType::Punctuator, Punctuator::CloseBrace));
-    tokens_copy.m_tokens.push_back(Token(TokenType::Punctuator, Punctuator::OpenBrace));
+    std::vector<size_t> marks;
+    size_t depth = 0;
 
-    if (!parse_block(tokens_copy, rootnode, false))
+    for (size_t i = 0; i < tokens.size(); i++)
     {
-        return nullptr;
+        Token tok = tokens.peek(i);
+
+        if (tok.type() == TokenType::Punctuator)
+        {
+            if (tok.punctuator() == Punctuator::OpenBrace)
+            {
+                depth++;
+            }
+            else if (tok.punctuator() == Punctuator::CloseBrace)
+            {
+                if (depth == 0)
+                {
+                    return {};
+                }
+                depth--;
+            }
+        }
+        else if (tok.type() == TokenType::Keyword && depth == 0)
+        {
+            switch (tok.keyword())
+            {
+            case Keyword::Subsystem:
+            case Keyword::Struct:
+            case Keyword::Region:
+            case Keyword::Packet:
+            case Keyword::Union:
+            case Keyword::Func:
+                marks.push_back(tokens.mark() + i);
+                break;
+            default:
+                break;
+            }
+        }
+    }
+
+    if (depth != 0)
+    {
+        return {};
     }
 
-    if (rootnode->type() != NodeType::Block)
+    return marks;
+}
+
+/// @brief Changed top-level declarations parsed together on one thread
+struct ParseChunk
+{
+    std::vector<size_t> spans;
+    jcc::AstArena arena;
+    std::vector<jcc::ParserDiagnostic> diagnostics;
+    std::exception_ptr error;
+};
+
+/// @brief Parse the top-level declarations of a chunk, each on its own
+/// @param tokens Token cursor over the whole source
+/// @param cuts Mark of the first token of each span, then the end mark
+/// @param chunk Spans to parse; receives their nodes and syntax errors
+/// @param blocks Receives the block of statements of each span parsed
+/// @param clean Receives whether each span parsed without syntax errors
+/// @param skim Whether to skip function and method bodies
+/// @param max_nesting How deeply subsystems and expressions may nest
+static void parse_chunk(const jcc::TokenCursor &tokens, const std::vector<size_t> &cuts, ParseChunk &chunk, std::vector<jcc::GenericNode *> &blocks, std::vector<char> &clean, bool skim, size_t max_nesting)
+{
+    using namespace jcc;
+
+    for (size_t span : chunk.spans)
+    {
+        TokenCursor cursor(tokens, cuts[span], cuts[span + 1]);
+        ParseContext ctx(cursor, chunk.arena, chunk.diagnostics, skim, max_nesting);
+        size_t errors = chunk.diagnostics.size();
+
+        // the span is parsed as the body of a block without braces
+        parse_structural_block(ctx, blocks[span], true);
+
+        clean[span] = blocks[span] != nullptr && chunk.diagnostics.size() == errors;
+    }
+}
+
+/// @brief Parse the tokens after a cursor, taking unchanged top-level declarations from a previous tree
+/// @param tokens Token cursor to consume
+/// @param previous Tree of an earlier version of the source, or nullptr
+/// @param diagnostics Receives every syntax error, in source order
+/// @param skimmed The cursor itself, owned, to skip function bodies; nullptr to parse them
+/// @param max_nesting How deeply subsystems and expressions may nest
+/// @param threads Number of threads, or 0 for one per `parseParallelMinTokens`
+/// tokens to parse, up to the number of cores
+/// @return Abstract syntax tree
+/// @note The source is cut into spans at its top-level declarations, found
+/// by brace matching. A span whose bytes match a clean span of the previous
+/// tree (by hash, then by content) takes that span's nodes as they are,
+/// unless its arena has aged out (see `parseMaxRetainedVersions`); the
+/// others are parsed, in parallel when there are enough tokens to, each
+/// thread into its own arena adopted by the tree afterwards. The root block
+/// and the diagnostics are assembled in source order.
+static std::shared_ptr<jcc::AbstractSyntaxTree> parse_spans(jcc::TokenCursor &tokens, const std::shared_ptr<jcc::AbstractSyntaxTree> &previous, std::vector<jcc::ParserDiagnostic> &diagnostics, std::shared_ptr<const jcc::TokenCursor> skimmed, size_t max_nesting, size_t threads)
+{
+    using namespace jcc;
+
+    bool skim = skimmed != nullptr;
+
+    // every node parsed for the unit is allocated in the tree's arena
+    std::shared_ptr<AstArena> arena = std::make_shared<AstArena>();
+    AstArena::Scope scope(*arena);
+
+    size_t begin = tokens.mark();
+    size_t total = tokens.size();
+
+    std::vector<size_t> cuts = find_top_level_declarations(tokens);
+    if (cuts.empty() || cuts.front() != begin)
+    {
+        cuts.insert(cuts.begin(), begin);
+    }
+    cuts.push_back(begin + total);
+
+    std::vector<TopLevelSpan> spans(cuts.size() - 1);
+    std::string_view source = tokens.source();
+
+    for (size_t i = 0; i < spans.size(); i++)
+    {
+        spans[i].begin = tokens.offset(cuts[i] - begin);
+        spans[i].end = tokens.offset(cuts[i + 1] - begin);
+        spans[i].hash = std::hash<std::string_view>()(source.substr(spans[i].begin, spans[i].end - spans[i].begin));
+    }
+
+    // match the spans against the clean spans of the previous version
+    std::vector<const TopLevelSpan *> reused(spans.size(), nullptr);
+
+    // nodes of a skimmed tree lack their bodies, so only trees parsed the same way are mixed
+    if (previous != nullptr && previous->skimmed() == skim && !previous->spans().empty())
+    {
+        std::string_view old_source = previous->source();
+        std::unordered_multimap<size_t, const TopLevelSpan *> candidates;
+
+        for (const auto &span : previous->spans())
+        {
+            // reusing a span keeps its arena alive, so old arenas age out
+            if (span.clean && span.age + 1 < parseMaxRetainedVersions)
+            {
+                candidates.emplace(span.hash, &span);
+            }
+        }
+
+        for (size_t i = 0; i < spans.size(); i++)
+        {
+            std::string_view text = source.substr(spans[i].begin, spans[i].end - spans[i].begin);
+            auto range = candidates.equal_range(spans[i].hash);
+
+            for (auto it = range.first; it != range.second; ++it)
+            {
+                if (old_source.substr(it->second->begin, it->second->end - it->second->begin) == text)
+                {
+                    reused[i] = it->second;
+                    candidates.erase(it);
+                    break;
+                }
+            }
+        }
+    }
+
+    // hand the changed spans out to threads in equal shares of their tokens
+    std::vector<size_t> dirty;
+    size_t dirty_tokens = 0;
+    for (size_t i = 0; i < spans.size(); i++)
+    {
+        if (reused[i] == nullptr)
+        {
+            dirty.push_back(i);
+            dirty_tokens += cuts[i + 1] - cuts[i];
+        }
+    }
+
+    if (threads == 0)
+    {
+        threads = std::max<size_t>(1, std::min<size_t>(std::thread::hardware_concurrency(), dirty_tokens / parseParallelMinTokens));
+    }
+
+    std::vector<ParseChunk> chunks(std::min(threads, std::max<size_t>(dirty.size(), 1)));
+    size_t share = 0;
+    for (size_t i : dirty)
+    {
+        size_t chunk = std::min(chunks.size() - 1, share * chunks.size() / std::max<size_t>(dirty_tokens, 1));
+        chunks[chunk].spans.push_back(i);
+        share += cuts[i + 1] - cuts[i];
+    }
+
+    std::vector<GenericNode *> blocks(spans.size(), nullptr);
+    std::vector<char> clean(spans.size(), 0);
+
+    if (chunks.size() == 1)
+    {
+        parse_chunk(tokens, cuts, chunks.front(), blocks, clean, skim, max_nesting);
+    }
+    else
+    {
+        std::vector<std::thread> workers;
+        for (auto &chunk : chunks)
+        {
+            workers.emplace_back([&tokens, &cuts, &chunk, &blocks, &clean, skim, max_nesting]()
+                                 {
+                try
+                {
+                    parse_chunk(tokens, cuts, chunk, blocks, clean, skim, max_nesting);
+                }
+                catch (...)
+                {
+                    chunk.error = std::current_exception();
+                } });
+        }
+
+        for (auto &worker : workers)
+        {
+            worker.join();
+        }
+    }
+
+    tokens.pop(total);
+
+    for (auto &chunk : chunks)
+    {
+        if (chunk.error)
+        {
+            std::rethrow_exception(chunk.error);
+        }
+
+        diagnostics.insert(diagnostics.end(), chunk.diagnostics.begin(), chunk.diagnostics.end());
+
+        arena->adopt(chunk.arena);
+    }
+
+    // stitch the spans together in source order
+    Block *rootnode = make_node<Block>();
+    rootnode->render_braces() = false;
+
+    for (size_t i = 0; i < spans.size(); i++)
+    {
+        spans[i].first = static_cast<uint32_t>(rootnode->children().size());
+
+        if (reused[i] != nullptr)
+        {
+            const auto &children = static_cast<Block *>(previous->root())->children();
+            for (uint32_t j = 0; j < reused[i]->count; j++)
+            {
+                rootnode->push(children[reused[i]->first + j]);
+            }
+
+            spans[i].clean = true;
+            spans[i].arena = reused[i]->arena;
+            spans[i].age = reused[i]->age + 1;
+        }
+        else
+        {
+            if (blocks[i] != nullptr)
+            {
+                for (GenericNode *child : static_cast<Block *>(blocks[i])->children())
+                {
+                    rootnode->push(child);
+                }
+            }
+
+            spans[i].clean = clean[i];
+            spans[i].arena = arena;
+        }
+
+        spans[i].count = static_cast<uint32_t>(rootnode->children().size()) - spans[i].first;
+    }
+
+    return std::make_shared<AbstractSyntaxTree>(std::move(arena), rootnode, std::move(spans), tokens.storage(), std::move(skimmed));
+}
+
+std::shared_ptr<jcc::AbstractSyntaxTree> jcc::CompilationUnit::parse(jcc::TokenCursor &tokens, std::vector<ParserDiagnostic> &diagnostics, size_t max_nesting, size_t threads)
+{
+    return parse_spans(tokens, nullptr, diagnostics, nullptr, max_nesting, threads);
+}
+
+std::shared_ptr<jcc::AbstractSyntaxTree> jcc::CompilationUnit::reparse(jcc::TokenCursor &tokens, const std::shared_ptr<AbstractSyntaxTree> &previous, std::vector<ParserDiagnostic> &diagnostics, size_t max_nesting, size_t threads)
+{
+    return parse_spans(tokens, previous, diagnostics, nullptr, max_nesting, threads);
+}
+
+std::shared_ptr<jcc::AbstractSyntaxTree> jcc::CompilationUnit::skim(const jcc::TokenList &tokens, std::vector<ParserDiagnostic> &diagnostics, size_t max_nesting, size_t threads)
+{
+    // the tree owns the cursor and a copy of the list it reads, so that bodies can be parsed from it later
+    std::shared_ptr<TokenCursor> cursor = std::make_shared<TokenCursor>(std::make_shared<const TokenList>(tokens));
+
+    return parse_spans(*cursor, nullptr, diagnostics, cursor, max_nesting, threads);
+}
+
+jcc::Block *jcc::CompilationUnit::parse_body(const std::shared_ptr<AbstractSyntaxTree> &ast, GenericNode *function, std::vector<ParserDiagnostic> &diagnostics)
+{
+    const TokenCursor *tokens = ast->skimmed_tokens();
+    if (tokens == nullptr)
     {
-        throw ParserException("Expected block as root node");
         return nullptr;
     }
 
-    std::static_pointer_cast<Block>(rootnode)->render_braces() = false;
+    Block **block = nullptr;
+    SourceRange range;
 
-    if (rootnode == nullptr)
+    switch (function->type())
     {
+    case NodeType::FunctionDefinition:
+        block = &static_cast<FunctionDefinition *>(function)->block();
+        range = static_cast<FunctionDefinition *>(function)->skipped_body();
+        break;
+    case NodeType::StructMethod:
+        block = &static_cast<StructMethod *>(function)->block();
+        range = static_cast<StructMethod *>(function)->skipped_body();
+        break;
+    default:
         return nullptr;
     }
 
-    std::shared_ptr<AbstractSyntaxTree> nodes = std::make_shared<AbstractSyntaxTree>();
+    if (*block != nullptr || range.empty())
+    {
+        return *block;
+    }
+
+    TokenCursor body(*tokens, tokens->find(range.begin), tokens->find(range.end));
+    ParseContext ctx(body, ast->arena(), diagnostics, false, parseMaxNestingDefault);
+
+    GenericNode *node = nullptr;
+    parse_functional_block(ctx, node);
 
-    nodes->root() = rootnode;
+    *block = static_cast<Block *>(node);
 
-    return nodes;
-}
\ No newline at end of file
+    return *block;
+}
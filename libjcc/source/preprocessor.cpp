@@ -1,8 +1,12 @@
 #include "preprocessor.hpp"
 
-std::string jcc::Preprocessor::preprocess(const std::string &source)
+std::string jcc::Preprocessor::preprocess(std::string_view source)
 {
     /// TODO: Implement this function.
     // wrap the entire source in a namespace for sanity
-    return source+"\n";
+    std::string result;
+    result.reserve(source.size() + 1);
+    result.append(source);
+    result += '\n';
+    return result;
 }
\ No newline at end of file
@@ -0,0 +1,533 @@
+#include "parser.hpp"
+#include "visitor.hpp"
+#include "json.hpp"
+#include <string>
+#include <string_view>
+#include <limits>
+
+using namespace jcc;
+
+///=============================================================================
+/// NodeStringPrinter
+///=============================================================================
+
+/// @brief Prints a tree in the `Name(fields, children)` debugging format
+/// @note Recurses into children. The parser rejects subsystems and expressions
+/// nested more than max_nesting levels deep, and nothing else nests, so the
+/// height of a tree and with it the recursion are bounded.
+class NodeStringPrinter : public ConstNodeVisitor<NodeStringPrinter>
+{
+public:
+    NodeStringPrinter(std::string &out) : m_out(out) {}
+
+    void visit(const Expression *) { m_out += "Expression()"; }
+    void visit(const Statement *) { m_out += "Statement()"; }
+    void visit(const Declaration *) { m_out += "Declaration()"; }
+    void visit(const Definition *) { m_out += "Definition()"; }
+
+    void visit(const Block *node)
+    {
+        m_out += "Block([";
+        list(node->children());
+        m_out += "])";
+    }
+
+    void visit(const TypeNode *node) { named("TypeNode", node->name().str()); }
+    void visit(const RawNode *node) { named("RawNode", node->value()); }
+
+    void visit(const TypeDeclaration *node)
+    {
+        m_out += "TypeDeclaration(" + node->alias() + ", " + node->type_name() + ")";
+    }
+
+    void visit(const StructDeclaration *node) { named("StructDeclaration", node->name()); }
+    void visit(const UnionDeclaration *node) { named("UnionDeclaration", node->name()); }
+    void visit(const EnumDeclaration *node) { named("EnumDeclaration", node->name()); }
+    void visit(const ClassDeclaration *node) { named("ClassDeclaration", node->name()); }
+
+    void visit(const FunctionParameter *node)
+    {
+        m_out += "FunctionParameter(";
+        m_out += node->name().str();
+        m_out += ", ";
+        m_out += node->type().str();
+        m_out += ")";
+    }
+
+    void visit(const FunctionDeclaration *node)
+    {
+        m_out += "FunctionDeclaration(" + node->name() + ", " + node->return_type() + ", [";
+        list(node->parameters());
+        m_out += "])";
+    }
+
+    void visit(const ExternalDeclaration *node)
+    {
+        m_out += "ExternalDeclaration(";
+        dispatch(node->declaration());
+        m_out += ")";
+    }
+
+    void visit(const SubsystemDeclaration *node) { named("SubsystemDeclaration", node->name()); }
+
+    void visit(const SubsystemDefinition *node)
+    {
+        m_out += "SubsystemDefinition(" + node->name() + ", {";
+        dispatch(node->block());
+        m_out += "})";
+    }
+
+    void visit(const StructField *node)
+    {
+        m_out += "StructField(";
+        m_out += node->name().str();
+        m_out += ", ";
+        m_out += node->type().str();
+        m_out += ")";
+    }
+
+    void visit(const StructMethod *node) { m_out += "StructMethod(" + node->name() + ", " + node->type() + ")"; }
+    void visit(const StructAttribute *node) { m_out += "StructAttribute(" + node->name() + ", " + node->value() + ")"; }
+
+    void visit(const StructDefinition *node)
+    {
+        m_out += "StructDefinition(" + node->name() + ", [";
+        list(node->fields());
+        m_out += "])";
+    }
+
+    void visit(const UnionField *node)
+    {
+        m_out += "UnionField(" + node->name() + ", ";
+        dispatch(node->dtype());
+        m_out += ")";
+    }
+
+    void visit(const UnionDefinition *node) { named("UnionDefinition", node->name()); }
+
+    void visit(const FunctionDefinition *node)
+    {
+        m_out += "FunctionDefinition(" + node->name() + ", " + node->return_type() + ", [";
+        list(node->parameters());
+        m_out += "], {";
+        if (node->block() != nullptr)
+        {
+            dispatch(node->block());
+        }
+        else
+        {
+            m_out += "...";
+        }
+        m_out += "})";
+    }
+
+    void visit(const BinaryExpression *node)
+    {
+        m_out += "BinaryExpression(";
+        m_out += lexOperatorMapReverse.at(node->op());
+        m_out += ", ";
+        dispatch(node->left());
+        m_out += ", ";
+        dispatch(node->right());
+        m_out += ")";
+    }
+
+    void visit(const UnaryExpression *node)
+    {
+        m_out += "UnaryExpression(";
+        m_out += lexOperatorMapReverse.at(node->op());
+        m_out += ", ";
+        dispatch(node->expression());
+        m_out += ")";
+    }
+
+    void visit(const TernaryExpression *node)
+    {
+        m_out += "TernaryExpression(";
+        dispatch(node->condition());
+        m_out += ", ";
+        dispatch(node->then_expression());
+        m_out += ", ";
+        dispatch(node->else_expression());
+        m_out += ")";
+    }
+
+    void visit(const CastExpression *node)
+    {
+        m_out += "CastExpression(";
+        m_out += node->type().str();
+        m_out += ", ";
+        dispatch(node->expression());
+        m_out += ")";
+    }
+
+    void visit(const NullExpression *node) { named("NullExpression", node->type()); }
+
+    void visit(const CallExpression *node)
+    {
+        m_out += "CallExpression(" + node->name() + ", [";
+        list(node->arguments());
+        m_out += "])";
+    }
+
+    void visit(const IdentifierExpression *node) { named("IdentifierExpression", node->name().str()); }
+
+    void visit(const LiteralExpression *node) { named("LiteralExpression", node->value()); }
+    void visit(const StringLiteralExpression *node) { named("StringLiteralExpression", node->value()); }
+    void visit(const CharLiteralExpression *node) { named("CharLiteralExpression", node->value()); }
+    void visit(const IntegerLiteralExpression *node) { named("IntegerLiteralExpression", node->value()); }
+    void visit(const FloatingPointLiteralExpression *node) { named("FloatingPointLiteralExpression", node->value()); }
+    void visit(const BooleanLiteralExpression *node) { named("BooleanLiteralExpression", node->value()); }
+
+    void visit(const ReturnStatement *) { m_out += "ReturnStatement()"; }
+    void visit(const LetDeclaration *) { m_out += "LetDeclaration()"; }
+    void visit(const VarDeclaration *) { m_out += "VarDeclaration()"; }
+
+private:
+    std::string &m_out;
+
+    void named(const char *type, std::string_view name)
+    {
+        m_out += type;
+        m_out += "(";
+        m_out += name;
+        m_out += ")";
+    }
+
+    template <typename T>
+    void list(const NodeList<T> &nodes)
+    {
+        for (size_t i = 0; i < nodes.size(); i++)
+        {
+            if (i > 0)
+            {
+                m_out += ", ";
+            }
+            dispatch(nodes[i]);
+        }
+    }
+};
+
+///=============================================================================
+/// NodeJsonPrinter
+///=============================================================================
+
+/// @brief Serializes a tree to JSON
+/// @note Recurses into children, as deeply as NodeStringPrinter does.
+class NodeJsonPrinter : public ConstNodeVisitor<NodeJsonPrinter>
+{
+public:
+    NodeJsonPrinter(JsonWriter &writer) : m_writer(writer) {}
+
+    void visit(const Expression *) { tagged("expression"); }
+    void visit(const Statement *) { tagged("statement"); }
+    void visit(const Declaration *) { tagged("declaration"); }
+    void visit(const Definition *) { tagged("definition"); }
+
+    void visit(const Block *node)
+    {
+        begin("block");
+        list("children", node->children());
+        m_writer.end_object();
+    }
+
+    void visit(const TypeNode *node)
+    {
+        begin("type_node");
+        m_writer.member("name", node->name().str());
+        m_writer.member("is_const", node->is_const());
+        m_writer.member("is_ref", node->is_reference());
+        if (node->arr_size() == std::numeric_limits<size_t>::max())
+        {
+            m_writer.member("arr_size", "dynamic");
+        }
+        else
+        {
+            m_writer.member("arr_size", node->arr_size());
+        }
+        m_writer.member("bitfield", node->bitfield());
+
+        if (node->default_value())
+        {
+            m_writer.key("default_value");
+            dispatch(node->default_value());
+        }
+        m_writer.end_object();
+    }
+
+    void visit(const RawNode *node) { field("raw_node", "value", node->value()); }
+
+    void visit(const TypeDeclaration *node)
+    {
+        begin("type_declaration");
+        m_writer.member("alias", node->alias());
+        m_writer.member("typename", node->type_name());
+        m_writer.end_object();
+    }
+
+    void visit(const StructDeclaration *node) { field("struct_declaration", "name", node->name()); }
+    void visit(const UnionDeclaration *node) { field("union_declaration", "name", node->name()); }
+    void visit(const EnumDeclaration *node) { field("enum_declaration", "name", node->name()); }
+    void visit(const ClassDeclaration *node) { field("class_declaration", "name", node->name()); }
+
+    void visit(const FunctionParameter *node)
+    {
+        begin("function_parameter");
+        m_writer.member("name", node->name().str());
+        m_writer.member("dtype", node->type().str());
+        m_writer.end_object();
+    }
+
+    void visit(const FunctionDeclaration *node)
+    {
+        begin("function_declaration");
+        m_writer.member("name", node->name());
+        m_writer.member("return_type", node->return_type());
+        list("parameters", node->parameters());
+        m_writer.end_object();
+    }
+
+    void visit(const ExternalDeclaration *node)
+    {
+        begin("external_declaration");
+        m_writer.key("declaration");
+        dispatch(node->declaration());
+        m_writer.end_object();
+    }
+
+    void visit(const SubsystemDeclaration *node) { field("subsystem_declaration", "name", node->name()); }
+
+    void visit(const SubsystemDefinition *node)
+    {
+        begin("subsystem_definition");
+        m_writer.member("name", node->name());
+        m_writer.key("block");
+        dispatch(node->block());
+        m_writer.end_object();
+    }
+
+    void visit(const StructField *node)
+    {
+        begin("struct_field");
+        m_writer.member("name", node->name().str());
+        m_writer.member("dtype", node->type().str());
+        m_writer.member("default_value", node->default_value());
+        m_writer.member("bitfield", node->bitfield());
+        if (!node->arr_size())
+        {
+            m_writer.member("arr_size", "dynamic");
+        }
+        else
+        {
+            m_writer.member("arr_size", node->arr_size());
+        }
+        list("attributes", node->attributes());
+        m_writer.end_object();
+    }
+
+    void visit(const StructMethod *node)
+    {
+        begin("struct_member");
+        m_writer.member("name", node->name());
+        m_writer.member("return_type", node->type());
+        list("parameters", node->parameters());
+        optional("block", node->block());
+        m_writer.end_object();
+    }
+
+    void visit(const StructAttribute *node)
+    {
+        begin("struct_attribute");
+        m_writer.member("name", node->name());
+        m_writer.member("value", node->value());
+        m_writer.end_object();
+    }
+
+    void visit(const StructDefinition *node)
+    {
+        begin("struct_definition");
+        m_writer.member("name", node->name());
+        list("fields", node->fields());
+        m_writer.end_object();
+    }
+
+    void visit(const UnionField *node)
+    {
+        begin("union_field");
+        m_writer.member("name", node->name());
+        m_writer.key("dtype");
+        dispatch(node->dtype());
+        m_writer.end_object();
+    }
+
+    void visit(const UnionDefinition *node)
+    {
+        begin("union_definition");
+        m_writer.member("name", node->name());
+        list("fields", node->fields());
+        m_writer.end_object();
+    }
+
+    void visit(const FunctionDefinition *node)
+    {
+        begin("function_definition");
+        m_writer.member("name", node->name());
+        m_writer.member("return_type", node->return_type());
+        list("parameters", node->parameters());
+        optional("block", node->block());
+        m_writer.end_object();
+    }
+
+    void visit(const BinaryExpression *node)
+    {
+        begin("binary_expression");
+        m_writer.member("op", lexOperatorMapReverse.at(node->op()));
+        m_writer.key("left");
+        dispatch(node->left());
+        m_writer.key("right");
+        dispatch(node->right());
+        m_writer.end_object();
+    }
+
+    void visit(const UnaryExpression *node)
+    {
+        begin("unary_expression");
+        m_writer.member("op", lexOperatorMapReverse.at(node->op()));
+        m_writer.member("postfix", node->postfix());
+        m_writer.key("expression");
+        dispatch(node->expression());
+        m_writer.end_object();
+    }
+
+    void visit(const TernaryExpression *node)
+    {
+        begin("ternary_expression");
+        m_writer.key("condition");
+        dispatch(node->condition());
+        m_writer.key("then");
+        dispatch(node->then_expression());
+        m_writer.key("else");
+        dispatch(node->else_expression());
+        m_writer.end_object();
+    }
+
+    void visit(const CastExpression *node)
+    {
+        begin("cast_expression");
+        m_writer.member("type", node->type().str());
+        m_writer.key("expression");
+        dispatch(node->expression());
+        m_writer.end_object();
+    }
+
+    void visit(const NullExpression *node) { field("null_expression", "type", node->type()); }
+
+    void visit(const CallExpression *node)
+    {
+        begin("call_expression");
+        m_writer.member("name", node->name());
+        list("arguments", node->arguments());
+        m_writer.end_object();
+    }
+
+    void visit(const IdentifierExpression *node) { field("identifier_expression", "name", node->name().str()); }
+
+    void visit(const LiteralExpression *node) { field("literal_expression", "value", node->value()); }
+    void visit(const StringLiteralExpression *node) { field("string_literal_expression", "value", node->value()); }
+    void visit(const CharLiteralExpression *node) { field("char_literal_expression", "value", node->value()); }
+    void visit(const IntegerLiteralExpression *node) { field("integer_literal_expression", "value", node->value()); }
+    void visit(const FloatingPointLiteralExpression *node) { field("float_literal_expression", "value", node->value()); }
+    void visit(const BooleanLiteralExpression *node) { field("boolean_literal_expression", "value", node->value()); }
+
+    void visit(const ReturnStatement *) { tagged("return_statement"); }
+    void visit(const LetDeclaration *node) { declaration("let_declaration", node->name(), node->dtype()); }
+    void visit(const VarDeclaration *node) { declaration("var_declaration", node->name(), node->dtype()); }
+
+private:
+    JsonWriter &m_writer;
+
+    void begin(const char *type)
+    {
+        m_writer.begin_object();
+        m_writer.member("type", type);
+    }
+
+    void tagged(const char *type)
+    {
+        begin(type);
+        m_writer.end_object();
+    }
+
+    void field(const char *type, const char *key, std::string_view value)
+    {
+        begin(type);
+        m_writer.member(key, value);
+        m_writer.end_object();
+    }
+
+    void declaration(const char *type, const std::string &name, const TypeNode *dtype)
+    {
+        begin(type);
+        m_writer.member("name", name);
+        m_writer.key("dtype");
+        dispatch(dtype);
+        m_writer.end_object();
+    }
+
+    void optional(const char *key, const GenericNode *node)
+    {
+        m_writer.key(key);
+        if (node != nullptr)
+        {
+            dispatch(node);
+        }
+        else
+        {
+            m_writer.null();
+        }
+    }
+
+    template <typename T>
+    void list(const char *key, const NodeList<T> &nodes)
+    {
+        m_writer.key(key);
+        m_writer.begin_array();
+        for (T *node : nodes)
+        {
+            dispatch(node);
+        }
+        m_writer.end_array();
+    }
+};
+
+///=============================================================================
+/// GenericNode
+///=============================================================================
+
+std::string jcc::GenericNode::to_string() const
+{
+    std::string str;
+    NodeStringPrinter(str).dispatch(this);
+    return str;
+}
+
+std::string jcc::GenericNode::to_json() const
+{
+    std::string str;
+    JsonWriter writer(str);
+    to_json(writer);
+    return str;
+}
+
+void jcc::GenericNode::to_json(JsonWriter &writer) const
+{
+    NodeJsonPrinter(writer).dispatch(this);
+}
+
+std::string std::to_string(const jcc::GenericNode *value)
+{
+    if (value == nullptr)
+        return "{}";
+
+    return value->to_json();
+}
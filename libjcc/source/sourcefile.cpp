@@ -0,0 +1,293 @@
+#include "sourcefile.hpp"
+#include <cstring>
+#include <cstdint>
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#else
+#error "Cross-platform support is not implemented yet"
+#endif
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+///=============================================================================
+/// UTF-8 scanning
+///=============================================================================
+
+/// @brief Validate one multi-byte sequence
+/// @param bytes The buffer
+/// @param size The size of the buffer
+/// @param i Index of the lead byte; advanced past the sequence
+/// @return False if the sequence is truncated, overlong, a surrogate or above U+10FFFF
+static inline bool utf8_check_sequence(const unsigned char *bytes, size_t size, size_t &i)
+{
+    unsigned char lead = bytes[i];
+    size_t num;
+    uint32_t cp;
+    uint32_t min;
+
+    if ((lead & 0xE0) == 0xC0)
+    {
+        // U+0080 to U+07FF
+        num = 2;
+        cp = lead & 0x1F;
+        min = 0x80;
+    }
+    else if ((lead & 0xF0) == 0xE0)
+    {
+        // U+0800 to U+FFFF
+        num = 3;
+        cp = lead & 0x0F;
+        min = 0x800;
+    }
+    else if ((lead & 0xF8) == 0xF0)
+    {
+        // U+10000 to U+10FFFF
+        num = 4;
+        cp = lead & 0x07;
+        min = 0x10000;
+    }
+    else
+    {
+        return false;
+    }
+
+    if (size - i < num)
+    {
+        return false;
+    }
+
+    for (size_t k = 1; k < num; k++)
+    {
+        if ((bytes[i + k] & 0xC0) != 0x80)
+        {
+            return false;
+        }
+        cp = (cp << 6) | (bytes[i + k] & 0x3F);
+    }
+
+    if (cp < min || cp > 0x10FFFF || (cp >= 0xD800 && cp <= 0xDFFF))
+    {
+        return false;
+    }
+
+    i += num;
+    return true;
+}
+
+/// @brief Validate bytes up to `end`; a sequence starting before `end` may run past it
+static inline bool utf8_check_run(const unsigned char *bytes, size_t size, size_t &i, size_t end)
+{
+    while (i < end)
+    {
+        if (bytes[i] < 0x80)
+        {
+            i++;
+        }
+        else if (!utf8_check_sequence(bytes, size, i))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/// @brief Scan the bytes left over after the last full block
+static inline jcc::Utf8Scan utf8_finish(const unsigned char *bytes, size_t size, size_t i, jcc::Utf8Scan result)
+{
+    for (size_t k = i; k < size; k++)
+    {
+        if (bytes[k] & 0x80)
+        {
+            result.ascii = false;
+            break;
+        }
+    }
+
+    if (!utf8_check_run(bytes, size, i, size))
+    {
+        return {false, false};
+    }
+
+    return result;
+}
+
+#if defined(__x86_64__)
+
+__attribute__((target("avx2"))) static jcc::Utf8Scan scan_utf8_avx2(const unsigned char *bytes, size_t size)
+{
+    jcc::Utf8Scan result;
+    size_t i = 0;
+
+    while (i + 64 <= size)
+    {
+        __m256i lo = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(bytes + i));
+        __m256i hi = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(bytes + i + 32));
+        if (_mm256_movemask_epi8(_mm256_or_si256(lo, hi)) == 0)
+        {
+            i += 64;
+            continue;
+        }
+
+        result.ascii = false;
+        if (!utf8_check_run(bytes, size, i, i + 64))
+        {
+            return {false, false};
+        }
+    }
+
+    return utf8_finish(bytes, size, i, result);
+}
+
+static jcc::Utf8Scan scan_utf8_sse2(const unsigned char *bytes, size_t size)
+{
+    jcc::Utf8Scan result;
+    size_t i = 0;
+
+    while (i + 16 <= size)
+    {
+        __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i *>(bytes + i));
+        if (_mm_movemask_epi8(block) == 0)
+        {
+            i += 16;
+            continue;
+        }
+
+        result.ascii = false;
+        if (!utf8_check_run(bytes, size, i, i + 16))
+        {
+            return {false, false};
+        }
+    }
+
+    return utf8_finish(bytes, size, i, result);
+}
+
+#else
+
+static jcc::Utf8Scan scan_utf8_scalar(const unsigned char *bytes, size_t size)
+{
+    jcc::Utf8Scan result;
+    size_t i = 0;
+
+    while (i + 8 <= size)
+    {
+        uint64_t word;
+        std::memcpy(&word, bytes + i, sizeof(word));
+        if ((word & 0x8080808080808080ull) == 0)
+        {
+            i += 8;
+            continue;
+        }
+
+        result.ascii = false;
+        if (!utf8_check_run(bytes, size, i, i + 8))
+        {
+            return {false, false};
+        }
+    }
+
+    return utf8_finish(bytes, size, i, result);
+}
+
+#endif
+
+jcc::Utf8Scan jcc::scan_utf8(const char *data, size_t size)
+{
+    const unsigned char *bytes = reinterpret_cast<const unsigned char *>(data);
+
+#if defined(__x86_64__)
+    // SSE2 is part of the x86-64 baseline; AVX2 is detected once
+    static const bool has_avx2 = __builtin_cpu_supports("avx2");
+
+    return has_avx2 ? scan_utf8_avx2(bytes, size) : scan_utf8_sse2(bytes, size);
+#else
+    return scan_utf8_scalar(bytes, size);
+#endif
+}
+
+///=============================================================================
+/// jcc::SourceFile class implementation
+///=============================================================================
+
+jcc::SourceFile::~SourceFile()
+{
+    close();
+}
+
+bool jcc::SourceFile::open(const std::string &filepath)
+{
+    close();
+
+    int fd = ::open(filepath.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+    {
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0)
+    {
+        ::close(fd);
+        return false;
+    }
+
+    if (S_ISREG(st.st_mode))
+    {
+        if (st.st_size == 0)
+        {
+            ::close(fd);
+            return true;
+        }
+
+        void *addr = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (addr != MAP_FAILED)
+        {
+            ::close(fd);
+            madvise(addr, st.st_size, MADV_SEQUENTIAL);
+
+            m_data = static_cast<const char *>(addr);
+            m_size = st.st_size;
+            m_mapped = true;
+            return true;
+        }
+    }
+
+    // pipes, character devices and file systems without mmap support
+    char chunk[65536];
+    ssize_t count;
+    while ((count = ::read(fd, chunk, sizeof(chunk))) > 0)
+    {
+        m_buffer.append(chunk, count);
+    }
+    ::close(fd);
+
+    if (count < 0)
+    {
+        m_buffer.clear();
+        return false;
+    }
+
+    m_data = m_buffer.data();
+    m_size = m_buffer.size();
+    return true;
+}
+
+void jcc::SourceFile::close()
+{
+    if (m_mapped)
+    {
+        munmap(const_cast<char *>(m_data), m_size);
+    }
+
+    m_data = nullptr;
+    m_size = 0;
+    m_mapped = false;
+    m_buffer.clear();
+}
@@ -0,0 +1,155 @@
+#include "symbol.hpp"
+#include "compile.hpp"
+#include <array>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+#include <algorithm>
+#include <cstring>
+
+///=============================================================================
+/// Symbol table
+///=============================================================================
+
+/// @brief IDs are `index << SymbolShardBits | shard`, so each shard hands out
+/// its own IDs without coordinating with the others
+constexpr uint32_t SymbolShardBits = 4;
+constexpr uint32_t SymbolShards = 1 << SymbolShardBits;
+
+/// @brief The text of each shard's symbols is found through fixed-size pages,
+/// so lookups by ID never race with a shard growing
+constexpr uint32_t SymbolPageBits = 12;
+constexpr uint32_t SymbolPageSize = 1 << SymbolPageBits;
+constexpr uint32_t SymbolMaxPages = 1 << (32 - SymbolShardBits - SymbolPageBits);
+
+/// @brief Size of the arena blocks holding symbol text
+constexpr size_t SymbolBlockSize = 64 * 1024;
+
+/// @brief Entries of the per-thread cache in front of the shared table
+constexpr size_t SymbolCacheSize = 1024;
+
+struct SymbolShard
+{
+    std::mutex mutex;
+    std::unordered_map<std::string_view, uint32_t> index;
+    std::array<std::atomic<std::string_view *>, SymbolMaxPages> pages{};
+    std::vector<std::unique_ptr<std::string_view[]>> page_storage;
+    uint32_t count = 0;
+
+    // Text is stored as [uint32_t id][bytes][NUL] so a view can be mapped back
+    // to its ID by `Symbol::from_interned`
+    std::vector<std::unique_ptr<char[]>> blocks;
+    char *cursor = nullptr;
+    size_t left = 0;
+
+    const char *store(std::string_view str, uint32_t id)
+    {
+        size_t need = sizeof(uint32_t) + str.size() + 1;
+        if (need > left)
+        {
+            size_t size = std::max(need, SymbolBlockSize);
+            blocks.push_back(std::make_unique<char[]>(size));
+            cursor = blocks.back().get();
+            left = size;
+        }
+
+        char *text = cursor + sizeof(uint32_t);
+        std::memcpy(cursor, &id, sizeof(uint32_t));
+        std::memcpy(text, str.data(), str.size());
+        text[str.size()] = '\0';
+
+        // keep the next prefix aligned
+        need = (need + alignof(uint32_t) - 1) & ~(alignof(uint32_t) - 1);
+        cursor += std::min(need, left);
+        left -= std::min(need, left);
+
+        return text;
+    }
+};
+
+static std::array<SymbolShard, SymbolShards> &symbol_shards()
+{
+    static std::array<SymbolShard, SymbolShards> shards;
+    return shards;
+}
+
+uint32_t jcc::Symbol::intern(std::string_view str)
+{
+    if (str.empty())
+    {
+        return 0;
+    }
+
+    struct CacheEntry
+    {
+        size_t hash = 0;
+        std::string_view str;
+        uint32_t id = 0;
+    };
+    thread_local std::array<CacheEntry, SymbolCacheSize> cache;
+
+    size_t hash = std::hash<std::string_view>{}(str);
+    CacheEntry &entry = cache[hash % SymbolCacheSize];
+    if (entry.id != 0 && entry.hash == hash && entry.str == str)
+    {
+        return entry.id;
+    }
+
+    uint32_t shard_index = (hash >> 32 ^ hash) & (SymbolShards - 1);
+    SymbolShard &shard = symbol_shards()[shard_index];
+
+    std::lock_guard<std::mutex> lock(shard.mutex);
+
+    auto it = shard.index.find(str);
+    if (it == shard.index.end())
+    {
+        // index 0 of shard 0 is the empty symbol
+        uint32_t index = shard.count++ + (shard_index == 0 ? 1 : 0);
+        if (index >= SymbolPageSize * SymbolMaxPages)
+        {
+            panic("Symbol table is full");
+        }
+
+        std::string_view *page = shard.pages[index / SymbolPageSize].load(std::memory_order_relaxed);
+        if (page == nullptr)
+        {
+            shard.page_storage.push_back(std::make_unique<std::string_view[]>(SymbolPageSize));
+            page = shard.page_storage.back().get();
+            shard.pages[index / SymbolPageSize].store(page, std::memory_order_release);
+        }
+
+        uint32_t id = index << SymbolShardBits | shard_index;
+        std::string_view stored(shard.store(str, id), str.size());
+        page[index % SymbolPageSize] = stored;
+        it = shard.index.emplace(stored, id).first;
+    }
+
+    entry = {hash, it->first, it->second};
+    return it->second;
+}
+
+jcc::Symbol jcc::Symbol::from_interned(std::string_view str)
+{
+    if (str.empty())
+    {
+        return Symbol();
+    }
+
+    uint32_t id;
+    std::memcpy(&id, str.data() - sizeof(uint32_t), sizeof(uint32_t));
+    return from_id(id);
+}
+
+std::string_view jcc::Symbol::str() const
+{
+    if (m_id == 0)
+    {
+        return std::string_view();
+    }
+
+    uint32_t index = m_id >> SymbolShardBits;
+    const std::string_view *page = symbol_shards()[m_id & (SymbolShards - 1)].pages[index / SymbolPageSize].load(std::memory_order_acquire);
+    return page[index % SymbolPageSize];
+}
@@ -0,0 +1,131 @@
+#include "compile.hpp"
+#include "common.hpp"
+#include <iostream>
+#include <string>
+#include <vector>
+#include <filesystem>
+#include <unistd.h>
+
+using namespace jcc;
+
+static const char *program = R"(subsystem Core : libc
+{
+    struct Point
+    {
+        x: int = 5;
+        y: float : 3;
+        name: string;
+    }
+    union U { a: int; b: float; }
+    struct Fwd;
+    union UFwd;
+    func add(a: int, b: int = 4) : int
+    {
+        let z: int = a + b * 2;
+        var w: int = -z;
+        let q: bool = a > b ? true : false;
+        let c: char = 'c';
+        let f: double = 3.5;
+        let s: string = "hi\n";
+        let p: int = f as int;
+        let n: string = null;
+        let x: int = (a ^^ b) >>>= 2;
+    }
+    subsystem Inner { let g: int = 1; }
+}
+func main() : int
+{
+    let v: int = add(1, 2);
+    let w: int = v++;
+}
+)";
+
+int main()
+{
+    bool ok = true;
+
+    TokenList tokens = CompilationUnit::lex(program, LexMode::NoTrivia);
+    TokenCursor cursor(tokens);
+    std::vector<ParserDiagnostic> diagnostics;
+    auto ast = CompilationUnit::parse(cursor, diagnostics);
+
+    if (!diagnostics.empty())
+    {
+        fail("unexpected syntax error: " + diagnostics.front().message);
+        return 1;
+    }
+
+    std::string binary;
+    ast->write(binary);
+
+    // in memory
+    auto back = AbstractSyntaxTree::read(binary);
+    if (back == nullptr)
+    {
+        ok = fail("a freshly written binary AST was not read");
+    }
+    else
+    {
+        if (back->to_json() != ast->to_json())
+        {
+            ok = fail("the tree read back differs from the one written");
+        }
+
+        std::string again;
+        back->write(again);
+        if (again != binary)
+        {
+            ok = fail("writing the tree read back gives different bytes");
+        }
+    }
+
+    // through a file
+    std::string path = (std::filesystem::temp_directory_path() / ("jcc-ast-file-" + std::to_string(getpid()) + ".jast")).string();
+    if (!ast->save(path))
+    {
+        ok = fail("unable to write " + path);
+    }
+    else
+    {
+        auto loaded = AbstractSyntaxTree::load(path);
+        if (loaded == nullptr || loaded->to_json() != ast->to_json())
+        {
+            ok = fail("the tree loaded from a file differs from the one saved");
+        }
+        std::filesystem::remove(path);
+    }
+
+    if (AbstractSyntaxTree::load(path) != nullptr)
+    {
+        ok = fail("a missing file was loaded");
+    }
+
+    // the header is followed by the version
+    std::string other_version = binary;
+    other_version[4] ^= 0x7f;
+    if (AbstractSyntaxTree::read(other_version) != nullptr)
+    {
+        ok = fail("a binary AST of another version was read");
+    }
+
+    // damaged data must be refused or read, never crash
+    for (size_t i = 0; i < binary.size(); i++)
+    {
+        std::string damaged = binary;
+        damaged[i] ^= 0x5a;
+        AbstractSyntaxTree::read(damaged);
+    }
+
+    for (size_t size = 0; size < binary.size(); size += 4)
+    {
+        if (AbstractSyntaxTree::read(std::string_view(binary.data(), size)) != nullptr)
+        {
+            ok = fail("a truncated binary AST was read");
+            break;
+        }
+    }
+
+    std::cout << (ok ? "Binary AST round trips correctly" : "Binary AST does not round trip") << std::endl;
+
+    return ok ? 0 : 1;
+}
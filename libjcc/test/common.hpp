@@ -0,0 +1,67 @@
+#ifndef _JCC_TEST_COMMON_HPP_
+#define _JCC_TEST_COMMON_HPP_
+
+#include "compile.hpp"
+#include <iostream>
+#include <string>
+#include <vector>
+
+/// @brief Print why a check failed
+/// @param message What went wrong
+/// @return false, so a check can `ok = fail(...)` or `return fail(...)`
+inline bool fail(const std::string &message)
+{
+    std::cout << message << std::endl;
+    return false;
+}
+
+/// @brief Top-level declarations covering structs and their methods, nested
+/// subsystems, unions, regions and globals, some malformed in a field, a
+/// statement or a method body; `#` is replaced by a number
+inline const char *declarations[] = {
+    "struct Point# { x: int = 5; y: float : 3; name: string; length: (scale: float) : float { let l: float = scale * 2.0; } }\n",
+    "func add#(a: int, b: int = 4) : int\n{\n    let z: int = a + b * 2;\n    var w: int = -z;\n}\n",
+    "subsystem Core# : libc\n{\n    union U { a: int; b: float; }\n    subsystem Inner { let g: int = 1; func inner(a: int) : int { let q: int = a; } }\n    struct S { f: (a: int) { let r: int = a; } }\n}\n",
+    "let global#: int = (1 + 2) * 3;\n",
+    "struct Broken# { x: int = ; y: int; }\n",
+    "func bad#(a: int) : int { let q: int = ; let r: int = a; }\n",
+    "region Packed# { a: byte; b: word; }\n",
+    "union Choice# { i: int; f: float; }\n",
+    "struct BrokenMethod# { m: () : int { let q: int = ; } }\n",
+};
+
+/// @brief Source of `count` declarations, cycling through `declarations`
+inline std::string make_source(size_t count)
+{
+    std::string source;
+
+    for (size_t i = 0; i < count; i++)
+    {
+        std::string declaration = declarations[i % (sizeof(declarations) / sizeof(declarations[0]))];
+        declaration.replace(declaration.find('#'), 1, std::to_string(i));
+        source += declaration;
+    }
+
+    return source;
+}
+
+/// @brief Render syntax errors one per line, as `line:column message`
+inline std::string describe(const std::vector<jcc::ParserDiagnostic> &diagnostics)
+{
+    std::string result;
+
+    for (const auto &diagnostic : diagnostics)
+    {
+        result += std::to_string(diagnostic.location.line) + ":" + std::to_string(diagnostic.location.column) + " " + diagnostic.message + "\n";
+    }
+
+    return result;
+}
+
+/// @brief Render everything a parse produces, for comparing two parses
+inline std::string describe(const jcc::AbstractSyntaxTree &ast, const std::vector<jcc::ParserDiagnostic> &diagnostics)
+{
+    return ast.to_json() + "\n" + describe(diagnostics);
+}
+
+#endif // _JCC_TEST_COMMON_HPP_
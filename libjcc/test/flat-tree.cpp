@@ -0,0 +1,386 @@
+#include "compile.hpp"
+#include "visitor.hpp"
+#include "common.hpp"
+#include <iostream>
+#include <string>
+#include <vector>
+#include <atomic>
+#include <stdexcept>
+
+using namespace jcc;
+
+typedef FlatTree<const GenericNode *> AstFlatTree;
+
+/// @brief Lists the children of a syntax tree node, in order
+class NodeChildren : public ConstNodeVisitor<NodeChildren>
+{
+public:
+    NodeChildren(std::vector<const GenericNode *> &out) : m_out(out) {}
+
+    void visit(const Expression *) {}
+    void visit(const Statement *) {}
+    void visit(const Declaration *) {}
+    void visit(const Definition *) {}
+    void visit(const Block *node) { list(node->children()); }
+    void visit(const TypeNode *node) { child(node->default_value()); }
+    void visit(const RawNode *) {}
+    void visit(const TypeDeclaration *) {}
+    void visit(const StructDeclaration *) {}
+    void visit(const UnionDeclaration *) {}
+    void visit(const EnumDeclaration *) {}
+    void visit(const FunctionParameter *node) { child(node->default_value()); }
+    void visit(const FunctionDeclaration *node) { list(node->parameters()); }
+    void visit(const ClassDeclaration *) {}
+    void visit(const ExternalDeclaration *node) { child(node->declaration()); }
+    void visit(const SubsystemDeclaration *) {}
+    void visit(const SubsystemDefinition *node) { child(node->block()); }
+    void visit(const StructField *node) { list(node->attributes()); }
+
+    void visit(const StructMethod *node)
+    {
+        list(node->parameters());
+        child(node->block());
+    }
+
+    void visit(const StructAttribute *) {}
+
+    void visit(const StructDefinition *node)
+    {
+        list(node->fields());
+        list(node->methods());
+    }
+
+    void visit(const UnionField *node) { child(node->dtype()); }
+    void visit(const UnionDefinition *node) { list(node->fields()); }
+
+    void visit(const FunctionDefinition *node)
+    {
+        list(node->parameters());
+        child(node->block());
+    }
+
+    void visit(const BinaryExpression *node)
+    {
+        child(node->left());
+        child(node->right());
+    }
+
+    void visit(const UnaryExpression *node) { child(node->expression()); }
+
+    void visit(const TernaryExpression *node)
+    {
+        child(node->condition());
+        child(node->then_expression());
+        child(node->else_expression());
+    }
+
+    void visit(const CastExpression *node) { child(node->expression()); }
+    void visit(const NullExpression *) {}
+    void visit(const LiteralExpression *) {}
+    void visit(const CallExpression *node) { list(node->arguments()); }
+    void visit(const IdentifierExpression *) {}
+    void visit(const StringLiteralExpression *) {}
+    void visit(const CharLiteralExpression *) {}
+    void visit(const IntegerLiteralExpression *) {}
+    void visit(const FloatingPointLiteralExpression *) {}
+    void visit(const BooleanLiteralExpression *) {}
+    void visit(const ReturnStatement *node) { child(node->expression()); }
+    void visit(const LetDeclaration *node) { child(node->dtype()); }
+    void visit(const VarDeclaration *node) { child(node->dtype()); }
+
+private:
+    std::vector<const GenericNode *> &m_out;
+
+    void child(const GenericNode *node)
+    {
+        if (node != nullptr)
+        {
+            m_out.push_back(node);
+        }
+    }
+
+    template <typename T>
+    void list(const NodeList<T> &nodes)
+    {
+        for (const T *node : nodes)
+        {
+            child(node);
+        }
+    }
+};
+
+static std::vector<const GenericNode *> children_of(const GenericNode *node)
+{
+    std::vector<const GenericNode *> children;
+    NodeChildren(children).dispatch(node);
+    return children;
+}
+
+static std::string name_of(size_t index)
+{
+    return "n" + std::to_string(index);
+}
+
+/// @brief Copy a syntax tree into a FlatTree and a Node tree, numbering nodes in preorder
+/// @param preorder Receives the syntax tree nodes in preorder
+static void build(const GenericNode *root, AstFlatTree &flat, Node<size_t> &tree, std::vector<const GenericNode *> &preorder)
+{
+    struct Pending
+    {
+        const GenericNode *node;
+        AstFlatTree::Index parent;
+        Node<size_t> *parent_node;
+    };
+
+    preorder = {root};
+    std::vector<Pending> stack;
+
+    for (auto children = children_of(root); !children.empty(); children.pop_back())
+    {
+        stack.push_back({children.back(), 0, &tree});
+    }
+
+    while (!stack.empty())
+    {
+        Pending next = stack.back();
+        stack.pop_back();
+
+        AstFlatTree::Index index = flat.add_child(next.parent, next.node, name_of(preorder.size()));
+        next.parent_node->add_child(Node<size_t>(index, name_of(preorder.size())));
+        Node<size_t> *node = next.parent_node->children().back().get();
+        preorder.push_back(next.node);
+
+        for (auto children = children_of(next.node); !children.empty(); children.pop_back())
+        {
+            stack.push_back({children.back(), index, node});
+        }
+    }
+}
+
+/// @brief Check the flat tree against the syntax tree and the Node tree
+static bool check_links(const AstFlatTree &flat, Node<size_t> &tree, const std::vector<const GenericNode *> &preorder)
+{
+    bool ok = true;
+
+    if (flat.size() != preorder.size() || flat.count() != preorder.size())
+    {
+        return fail("the flat tree does not hold every node of the syntax tree");
+    }
+
+    // children are added after their parent and before its next sibling, so indices are preorder
+    std::vector<AstFlatTree::Index> walked;
+    flat.traverse_dfs([&walked](AstFlatTree::Index node)
+                      { walked.push_back(node); });
+    for (size_t i = 0; i < walked.size(); i++)
+    {
+        if (walked[i] != i || flat.value(walked[i]) != preorder[i])
+        {
+            return fail("the flat tree's depth first walk is not in preorder");
+        }
+    }
+
+    size_t nodes = tree.traverse_dfs([&](Node<size_t> &node)
+                                     {
+        AstFlatTree::Index index = static_cast<AstFlatTree::Index>(node.value());
+
+        if (flat.name(index) != node.name())
+        {
+            ok = fail("node " + node.name() + " has another name in the flat tree");
+        }
+
+        std::vector<AstFlatTree::Index> children;
+        for (AstFlatTree::Index child = flat.first_child(index); child != AstFlatTree::npos; child = flat.next_sibling(child))
+        {
+            children.push_back(child);
+            if (flat.parent(child) != index)
+            {
+                ok = fail("child " + flat.name(child) + " does not link back to its parent");
+            }
+        }
+
+        if (children.size() != node.children().size() || flat.is_empty(index) != node.children().empty())
+        {
+            ok = fail("node " + node.name() + " has a different number of children in the flat tree");
+            return;
+        }
+
+        for (size_t i = 0; i < children.size(); i++)
+        {
+            if (node.children()[i]->value() != children[i])
+            {
+                ok = fail("node " + node.name() + " has its children in another order in the flat tree");
+            }
+        } });
+
+    if (nodes != flat.size())
+    {
+        ok = fail("the Node tree and the flat tree differ in size");
+    }
+
+    if (flat.parent(0) != AstFlatTree::npos)
+    {
+        ok = fail("the root of the flat tree has a parent");
+    }
+
+    if (tree.depth() != flat.depth())
+    {
+        ok = fail("the Node tree and the flat tree differ in depth");
+    }
+
+    std::vector<size_t> tree_bfs, flat_bfs;
+    tree.traverse_bfs([&tree_bfs](Node<size_t> &node)
+                      { tree_bfs.push_back(node.value()); });
+    flat.traverse_bfs([&flat_bfs](AstFlatTree::Index node)
+                      { flat_bfs.push_back(node); });
+    if (tree_bfs != flat_bfs)
+    {
+        ok = fail("the Node tree and the flat tree differ in breadth first order");
+    }
+
+    return ok;
+}
+
+/// @brief Check that a parallel walk visits each node exactly once
+/// @param walk Called as `walk(func, threads)`, returns the number of nodes visited
+template <typename Walk>
+static bool check_parallel(const std::string &what, size_t size, Walk &&walk)
+{
+    bool ok = true;
+
+    for (size_t threads : {1, 2, 4, 8})
+    {
+        std::vector<std::atomic<uint32_t>> visits(size);
+        size_t visited = walk([&visits](size_t index)
+                              { visits[index]++; },
+                              threads);
+
+        if (visited != size)
+        {
+            ok = fail(what + " on " + std::to_string(threads) + " threads reported " + std::to_string(visited) + " of " + std::to_string(size) + " nodes");
+        }
+
+        for (size_t i = 0; i < size; i++)
+        {
+            if (visits[i] != 1)
+            {
+                ok = fail(what + " on " + std::to_string(threads) + " threads visited node " + std::to_string(i) + " " + std::to_string(visits[i]) + " times");
+                break;
+            }
+        }
+
+        // the first exception is rethrown once every thread stopped
+        try
+        {
+            walk([size](size_t index)
+                 {
+                     if (index == size / 2)
+                     {
+                         throw std::runtime_error("stop");
+                     } },
+                 threads);
+            ok = fail(what + " on " + std::to_string(threads) + " threads swallowed an exception");
+        }
+        catch (const std::runtime_error &)
+        {
+        }
+    }
+
+    return ok;
+}
+
+/// @brief Check Node::find_path against the parent links of the flat tree
+static bool check_find_path(const AstFlatTree &flat, const Node<size_t> &tree)
+{
+    bool ok = true;
+
+    // the last node in preorder is a leaf, as is the deepest one
+    AstFlatTree::Index deepest = 0;
+    for (AstFlatTree::Index i = 0; i < flat.size(); i++)
+    {
+        if (flat.distance(i) > flat.distance(deepest))
+        {
+            deepest = i;
+        }
+    }
+
+    for (AstFlatTree::Index target : {AstFlatTree::Index(0), deepest, static_cast<AstFlatTree::Index>(flat.size() - 1)})
+    {
+        std::vector<const Node<size_t> *> path;
+        std::vector<AstFlatTree::Index> expected;
+
+        if (!tree.find_path(flat.name(target), path) || !flat.find_path(flat.name(target), expected))
+        {
+            ok = fail("no path was found to " + flat.name(target));
+            continue;
+        }
+
+        bool same = path.size() == expected.size();
+        for (size_t i = 0; same && i < path.size(); i++)
+        {
+            same = path[i]->value() == expected[i];
+        }
+
+        if (!same || path.front() != &tree || path.back()->name() != flat.name(target))
+        {
+            ok = fail("the path to " + flat.name(target) + " does not follow the parent links");
+        }
+
+        if (tree.distance(flat.name(target)) != flat.distance(target))
+        {
+            ok = fail("the distance to " + flat.name(target) + " differs between the trees");
+        }
+
+        std::vector<Node<size_t>> copies;
+        if (!tree.find_path(flat.name(target), copies) || copies.size() != path.size() || copies.back().name() != flat.name(target))
+        {
+            ok = fail("the copying find_path disagrees about " + flat.name(target));
+        }
+    }
+
+    std::vector<const Node<size_t> *> path = {&tree};
+    if (tree.find_path("missing", path) || path.size() != 1 || tree.distance("missing") != -1)
+    {
+        ok = fail("find_path reported a path to a missing node");
+    }
+
+    std::vector<AstFlatTree::Index> flat_path;
+    if (flat.find_path("missing", flat_path) || !flat_path.empty())
+    {
+        ok = fail("the flat tree reported a path to a missing node");
+    }
+
+    return ok;
+}
+
+int main()
+{
+    bool ok = true;
+
+    TokenList tokens = CompilationUnit::lex(make_source(90), LexMode::NoTrivia);
+    TokenCursor cursor(tokens);
+    std::vector<ParserDiagnostic> diagnostics;
+    auto ast = CompilationUnit::parse(cursor, diagnostics);
+
+    AstFlatTree flat(ast->root(), name_of(0));
+    Node<size_t> tree(0, name_of(0));
+    std::vector<const GenericNode *> preorder;
+    build(ast->root(), flat, tree, preorder);
+
+    ok &= check_links(flat, tree, preorder);
+
+    ok &= check_parallel("FlatTree::parallel_for_each_dfs", flat.size(), [&flat](auto &&func, size_t threads)
+                         { return flat.parallel_for_each_dfs([&func](AstFlatTree::Index node)
+                                                             { func(node); },
+                                                             0, threads); });
+
+    ok &= check_parallel("Node::parallel_for_each_dfs", flat.size(), [&tree](auto &&func, size_t threads)
+                         { return tree.parallel_for_each_dfs([&func](Node<size_t> &node)
+                                                             { func(node.value()); },
+                                                             threads); });
+
+    ok &= check_find_path(flat, tree);
+
+    std::cout << (ok ? "FlatTree, parallel walks and find_path agree with the syntax tree" : "FlatTree, parallel walks or find_path are not correct") << std::endl;
+
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,119 @@
+#include "compile.hpp"
+#include "common.hpp"
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace jcc;
+
+static std::string repeat(const std::string &text, size_t count)
+{
+    std::string result;
+
+    for (size_t i = 0; i < count; i++)
+    {
+        result += text;
+    }
+
+    return result;
+}
+
+/// @brief Expressions `count` levels deep, built in each way an expression nests
+static std::vector<std::string> nested_expressions(size_t count)
+{
+    return {
+        repeat("(", count) + "1" + repeat(")", count),
+        repeat("- ", count) + "1",
+        repeat("! ~ ", count / 2) + "a",
+        "a" + repeat(" + 1", count),
+        "a" + repeat(" = a", count),
+        repeat("f(", count) + "1" + repeat(")", count),
+        repeat("a ? 1 : ", count) + "1",
+        "a" + repeat(" as int", count),
+        "a" + repeat("++", count),
+    };
+}
+
+/// @brief Parse an expression between two well-formed declarations
+static std::vector<ParserDiagnostic> parse(const std::string &expression, size_t max_nesting, size_t &declarations)
+{
+    std::string source = "let before: int = 1;\nlet x: int = " + expression + ";\nlet after: int = 2;\n";
+
+    TokenList tokens = CompilationUnit::lex(source, LexMode::NoTrivia);
+    TokenCursor cursor(tokens);
+    std::vector<ParserDiagnostic> diagnostics;
+
+    auto ast = CompilationUnit::parse(cursor, diagnostics, max_nesting);
+    declarations = static_cast<Block *>(ast->root())->children().size();
+
+    if (diagnostics.empty())
+    {
+        // a tree the parser accepts must also be printable and translatable
+        ast->to_json();
+        ast->to_string();
+        CompilationUnit::generate(ast);
+    }
+
+    return diagnostics;
+}
+
+/// @brief Check that expressions deeper than the limit are rejected and recovered from
+static bool check_too_deep(size_t max_nesting, size_t count)
+{
+    bool ok = true;
+
+    for (const std::string &expression : nested_expressions(count))
+    {
+        size_t declarations = 0;
+        auto diagnostics = parse(expression, max_nesting, declarations);
+
+        std::string what = expression.substr(0, 12) + "... (" + std::to_string(count) + " levels)";
+        if (diagnostics.size() != 1 || diagnostics.front().message.find("Expression nested more than " + std::to_string(max_nesting) + " levels deep") == std::string::npos)
+        {
+            ok = fail(what + ": expected one error for nesting past " + std::to_string(max_nesting) + " levels, got: " + describe(diagnostics));
+        }
+        else if (declarations != 2)
+        {
+            ok = fail(what + ": the declarations around the error were not recovered");
+        }
+    }
+
+    return ok;
+}
+
+/// @brief Check that expressions within the limit are accepted
+static bool check_within_limit(size_t max_nesting, size_t count)
+{
+    bool ok = true;
+
+    for (const std::string &expression : nested_expressions(count))
+    {
+        size_t declarations = 0;
+        auto diagnostics = parse(expression, max_nesting, declarations);
+
+        if (!diagnostics.empty() || declarations != 3)
+        {
+            ok = fail(expression.substr(0, 12) + "... (" + std::to_string(count) + " levels): rejected within the limit: " + describe(diagnostics));
+        }
+    }
+
+    return ok;
+}
+
+int main()
+{
+    bool ok = true;
+
+    // deep enough to overflow the stack if the recursion were unbounded
+    ok &= check_too_deep(parseMaxNestingDefault, 200000);
+    ok &= check_too_deep(parseMaxNestingDefault, parseMaxNestingDefault + 1);
+    ok &= check_within_limit(parseMaxNestingDefault, parseMaxNestingDefault / 2);
+
+    // the limit follows max_nesting
+    ok &= check_too_deep(16, 40);
+    ok &= check_within_limit(16, 6);
+
+    std::cout << (ok ? "Deeply nested expressions are rejected without crashing" : "Deeply nested expressions are not handled correctly") << std::endl;
+
+    return ok ? 0 : 1;
+}
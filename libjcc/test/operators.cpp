@@ -0,0 +1,126 @@
+#include "compile.hpp"
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace jcc;
+
+/// @brief An operator and the C++ it must be lowered to
+struct OperatorCase
+{
+    const char *op;
+    const char *expected;
+};
+
+static const OperatorCase cases[] = {
+    {">>>=", "_int _c = _unsigned_right_shift_assign(_a, _b);"},
+    {"??", "_int _c = (_a != nullptr ? _a : _b);"},
+    {"^^=", "_int _c = (_a = (!_a != !_b));"},
+    {"||=", "_int _c = (_a = (_a || _b));"},
+    {"&&=", "_int _c = (_a = (_a && _b));"},
+    {"^^", "_int _c = (!_a != !_b);"},
+};
+
+static std::shared_ptr<AbstractSyntaxTree> parse(const std::string &source, std::vector<ParserDiagnostic> &diagnostics)
+{
+    TokenList tokens = CompilationUnit::lex(source, LexMode::NoTrivia);
+    TokenCursor cursor(tokens);
+
+    return CompilationUnit::parse(cursor, diagnostics);
+}
+
+static bool check_lowering(const OperatorCase &test)
+{
+    std::vector<ParserDiagnostic> diagnostics;
+    auto ast = parse(std::string("func f(a: int, b: int) : int { let c: int = a ") + test.op + " b; }", diagnostics);
+
+    if (!diagnostics.empty())
+    {
+        std::cout << test.op << ": unexpected syntax error: " << diagnostics.front().message << std::endl;
+        return false;
+    }
+
+    std::string output = CompilationUnit::generate(ast);
+    if (output.find(test.expected) == std::string::npos)
+    {
+        std::cout << test.op << ": expected '" << test.expected << "' in:\n"
+                  << output << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+/// @brief `//` always begins a comment, so a floor division only comes from a
+/// tree built or loaded some other way
+static bool check_floor_divide()
+{
+    std::vector<ParserDiagnostic> diagnostics;
+    auto ast = parse("let c: int = a / b;", diagnostics);
+
+    auto let = static_cast<LetDeclaration *>(static_cast<Block *>(ast->root())->children()[0]);
+    static_cast<BinaryExpression *>(let->dtype()->default_value())->op() = Operator::FloorDivide;
+
+    std::string output = CompilationUnit::generate(ast);
+    if (output.find("_int _c = _floor_divide(_a, _b);") == std::string::npos)
+    {
+        std::cout << "//: expected '_floor_divide(_a, _b)' in:\n"
+                  << output << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+static bool check_unsupported_at()
+{
+    std::vector<ParserDiagnostic> diagnostics;
+    parse("let c: int = a @ b;", diagnostics);
+
+    if (diagnostics.size() != 1 || diagnostics.front().message != "Unsupported operator: @")
+    {
+        std::cout << "@: expected an 'Unsupported operator: @' syntax error" << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+static bool check_variable_required()
+{
+    std::vector<ParserDiagnostic> diagnostics;
+    auto ast = parse("func f(a: int, b: int) : int { let c: int = f(a, b) ||= b; }", diagnostics);
+
+    try
+    {
+        CompilationUnit::generate(ast);
+    }
+    catch (const std::runtime_error &e)
+    {
+        if (std::string(e.what()) == "The left operand of '||=' must be a variable")
+        {
+            return true;
+        }
+    }
+
+    std::cout << "||=: expected the generator to reject a left operand that is not a variable" << std::endl;
+    return false;
+}
+
+int main()
+{
+    bool ok = true;
+
+    for (const auto &test : cases)
+    {
+        ok &= check_lowering(test);
+    }
+
+    ok &= check_floor_divide();
+    ok &= check_unsupported_at();
+    ok &= check_variable_required();
+
+    std::cout << (ok ? "Operators are lowered correctly" : "Operators are not lowered correctly") << std::endl;
+
+    return ok ? 0 : 1;
+}
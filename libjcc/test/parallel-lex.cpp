@@ -0,0 +1,107 @@
+#include "compile.hpp"
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cstdint>
+
+using namespace jcc;
+
+/// @brief Lines with what a chunk boundary must not fall inside of: strings,
+/// raw blocks and comments spanning or hiding newlines
+static const char *fragments[] = {
+    "// comment with ` and \" and /*\n",
+    "`raw\nblock \"q\" // not\n /* not */`\n",
+    "\n\n   \n",
+    "b = 12;   \n\t\n",
+    "let a: int = 5;\n",
+    "/* multi\n line \"x\" `y` \n*/\n",
+    "  indented = 0x1f + 2.5e-3;\n",
+    "func f() : int { let z: int = 1; }\n",
+    "\"str // with \\\" quote\";\n",
+    "'it\\'s /* not */';\n",
+    "x::y::z\n",
+    "x = 12.5e+10;\n",
+};
+
+/// @brief Shuffle the fragments into a source of a given number of lines
+static std::string make_source(size_t lines)
+{
+    std::string source;
+    uint32_t seed = 12345;
+
+    for (size_t i = 0; i < lines; i++)
+    {
+        seed = seed * 1103515245 + 12345;
+        source += fragments[(seed >> 16) % (sizeof(fragments) / sizeof(fragments[0]))];
+    }
+
+    return source;
+}
+
+/// @brief Lex a source with a number of threads
+/// @return The token list as JSON, or the message of the error thrown
+static std::string lex(const std::string &source, LexMode mode, size_t threads)
+{
+    try
+    {
+        return CompilationUnit::lex(source, mode, threads).to_json();
+    }
+    catch (const LexerException &e)
+    {
+        return std::string("error: ") + e.what();
+    }
+}
+
+static bool check(const std::string &name, const std::string &source)
+{
+    bool ok = true;
+
+    for (LexMode mode : {LexMode::Full, LexMode::NoTrivia})
+    {
+        std::string sequential = lex(source, mode, 1);
+
+        for (size_t threads : {2, 3, 8})
+        {
+            if (lex(source, mode, threads) != sequential)
+            {
+                std::cout << name << ": lexing on " << threads << " threads differs from lexing sequentially" << std::endl;
+                ok = false;
+            }
+        }
+    }
+
+    return ok;
+}
+
+int main()
+{
+    bool ok = true;
+
+    std::string source = make_source(2000);
+    ok &= check("valid source", source);
+
+    if (lex(source, LexMode::Full, 1).rfind("error: ", 0) == 0)
+    {
+        std::cout << "valid source: unexpected lexer error" << std::endl;
+        ok = false;
+    }
+
+    // the first error must be reported, whichever chunk it is in
+    std::string broken = source;
+    broken.insert(broken.size() / 3, "\n\"unterminated\n");
+    broken.insert(broken.size() * 2 / 3, "\nlet q: int = 0x;\n");
+    ok &= check("source with errors", broken);
+
+    if (lex(broken, LexMode::Full, 1).rfind("error: ", 0) != 0)
+    {
+        std::cout << "source with errors: expected a lexer error" << std::endl;
+        ok = false;
+    }
+
+    ok &= check("empty source", "");
+    ok &= check("single line", "let a: int = 5;");
+
+    std::cout << (ok ? "Parallel lexing matches sequential lexing" : "Parallel lexing does not match sequential lexing") << std::endl;
+
+    return ok ? 0 : 1;
+}
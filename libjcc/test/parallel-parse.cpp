@@ -0,0 +1,66 @@
+#include "compile.hpp"
+#include "common.hpp"
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace jcc;
+
+static std::string parse(const TokenList &tokens, size_t threads)
+{
+    TokenCursor cursor(tokens);
+    std::vector<ParserDiagnostic> diagnostics;
+
+    auto ast = CompilationUnit::parse(cursor, diagnostics, parseMaxNestingDefault, threads);
+
+    return describe(*ast, diagnostics);
+}
+
+static std::string skim(const TokenList &tokens, size_t threads)
+{
+    std::vector<ParserDiagnostic> diagnostics;
+
+    auto ast = CompilationUnit::skim(tokens, diagnostics, parseMaxNestingDefault, threads);
+
+    return describe(*ast, diagnostics);
+}
+
+int main()
+{
+    bool ok = true;
+
+    std::string source = make_source(400);
+
+    for (LexMode mode : {LexMode::NoTrivia, LexMode::Full})
+    {
+        TokenList tokens = CompilationUnit::lex(source, mode);
+
+        std::string sequential = parse(tokens, 1);
+        std::string sequential_skim = skim(tokens, 1);
+
+        if (sequential.find("Expected") == std::string::npos)
+        {
+            std::cout << "expected the malformed declarations to be reported" << std::endl;
+            ok = false;
+        }
+
+        for (size_t threads : {2, 3, 8})
+        {
+            if (parse(tokens, threads) != sequential)
+            {
+                std::cout << "parsing on " << threads << " threads differs from parsing sequentially" << std::endl;
+                ok = false;
+            }
+
+            if (skim(tokens, threads) != sequential_skim)
+            {
+                std::cout << "skimming on " << threads << " threads differs from skimming sequentially" << std::endl;
+                ok = false;
+            }
+        }
+    }
+
+    std::cout << (ok ? "Parallel parsing matches sequential parsing" : "Parallel parsing does not match sequential parsing") << std::endl;
+
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,143 @@
+#include "compile.hpp"
+#include "common.hpp"
+#include <iostream>
+#include <string>
+#include <vector>
+#include <set>
+
+using namespace jcc;
+
+/// @brief Source with one function per entry of `bodies`
+static std::string make_functions(const std::vector<std::string> &bodies)
+{
+    std::string source;
+
+    for (size_t i = 0; i < bodies.size(); i++)
+    {
+        source += "func f" + std::to_string(i) + "(a: int) : int\n{\n    " + bodies[i] + "\n}\n";
+    }
+
+    return source;
+}
+
+struct Version
+{
+    TokenList tokens;
+    std::shared_ptr<AbstractSyntaxTree> ast;
+    std::vector<ParserDiagnostic> diagnostics;
+};
+
+static void parse(Version &version, const std::string &source, const std::shared_ptr<AbstractSyntaxTree> &previous, size_t threads)
+{
+    version.tokens = CompilationUnit::lex(source, LexMode::NoTrivia);
+    TokenCursor cursor(version.tokens);
+    version.ast = CompilationUnit::reparse(cursor, previous, version.diagnostics, parseMaxNestingDefault, threads);
+}
+
+/// @brief Get the nodes a span contributes to the root
+static std::vector<GenericNode *> span_nodes(const AbstractSyntaxTree &ast, size_t span)
+{
+    const auto &children = static_cast<Block *>(ast.root())->children();
+    const TopLevelSpan &s = ast.spans()[span];
+
+    return std::vector<GenericNode *>(children.begin() + s.first, children.begin() + s.first + s.count);
+}
+
+/// @brief Reparse after editing declarations, and check what was reused
+/// @param changed Indices of the declarations edited or malformed in either version
+static bool check_edit(const std::vector<std::string> &before, const std::vector<std::string> &after, const std::set<size_t> &changed, size_t threads)
+{
+    bool ok = true;
+
+    Version old_version, new_version, fresh;
+    parse(old_version, make_functions(before), nullptr, threads);
+    parse(new_version, make_functions(after), old_version.ast, threads);
+    parse(fresh, make_functions(after), nullptr, threads);
+
+    if (describe(*new_version.ast, new_version.diagnostics) != describe(*fresh.ast, fresh.diagnostics))
+    {
+        ok = fail("a reparse differs from a parse from scratch");
+    }
+
+    if (new_version.ast->spans().size() != after.size() || old_version.ast->spans().size() != before.size())
+    {
+        return fail("expected one span per declaration");
+    }
+
+    for (size_t i = 0; i < after.size(); i++)
+    {
+        bool reused = span_nodes(*new_version.ast, i) == span_nodes(*old_version.ast, i);
+
+        if (changed.count(i) && reused)
+        {
+            ok = fail("declaration " + std::to_string(i) + " changed or has errors but was reused");
+        }
+        else if (!changed.count(i) && !reused)
+        {
+            ok = fail("declaration " + std::to_string(i) + " is unchanged but was parsed again");
+        }
+    }
+
+    return ok;
+}
+
+/// @brief Edit the same source many times, and check that old arenas are let go
+static bool check_retention(size_t threads)
+{
+    std::vector<std::string> bodies(6, "let z: int = a;");
+    std::shared_ptr<AbstractSyntaxTree> previous;
+    std::vector<Version> versions(20);
+
+    for (size_t edit = 0; edit < versions.size(); edit++)
+    {
+        bodies.back() = "let z: int = a + " + std::to_string(edit) + ";";
+        parse(versions[edit], make_functions(bodies), previous, threads);
+        previous = versions[edit].ast;
+        versions[edit].ast = nullptr;
+
+        std::set<AstArena *> arenas;
+        for (const auto &span : previous->spans())
+        {
+            arenas.insert(span.arena.get());
+            if (span.age >= parseMaxRetainedVersions)
+            {
+                return fail("a span outlived parseMaxRetainedVersions");
+            }
+        }
+
+        if (arenas.size() > parseMaxRetainedVersions)
+        {
+            return fail("a reparsed tree keeps more than parseMaxRetainedVersions arenas");
+        }
+    }
+
+    return true;
+}
+
+int main()
+{
+    bool ok = true;
+
+    std::vector<std::string> before(8, "let z: int = a;");
+    before[5] = "let z: int = ;";
+
+    std::vector<std::string> after = before;
+    after[2] = "let z: int = a * 2;";
+
+    for (size_t threads : {1, 2, 4})
+    {
+        // the edited declaration and the malformed one are parsed again
+        ok &= check_edit(before, after, {2, 5}, threads);
+
+        // fixing the malformed declaration only reparses it
+        std::vector<std::string> fixed = before;
+        fixed[5] = "let z: int = a;";
+        ok &= check_edit(before, fixed, {5}, threads);
+
+        ok &= check_retention(threads);
+    }
+
+    std::cout << (ok ? "Reparsing reuses exactly the unchanged declarations" : "Reparsing is not correct") << std::endl;
+
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,134 @@
+#include "compile.hpp"
+#include "common.hpp"
+#include <iostream>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <tuple>
+
+using namespace jcc;
+
+/// @brief Collect the function definitions and struct methods of a block, in source order
+static void collect_functions(Block *block, std::vector<GenericNode *> &functions)
+{
+    for (GenericNode *child : block->children())
+    {
+        switch (child->type())
+        {
+        case NodeType::FunctionDefinition:
+            functions.push_back(child);
+            break;
+        case NodeType::StructDefinition:
+            for (StructMethod *method : static_cast<StructDefinition *>(child)->methods())
+            {
+                functions.push_back(method);
+            }
+            break;
+        case NodeType::SubsystemDefinition:
+            collect_functions(static_cast<SubsystemDefinition *>(child)->block(), functions);
+            break;
+        default:
+            break;
+        }
+    }
+}
+
+static Block *body_of(GenericNode *function)
+{
+    if (function->type() == NodeType::FunctionDefinition)
+    {
+        return static_cast<FunctionDefinition *>(function)->block();
+    }
+
+    return static_cast<StructMethod *>(function)->block();
+}
+
+/// @brief Order syntax errors by where they are
+static bool before(const ParserDiagnostic &a, const ParserDiagnostic &b)
+{
+    return std::tie(a.location.line, a.location.column, a.message) < std::tie(b.location.line, b.location.column, b.message);
+}
+
+static bool check(const TokenList &tokens, size_t threads)
+{
+    bool ok = true;
+
+    TokenCursor cursor(tokens);
+    std::vector<ParserDiagnostic> full_diagnostics;
+    auto full = CompilationUnit::parse(cursor, full_diagnostics, parseMaxNestingDefault, threads);
+
+    std::vector<ParserDiagnostic> diagnostics;
+    auto skimmed = CompilationUnit::skim(tokens, diagnostics, parseMaxNestingDefault, threads);
+
+    std::vector<GenericNode *> full_functions, functions;
+    collect_functions(static_cast<Block *>(full->root()), full_functions);
+    collect_functions(static_cast<Block *>(skimmed->root()), functions);
+
+    if (functions.size() != full_functions.size())
+    {
+        return fail("skimming and parsing found a different number of functions");
+    }
+
+    for (size_t i = 0; i < functions.size(); i++)
+    {
+        if (body_of(functions[i]) != nullptr)
+        {
+            ok = fail("a skimmed function has a body before parse_body");
+        }
+
+        Block *block = CompilationUnit::parse_body(skimmed, functions[i], diagnostics);
+        if (block == nullptr || block != body_of(functions[i]))
+        {
+            ok = fail("parse_body did not store the body in the function");
+            continue;
+        }
+
+        std::vector<ParserDiagnostic> again;
+        if (CompilationUnit::parse_body(skimmed, functions[i], again) != block || !again.empty())
+        {
+            ok = fail("parsing a body twice did not return the same block");
+        }
+
+        Block *expected = body_of(full_functions[i]);
+        if (expected == nullptr || block->to_json() != expected->to_json())
+        {
+            ok = fail("a body parsed after skimming differs from a full parse");
+        }
+    }
+
+    if (skimmed->to_json() != full->to_json())
+    {
+        ok = fail("a skimmed tree with every body parsed differs from a full parse");
+    }
+
+    // bodies are parsed after the declarations, so only the order differs
+    std::sort(diagnostics.begin(), diagnostics.end(), before);
+    std::sort(full_diagnostics.begin(), full_diagnostics.end(), before);
+    if (describe(diagnostics) != describe(full_diagnostics))
+    {
+        ok = fail("skimming and parsing bodies reported different errors than a full parse");
+    }
+
+    return ok;
+}
+
+int main()
+{
+    bool ok = true;
+
+    std::string source = make_source(90);
+
+    for (LexMode mode : {LexMode::NoTrivia, LexMode::Full})
+    {
+        TokenList tokens = CompilationUnit::lex(source, mode);
+
+        for (size_t threads : {1, 2})
+        {
+            ok &= check(tokens, threads);
+        }
+    }
+
+    std::cout << (ok ? "Skimming then parsing bodies matches a full parse" : "Skimming then parsing bodies does not match a full parse") << std::endl;
+
+    return ok ? 0 : 1;
+}
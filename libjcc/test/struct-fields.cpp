@@ -0,0 +1,49 @@
+#include "compile.hpp"
+#include "common.hpp"
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace jcc;
+
+struct FieldCase
+{
+    const char *source;
+    /// @brief The diagnostics expected, as rendered by `describe`
+    const char *expected;
+};
+
+static const FieldCase cases[] = {
+    {"struct A { x: int; y: float : 3; z: int[4]; w: int = 0x1f; }", ""},
+    // the field after a malformed one is still parsed
+    {"struct A { x; y: int; }", "1:13 Expected seperator in struct field\n"},
+    {"struct A { x int; y: int; }", "1:14 Expected seperator in struct field\n"},
+    {"struct A { x: int : 3; y: int[4]; z; }", "1:36 Expected seperator in struct field\n"},
+    {"struct A { x: int : ; y: int; }", "1:21 Expected bitfield in struct field\n"},
+    {"struct A { x: int : 1.5; y: int; }", "1:21 Expected bitfield in struct field\n"},
+    {"struct A { x: int : a; }", "1:21 Expected bitfield in struct field\n"},
+    // each malformed struct is reported on its own
+    {"struct A { x; }\nstruct B { y: int : ; }", "1:13 Expected seperator in struct field\n2:21 Expected bitfield in struct field\n"},
+};
+
+int main()
+{
+    bool ok = true;
+
+    for (const FieldCase &test : cases)
+    {
+        TokenList tokens = CompilationUnit::lex(test.source, LexMode::NoTrivia);
+        TokenCursor cursor(tokens);
+        std::vector<ParserDiagnostic> diagnostics;
+        CompilationUnit::parse(cursor, diagnostics);
+
+        if (describe(diagnostics) != test.expected)
+        {
+            ok = fail(std::string(test.source) + ": expected\n" + test.expected + "got\n" + describe(diagnostics));
+        }
+    }
+
+    std::cout << (ok ? "Struct fields are diagnosed correctly" : "Struct fields are not diagnosed correctly") << std::endl;
+
+    return ok ? 0 : 1;
+}
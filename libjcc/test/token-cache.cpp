@@ -0,0 +1,142 @@
+#include "compile.hpp"
+#include "common.hpp"
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <memory>
+#include <filesystem>
+#include <unistd.h>
+
+using namespace jcc;
+
+static const char *program = R"(subsystem Core : libc
+{
+    struct Point { x: int = 0x1f; y: float : 3; name: string = "a\tb\"c"; }
+    /* a comment */
+    func add(a: int, b: int = 4) : int
+    {
+        let z: int = a + b * 2; // another
+        let s: string = 'it\'s';
+    }
+}
+)";
+
+/// @brief Compare two lists entry by entry, including identifier symbols
+static bool same_tokens(const TokenList &a, const TokenList &b)
+{
+    if (a.size() != b.size() || a.to_json() != b.to_json())
+    {
+        return false;
+    }
+
+    for (size_t i = 0; i < a.size(); i++)
+    {
+        Token x = a.peek(i), y = b.peek(i);
+        if (x.type() == TokenType::Identifier && x.symbol() != y.symbol())
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static void write_file(const std::string &path, const std::string &data)
+{
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out << data;
+}
+
+static std::string read_file(const std::string &path)
+{
+    std::ifstream in(path, std::ios::binary);
+    return std::string(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+}
+
+static bool check_mode(const std::filesystem::path &dir, LexMode mode)
+{
+    bool ok = true;
+    auto source = std::make_shared<const std::string>(program);
+    std::string path = (dir / (mode == LexMode::Full ? "full.jtok" : "notrivia.jtok")).string();
+
+    TokenList tokens = CompilationUnit::lex(source, mode);
+    if (!tokens.save(path, "key-1", mode))
+    {
+        return fail("unable to write " + path);
+    }
+
+    // round trip
+    TokenList loaded;
+    if (!loaded.load(path, source, "key-1", mode))
+    {
+        ok = fail("a freshly written cache was not loaded");
+    }
+    else if (!same_tokens(tokens, loaded))
+    {
+        ok = fail("the loaded tokens differ from the lexed ones");
+    }
+
+    // invalidation: every mismatch must be refused, not half loaded
+    TokenList rejected;
+    if (rejected.load(path, source, "key-2", mode))
+    {
+        ok = fail("a cache was loaded for a different key");
+    }
+
+    if (rejected.load(path, source, "key-1", mode == LexMode::Full ? LexMode::NoTrivia : LexMode::Full))
+    {
+        ok = fail("a cache was loaded for a different lex mode");
+    }
+
+    auto edited = std::make_shared<const std::string>(std::string(program) + "\n");
+    if (rejected.load(path, edited, "key-1", mode))
+    {
+        ok = fail("a cache was loaded for a source of a different size");
+    }
+
+    if (rejected.load((dir / "missing.jtok").string(), source, "key-1", mode))
+    {
+        ok = fail("a missing cache was loaded");
+    }
+
+    std::string data = read_file(path);
+
+    std::string bad_path = (dir / "bad.jtok").string();
+    write_file(bad_path, data.substr(0, data.size() - 1));
+    if (rejected.load(bad_path, source, "key-1", mode))
+    {
+        ok = fail("a truncated cache was loaded");
+    }
+
+    std::string corrupted = data;
+    corrupted[0] ^= 0x20;
+    write_file(bad_path, corrupted);
+    if (rejected.load(bad_path, source, "key-1", mode))
+    {
+        ok = fail("a cache with a corrupted magic was loaded");
+    }
+
+    if (rejected.size() != 0)
+    {
+        ok = fail("a refused load changed the list");
+    }
+
+    return ok;
+}
+
+int main()
+{
+    std::filesystem::path dir = std::filesystem::temp_directory_path() / ("jcc-token-cache-" + std::to_string(getpid()));
+    std::filesystem::create_directories(dir);
+
+    bool ok = true;
+    ok &= check_mode(dir, LexMode::Full);
+    ok &= check_mode(dir, LexMode::NoTrivia);
+
+    std::filesystem::remove_all(dir);
+
+    std::cout << (ok ? "Token cache round trips and invalidates correctly" : "Token cache is not correct") << std::endl;
+
+    return ok ? 0 : 1;
+}
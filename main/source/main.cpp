@@ -49,6 +49,9 @@ enum JccModeFlags
     OptimizeSize,
     Object,
     TranslateOnly,
+    DumpTokens,
+    DumpAst,
+    EmitAstBinary,
 };
 
 std::map<JccModeFlags, std::string> flag_names = {
@@ -61,12 +64,17 @@ std::map<JccModeFlags, std::string> flag_names = {
     {JccModeFlags::OptimizeSize, "-Os"},
     {JccModeFlags::Object, "-c"},
     {JccModeFlags::TranslateOnly, "-S"},
+    {JccModeFlags::DumpTokens, "-dump-tokens"},
+    {JccModeFlags::DumpAst, "-dump-ast"},
+    {JccModeFlags::EmitAstBinary, "-emit-ast=bin"},
 };
 
 struct JccMode
 {
     std::vector<std::string> input_files;
     std::string output_file;
+    std::string token_cache;
+    size_t max_nesting = parseMaxNestingDefault;
     std::vector<JccModeFlags> flags;
 };
 
@@ -139,6 +147,50 @@ bool parse_arguments(StringVector args, JccMode &mode)
         {
             mode.flags.push_back(JccModeFlags::TranslateOnly);
         }
+        else if (*it == "-dump-tokens")
+        {
+            mode.flags.push_back(JccModeFlags::DumpTokens);
+        }
+        else if (*it == "-dump-ast" || *it == "-emit-ast=json")
+        {
+            mode.flags.push_back(JccModeFlags::DumpAst);
+        }
+        else if (*it == "-emit-ast=bin")
+        {
+            mode.flags.push_back(JccModeFlags::EmitAstBinary);
+        }
+        else if (*it == "-token-cache" && mode.token_cache != "")
+        {
+            print_error("multiple token cache directories specified");
+            return false;
+        }
+        else if (*it == "-token-cache")
+        {
+            if (it + 1 == args.end())
+            {
+                print_error("no token cache directory specified");
+                return false;
+            }
+
+            mode.token_cache = *(++it);
+        }
+        else if (*it == "-max-nesting")
+        {
+            if (it + 1 == args.end())
+            {
+                print_error("no nesting limit specified");
+                return false;
+            }
+
+            std::string depth = *(++it);
+            if (depth.empty() || depth.find_first_not_of("0123456789") != std::string::npos || depth.size() > 9)
+            {
+                print_error("invalid nesting limit '" + depth + "'");
+                return false;
+            }
+
+            mode.max_nesting = std::stoul(depth);
+        }
         else
         {
             if (!it->ends_with(".j"))
@@ -240,6 +292,8 @@ int main(int argc, char **argv)
 
     auto unit = std::make_unique<CompilationUnit>();
     unit->set_output_file(mode.output_file);
+    unit->set_token_cache(mode.token_cache);
+    unit->set_max_nesting(mode.max_nesting);
 
     for (auto file : mode.input_files)
     {
@@ -276,6 +330,15 @@ int main(int argc, char **argv)
         case JccModeFlags::TranslateOnly:
             unit->add_flag(CompileFlag::TranslateOnly);
             break;
+        case JccModeFlags::DumpTokens:
+            unit->add_flag(CompileFlag::DumpTokens);
+            break;
+        case JccModeFlags::DumpAst:
+            unit->add_flag(CompileFlag::DumpAst);
+            break;
+        case JccModeFlags::EmitAstBinary:
+            unit->add_flag(CompileFlag::EmitAstBinary);
+            break;
 
         default:
             break;